@@ -37,6 +37,19 @@ typedef tbb::enumerable_thread_specific<Task *> TaskInfo;
 
 static TaskInfo task_running;
 
+// State of a tbb worker thread, used in work stealing mode.
+struct TaskWorker {
+    TaskWorker() : active(false), exiting(false), next(NULL), bypass_count(0) {
+    }
+    bool active;        // Thread is executing a TaskImpl
+    bool exiting;       // Thread is processing exit of the Task
+    tbb::task *next;    // tbb::task to run next on this thread
+    int bypass_count;   // # of tasks run back to back via next
+};
+typedef tbb::enumerable_thread_specific<TaskWorker> TaskWorkerInfo;
+
+static TaskWorkerInfo task_worker;
+
 // Vector of Task entries
 typedef std::vector<TaskEntry *> TaskEntryList;
 
@@ -52,13 +65,16 @@ boost::scoped_ptr<TaskScheduler> TaskScheduler::singleton_;
 // registered with tbb::task
 class TaskImpl : public tbb::task {
 public:
-    TaskImpl(Task *t) : parent_(t) {};
+    TaskImpl(Task *t) : parent_(t), bypassed_(false) {};
     virtual ~TaskImpl();
 
+    void set_bypassed() { bypassed_ = true; }
+
 private:
     tbb::task *execute();
 
     Task    *parent_;
+    bool    bypassed_;
 
     DISALLOW_COPY_AND_ASSIGN(TaskImpl);
 };
@@ -259,6 +275,10 @@ private:
 tbb::task *TaskImpl::execute() {
     TaskInfo::reference running = task_running.local();
     running = parent_;
+    TaskWorkerInfo::reference worker = task_worker.local();
+    worker.active = true;
+    if (!bypassed_)
+        worker.bypass_count = 0;
     parent_->SetTbbState(Task::TBB_EXEC);
     try {
         uint64_t t = 0;
@@ -310,14 +330,31 @@ tbb::task *TaskImpl::execute() {
         assert(0);
     }
 
-    return NULL;
+    // In work stealing mode, process the exit here instead of in the
+    // destructor, so that a task made runnable by the exit can be returned
+    // to tbb and run next on this thread.
+    tbb::task *next = NULL;
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    if (scheduler->work_stealing()) {
+        worker.exiting = true;
+        scheduler->OnTaskExit(parent_);
+        parent_ = NULL;
+        worker.exiting = false;
+        next = worker.next;
+        worker.next = NULL;
+    }
+    worker.active = false;
+
+    return next;
 }
 
 // Destructor called when a task execution is compeleted. Invoked
 // implicitly by tbb::task. 
-// Invokes OnTaskExit to schedule tasks pending tasks
+// Invokes OnTaskExit to schedule tasks pending tasks, unless execute()
+// already did so.
 TaskImpl::~TaskImpl() {
-    assert(parent_ != NULL);
+    if (parent_ == NULL)
+        return;
 
     TaskScheduler *sched = TaskScheduler::GetInstance();
     sched->OnTaskExit(parent_);
@@ -357,6 +394,13 @@ bool TaskScheduler::ShouldUseSpawn() {
     return false;
 }
 
+bool TaskScheduler::ShouldUseWorkStealing() {
+    if (getenv("TBB_USE_WORK_STEALING"))
+        return true;
+
+    return false;
+}
+
 ////////////////////////////////////////////////////////////////////////////
 // Implementation for class TaskScheduler 
 ////////////////////////////////////////////////////////////////////////////
@@ -366,10 +410,12 @@ bool TaskScheduler::ShouldUseSpawn() {
 // for task scheduling. But, in our case we dont want "main" thread to be
 // part of tbb. So, initialize TBB with one thread more than its default
 TaskScheduler::TaskScheduler(int task_count) : 
-    use_spawn_(ShouldUseSpawn()), task_scheduler_(GetThreadCount(task_count) + 1),
+    use_spawn_(ShouldUseSpawn()), work_stealing_(ShouldUseWorkStealing()),
+    task_scheduler_(GetThreadCount(task_count) + 1),
     running_(true), seqno_(0), id_max_(0), log_fn_(), track_run_time_(false),
     measure_delay_(false), schedule_delay_(0), execute_delay_(0),
-    enqueue_count_(0), done_count_(0), cancel_count_(0), evm_(NULL),
+    enqueue_count_(0), done_count_(0), cancel_count_(0), bypass_count_(0),
+    spawn_count_(0), evm_(NULL),
     tbb_awake_task_(NULL), task_monitor_(NULL) {
     hw_thread_count_ = GetThreadCount(task_count);
     task_group_db_.resize(TaskScheduler::kVectorGrowSize);
@@ -705,6 +751,43 @@ TaskScheduler::CancelReturnCode TaskScheduler::Cancel(Task *t) {
     return QUEUED;
 }
 
+// Hand over the tbb::task for a Task that is ready to run to tbb.
+//
+// In work stealing mode, a task made runnable on a tbb worker thread stays
+// with that worker. The first task made runnable by the exit of a Task is
+// returned from TaskImpl::execute(), so that tbb runs it next on the same
+// thread without queueing it anywhere. Other tasks are spawned into the
+// local deque of the worker, from where idle workers steal them. Tasks made
+// runnable on threads that are not tbb workers, or on a worker that has run
+// kMaxBypassCount tasks back to back, go to the shared tbb queue so that
+// tasks waiting there don't starve.
+//
+// Policy checks are the same in all modes. The Task is already accounted
+// as running in its TaskEntry and TaskGroup by the time it gets here.
+void TaskScheduler::StartTbbTask(tbb::task *task_impl) {
+    if (work_stealing_) {
+        TaskWorkerInfo::reference worker = task_worker.local();
+        if (!worker.active || worker.bypass_count >= kMaxBypassCount) {
+            task::enqueue(*task_impl);
+        } else if (worker.exiting && worker.next == NULL) {
+            static_cast<TaskImpl *>(task_impl)->set_bypassed();
+            worker.next = task_impl;
+            worker.bypass_count++;
+            bypass_count_++;
+        } else {
+            task::spawn(*task_impl);
+            spawn_count_++;
+        }
+        return;
+    }
+
+    if (use_spawn_) {
+        task::spawn(*task_impl);
+    } else {
+        task::enqueue(*task_impl);
+    }
+}
+
 // Method invoked on exit of a Task.
 // Exit of a task can potentially start tasks in pendingq.
 void TaskScheduler::OnTaskExit(Task *t) {
@@ -1571,11 +1654,7 @@ void Task::StartTask(TaskScheduler *scheduler) {
     SetState(RUN);
     SetTbbState(TBB_ENQUEUED);
     task_impl_ = new (task::allocate_root())TaskImpl(this);
-    if (scheduler->use_spawn()) {
-        task::spawn(*task_impl_);
-    } else {
-        task::enqueue(*task_impl_);
-    }
+    scheduler->StartTbbTask(task_impl_);
 }
 
 Task *Task::Running() {
@@ -1643,6 +1722,9 @@ void TaskScheduler::GetSandeshData(SandeshTaskScheduler *resp, bool summary) {
 
     resp->set_running(running_);
     resp->set_use_spawn(use_spawn_);
+    resp->set_work_stealing(work_stealing_);
+    resp->set_bypass_count(bypass_count_);
+    resp->set_spawn_count(spawn_count_);
     resp->set_total_count(seqno_);
     resp->set_thread_count(hw_thread_count_);
 
@@ -213,12 +213,15 @@ public:
     // Get number of tbb worker threads.
     static int GetThreadCount(int thread_count = 0);
     static bool ShouldUseSpawn();
+    static bool ShouldUseWorkStealing();
 
     static int GetDefaultThreadCount();
 
     uint64_t enqueue_count() const { return enqueue_count_; }
     uint64_t done_count() const { return done_count_; }
     uint64_t cancel_count() const { return cancel_count_; }
+    uint64_t bypass_count() const { return bypass_count_; }
+    uint64_t spawn_count() const { return spawn_count_; }
     // Force number of threads
     void SetMaxThreadCount(int n);
     void GetSandeshData(SandeshTaskScheduler *resp, bool summary);
@@ -255,16 +258,26 @@ public:
     const TaskTbbKeepAwake *tbb_awake_task() const { return tbb_awake_task_; }
     bool use_spawn() const { return use_spawn_; }
 
+    // Work stealing mode keeps tasks made runnable by a tbb worker thread on
+    // that worker instead of sending them through the shared tbb queue. See
+    // TaskScheduler::StartTbbTask() for details.
+    void SetWorkStealing(bool value) { work_stealing_ = value; }
+    bool work_stealing() const { return work_stealing_; }
+
     // following function allows one to increase max num of threads used by
     // TBB
     static void SetThreadAmpFactor(int n);
 
 private:
     friend class ConcurrencyScope;
+    friend class Task;
     typedef std::vector<TaskGroup *> TaskGroupDb;
     typedef std::map<std::string, int> TaskIdMap;
 
     static const int        kVectorGrowSize = 16;
+    // Max number of tasks a worker runs back to back in work stealing mode
+    // before it hands a runnable task to the shared tbb queue.
+    static const int        kMaxBypassCount = 32;
     static boost::scoped_ptr<TaskScheduler> singleton_;
 
     // XXX
@@ -276,9 +289,11 @@ private:
     void WaitForTerminateCompletion();
 
     int CountThreadsPerPid(pid_t pid);
+    void StartTbbTask(tbb::task *task_impl);
 
     // Use spawn() to run a tbb::task instead of enqueue()
     bool                    use_spawn_;
+    bool                    work_stealing_;
     TaskEntry               *stop_entry_;
 
     tbb::task_scheduler_init task_scheduler_;
@@ -304,6 +319,8 @@ private:
     uint64_t                enqueue_count_;
     uint64_t                done_count_;
     uint64_t                cancel_count_;
+    uint64_t                bypass_count_;
+    uint64_t                spawn_count_;
     EventManager            *evm_;
     // following variable allows one to increase max num of threads used by
     // TBB
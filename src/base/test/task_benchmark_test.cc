@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <assert.h>
+#include <tbb/atomic.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/task.h"
+#include "base/time_util.h"
+#include "base/test/task_test_util.h"
+
+#include "testing/gunit.h"
+
+using std::string;
+using std::vector;
+
+//
+// Measure task dispatch latency and throughput of the TaskScheduler with
+// and without work stealing, as the number of busy task instances grows
+// from one up to the number of tbb worker threads.
+//
+// Each instance of bench::Chain runs a chain of tasks. A running task
+// enqueues the next task of its chain, which has to wait for the running
+// one to exit, the same way db::DBTable partition tasks are fed. Tasks of
+// bench::Exclusive are mutually exclusive with all bench::Chain tasks.
+//
+class TaskBenchmarkTest : public ::testing::Test {
+protected:
+    static const int kMaxInstances = 256;
+    static const int kChainLength = 10000;
+    static const int kWorkIterations = 1000;
+
+    struct Result {
+        Result() : tasks(0), elapsed(0), latency(0) { }
+        uint64_t tasks;
+        uint64_t elapsed;
+        uint64_t latency;
+    };
+
+    class ChainTask : public Task {
+    public:
+        ChainTask(TaskBenchmarkTest *test, int instance, int remaining)
+            : Task(test->chain_id_, instance),
+              test_(test),
+              remaining_(remaining),
+              enqueue_usec_(0) {
+        }
+
+        virtual bool Run() {
+            test_->ChainRun(this);
+            return true;
+        }
+        string Description() const { return "ChainTask"; }
+
+    private:
+        friend class TaskBenchmarkTest;
+        TaskBenchmarkTest *test_;
+        int remaining_;
+        uint64_t enqueue_usec_;
+    };
+
+    class ExclusiveTask : public Task {
+    public:
+        explicit ExclusiveTask(TaskBenchmarkTest *test)
+            : Task(test->exclusive_id_), test_(test) {
+        }
+
+        virtual bool Run() {
+            test_->ExclusiveRun();
+            return true;
+        }
+        string Description() const { return "ExclusiveTask"; }
+
+    private:
+        TaskBenchmarkTest *test_;
+    };
+
+    TaskBenchmarkTest()
+        : scheduler_(TaskScheduler::GetInstance()),
+          chain_id_(scheduler_->GetTaskId("bench::Chain")),
+          exclusive_id_(scheduler_->GetTaskId("bench::Exclusive")),
+          exclusive_interval_(0),
+          work_stealing_(scheduler_->work_stealing()) {
+    }
+
+    virtual void TearDown() {
+        task_util::WaitForIdle();
+        scheduler_->SetWorkStealing(work_stealing_);
+    }
+
+    void Enqueue(ChainTask *task) {
+        task->enqueue_usec_ = ClockMonotonicUsec();
+        scheduler_->Enqueue(task);
+    }
+
+    static void Work() {
+        volatile int count = 0;
+        for (int idx = 0; idx < kWorkIterations; ++idx) {
+            count++;
+        }
+    }
+
+    void ChainRun(ChainTask *task) {
+        latency_ += ClockMonotonicUsec() - task->enqueue_usec_;
+        int instance = task->GetTaskInstance();
+        if (instance_running_[instance]++ != 0)
+            violations_++;
+        chain_running_++;
+        if (exclusive_running_ != 0)
+            violations_++;
+
+        Work();
+        if (task->remaining_ > 1)
+            Enqueue(new ChainTask(this, instance, task->remaining_ - 1));
+        if (exclusive_interval_ && task->remaining_ % exclusive_interval_ == 0)
+            scheduler_->Enqueue(new ExclusiveTask(this));
+
+        chain_running_--;
+        instance_running_[instance]--;
+        chain_completed_++;
+    }
+
+    void ExclusiveRun() {
+        exclusive_running_++;
+        if (chain_running_ != 0)
+            violations_++;
+        Work();
+        exclusive_running_--;
+        exclusive_completed_++;
+    }
+
+    Result RunChains(bool work_stealing, int instances, int length) {
+        assert(instances <= kMaxInstances);
+        scheduler_->SetWorkStealing(work_stealing);
+        latency_ = 0;
+        violations_ = 0;
+        chain_running_ = 0;
+        exclusive_running_ = 0;
+        chain_completed_ = 0;
+        exclusive_completed_ = 0;
+        for (int idx = 0; idx < instances; ++idx) {
+            instance_running_[idx] = 0;
+        }
+
+        uint64_t total = static_cast<uint64_t>(instances) * length;
+        uint64_t start = ClockMonotonicUsec();
+        for (int idx = 0; idx < instances; ++idx) {
+            Enqueue(new ChainTask(this, idx, length));
+        }
+        while (chain_completed_ != total) {
+            usleep(100);
+        }
+
+        Result result;
+        result.elapsed = ClockMonotonicUsec() - start;
+        result.tasks = total;
+        result.latency = latency_;
+        task_util::WaitForIdle();
+        EXPECT_EQ(0, static_cast<int>(violations_));
+        return result;
+    }
+
+    static void PrintResult(const string &mode, int instances,
+                            const Result &result) {
+        std::cout << mode << " instances " << instances
+            << " tasks " << result.tasks
+            << " elapsed " << result.elapsed << " usec"
+            << " throughput "
+            << result.tasks * 1000000 / (result.elapsed ? result.elapsed : 1)
+            << " tasks/sec"
+            << " avg latency " << result.latency / result.tasks << " usec"
+            << std::endl;
+    }
+
+    TaskScheduler *scheduler_;
+    int chain_id_;
+    int exclusive_id_;
+    int exclusive_interval_;
+    bool work_stealing_;
+    tbb::atomic<uint64_t> latency_;
+    tbb::atomic<int> violations_;
+    tbb::atomic<int> chain_running_;
+    tbb::atomic<int> exclusive_running_;
+    tbb::atomic<uint64_t> chain_completed_;
+    tbb::atomic<uint64_t> exclusive_completed_;
+    tbb::atomic<int> instance_running_[kMaxInstances];
+};
+
+//
+// Verify that task instance and task group exclusion hold in work stealing
+// mode when tasks made runnable on exit run on the same thread.
+//
+TEST_F(TaskBenchmarkTest, WorkStealingPolicy) {
+    int instances = std::min(TaskScheduler::GetThreadCount() * 2,
+                             static_cast<int>(kMaxInstances));
+    exclusive_interval_ = 100;
+    RunChains(true, instances, kChainLength / 10);
+    EXPECT_EQ(instances * kChainLength / 10 / exclusive_interval_,
+              static_cast<uint64_t>(exclusive_completed_));
+    EXPECT_NE(0, scheduler_->bypass_count());
+}
+
+TEST_F(TaskBenchmarkTest, Benchmark) {
+    vector<int> instance_counts;
+    int thread_count = TaskScheduler::GetThreadCount();
+    for (int count = 1; count < thread_count; count *= 2) {
+        instance_counts.push_back(count);
+    }
+    instance_counts.push_back(std::min(thread_count,
+                                       static_cast<int>(kMaxInstances)));
+
+    for (vector<int>::const_iterator it = instance_counts.begin();
+         it != instance_counts.end(); ++it) {
+        Result result = RunChains(false, *it, kChainLength);
+        PrintResult("Default      ", *it, result);
+        result = RunChains(true, *it, kChainLength);
+        PrintResult("Work stealing", *it, result);
+    }
+}
+
+int main(int argc, char **argv) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    TaskPolicy policy;
+    policy.push_back(TaskExclusion(scheduler->GetTaskId("bench::Chain")));
+    scheduler->SetPolicy(scheduler->GetTaskId("bench::Exclusive"), policy);
+    int result = RUN_ALL_TESTS();
+    task_util::WaitForIdle();
+    scheduler->Terminate();
+    return result;
+}
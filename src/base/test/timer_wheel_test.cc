@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <tbb/atomic.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/task.h"
+#include "base/test/task_test_util.h"
+#include "base/time_util.h"
+#include "base/timer.h"
+#include "base/timer_wheel.h"
+#include "io/test/event_manager_test.h"
+
+#include "testing/gunit.h"
+
+using std::string;
+using std::vector;
+
+class TimerWheelTest : public ::testing::Test {
+protected:
+    static const int kRearmTimerCount = 100 * 1000;
+    static const int kRearmRounds = 10;
+
+    class RearmTask : public Task {
+    public:
+        RearmTask(TimerWheelTest *test, int index, int count)
+            : Task(TaskScheduler::GetInstance()->GetTaskId("timer::Rearm"),
+                   Task::kTaskInstanceAny),
+              test_(test),
+              index_(index),
+              count_(count) {
+        }
+
+        virtual bool Run() {
+            test_->RearmTimers(index_, count_);
+            return true;
+        }
+        string Description() const { return "RearmTask"; }
+
+    private:
+        TimerWheelTest *test_;
+        int index_;
+        int count_;
+    };
+
+    TimerWheelTest() : use_timer_wheel_(Timer::UseTimerWheel()) {
+    }
+
+    virtual void SetUp() {
+        thread_.reset(new ServerThread(&evm_));
+        thread_->Start();
+        fired_ = 0;
+        early_ = 0;
+    }
+
+    virtual void TearDown() {
+        DeleteTimers();
+        task_util::WaitForIdle();
+        evm_.Shutdown();
+        thread_->Join();
+        task_util::WaitForIdle();
+        Timer::SetUseTimerWheel(use_timer_wheel_);
+    }
+
+    void CreateTimers(bool use_timer_wheel, int count) {
+        Timer::SetUseTimerWheel(use_timer_wheel);
+        timers_.reserve(count);
+        for (int idx = 0; idx < count; ++idx) {
+            Timer *timer =
+                TimerManager::CreateTimer(*evm_.io_service(), "Test Timer");
+            EXPECT_EQ(use_timer_wheel, timer->use_timer_wheel());
+            timers_.push_back(timer);
+        }
+    }
+
+    void DeleteTimers() {
+        for (vector<Timer *>::iterator it = timers_.begin();
+             it != timers_.end(); ++it) {
+            TimerManager::DeleteTimer(*it);
+        }
+        timers_.clear();
+    }
+
+    size_t WheelSize() {
+        return boost::asio::use_service<TimerWheel>(*evm_.io_service()).size();
+    }
+
+    bool TimerCallback(uint64_t start, int time) {
+        if (ClockMonotonicUsec() - start < static_cast<uint64_t>(time) * 1000)
+            early_++;
+        fired_++;
+        return false;
+    }
+
+    bool PeriodicTimerCallback(int count) {
+        return ++fired_ < count;
+    }
+
+    void StartTimer(Timer *timer, int time) {
+        timer->Start(time, boost::bind(&TimerWheelTest::TimerCallback, this,
+                                       ClockMonotonicUsec(), time));
+    }
+
+    // Rearm every count'th timer starting at index, like keepalive timers
+    // that get restarted each time a message is sent.
+    void RearmTimers(int index, int count) {
+        for (int round = 0; round < kRearmRounds; ++round) {
+            for (size_t idx = index; idx < timers_.size(); idx += count) {
+                timers_[idx]->Cancel();
+                StartTimer(timers_[idx], 60000 + idx % 1000);
+            }
+        }
+    }
+
+    uint64_t RunRearmTasks(bool use_timer_wheel) {
+        CreateTimers(use_timer_wheel, kRearmTimerCount);
+        TaskScheduler *scheduler = TaskScheduler::GetInstance();
+        int task_count = TaskScheduler::GetThreadCount();
+        uint64_t start = ClockMonotonicUsec();
+        for (int idx = 0; idx < task_count; ++idx) {
+            scheduler->Enqueue(new RearmTask(this, idx, task_count));
+        }
+        task_util::WaitForIdle(600);
+        uint64_t elapsed = ClockMonotonicUsec() - start;
+        DeleteTimers();
+        return elapsed;
+    }
+
+    EventManager evm_;
+    std::auto_ptr<ServerThread> thread_;
+    vector<Timer *> timers_;
+    tbb::atomic<int> fired_;
+    tbb::atomic<int> early_;
+    bool use_timer_wheel_;
+};
+
+//
+// Timers spread over more than one turn of level 0 fire once each, and
+// not before their time.
+//
+TEST_F(TimerWheelTest, Fire) {
+    const int count = 1000;
+    CreateTimers(true, count);
+    for (int idx = 0; idx < count; ++idx) {
+        StartTimer(timers_[idx], (idx * 7) % 1200);
+    }
+    TASK_UTIL_EXPECT_EQ(count, fired_);
+    EXPECT_EQ(0, static_cast<int>(early_));
+    EXPECT_EQ(0, WheelSize());
+    task_util::WaitForIdle();
+    for (int idx = 0; idx < count; ++idx) {
+        EXPECT_FALSE(timers_[idx]->running());
+    }
+}
+
+TEST_F(TimerWheelTest, Cancel) {
+    const int count = 1000;
+    CreateTimers(true, count);
+    for (int idx = 0; idx < count; ++idx) {
+        StartTimer(timers_[idx], 100 + idx % 400);
+    }
+    for (int idx = 0; idx < count; idx += 2) {
+        EXPECT_TRUE(timers_[idx]->Cancel());
+    }
+    EXPECT_EQ(count / 2, WheelSize());
+    TASK_UTIL_EXPECT_EQ(count / 2, fired_);
+    EXPECT_EQ(0, WheelSize());
+    usleep(100000);
+    EXPECT_EQ(count / 2, static_cast<int>(fired_));
+}
+
+TEST_F(TimerWheelTest, Periodic) {
+    CreateTimers(true, 1);
+    timers_[0]->Start(10, boost::bind(&TimerWheelTest::PeriodicTimerCallback,
+                                      this, 20));
+    TASK_UTIL_EXPECT_EQ(20, fired_);
+    task_util::WaitForIdle();
+    EXPECT_FALSE(timers_[0]->running());
+    EXPECT_EQ(0, WheelSize());
+}
+
+TEST_F(TimerWheelTest, ElapsedTime) {
+    CreateTimers(true, 1);
+    StartTimer(timers_[0], 60000);
+    usleep(100000);
+    EXPECT_LE(100, timers_[0]->GetElapsedTime());
+    EXPECT_GT(1000, timers_[0]->GetElapsedTime());
+    EXPECT_TRUE(timers_[0]->Cancel());
+    EXPECT_EQ(0, WheelSize());
+}
+
+//
+// Rearm kRearmTimerCount timers kRearmRounds times from all tbb threads,
+// with an ASIO timer per Timer and with the timer wheel.
+//
+TEST_F(TimerWheelTest, RearmBenchmark) {
+    uint64_t asio_time = RunRearmTasks(false);
+    uint64_t wheel_time = RunRearmTasks(true);
+    std::cout << "Rearmed " << kRearmTimerCount << " timers "
+        << kRearmRounds << " times from "
+        << TaskScheduler::GetThreadCount() << " threads" << std::endl;
+    std::cout << "ASIO timers : " << asio_time << " usec" << std::endl;
+    std::cout << "Timer wheel : " << wheel_time << " usec" << std::endl;
+    EXPECT_EQ(0, WheelSize());
+}
+
+int main(int argc, char **argv) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
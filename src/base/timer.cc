@@ -4,6 +4,9 @@
 
 #include "base/timer.h"
 #include "base/timer_impl.h"
+#include "base/timer_wheel.h"
+
+static bool timer_wheel_enabled = (getenv("TIMER_USE_WHEEL") != NULL);
 
 class Timer::TimerTask : public Task {
 public:
@@ -82,7 +85,11 @@ private:
 
 Timer::Timer(boost::asio::io_service &service, const std::string &name,
           int task_id, int task_instance, bool delete_on_completion)
-        : impl_(new TimerImpl(service)),
+        : impl_(timer_wheel_enabled ? NULL : new TimerImpl(service)),
+          wheel_(timer_wheel_enabled ?
+                 &boost::asio::use_service<TimerWheel>(service) : NULL),
+          wheel_expiry_(0),
+          wheel_seq_no_(0),
           name_(name),
           handler_(NULL),
           error_handler_(NULL),
@@ -100,6 +107,14 @@ Timer::~Timer() {
     assert(state_ != Running && state_ != Fired);
 }
 
+void Timer::SetUseTimerWheel(bool value) {
+    timer_wheel_enabled = value;
+}
+
+bool Timer::UseTimerWheel() {
+    return timer_wheel_enabled;
+}
+
 //
 // Start a timer
 //
@@ -121,6 +136,15 @@ bool Timer::Start(int time, Handler handler, ErrorHandler error_handler) {
     handler_ = handler;
     seq_no_++;
     error_handler_ = error_handler;
+
+    // The wheel holds a reference to the timer until it expires or gets
+    // cancelled, just like the ASIO callback below.
+    if (wheel_) {
+        SetState(Running);
+        wheel_->Add(this, time);
+        return true;
+    }
+
     boost::system::error_code ec;
     impl_->expires_from_now(time, ec);
     if (ec) {
@@ -148,6 +172,8 @@ bool Timer::Reschedule(int time)
 
 // Cancel a running timer
 bool Timer::Cancel() {
+    // Reference taken over from the wheel, released after the mutex.
+    TimerPtr wheel_reference;
     tbb::mutex::scoped_lock lock(mutex_);
 
     // A fired timer cannot be cancelled
@@ -155,6 +181,10 @@ bool Timer::Cancel() {
         return false;
     }
 
+    if (wheel_ && wheel_->Remove(this)) {
+        wheel_reference = TimerPtr(this, false);
+    }
+
     // Cancel Task. If Task cancel succeeds, there will be no callback.
     // Reset TaskRef if call succeeds.
     if (timer_task_) {
@@ -236,6 +266,11 @@ int Timer::GetElapsedTime() const {
     tbb::mutex::scoped_lock lock(mutex_);
     int64_t elapsed;
 
+    if (wheel_) {
+        elapsed = time_ - wheel_->TimeToExpiry(this);
+        return elapsed < 0 ? 0 : elapsed;
+    }
+
 #if BOOST_VERSION >= 104900
     elapsed =
         boost::chrono::nanoseconds(impl_->timer_.expires_from_now()).count();
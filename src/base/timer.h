@@ -32,6 +32,12 @@
 //    Timer class will keep of reference from ASIO and Task. Timer will
 //    be deleted when both the references go away. (via intrusive pointer)
 //
+//  Timer wheel:
+//  - If enabled via SetUseTimerWheel() or the TIMER_USE_WHEEL environment
+//    variable, timers created from then on are kept in the TimerWheel of
+//    the io_service instead of having an ASIO timer each. See
+//    base/timer_wheel.h.
+//
 
 #ifndef TIMER_H_
 #define TIMER_H_
@@ -40,6 +46,7 @@
 
 #include <boost/asio/placeholders.hpp>
 #include <boost/bind.hpp>
+#include <boost/intrusive/list.hpp>
 #include <boost/intrusive_ptr.hpp>
 #include <boost/function.hpp>
 #include <boost/asio.hpp>
@@ -49,6 +56,7 @@
 #include <base/task.h>
 
 class TimerImpl;
+class TimerWheel;
 
 class Timer {
 private:
@@ -126,14 +134,23 @@ public:
     virtual std::string Description() {
         return name_;
     }
+
+    bool use_timer_wheel() const { return wheel_ != NULL; }
+
+    static void SetUseTimerWheel(bool value);
+    static bool UseTimerWheel();
+
 private:
     friend class TimerImpl;
     friend class TimerManager;
     friend class TimerTest;
+    friend class TimerWheel;
 
     friend void intrusive_ptr_add_ref(Timer *timer);
     friend void intrusive_ptr_release(Timer *timer);
     typedef boost::intrusive_ptr<Timer> TimerPtr;
+    typedef boost::intrusive::list_member_hook<
+        boost::intrusive::link_mode<boost::intrusive::auto_unlink> > WheelHook;
 
     enum TimerState {
         Init            = 0,
@@ -160,6 +177,10 @@ private:
     }
 
     std::auto_ptr<TimerImpl> impl_;
+    TimerWheel *wheel_;
+    WheelHook wheel_hook_;
+    uint64_t wheel_expiry_;
+    uint32_t wheel_seq_no_;
     std::string name_;
     Handler handler_;
     ErrorHandler error_handler_;
@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "base/timer_wheel.h"
+
+#include <boost/bind.hpp>
+
+#include "base/time_util.h"
+#include "base/timer_impl.h"
+
+boost::asio::io_service::id TimerWheel::id;
+
+TimerWheel::TimerWheel(boost::asio::io_service &io_service)
+    : boost::asio::io_service::service(io_service),
+      timer_impl_(new TimerImpl(io_service)),
+      current_tick_(CurrentTick()),
+      armed_tick_(0),
+      size_(0) {
+}
+
+TimerWheel::~TimerWheel() {
+    assert(size_ == 0);
+}
+
+//
+// Called when the io_service is destroyed. Release the references to the
+// timers that are still linked, the same way asio releases the handlers
+// of pending waits.
+//
+void TimerWheel::shutdown_service() {
+    std::vector<Timer *> timers;
+    {
+        tbb::mutex::scoped_lock lock(mutex_);
+        for (int level = 0; level < kLevels; ++level) {
+            for (int idx = 0; idx < kSlots; ++idx) {
+                Slot &slot = slots_[level][idx];
+                while (!slot.empty()) {
+                    timers.push_back(&slot.front());
+                    slot.pop_front();
+                }
+            }
+        }
+        size_ = 0;
+        timer_impl_.reset();
+    }
+
+    for (std::vector<Timer *>::iterator it = timers.begin();
+         it != timers.end(); ++it) {
+        intrusive_ptr_release(*it);
+    }
+}
+
+uint64_t TimerWheel::CurrentTick() {
+    return ClockMonotonicUsec() / (kTickMsec * 1000);
+}
+
+size_t TimerWheel::size() const {
+    tbb::mutex::scoped_lock lock(mutex_);
+    return size_;
+}
+
+//
+// Link the timer into the slot for its expiry tick, relative to the current
+// tick of the wheel. Expiry ticks beyond the range of the top level go in
+// the furthest slot of the top level and get cascaded down from there.
+//
+void TimerWheel::Insert(Timer *timer) {
+    uint64_t expiry = timer->wheel_expiry_;
+    uint64_t delta = expiry - current_tick_;
+    int level = 0;
+    while (level < kLevels - 1 &&
+           delta >= (static_cast<uint64_t>(1) << ((level + 1) * kSlotBits))) {
+        level++;
+    }
+    if (delta >= (static_cast<uint64_t>(1) << (kLevels * kSlotBits))) {
+        expiry = current_tick_ +
+            (static_cast<uint64_t>(1) << (kLevels * kSlotBits)) - 1;
+    }
+    int idx = (expiry >> (level * kSlotBits)) & (kSlots - 1);
+    slots_[level][idx].push_back(*timer);
+}
+
+//
+// Move the timers in the slot of the given level that covers the tick down
+// to the lower levels.
+//
+void TimerWheel::Cascade(int level, uint64_t tick) {
+    int idx = (tick >> (level * kSlotBits)) & (kSlots - 1);
+    Slot &slot = slots_[level][idx];
+    while (!slot.empty()) {
+        Timer *timer = &slot.front();
+        slot.pop_front();
+        Insert(timer);
+    }
+}
+
+//
+// Process all ticks up to and including now. Timers that expire are moved
+// to expired_ along with the reference held by the wheel.
+//
+void TimerWheel::Advance(uint64_t now) {
+    while (current_tick_ < now) {
+        if (size_ == 0) {
+            current_tick_ = now;
+            break;
+        }
+
+        uint64_t tick = ++current_tick_;
+        for (int level = 1; level < kLevels; ++level) {
+            if ((tick & ((static_cast<uint64_t>(1) << (level * kSlotBits)) - 1))
+                != 0) {
+                break;
+            }
+            Cascade(level, tick);
+        }
+
+        Slot &slot = slots_[0][tick & (kSlots - 1)];
+        while (!slot.empty()) {
+            Timer *timer = &slot.front();
+            slot.pop_front();
+            size_--;
+            expired_.push_back(ExpiredTimer(timer, timer->wheel_seq_no_));
+        }
+    }
+}
+
+//
+// Tick at which the wheel needs to run next. That's the first non-empty
+// slot of level 0, or the tick at which level 0 wraps around if timers in
+// the higher levels need to be cascaded before that.
+//
+uint64_t TimerWheel::NextTick() const {
+    if (size_ == 0)
+        return 0;
+    uint64_t wrap = (current_tick_ | (kSlots - 1)) + 1;
+    for (uint64_t tick = current_tick_ + 1; tick < wrap; ++tick) {
+        if (!slots_[0][tick & (kSlots - 1)].empty())
+            return tick;
+    }
+    return wrap;
+}
+
+//
+// Arm the asio timer to run the wheel at the given tick, unless it's
+// already armed to run at or before that tick.
+//
+void TimerWheel::Arm(uint64_t tick) {
+    if (tick == 0 || !timer_impl_.get())
+        return;
+    if (armed_tick_ != 0 && armed_tick_ <= tick)
+        return;
+
+    uint64_t now = ClockMonotonicUsec();
+    uint64_t expiry = tick * kTickMsec * 1000;
+    int time = expiry > now ? (expiry - now + 999) / 1000 : 0;
+    boost::system::error_code ec;
+    timer_impl_->expires_from_now(time, ec);
+    if (ec)
+        return;
+    armed_tick_ = tick;
+    timer_impl_->async_wait(
+        boost::bind(&TimerWheel::OnExpiry, this,
+                    boost::asio::placeholders::error));
+}
+
+void TimerWheel::Add(Timer *timer, int time) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    if (size_ == 0)
+        current_tick_ = CurrentTick();
+
+    // Round up so that the timer doesn't fire early.
+    uint64_t expiry = ClockMonotonicUsec() + time * 1000;
+    uint64_t tick = (expiry + kTickMsec * 1000 - 1) / (kTickMsec * 1000);
+    if (tick <= current_tick_)
+        tick = current_tick_ + 1;
+
+    intrusive_ptr_add_ref(timer);
+    timer->wheel_expiry_ = tick;
+    timer->wheel_seq_no_ = timer->seq_no_;
+    Insert(timer);
+    size_++;
+    Arm(NextTick());
+}
+
+bool TimerWheel::Remove(Timer *timer) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    if (!timer->wheel_hook_.is_linked())
+        return false;
+    timer->wheel_hook_.unlink();
+    size_--;
+    return true;
+}
+
+int TimerWheel::TimeToExpiry(const Timer *timer) const {
+    uint64_t now = ClockMonotonicUsec();
+    uint64_t expiry = timer->wheel_expiry_ * kTickMsec * 1000;
+    if (expiry <= now)
+        return 0;
+    return (expiry - now) / 1000;
+}
+
+void TimerWheel::OnExpiry(const boost::system::error_code &ec) {
+    if (ec == boost::asio::error::operation_aborted)
+        return;
+
+    {
+        tbb::mutex::scoped_lock lock(mutex_);
+        armed_tick_ = 0;
+        Advance(CurrentTick());
+        Arm(NextTick());
+    }
+
+    // The wheel mutex is not held here since firing the timer takes the
+    // Timer mutex. Only the io_service thread touches expired_.
+    for (std::vector<ExpiredTimer>::iterator it = expired_.begin();
+         it != expired_.end(); ++it) {
+        Timer *timer = it->timer;
+        timer->StartTimerTask(Timer::TimerPtr(timer, false), timer->time_,
+                              it->seq_no, boost::system::error_code());
+    }
+    expired_.clear();
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+//
+// Hierarchical timing wheel backend for Timer.
+//
+// Timers that use the wheel are not registered with the asio timer queue
+// individually. Instead, each io_service has one TimerWheel, which is an
+// asio service and runs a single asio timer for the earliest slot that has
+// timers. Starting or cancelling a Timer links or unlinks it in a slot of
+// the wheel in constant time, without any memory allocation.
+//
+// The wheel has kLevels levels of kSlots slots each. The resolution is one
+// tick of kTickMsec. Timers that expire in less than kSlots ticks are kept
+// in a slot of level 0. Timers that expire later are kept in the higher
+// levels and are cascaded down a level each time the lower level wraps
+// around. Timers never fire early, but may fire up to one tick late.
+//
+// The wheel holds a reference to each Timer that is linked in it. Expired
+// timers are fired via Timer::StartTimerTask, same as asio timer expiry.
+//
+// Concurrency aspects:
+// - All wheel state is protected by mutex_.
+// - Timer calls into the wheel with the Timer mutex held. The wheel never
+//   takes the Timer mutex while holding its own mutex.
+// - Expired timers are fired from the io_service thread without holding the
+//   wheel mutex. This assumes that a single thread runs the io_service, as
+//   enforced by EventManager.
+//
+
+#ifndef SRC_BASE_TIMER_WHEEL_H_
+#define SRC_BASE_TIMER_WHEEL_H_
+
+#include <boost/asio/io_service.hpp>
+#include <boost/intrusive/list.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/version.hpp>
+#include <tbb/mutex.h>
+
+#include <vector>
+
+#include "base/timer.h"
+
+class TimerImpl;
+
+class TimerWheel : public boost::asio::io_service::service {
+public:
+    static const int kTickMsec = 1;
+    static const int kSlotBits = 8;
+    static const int kSlots = 1 << kSlotBits;
+    static const int kLevels = 4;
+
+    static boost::asio::io_service::id id;
+
+    explicit TimerWheel(boost::asio::io_service &io_service);
+    virtual ~TimerWheel();
+
+    // Link the timer to expire after time msec. Takes a reference on the
+    // timer which is released when the timer expires or is removed.
+    void Add(Timer *timer, int time);
+
+    // Unlink the timer if it's waiting to expire. Returns true if the timer
+    // was unlinked, in which case the reference held by the wheel is handed
+    // over to the caller.
+    bool Remove(Timer *timer);
+
+    // Number of msec before the timer expires.
+    int TimeToExpiry(const Timer *timer) const;
+
+    size_t size() const;
+
+private:
+    typedef boost::intrusive::member_hook<Timer, Timer::WheelHook,
+        &Timer::wheel_hook_> SlotMember;
+    typedef boost::intrusive::list<Timer, SlotMember,
+        boost::intrusive::constant_time_size<false> > Slot;
+
+    struct ExpiredTimer {
+        ExpiredTimer(Timer *timer, uint32_t seq_no)
+            : timer(timer), seq_no(seq_no) {
+        }
+        Timer *timer;
+        uint32_t seq_no;
+    };
+
+    virtual void shutdown_service();
+#if BOOST_VERSION >= 106600
+    virtual void shutdown() { shutdown_service(); }
+#endif
+
+    static uint64_t CurrentTick();
+    void Insert(Timer *timer);
+    void Cascade(int level, uint64_t tick);
+    void Advance(uint64_t now);
+    uint64_t NextTick() const;
+    void Arm(uint64_t tick);
+    void OnExpiry(const boost::system::error_code &ec);
+
+    mutable tbb::mutex mutex_;
+    boost::scoped_ptr<TimerImpl> timer_impl_;
+    Slot slots_[kLevels][kSlots];
+    uint64_t current_tick_;
+    uint64_t armed_tick_;
+    size_t size_;
+    std::vector<ExpiredTimer> expired_;
+
+    DISALLOW_COPY_AND_ASSIGN(TimerWheel);
+};
+
+#endif  // SRC_BASE_TIMER_WHEEL_H_
@@ -7,7 +7,9 @@
 
 #include <boost/functional/hash.hpp>
 #include <boost/scoped_array.hpp>
+#include <tbb/atomic.h>
 #include <tbb/mutex.h>
+#include <tbb/spin_rw_mutex.h>
 
 #include <set>
 #include <string>
@@ -104,12 +106,38 @@ struct BgpProtoPrefix : public ParseObject {
     uint8_t type;
 };
 
+//
+// Statistics for a BgpPathAttributeDB, summed over all partitions.
+//
+// A hit is a Locate that found a live entry with the same contents and a
+// miss is a Locate that inserted a new entry. Contentions counts the number
+// of times a partition lock could not be acquired without waiting.
+//
+struct BgpPathAttributeDBStats {
+    BgpPathAttributeDBStats()
+        : partitions(0), size(0), hits(0), misses(0), contentions(0) {
+    }
+
+    uint32_t partitions;
+    uint64_t size;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t contentions;
+};
+
 //
 // Base class to manage BGP Path Attributes database. This class provides
 // thread safe access to the data base.
 //
+// The data base is split into partitions based on a hash of the attribute
+// contents, each protected by its own reader-writer lock. Lookups that find
+// an existing entry, which is by far the common case, only need the lock in
+// shared mode and hence proceed in parallel. The lock is taken in exclusive
+// mode to insert a new entry and to remove an entry whose last reference is
+// gone.
+//
 // Lock contention can be tuned by varying the hash table size passed to the
-// constructor.
+// constructor, or via BGP_PATH_ATTRIBUTE_DB_HASH_SIZE.
 //
 // Attribute contents must be hashable via hash_value() and hashed using
 // boost::hash_combine() to partition the attribute database.
@@ -119,26 +147,38 @@ template <class Type, class TypePtr, class TypeSpec, typename TypeCompare,
 class BgpPathAttributeDB {
 public:
     explicit BgpPathAttributeDB(int hash_size = GetHashSize())
-        : hash_size_(hash_size),
-          set_(new Set[hash_size]),
-          mutex_(new tbb::mutex[hash_size]) {
+        : hash_size_(hash_size > 0 ? hash_size : 1),
+          partitions_(new Partition[hash_size_]) {
     }
 
     size_t Size() {
         size_t size = 0;
 
         for (size_t i = 0; i < hash_size_; i++) {
-            tbb::mutex::scoped_lock lock(mutex_[i]);
-            size += set_[i].size();
+            Mutex::scoped_lock lock(partitions_[i].mutex, false);
+            size += partitions_[i].set.size();
         }
         return size;
     }
 
+    void GetStats(BgpPathAttributeDBStats *stats) {
+        stats->partitions = hash_size_;
+        for (size_t i = 0; i < hash_size_; i++) {
+            Partition &partition = partitions_[i];
+            Mutex::scoped_lock lock(partition.mutex, false);
+            stats->size += partition.set.size();
+            stats->hits += partition.hits;
+            stats->misses += partition.misses;
+            stats->contentions += partition.contentions;
+        }
+    }
+
     void Delete(Type *attr) {
-        size_t hash = HashCompute(attr);
+        Partition &partition = partitions_[HashCompute(attr)];
 
-        tbb::mutex::scoped_lock lock(mutex_[hash]);
-        set_[hash].erase(attr);
+        Mutex::scoped_lock lock;
+        AcquireLock(&partition, &lock, true);
+        partition.set.erase(attr);
     }
 
     // Locate passed in attribute in the data base based on the attr ptr.
@@ -153,6 +193,28 @@ public:
     }
 
 private:
+    static const size_t kDefaultHashSize = 32;
+
+    typedef tbb::spin_rw_mutex Mutex;
+    typedef std::set<Type *, TypeCompare> Set;
+
+    struct Partition {
+        Partition() {
+            hits = 0;
+            misses = 0;
+            contentions = 0;
+        }
+
+        Mutex mutex;
+        Set set;
+        tbb::atomic<uint64_t> hits;
+        tbb::atomic<uint64_t> misses;
+        tbb::atomic<uint64_t> contentions;
+
+        // Keep the locks of adjacent partitions on different cache lines.
+        char padding[64];
+    };
+
     const size_t HashCompute(Type *attr) const {
         if (hash_size_ <= 1) return 0;
 
@@ -164,11 +226,44 @@ private:
     static size_t GetHashSize() {
         char *str = getenv("BGP_PATH_ATTRIBUTE_DB_HASH_SIZE");
 
-        // Use just one bucket for now.
-        if (!str) return 1;
+        if (!str) return kDefaultHashSize;
         return strtoul(str, NULL, 0);
     }
 
+    static void AcquireLock(Partition *partition, Mutex::scoped_lock *lock,
+        bool write) {
+        if (lock->try_acquire(partition->mutex, write))
+            return;
+        partition->contentions++;
+        lock->acquire(partition->mutex, write);
+    }
+
+    // Find an existing entry with the same contents as the passed attribute
+    // while holding the partition lock in shared mode. Entries can only be
+    // removed from the set with the lock held in exclusive mode, so the entry
+    // cannot go away while the shared lock is held.
+    //
+    // Returns NULL if there's no live entry, in which case the caller needs
+    // to insert the passed attribute.
+    Type *Find(Partition *partition, Type *attr) {
+        Mutex::scoped_lock lock;
+        AcquireLock(partition, &lock, false);
+
+        typename Set::iterator it = partition->set.find(attr);
+        if (it == partition->set.end())
+            return NULL;
+
+        // Take a reference to prevent this entry from getting deleted. If the
+        // previous refcount is 0, the entry is about to get deleted, so treat
+        // it as not found.
+        Type *entry = *it;
+        int prev = intrusive_ptr_add_ref(entry);
+        if (prev > 0)
+            return entry;
+        intrusive_ptr_del_ref(entry);
+        return NULL;
+    }
+
     // This template safely retrieves an attribute entry from its data base.
     // If the entry is not found, it is inserted into the database.
     //
@@ -176,14 +271,29 @@ private:
     // existing entry is returned.
     TypePtr LocateInternal(Type *attr) {
         // Hash attribute contents to to avoid potential mutex contention.
-        size_t hash = HashCompute(attr);
+        Partition &partition = partitions_[HashCompute(attr)];
+
+        // Fast path for an entry that is already present.
+        Type *entry = Find(&partition, attr);
+        if (entry) {
+            partition.hits++;
+            delete attr;
+
+            // Take intrusive pointer, thereby incrementing the refcount and
+            // release the refcount taken in Find.
+            TypePtr ptr = TypePtr(entry);
+            intrusive_ptr_del_ref(entry);
+            return ptr;
+        }
+
         while (true) {
             // Grab mutex to keep db access thread safe.
-            tbb::mutex::scoped_lock lock(mutex_[hash]);
+            Mutex::scoped_lock lock;
+            AcquireLock(&partition, &lock, true);
             std::pair<typename Set::iterator, bool> ret;
 
             // Try to insert the passed entry into the database.
-            ret = set_[hash].insert(attr);
+            ret = partition.set.insert(attr);
 
             // Take a reference to prevent this entry from getting deleted.
             // Counter is automatically incremented, hence we get thread safety
@@ -192,6 +302,8 @@ private:
 
             // Check if passed in entry did get into the data base.
             if (ret.second) {
+                partition.misses++;
+
                 // Take intrusive pointer, thereby incrementing the refcount.
                 TypePtr ptr = TypePtr(*ret.first);
 
@@ -210,6 +322,8 @@ private:
             // cases, we retry inserting the passed attribute pointer into the
             // data base.
             if (prev > 0) {
+                partition.hits++;
+
                 // Free passed in attribute, as it is already in the database.
                 delete attr;
 
@@ -232,10 +346,8 @@ private:
         return NULL;
     }
 
-    typedef std::set<Type *, TypeCompare> Set;
     size_t hash_size_;
-    boost::scoped_array<Set> set_;
-    boost::scoped_array<tbb::mutex> mutex_;
+    boost::scoped_array<Partition> partitions_;
 };
 
 #endif  // SRC_BGP_BGP_ATTR_BASE_H_
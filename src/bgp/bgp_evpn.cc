@@ -164,7 +164,7 @@ void EvpnLocalMcastNode::AddInclusiveMulticastRoute() {
     // Build the RD using the TOR IP address, not the TOR agent IP address.
     // This ensures that the MAC broadcast route from the primary and backup
     // TOR Agents results in the same Inclusive Multicast prefix.
-    const EvpnPrefix &mac_prefix = route_->GetPrefix();
+    const EvpnPackedPrefix &mac_prefix = route_->GetPackedPrefix();
     RouteDistinguisher rd(
         address_.to_ulong(), mac_prefix.route_distinguisher().GetVrfId());
     EvpnPrefix prefix(rd, mac_prefix.tag(), address_);
@@ -197,7 +197,7 @@ void EvpnLocalMcastNode::DeleteInclusiveMulticastRoute() {
     if (!inclusive_mcast_route_)
         return;
 
-    const EvpnPrefix &mac_prefix = route_->GetPrefix();
+    const EvpnPackedPrefix &mac_prefix = route_->GetPackedPrefix();
     uint32_t path_id = mac_prefix.route_distinguisher().GetAddress();
     DBTablePartition *tbl_partition = partition_->GetTablePartition();
     inclusive_mcast_route_->RemovePath(BgpPath::Local, path_id);
@@ -242,12 +242,12 @@ UpdateInfo *EvpnLocalMcastNode::GetUpdateInfo() {
 
     const RoutingInstance *rti = partition_->table()->routing_instance();
     bool pbb_evpn_enable = rti->virtual_network_pbb_evpn_enable();
-    uint32_t local_ethernet_tag = route_->GetPrefix().tag();
+    uint32_t local_ethernet_tag = route_->GetPackedPrefix().tag();
 
     // Go through list of EvpnRemoteMcastNodes and build the BgpOList.
     BgpOListSpec olist_spec(BgpAttribute::OList);
     BOOST_FOREACH(EvpnMcastNode *node, partition_->remote_mcast_node_list()) {
-        uint32_t remote_ethernet_tag = node->route()->GetPrefix().tag();
+        uint32_t remote_ethernet_tag = node->route()->GetPackedPrefix().tag();
 
         if (node->address() == address_)
             continue;
@@ -578,7 +578,8 @@ void EvpnManager::RouteListener(DBTablePartBase *tpart, DBEntryBase *db_entry) {
 
         // Create a new EvpnMcastNode and associate it with the route.
         EvpnMcastNode *node;
-        if (route->GetPrefix().type() == EvpnPrefix::MacAdvertisementRoute) {
+        if (route->GetPackedPrefix().type() ==
+            EvpnPrefix::MacAdvertisementRoute) {
             node = new EvpnLocalMcastNode(partition, route);
         } else {
             node = new EvpnRemoteMcastNode(partition, route);
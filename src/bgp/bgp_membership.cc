@@ -108,6 +108,61 @@ void BgpMembershipManager::Register(IPeer *peer, BgpTable *table,
         "bgp::StateMachine", "xmpp::StateMachine");
 
     tbb::spin_rw_mutex::scoped_lock write_lock(rw_mutex_, true);
+    EnqueueEvent(RegisterUnlocked(peer, table, policy, instance_id));
+}
+
+//
+// Register the IPeer to all BgpTables in the list.
+// Post a single REGISTER_RIB_LIST event so that all the RibOuts are joined
+// before any of the BgpTables get walked.
+//
+void BgpMembershipManager::RegisterTableList(IPeer *peer,
+    const TableList &table_list, const RibExportPolicy &policy,
+    int instance_id) {
+    CHECK_CONCURRENCY("bgp::Config", "bgp::ConfigHelper",
+        "bgp::StateMachine", "xmpp::StateMachine");
+
+    if (table_list.empty())
+        return;
+
+    tbb::spin_rw_mutex::scoped_lock write_lock(rw_mutex_, true);
+    Event *event = new Event(REGISTER_RIB_LIST);
+    BOOST_FOREACH(BgpTable *table, table_list) {
+        event->event_list.push_back(
+            RegisterUnlocked(peer, table, policy, instance_id));
+    }
+    EnqueueEvent(event);
+}
+
+//
+// Register all IPeers in the list to the BgpTable.
+// Post a single REGISTER_RIB_LIST event so that the BgpTable gets walked
+// once for all the IPeers.
+//
+void BgpMembershipManager::RegisterPeerList(const PeerList &peer_list,
+    BgpTable *table, const RibExportPolicy &policy, int instance_id) {
+    CHECK_CONCURRENCY("bgp::Config", "bgp::ConfigHelper",
+        "bgp::StateMachine", "xmpp::StateMachine");
+
+    if (peer_list.empty())
+        return;
+
+    tbb::spin_rw_mutex::scoped_lock write_lock(rw_mutex_, true);
+    Event *event = new Event(REGISTER_RIB_LIST);
+    BOOST_FOREACH(IPeer *peer, peer_list) {
+        event->event_list.push_back(
+            RegisterUnlocked(peer, table, policy, instance_id));
+    }
+    EnqueueEvent(event);
+}
+
+//
+// Common routine to handle register of IPeer to BgpTable.
+// Returns the REGISTER_RIB event that needs to be processed.
+//
+BgpMembershipManager::Event *BgpMembershipManager::RegisterUnlocked(
+    IPeer *peer, BgpTable *table, const RibExportPolicy &policy,
+    int instance_id) {
     current_jobs_count_++;
     total_jobs_count_++;
     PeerRibState *prs = LocatePeerRibState(peer, table);
@@ -115,8 +170,7 @@ void BgpMembershipManager::Register(IPeer *peer, BgpTable *table,
     assert(!prs->ribout_registered());
     prs->set_ribin_registered(true);
     prs->set_action(RIBOUT_ADD);
-    Event *event = new Event(REGISTER_RIB, peer, table, policy, instance_id);
-    EnqueueEvent(event);
+    return new Event(REGISTER_RIB, peer, table, policy, instance_id);
 }
 
 //
@@ -142,6 +196,64 @@ void BgpMembershipManager::Unregister(IPeer *peer, BgpTable *table) {
     CHECK_CONCURRENCY("bgp::Config", "bgp::StateMachine", "xmpp::StateMachine");
 
     tbb::spin_rw_mutex::scoped_lock write_lock(rw_mutex_, true);
+    Event *event = UnregisterUnlocked(peer, table);
+    if (event)
+        EnqueueEvent(event);
+}
+
+//
+// Unregister the IPeer from all BgpTables in the list.
+// Post a single UNREGISTER_RIB_LIST event so that all the RibOuts are left
+// before any of the BgpTables get walked.
+//
+void BgpMembershipManager::UnregisterTableList(IPeer *peer,
+    const TableList &table_list) {
+    CHECK_CONCURRENCY("bgp::Config", "bgp::StateMachine", "xmpp::StateMachine");
+
+    tbb::spin_rw_mutex::scoped_lock write_lock(rw_mutex_, true);
+    Event *event = new Event(UNREGISTER_RIB_LIST);
+    BOOST_FOREACH(BgpTable *table, table_list) {
+        Event *table_event = UnregisterUnlocked(peer, table);
+        if (table_event)
+            event->event_list.push_back(table_event);
+    }
+    if (event->event_list.empty()) {
+        delete event;
+        return;
+    }
+    EnqueueEvent(event);
+}
+
+//
+// Unregister all IPeers in the list from the BgpTable.
+// Post a single UNREGISTER_RIB_LIST event so that the BgpTable gets walked
+// once for all the IPeers.
+//
+void BgpMembershipManager::UnregisterPeerList(const PeerList &peer_list,
+    BgpTable *table) {
+    CHECK_CONCURRENCY("bgp::Config", "bgp::StateMachine", "xmpp::StateMachine");
+
+    tbb::spin_rw_mutex::scoped_lock write_lock(rw_mutex_, true);
+    Event *event = new Event(UNREGISTER_RIB_LIST);
+    BOOST_FOREACH(IPeer *peer, peer_list) {
+        Event *peer_event = UnregisterUnlocked(peer, table);
+        if (peer_event)
+            event->event_list.push_back(peer_event);
+    }
+    if (event->event_list.empty()) {
+        delete event;
+        return;
+    }
+    EnqueueEvent(event);
+}
+
+//
+// Common routine to handle unregister of IPeer from BgpTable.
+// Returns the UNREGISTER_RIB event that needs to be processed, or NULL if
+// the IPeer is only registered for RIBIN.
+//
+BgpMembershipManager::Event *BgpMembershipManager::UnregisterUnlocked(
+    IPeer *peer, BgpTable *table) {
     current_jobs_count_++;
     total_jobs_count_++;
     PeerRibState *prs = FindPeerRibState(peer, table);
@@ -150,15 +262,14 @@ void BgpMembershipManager::Unregister(IPeer *peer, BgpTable *table) {
 
     if (!prs->ribout_registered()) {
         UnregisterRibInUnlocked(prs);
-        return;
+        return NULL;
     }
 
     prs->set_action(RIBIN_DELETE_RIBOUT_DELETE);
     prs->set_ribin_registered(false);
     prs->set_instance_id(-1);
     prs->set_subscription_gen_id(0);
-    Event *event = new Event(UNREGISTER_RIB, peer, table);
-    EnqueueEvent(event);
+    return new Event(UNREGISTER_RIB, peer, table);
 }
 
 //
@@ -664,6 +775,26 @@ void BgpMembershipManager::ProcessWalkRibCompleteEvent(Event *event) {
     current_jobs_count_--;
 }
 
+//
+// Process REGISTER_RIB_LIST event.
+// All RibOuts are joined before returning, so the Walker sees all pending
+// PeerRibStates for a given RibState when it starts the table walk.
+//
+void BgpMembershipManager::ProcessRegisterRibListEvent(Event *event) {
+    BOOST_FOREACH(Event *rib_event, event->event_list) {
+        ProcessRegisterRibEvent(rib_event);
+    }
+}
+
+//
+// Process UNREGISTER_RIB_LIST event.
+//
+void BgpMembershipManager::ProcessUnregisterRibListEvent(Event *event) {
+    BOOST_FOREACH(Event *rib_event, event->event_list) {
+        ProcessUnregisterRibEvent(rib_event);
+    }
+}
+
 //
 // Internal handler for an Event.
 // Exists so that test code can override it.
@@ -685,6 +816,12 @@ bool BgpMembershipManager::EventCallbackInternal(Event *event) {
     case WALK_RIB_COMPLETE:
         ProcessWalkRibCompleteEvent(event);
         break;
+    case REGISTER_RIB_LIST:
+        ProcessRegisterRibListEvent(event);
+        break;
+    case UNREGISTER_RIB_LIST:
+        ProcessUnregisterRibListEvent(event);
+        break;
     default:
         assert(false);
         break;
@@ -725,6 +862,23 @@ BgpMembershipManager::Event::Event(EventType event_type, IPeer *peer,
       instance_id(instance_id) {
 }
 
+//
+// Constructor for REGISTER_RIB_LIST and UNREGISTER_RIB_LIST events.
+//
+BgpMembershipManager::Event::Event(EventType event_type)
+    : event_type(event_type),
+      peer(NULL),
+      table(NULL),
+      instance_id(-1) {
+}
+
+//
+// Destructor.
+//
+BgpMembershipManager::Event::~Event() {
+    STLDeleteValues(&event_list);
+}
+
 //
 // Constructor.
 //`
@@ -1005,6 +1159,54 @@ void BgpMembershipManager::PeerRibState::FillMembershipInfo(
     smpi->set_generation_id(subscription_gen_id_);
 }
 
+//
+// The maximum number of concurrent table walks can be set via the environment
+// for now.
+//
+static int GetMaxConcurrentWalks(int default_walks, int max_walks) {
+    char *walks_str = getenv("BGP_MEMBERSHIP_WALK_CONCURRENCY");
+    if (!walks_str)
+        return default_walks;
+    int walks = strtol(walks_str, NULL, 0);
+    if (walks < 1)
+        return 1;
+    return (walks > max_walks ? max_walks : walks);
+}
+
+//
+// Constructor.
+//
+BgpMembershipManager::Walker::TableWalk::TableWalk(RibState *rs)
+    : rs(rs),
+      walk_completed(false),
+      ribout_state_list_size(0) {
+}
+
+//
+// Destructor.
+//
+BgpMembershipManager::Walker::TableWalk::~TableWalk() {
+    assert(walk_ref == NULL);
+    assert(ribout_state_map.empty());
+}
+
+//
+// Find or create the RibOutState for given RibOut.
+//
+BgpMembershipManager::Walker::RibOutState *
+BgpMembershipManager::Walker::TableWalk::LocateRibOutState(RibOut *ribout) {
+    RibOutStateMap::iterator loc = ribout_state_map.find(ribout);
+    if (loc == ribout_state_map.end()) {
+        RibOutState *ros = new RibOutState(ribout);
+        ribout_state_map.insert(make_pair(ribout, ros));
+        ribout_state_list.push_back(ros);
+        ribout_state_list_size++;
+        return ros;
+    } else {
+        return loc->second;
+    }
+}
+
 //
 // Constructor.
 //
@@ -1013,12 +1215,10 @@ BgpMembershipManager::Walker::Walker(BgpMembershipManager *manager)
       trigger_(new TaskTrigger(
           boost::bind(&BgpMembershipManager::Walker::WalkTrigger, this),
           TaskScheduler::GetInstance()->GetTaskId("bgp::PeerMembership"), 0)),
+      max_concurrent_walks_(GetMaxConcurrentWalks(kDefaultConcurrentWalks,
+          kMaxConcurrentWalks)),
       postpone_walk_(false),
-      walk_started_(false),
-      walk_completed_(false),
-      rs_(NULL),
-      rib_state_list_size_(0),
-      ribout_state_list_size_(0) {
+      rib_state_list_size_(0) {
 }
 
 //
@@ -1028,17 +1228,12 @@ BgpMembershipManager::Walker::~Walker() {
     assert(rib_state_set_.empty());
     assert(rib_state_list_.empty());
     assert(!postpone_walk_);
-    assert(!rs_);
-    assert(walk_ref_ == NULL);
-    assert(peer_rib_list_.empty());
-    assert(peer_list_.empty());
-    assert(ribout_state_map_.empty());
-    assert(ribout_state_list_.empty());
+    assert(walk_map_.empty());
 }
 
 //
 // Add the given RibState to the RibStateList if it's not already present.
-// Trigger processing of the RibStateList if a walk is not already in progress.
+// Trigger processing of the RibStateList if there's room for another walk.
 //
 void BgpMembershipManager::Walker::Enqueue(RibState *rs) {
     if (rib_state_set_.find(rs) != rib_state_set_.end())
@@ -1046,7 +1241,7 @@ void BgpMembershipManager::Walker::Enqueue(RibState *rs) {
     rib_state_set_.insert(rs);
     rib_state_list_.push_back(rs);
     rib_state_list_size_++;
-    if (!walk_started_)
+    if (walk_map_.size() < max_concurrent_walks_)
         trigger_->Set();
 }
 
@@ -1054,36 +1249,19 @@ void BgpMembershipManager::Walker::Enqueue(RibState *rs) {
 // Return true if the Walk does not have any pending items.
 //
 bool BgpMembershipManager::Walker::IsQueueEmpty() const {
-    return (rib_state_list_.empty() && !trigger_->IsSet() && !rs_);
-}
-
-//
-// Find or create the RibOutState for given RibOut.
-//
-BgpMembershipManager::Walker::RibOutState *
-BgpMembershipManager::Walker::LocateRibOutState(RibOut *ribout) {
-    RibOutStateMap::iterator loc = ribout_state_map_.find(ribout);
-    if (loc == ribout_state_map_.end()) {
-        RibOutState *ros = new RibOutState(ribout);
-        ribout_state_map_.insert(make_pair(ribout, ros));
-        ribout_state_list_.push_back(ros);
-        ribout_state_list_size_++;
-        return ros;
-    } else {
-        return loc->second;
-    }
+    return (rib_state_list_.empty() && !trigger_->IsSet() && walk_map_.empty());
 }
 
 //
 // Process table walk callback from DB infrastructure.
 //
-bool BgpMembershipManager::Walker::WalkCallback(DBTablePartBase *tpart,
-    DBEntryBase *db_entry) {
+bool BgpMembershipManager::Walker::WalkCallback(TableWalk *walk,
+    DBTablePartBase *tpart, DBEntryBase *db_entry) {
     CHECK_CONCURRENCY("db::DBTable");
 
     // Walk all RibOutStates and handle join/leave processing.
-    for (RibOutStateList::iterator it = ribout_state_list_.begin();
-         it != ribout_state_list_.end(); ++it) {
+    for (RibOutStateList::iterator it = walk->ribout_state_list.begin();
+         it != walk->ribout_state_list.end(); ++it) {
         RibOutState *ros = *it;
         RibOut *ribout = ros->ribout();
         ribout->bgp_export()->Join(tpart, ros->join_bitset(), db_entry);
@@ -1091,7 +1269,8 @@ bool BgpMembershipManager::Walker::WalkCallback(DBTablePartBase *tpart,
     }
 
     // Bail if there's no peers that need RibIn processing.
-    if (peer_list_.empty())
+    const PeerList &peer_list = walk->peer_list;
+    if (peer_list.empty())
         return true;
 
     // Walk through all eligible paths and notify the source peer if needed.
@@ -1113,13 +1292,13 @@ bool BgpMembershipManager::Walker::WalkCallback(DBTablePartBase *tpart,
             continue;
 
         // Skip if there's no walk requested for this IPeer.
-        if (!peer || peer_list_.find(peer) == peer_list_.end())
+        if (!peer || peer_list.find(peer) == peer_list.end())
             continue;
 
         notify |= peer->MembershipPathCallback(tpart, route, path);
     }
 
-    rs_->table()->InputCommonPostProcess(tpart, route, notify);
+    walk->rs->table()->InputCommonPostProcess(tpart, route, notify);
     return true;
 }
 
@@ -1128,64 +1307,64 @@ bool BgpMembershipManager::Walker::WalkCallback(DBTablePartBase *tpart,
 // Just note that the walk has completed and trigger processing from the
 // bgp::PeerMembership task.
 //
-void BgpMembershipManager::Walker::WalkDoneCallback(DBTableBase *table_base) {
+void BgpMembershipManager::Walker::WalkDoneCallback(TableWalk *walk,
+    DBTableBase *table_base) {
     CHECK_CONCURRENCY("db::Walker");
-    assert(rs_->table() == table_base);
-    walk_completed_ = true;
+    assert(walk->rs->table() == table_base);
+    walk->walk_completed = true;
     trigger_->Set();
 }
 
 //
-// Start a walk for the BgpTable corresponding to the next RibState in the
-// RibStateList.
+// Start a walk for the BgpTable corresponding to the first RibState in the
+// RibStateList that doesn't already have a walk in progress.
 //
-void BgpMembershipManager::Walker::WalkStart() {
+// Return false if there's no such RibState.
+//
+bool BgpMembershipManager::Walker::WalkStart() {
     CHECK_CONCURRENCY("bgp::PeerMembership");
 
-    assert(walk_ref_ == NULL);
-    assert(!rs_);
-    assert(peer_rib_list_.empty());
-    assert(peer_list_.empty());
-    assert(ribout_state_map_.empty());
-    assert(ribout_state_list_.empty());
     assert(rib_state_list_size_ == rib_state_set_.size());
 
-    // Bail if the list if empty.
-    if (rib_state_list_.empty())
-        return;
-
-    // Get and remove the first RibState from the RibStateList.
-    rs_ = rib_state_list_.front();
-    rib_state_list_.pop_front();
+    // Get and remove the first eligible RibState from the RibStateList.
+    RibStateList::iterator loc = rib_state_list_.begin();
+    while (loc != rib_state_list_.end() && walk_map_.count(*loc) > 0) {
+        ++loc;
+    }
+    if (loc == rib_state_list_.end())
+        return false;
+    RibState *rs = *loc;
+    rib_state_list_.erase(loc);
     rib_state_list_size_--;
-    assert(rib_state_set_.erase(rs_) == 1);
+    assert(rib_state_set_.erase(rs) == 1);
 
     // Process all pending PeerRibStates for chosen RibState.
     // Insert the PeerRibStates into PeerRibList for post processing when
     // table walk is complete.
-    for (RibState::iterator it = rs_->begin(); it != rs_->end(); ++it) {
+    TableWalk *walk = new TableWalk(rs);
+    for (RibState::iterator it = rs->begin(); it != rs->end(); ++it) {
         PeerRibState *prs = *it;
-        peer_rib_list_.insert(prs);
+        walk->peer_rib_list.insert(prs);
 
         // Update PeerList for RIBIN actions and RibOutStateMap for RIBOUT
         // actions.
         switch (prs->action()) {
         case RIBOUT_ADD: {
-            RibOutState *ros = LocateRibOutState(prs->ribout());
+            RibOutState *ros = walk->LocateRibOutState(prs->ribout());
             ros->JoinPeer(prs->ribout_index());
             break;
         }
         case RIBIN_DELETE:
         case RIBIN_WALK: {
             IPeer *peer = prs->peer_state()->peer();
-            peer_list_.insert(peer);
+            walk->peer_list.insert(peer);
             break;
         }
         case RIBIN_WALK_RIBOUT_DELETE:
         case RIBIN_DELETE_RIBOUT_DELETE: {
             IPeer *peer = prs->peer_state()->peer();
-            peer_list_.insert(peer);
-            RibOutState *ros = LocateRibOutState(prs->ribout());
+            walk->peer_list.insert(peer);
+            RibOutState *ros = walk->LocateRibOutState(prs->ribout());
             ros->LeavePeer(prs->ribout_index());
             break;
         }
@@ -1199,39 +1378,42 @@ void BgpMembershipManager::Walker::WalkStart() {
     // Clear the pending PeerRibStates in the RibState.
     // This allows the RibState to accumulate new PeerRibStates for a future
     // walk of it's BgpTable.
-    rs_->ClearPeerRibStateList();
+    rs->ClearPeerRibStateList();
 
     // Start the walk.
-    rs_->increment_walk_count();
-    BgpTable *table = rs_->table();
-    walk_ref_ = table->AllocWalker(
-        boost::bind(&BgpMembershipManager::Walker::WalkCallback, this, _1, _2),
-        boost::bind(&BgpMembershipManager::Walker::WalkDoneCallback, this, _2));
-    walk_started_ = true;
+    rs->increment_walk_count();
+    walk_map_.insert(make_pair(rs, walk));
+    BgpTable *table = rs->table();
+    walk->walk_ref = table->AllocWalker(
+        boost::bind(&BgpMembershipManager::Walker::WalkCallback,
+            this, walk, _1, _2),
+        boost::bind(&BgpMembershipManager::Walker::WalkDoneCallback,
+            this, walk, _2));
     if (!postpone_walk_)
-        table->WalkTable(walk_ref_);
+        table->WalkTable(walk->walk_ref);
+    return true;
 }
 
 //
-// Finish processing of the walk of BgpTable for current RibState.
+// Finish processing of the walk of BgpTable for given TableWalk.
 //
 // The walk complete notification is handled by WalkDoneCallback but all the
 // book-keeping and triggering of Events is handled by this method since it
 // needs to happen in bgp::PeerMembership task.
 //
-void BgpMembershipManager::Walker::WalkFinish() {
+void BgpMembershipManager::Walker::WalkFinish(TableWalk *walk) {
     CHECK_CONCURRENCY("bgp::PeerMembership");
 
-    assert(walk_ref_ != NULL);
-    assert(rs_);
-    assert(!peer_rib_list_.empty());
-    assert(!peer_list_.empty() || !ribout_state_map_.empty());
+    assert(walk->walk_ref != NULL);
+    assert(walk->walk_completed);
+    assert(!walk->peer_rib_list.empty());
+    assert(!walk->peer_list.empty() || !walk->ribout_state_map.empty());
     assert(rib_state_list_size_ == rib_state_set_.size());
-    assert(ribout_state_list_size_ == ribout_state_map_.size());
+    assert(walk->ribout_state_list_size == walk->ribout_state_map.size());
 
-    BgpTable *table = rs_->table();
-    for (PeerRibList::iterator it = peer_rib_list_.begin();
-         it != peer_rib_list_.end(); ++it) {
+    BgpTable *table = walk->rs->table();
+    for (PeerRibList::iterator it = walk->peer_rib_list.begin();
+         it != walk->peer_rib_list.end(); ++it) {
         PeerRibState *prs = *it;
         IPeer *peer = prs->peer_state()->peer();
 
@@ -1253,32 +1435,33 @@ void BgpMembershipManager::Walker::WalkFinish() {
         }
     }
 
-    table->ReleaseWalker(walk_ref_);
-    rs_ = NULL;
-    peer_rib_list_.clear();
-    peer_list_.clear();
-    ribout_state_list_.clear();
-    ribout_state_list_size_ = 0;
-    STLDeleteElements(&ribout_state_map_);
-
-    walk_started_ = false;
-    walk_completed_ = false;
+    table->ReleaseWalker(walk->walk_ref);
+    walk->ribout_state_list.clear();
+    walk->ribout_state_list_size = 0;
+    STLDeleteElements(&walk->ribout_state_map);
+    assert(walk_map_.erase(walk->rs) == 1);
+    delete walk;
 }
 
 //
 // Handler for TaskTrigger.
-// Start a new walk or finish processing for the current walk and start a new
-// one.
+// Finish processing for all completed walks and start new walks as long as
+// there's room for them.
 //
 bool BgpMembershipManager::Walker::WalkTrigger() {
     CHECK_CONCURRENCY("bgp::PeerMembership");
 
-    if (!walk_started_) {
-        assert(!walk_completed_);
-        WalkStart();
-    } else if (walk_completed_) {
-        WalkFinish();
-        WalkStart();
+    for (TableWalkMap::iterator it = walk_map_.begin(), next = it;
+         it != walk_map_.end(); it = next) {
+        ++next;
+        TableWalk *walk = it->second;
+        if (walk->walk_completed)
+            WalkFinish(walk);
+    }
+
+    while (walk_map_.size() < max_concurrent_walks_) {
+        if (!WalkStart())
+            break;
     }
     return true;
 }
@@ -1296,25 +1479,77 @@ void BgpMembershipManager::Walker::SetQueueDisable(bool value) {
     }
 }
 
+//
+// Set the maximum number of concurrent table walks.
+// Testing only.
+//
+void BgpMembershipManager::Walker::SetMaxConcurrentWalks(
+    int max_concurrent_walks) {
+    assert(max_concurrent_walks >= 1);
+    assert(max_concurrent_walks <= kMaxConcurrentWalks);
+    max_concurrent_walks_ = max_concurrent_walks;
+}
+
+//
+// Get the number of IPeers for RibIn processing in all walks in progress.
+// Testing only.
+//
+size_t BgpMembershipManager::Walker::GetPeerListSize() const {
+    size_t count = 0;
+    for (TableWalkMap::const_iterator it = walk_map_.begin();
+         it != walk_map_.end(); ++it) {
+        count += it->second->peer_list.size();
+    }
+    return count;
+}
+
+//
+// Get the number of PeerRibStates in all walks in progress.
+// Testing only.
+//
+size_t BgpMembershipManager::Walker::GetPeerRibListSize() const {
+    size_t count = 0;
+    for (TableWalkMap::const_iterator it = walk_map_.begin();
+         it != walk_map_.end(); ++it) {
+        count += it->second->peer_rib_list.size();
+    }
+    return count;
+}
+
+//
+// Get the number of RibOutStates in all walks in progress.
+// Testing only.
+//
+size_t BgpMembershipManager::Walker::GetRibOutStateListSize() const {
+    size_t count = 0;
+    for (TableWalkMap::const_iterator it = walk_map_.begin();
+         it != walk_map_.end(); ++it) {
+        count += it->second->ribout_state_list_size;
+    }
+    return count;
+}
+
 //
 // Force the Walker to trigger walks that are postponed.
 // Testing only.
 //
 void BgpMembershipManager::Walker::PostponeWalk() {
-    assert(!walk_started_);
-    assert(walk_ref_ == NULL);
+    assert(walk_map_.empty());
     postpone_walk_ = true;
 }
 
 //
-// Tell the DBTableWalkMgr to resume walk that was postponed previously.
+// Tell the DBTableWalkMgr to resume walks that were postponed previously.
 // Testing only.
 //
 void BgpMembershipManager::Walker::ResumeWalk() {
-    assert(walk_started_);
-    assert(!walk_completed_);
-    assert(walk_ref_ != NULL);
+    assert(!walk_map_.empty());
     postpone_walk_ = false;
-    BgpTable *table = rs_->table();
-    table->WalkTable(walk_ref_);
+    for (TableWalkMap::iterator it = walk_map_.begin();
+         it != walk_map_.end(); ++it) {
+        TableWalk *walk = it->second;
+        assert(!walk->walk_completed);
+        assert(walk->walk_ref != NULL);
+        walk->rs->table()->WalkTable(walk->walk_ref);
+    }
 }
@@ -59,6 +59,17 @@ class TaskTrigger;
 // number of table walks. The table walk functionality is delegated to the
 // Walker class.
 //
+// Bulk versions of Register and Unregister are provided for clients that
+// know up front that they need to (un)register one IPeer to many BgpTables
+// or many IPeers to one BgpTable. All (IPeer, BgpTable) pairs in a bulk call
+// are handled under a single acquisition of the mutex and posted as a single
+// Event. This guarantees that the RibOut processing for all of them is done
+// before the Walker gets to run. With many IPeers, the BgpTable is walked
+// just once for all of them instead of potentially once per IPeer. With many
+// BgpTables, the walks for all of them get started together. Per (IPeer,
+// BgpTable) bookkeeping, statistics and logging are shared with Register and
+// Unregister.
+//
 // Membership information corresponding to (IPeer, BgpTable) pairs is organized
 // with the above goal in mind. An IPeer is represented using a PeerState and a
 // BgpTable is represented using a RibState. A PeerStateMap and RibStateMap are
@@ -87,6 +98,8 @@ class BgpMembershipManager {
 public:
     typedef boost::function<void(IPeer *, BgpTable *, bool)>
         PeerRegistrationCallback;
+    typedef std::vector<IPeer *> PeerList;
+    typedef std::vector<BgpTable *> TableList;
 
     explicit BgpMembershipManager(BgpServer *server);
     virtual ~BgpMembershipManager();
@@ -102,6 +115,13 @@ public:
     virtual void UnregisterRibOut(IPeer *peer, BgpTable *table);
     void WalkRibIn(IPeer *peer, BgpTable *table);
 
+    void RegisterTableList(IPeer *peer, const TableList &table_list,
+        const RibExportPolicy &policy, int instance_id = -1);
+    void RegisterPeerList(const PeerList &peer_list, BgpTable *table,
+        const RibExportPolicy &policy, int instance_id = -1);
+    void UnregisterTableList(IPeer *peer, const TableList &table_list);
+    void UnregisterPeerList(const PeerList &peer_list, BgpTable *table);
+
     bool GetRegistrationInfo(const IPeer *peer, const BgpTable *table,
         int *instance_id = NULL, uint64_t *subscription_gen_id = NULL) const;
     void SetRegistrationInfo(const IPeer *peer, const BgpTable *table,
@@ -161,7 +181,9 @@ private:
         REGISTER_RIB_COMPLETE,
         UNREGISTER_RIB,
         UNREGISTER_RIB_COMPLETE,
-        WALK_RIB_COMPLETE
+        WALK_RIB_COMPLETE,
+        REGISTER_RIB_LIST,
+        UNREGISTER_RIB_LIST
     };
 
     typedef std::vector<PeerRegistrationCallback> PeerRegistrationListenerList;
@@ -169,6 +191,9 @@ private:
     typedef std::map<const BgpTable *, RibState *> RibStateMap;
     typedef std::set<PeerRibState *> PeerRibList;
 
+    Event *RegisterUnlocked(IPeer *peer, BgpTable *table,
+        const RibExportPolicy &policy, int instance_id);
+    Event *UnregisterUnlocked(IPeer *peer, BgpTable *table);
     void UnregisterRibInUnlocked(PeerRibState *prs);
 
     PeerState *LocatePeerState(IPeer *peer);
@@ -197,6 +222,8 @@ private:
     void ProcessUnregisterRibEvent(Event *event);
     void ProcessUnregisterRibCompleteEvent(Event *event);
     void ProcessWalkRibCompleteEvent(Event *event);
+    void ProcessRegisterRibListEvent(Event *event);
+    void ProcessUnregisterRibListEvent(Event *event);
 
     void EnqueueEvent(Event *event) { event_queue_->Enqueue(event); }
     bool EventCallback(Event *event);
@@ -229,12 +256,17 @@ struct BgpMembershipManager::Event {
     Event(EventType event_type, IPeer *peer, BgpTable *table);
     Event(EventType event_type, IPeer *peer, BgpTable *table,
         const RibExportPolicy &policy, int instance_id);
+    explicit Event(EventType event_type);
+    ~Event();
 
     EventType event_type;
     IPeer *peer;
     BgpTable *table;
     RibExportPolicy policy;
     int instance_id;
+
+    // Individual events for REGISTER_RIB_LIST and UNREGISTER_RIB_LIST.
+    std::vector<Event *> event_list;
 };
 
 //
@@ -389,12 +421,27 @@ private:
 //
 // This class is responsible for efficient implementation of BgpTable walks
 // for the BgpMembershipManager. It accepts walk requests for any number of
-// RibStates and triggers table walks one at a time. It has a maximum of one
-// ongoing table walk at any given time.
+// RibStates and triggers table walks for up to max_concurrent_walks_ of them
+// at any given time. A walk of a BgpTable runs on all DB partitions of the
+// table in parallel. Having walks of multiple BgpTables in progress at the
+// same time avoids serializing the setup and completion of each walk behind the walk
+// of the previous BgpTable. This matters when a peer that's registered to
+// a large number of BgpTables goes down, or when many such peers go down at
+// about the same time. The limit on concurrent walks can be set via the
+// environment and defaults to kDefaultConcurrentWalks.
+//
+// The Walker leaves the limit of the DBTableWalkMgr alone, since it applies
+// to all BgpTable walks and not just to membership walks. With the default
+// limit of 1, the DBTableWalkMgr still iterates one table at a time. But
+// the next walk is already queued when the previous one finishes, so the
+// Walker's setup and completion of each walk overlap with the iteration of
+// other tables instead of adding to it.
 //
 // The RibStateList contains all RibStates for which walks have not yet been
-// started. The Walker removes the first RibState from the list and starts a
-// table walk for it.
+// started. The Walker removes the first RibState from the list that doesn't
+// have a walk in progress and starts a table walk for it. A RibState that
+// already has a walk in progress stays on the list till that walk finishes,
+// so there's never more than one walk for a given BgpTable.
 //
 // The RibStateSet is used to prevent duplicates in the RibStateList. Using
 // just the RibStateSet to maintain the pending RibStates would have caused
@@ -408,30 +455,36 @@ private:
 // There's no issues with concurrent access in the former case. In the latter
 // case, access is serialized because of the mutex in BgpMembershipManager.
 //
-// The Walker creates temporary internal state when it starts a table walk so
-// that walk callbacks for each DBEntry can be handled with minimal processing
-// overhead. Details on this temporary state are as follows:
+// The Walker creates a TableWalk when it starts a table walk so that walk
+// callbacks for each DBEntry can be handled with minimal processing overhead.
+// The TableWalks in progress are kept in the TableWalkMap, keyed by RibState.
+// Details on the state in a TableWalk are as follows:
 //
-// - walk_ref_ is the walker for the current walk
-// - rs_ is the RibState for which the walk was started
-// - peer_rib_list_ is the list of PeerRibStates for the current RibState
-//   that have a pending action. The pending list in RibState is logically
-//   moved to this field. This allows the RibState to accumulate a new set
-//   of pending PeerRibStates that can be serviced in a subsequent walk.
-//   The peer_rib_list_ is used to create and enqueue events when the table
+// - walk_ref is the walker for the walk
+// - rs is the RibState for which the walk was started
+// - peer_rib_list is the list of PeerRibStates for the RibState that have
+//   a pending action. The pending list in RibState is logically moved to
+//   this field. This allows the RibState to accumulate a new set of pending
+//   PeerRibStates that can be serviced in a subsequent walk.
+//   The peer_rib_list is used to create and enqueue events when the table
 //   walk finishes.
-// - peer_list_ is the list of IPeers to be notified about BgpPaths added
-//   by them for RibIn processing.
-// - ribout_state_map_ is a map of RibOutStates that need to be processed
+// - peer_list is the list of IPeers to be notified about BgpPaths added
+//   by them for RibIn processing. Since all pending PeerRibStates for the
+//   RibState are serviced by one walk, requests from multiple IPeers that
+//   are going down at about the same time get merged into a single walk.
+// - ribout_state_map is a map of RibOutStates that need to be processed
 //   for each route.
-// - ribout_state_list_ is a list of same RibOutStates as ribout_state_map_.
-//   It allows simpler traversal compared to the ribout_state_map_ when each
+// - ribout_state_list is a list of same RibOutStates as ribout_state_map.
+//   It allows simpler traversal compared to the ribout_state_map when each
 //   DBEntry is processed.
 //
 // A RibOutState is created for each unique RibOut in the PeerRibStates in
-// peer_rib_list_. It's join and leave bitsets are based on the action in
+// peer_rib_list. It's join and leave bitsets are based on the action in
 // the PeerRibStates.
 //
+// Walk callbacks for TableWalks of different BgpTables can run concurrently.
+// Each of them only accesses state in it's own TableWalk and BgpTable.
+//
 // A TaskTrigger that runs in context of bgp::PeerMembership task is used to
 // handle start and finish of table walks. This avoids concurrency issues in
 // accessing/clearing the pending list in the RibState. Note that TaskTrigger
@@ -440,6 +493,9 @@ private:
 //
 class BgpMembershipManager::Walker {
 public:
+    static const int kDefaultConcurrentWalks = 16;
+    static const int kMaxConcurrentWalks = 64;
+
     explicit Walker(BgpMembershipManager *manager);
     ~Walker();
 
@@ -478,19 +534,39 @@ private:
     typedef std::list<RibOutState *> RibOutStateList;
     typedef std::set<const IPeer *> PeerList;
 
-    RibOutState *LocateRibOutState(RibOut *ribout);
-    bool WalkCallback(DBTablePartBase *tpart, DBEntryBase *db_entry);
-    void WalkDoneCallback(DBTableBase *table);
-    void WalkStart();
-    void WalkFinish();
+    struct TableWalk {
+        explicit TableWalk(RibState *rs);
+        ~TableWalk();
+
+        RibOutState *LocateRibOutState(RibOut *ribout);
+
+        RibState *rs;
+        DBTable::DBTableWalkRef walk_ref;
+        bool walk_completed;
+        PeerRibList peer_rib_list;
+        PeerList peer_list;
+        RibOutStateMap ribout_state_map;
+        RibOutStateList ribout_state_list;
+        size_t ribout_state_list_size;
+    };
+
+    typedef std::map<RibState *, TableWalk *> TableWalkMap;
+
+    bool WalkCallback(TableWalk *walk, DBTablePartBase *tpart,
+        DBEntryBase *db_entry);
+    void WalkDoneCallback(TableWalk *walk, DBTableBase *table);
+    bool WalkStart();
+    void WalkFinish(TableWalk *walk);
     bool WalkTrigger();
 
     // Testing only.
     void SetQueueDisable(bool value);
+    void SetMaxConcurrentWalks(int max_concurrent_walks);
     size_t GetQueueSize() const { return rib_state_list_size_; }
-    size_t GetPeerListSize() const { return peer_list_.size(); }
-    size_t GetPeerRibListSize() const { return peer_rib_list_.size(); }
-    size_t GetRibOutStateListSize() const { return ribout_state_list_size_; }
+    size_t GetWalkCount() const { return walk_map_.size(); }
+    size_t GetPeerListSize() const;
+    size_t GetPeerRibListSize() const;
+    size_t GetRibOutStateListSize() const;
     void PostponeWalk();
     void ResumeWalk();
 
@@ -499,17 +575,10 @@ private:
     RibStateList rib_state_list_;
     boost::scoped_ptr<TaskTrigger> trigger_;
 
+    size_t max_concurrent_walks_;
     bool postpone_walk_;
-    bool walk_started_;
-    bool walk_completed_;
-    DBTable::DBTableWalkRef walk_ref_;
-    RibState *rs_;
-    PeerRibList peer_rib_list_;
-    PeerList peer_list_;
-    RibOutStateMap ribout_state_map_;
-    RibOutStateList ribout_state_list_;
+    TableWalkMap walk_map_;
     size_t rib_state_list_size_;
-    size_t ribout_state_list_size_;
 
     DISALLOW_COPY_AND_ASSIGN(Walker);
 };
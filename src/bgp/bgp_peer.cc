@@ -62,6 +62,7 @@ public:
         proto_stats_[1] = ProtoStats();
         update_stats_[0] = UpdateStats();
         update_stats_[1] = UpdateStats();
+        packing_stats_ = PackingStats();
     }
 
     // Printable name
@@ -137,6 +138,14 @@ public:
         update_stats_[1].reach += count;
     }
 
+    virtual void GetTxPackingStats(PackingStats *stats) const {
+        *stats = packing_stats_;
+    }
+
+    virtual void UpdateTxPacking(uint64_t prefixes, uint64_t bytes) {
+        packing_stats_.Update(prefixes, bytes);
+    }
+
     // Do nothing for bgp peers.
     virtual void GetRxErrorStats(RxErrorStats *stats) const {
     }
@@ -153,6 +162,7 @@ private:
     ErrorStats error_stats_;
     ProtoStats proto_stats_[2];
     UpdateStats update_stats_[2];
+    PackingStats packing_stats_;
 };
 
 class BgpPeer::DeleteActor : public LifetimeActor {
@@ -1425,8 +1435,9 @@ bool BgpPeer::FlushUpdateUnlocked() {
     }
 
     if (!SkipUpdateSend()) {
-        send_ready_ = session_->Send(buffer_.data(), buffer_.size(), NULL);
-        buffer_.clear();
+        // The buffer gets cleared, but keeps its capacity for the next
+        // batch of updates.
+        send_ready_ = session_->SendBuffer(&buffer_, NULL);
         if (send_ready_) {
             StartKeepaliveTimerUnlocked();
         } else {
@@ -9,6 +9,7 @@
 #include <algorithm>
 #include <list>
 #include <map>
+#include <memory>
 #include <utility>
 
 #include "base/proto.h"
@@ -1734,8 +1735,293 @@ public:
     typedef mpl::list<BgpMarker, BgpMsgLength, BgpMsgType> Sequence;
 };
 
+//
+// Fast path decoder for UPDATE messages.
+//
+// The generic decoder goes through the ProtoSequence machinery for every
+// attribute and prefix, keeping a stack of parse contexts and allocating
+// a temporary BgpAttribute for each attribute before swapping it for the
+// derived type. This dominates the cost of receiving a full table.
+//
+// Update::Decode handles the attributes and address families that make up
+// the bulk of such updates with straight line code and builds the same
+// Update as the generic decoder. It returns NULL for anything else, which
+// includes any malformed message, and the caller then falls back to the
+// generic decoder, which also takes care of error reporting. Some checks
+// are stricter than in the generic decoder e.g. the message length must
+// match the buffer size and list attributes must not be empty. That's ok
+// since failing them just means taking the slow path.
+//
+static bool update_fast_path_enabled =
+    (getenv("BGP_UPDATE_NO_FAST_PATH") == NULL);
+
+void BgpProto::SetUseUpdateFastPath(bool value) {
+    update_fast_path_enabled = value;
+}
+
+bool BgpProto::UseUpdateFastPath() {
+    return update_fast_path_enabled;
+}
+
+static bool FastDecodePrefixes(const uint8_t *data, size_t size,
+                               vector<BgpProtoPrefix *> *prefixes) {
+    while (size > 0) {
+        size_t prefix_size = 1 + (data[0] + 7) / 8;
+        if (prefix_size > size)
+            return false;
+        BgpProtoPrefix *prefix = new BgpProtoPrefix;
+        prefix->prefixlen = data[0];
+        prefix->prefix.assign(data + 1, data + prefix_size);
+        prefixes->push_back(prefix);
+        data += prefix_size;
+        size -= prefix_size;
+    }
+    return true;
+}
+
+template <class C, typename T, T C::*Member>
+static BgpAttribute *FastDecodeValue(uint8_t flags, uint8_t code,
+                                     const uint8_t *data, size_t size) {
+    if (static_cast<int>(size) != C::kSize)
+        return NULL;
+    if ((flags & BgpAttribute::FLAG_MASK) != C::kFlags)
+        return NULL;
+    C *attr = new C(BgpAttribute(code, flags));
+    Accessor<C, T, Member>::set(attr, get_value(data, size));
+    return attr;
+}
+
+template <class C, typename T, vector<T> C::*Member>
+static BgpAttribute *FastDecodeVector(uint8_t flags, uint8_t code,
+                                      const uint8_t *data, size_t size) {
+    if (size == 0 || size % sizeof(T) != 0)
+        return NULL;
+    if ((flags & BgpAttribute::FLAG_MASK) != C::kFlags)
+        return NULL;
+    C *attr = new C(BgpAttribute(code, flags));
+    VectorAccessor<C, T, Member>::set(attr, data, size);
+    return attr;
+}
+
+static BgpAttribute *FastDecodeAggregator(uint8_t flags, uint8_t code,
+                                          const uint8_t *data, size_t size) {
+    if (size != BgpAttrAggregator::kSize)
+        return NULL;
+    if ((flags & BgpAttribute::FLAG_MASK) != BgpAttrAggregator::kFlags)
+        return NULL;
+    BgpAttrAggregator *attr = new BgpAttrAggregator(BgpAttribute(code, flags));
+    attr->as_num = get_short(data);
+    attr->address = get_value(data + sizeof(as_t), 4);
+    return attr;
+}
+
+static BgpAttribute *FastDecodeAsPath(uint8_t flags, uint8_t code,
+                                      const uint8_t *data, size_t size) {
+    if ((flags & BgpAttribute::FLAG_MASK) != AsPathSpec::kFlags)
+        return NULL;
+    std::auto_ptr<AsPathSpec> attr(new AsPathSpec(BgpAttribute(code, flags)));
+    while (size > 0) {
+        if (size < 2 || data[1] == 0)
+            return NULL;
+        size_t segment_size = 2 + data[1] * sizeof(as_t);
+        if (segment_size > size)
+            return NULL;
+        AsPathSpec::PathSegment *ps = new AsPathSpec::PathSegment;
+        attr->path_segments.push_back(ps);
+        ps->path_segment_type = data[0];
+        ps->path_segment.reserve(data[1]);
+        for (size_t offset = 2; offset < segment_size;
+             offset += sizeof(as_t)) {
+            ps->path_segment.push_back(get_short(data + offset));
+        }
+        data += segment_size;
+        size -= segment_size;
+    }
+    return attr.release();
+}
+
+//
+// Families with plain prefix encoding of the NLRI. E-VPN and Erm-VPN are
+// left to the generic decoder.
+//
+static bool FastDecodeMpFamily(uint16_t afi, uint8_t safi) {
+    return ((afi == BgpAf::IPv4 && safi == BgpAf::Unicast) ||
+        (afi == BgpAf::IPv4 && safi == BgpAf::Vpn) ||
+        (afi == BgpAf::IPv6 && safi == BgpAf::Unicast) ||
+        (afi == BgpAf::IPv6 && safi == BgpAf::Vpn) ||
+        (afi == BgpAf::IPv4 && safi == BgpAf::RTarget));
+}
+
+static bool FastDecodeMpNextHopLength(uint16_t afi, uint8_t safi, size_t len) {
+    if (afi == BgpAf::IPv4 && safi == BgpAf::Unicast) {
+        return (len == Address::kMaxV4Bytes);
+    } else if (afi == BgpAf::IPv4 && safi == BgpAf::Vpn) {
+        return (len == RouteDistinguisher::kSize + Address::kMaxV4Bytes);
+    } else if (afi == BgpAf::IPv6 && safi == BgpAf::Unicast) {
+        return (len == Address::kMaxV6Bytes ||
+            len == 2 * Address::kMaxV6Bytes);
+    } else if (afi == BgpAf::IPv6 && safi == BgpAf::Vpn) {
+        return (len == RouteDistinguisher::kSize + Address::kMaxV6Bytes);
+    } else if (afi == BgpAf::IPv4 && safi == BgpAf::RTarget) {
+        return (len == Address::kMaxV4Bytes);
+    }
+    return false;
+}
+
+static BgpAttribute *FastDecodeMpNlri(uint8_t flags, uint8_t code,
+                                      const uint8_t *data, size_t size) {
+    if ((flags & BgpAttribute::FLAG_MASK) != BgpMpNlri::kFlags)
+        return NULL;
+    if (size < 3)
+        return NULL;
+    std::auto_ptr<BgpMpNlri> attr(new BgpMpNlri(BgpAttribute(code, flags)));
+    attr->afi = get_short(data);
+    attr->safi = data[2];
+    if (!FastDecodeMpFamily(attr->afi, attr->safi))
+        return NULL;
+
+    // Next hop length, next hop and reserved byte.
+    size_t offset = 3;
+    if (code == BgpAttribute::MPReachNlri) {
+        if (size < offset + 1)
+            return NULL;
+        size_t nh_size = data[offset];
+        if (!FastDecodeMpNextHopLength(attr->afi, attr->safi, nh_size))
+            return NULL;
+        if (size < offset + 1 + nh_size + 1)
+            return NULL;
+        attr->nexthop.assign(data + offset + 1, data + offset + 1 + nh_size);
+        offset += 1 + nh_size + 1;
+    }
+
+    if (!FastDecodePrefixes(data + offset, size - offset, &attr->nlri))
+        return NULL;
+    return attr.release();
+}
+
+static BgpAttribute *FastDecodeAttribute(uint8_t flags, uint8_t code,
+                                         const uint8_t *data, size_t size) {
+    switch (code) {
+    case BgpAttribute::Origin:
+        if (size == BgpAttrOrigin::kSize &&
+            data[0] > BgpAttrOrigin::INCOMPLETE) {
+            return NULL;
+        }
+        return FastDecodeValue<BgpAttrOrigin, int,
+            &BgpAttrOrigin::origin>(flags, code, data, size);
+    case BgpAttribute::AsPath:
+        return FastDecodeAsPath(flags, code, data, size);
+    case BgpAttribute::NextHop:
+        if (size == BgpAttrNextHop::kSize && get_value(data, size) == 0)
+            return NULL;
+        return FastDecodeValue<BgpAttrNextHop, uint32_t,
+            &BgpAttrNextHop::nexthop>(flags, code, data, size);
+    case BgpAttribute::MultiExitDisc:
+        return FastDecodeValue<BgpAttrMultiExitDisc, uint32_t,
+            &BgpAttrMultiExitDisc::med>(flags, code, data, size);
+    case BgpAttribute::LocalPref:
+        return FastDecodeValue<BgpAttrLocalPref, uint32_t,
+            &BgpAttrLocalPref::local_pref>(flags, code, data, size);
+    case BgpAttribute::AtomicAggregate:
+        if (size != 0 || flags != BgpAttrAtomicAggregate::kFlags)
+            return NULL;
+        return new BgpAttrAtomicAggregate(BgpAttribute(code, flags));
+    case BgpAttribute::Aggregator:
+        return FastDecodeAggregator(flags, code, data, size);
+    case BgpAttribute::Communities:
+        return FastDecodeVector<CommunitySpec, uint32_t,
+            &CommunitySpec::communities>(flags, code, data, size);
+    case BgpAttribute::OriginatorId:
+        return FastDecodeValue<BgpAttrOriginatorId, uint32_t,
+            &BgpAttrOriginatorId::originator_id>(flags, code, data, size);
+    case BgpAttribute::ClusterList:
+        return FastDecodeVector<ClusterListSpec, uint32_t,
+            &ClusterListSpec::cluster_list>(flags, code, data, size);
+    case BgpAttribute::MPReachNlri:
+    case BgpAttribute::MPUnreachNlri:
+        return FastDecodeMpNlri(flags, code, data, size);
+    case BgpAttribute::ExtendedCommunities:
+        return FastDecodeVector<ExtCommunitySpec, uint64_t,
+            &ExtCommunitySpec::communities>(flags, code, data, size);
+    case BgpAttribute::OriginVnPath:
+        return FastDecodeVector<OriginVnPathSpec, uint64_t,
+            &OriginVnPathSpec::origin_vns>(flags, code, data, size);
+    default:
+        return NULL;
+    }
+}
+
+//
+// The data must be the complete message, starting with the marker.
+//
+BgpProto::Update *BgpProto::Update::Decode(const uint8_t *data, size_t size) {
+    if (size < static_cast<size_t>(kMinMessageSize) + 4 ||
+        size > static_cast<size_t>(kMaxMessageSize)) {
+        return NULL;
+    }
+    for (int i = 0; i < 16; i++) {
+        if (data[i] != 0xff)
+            return NULL;
+    }
+    if (get_short(data + 16) != size || data[18] != UPDATE)
+        return NULL;
+
+    std::auto_ptr<Update> update(new Update);
+    const uint8_t *end = data + size;
+    const uint8_t *ptr = data + kMinMessageSize;
+
+    // Withdrawn routes, followed by at least the path attribute length.
+    size_t withdrawn_size = get_short(ptr);
+    ptr += 2;
+    if (withdrawn_size + 2 > static_cast<size_t>(end - ptr))
+        return NULL;
+    if (!FastDecodePrefixes(ptr, withdrawn_size, &update->withdrawn_routes))
+        return NULL;
+    ptr += withdrawn_size;
+
+    size_t attr_list_size = get_short(ptr);
+    ptr += 2;
+    if (attr_list_size > static_cast<size_t>(end - ptr))
+        return NULL;
+    const uint8_t *attr_end = ptr + attr_list_size;
+    while (ptr < attr_end) {
+        if (attr_end - ptr < 3)
+            return NULL;
+        uint8_t flags = ptr[0];
+        uint8_t code = ptr[1];
+        size_t header_size = 3;
+        size_t attr_size = ptr[2];
+        if (flags & BgpAttribute::ExtendedLength) {
+            header_size = 4;
+            if (attr_end - ptr < 4)
+                return NULL;
+            attr_size = get_short(ptr + 2);
+        }
+        ptr += header_size;
+        if (attr_size > static_cast<size_t>(attr_end - ptr))
+            return NULL;
+        BgpAttribute *attr = FastDecodeAttribute(flags, code, ptr, attr_size);
+        if (!attr)
+            return NULL;
+        update->path_attributes.push_back(attr);
+        ptr += attr_size;
+    }
+
+    if (!FastDecodePrefixes(ptr, end - ptr, &update->nlri))
+        return NULL;
+    return update.release();
+}
+
 BgpProto::BgpMessage *BgpProto::Decode(const uint8_t *data, size_t size,
                                        ParseErrorContext *ec) {
+    if (update_fast_path_enabled &&
+        size > static_cast<size_t>(kMinMessageSize) &&
+        data[kMinMessageSize - 1] == UPDATE) {
+        Update *update = Update::Decode(data, size);
+        if (update)
+            return update;
+    }
+
     ParseContext context;
     int result = BgpProtocol::Parse(
         data, size, &context, reinterpret_cast<void *>(NULL));
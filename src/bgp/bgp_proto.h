@@ -429,6 +429,8 @@ public:
         ~Update();
         int Validate(const BgpPeer *, std::string *data);
         int CompareTo(const Update &rhs) const;
+        // Fast path decoder, returns NULL if the message needs the generic
+        // decoder.
         static BgpProto::Update *Decode(const uint8_t *data, size_t size);
 
         std::vector <BgpProtoPrefix *> withdrawn_routes;
@@ -443,6 +445,11 @@ public:
     static BgpMessage *Decode(const uint8_t *data, size_t size,
                               ParseErrorContext *ec = NULL);
 
+    // Decode UPDATE messages with Update::Decode when possible.
+    // Enabled unless the BGP_UPDATE_NO_FAST_PATH environment variable is set.
+    static void SetUseUpdateFastPath(bool value);
+    static bool UseUpdateFastPath();
+
     static int Encode(const BgpMessage *msg, uint8_t *data, size_t size,
                       EncodeOffsets *offsets = NULL);
     static int Encode(const BgpMpNlri *msg, uint8_t *data, size_t size,
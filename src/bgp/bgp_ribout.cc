@@ -5,15 +5,19 @@
 #include "bgp/bgp_ribout.h"
 
 #include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#include <boost/functional/hash.hpp>
 
 #include <algorithm>
 
 #include "sandesh/sandesh_trace.h"
 #include "base/string_util.h"
+#include "bgp/bgp_attr_base.h"
 #include "bgp/bgp_peer_types.h"
 #include "bgp/bgp_ribout_updates.h"
 #include "bgp/bgp_export.h"
 #include "bgp/bgp_factory.h"
+#include "bgp/bgp_peer.h"
 #include "bgp/bgp_route.h"
 #include "bgp/bgp_server.h"
 #include "bgp/bgp_table.h"
@@ -62,6 +66,26 @@ int RibOutAttr::NextHop::CompareTo(const NextHop &rhs) const {
     return 0;
 }
 
+//
+// Same as CompareTo, but ignore the label. Used by the xmpp message builder
+// to share the encoding of nexthops that differ only in the label.
+//
+int RibOutAttr::NextHop::CompareToExceptLabel(const NextHop &rhs) const {
+    KEY_COMPARE(address_, rhs.address_);
+    KEY_COMPARE(mac_, rhs.mac_);
+    KEY_COMPARE(l3_label_, rhs.l3_label_);
+    KEY_COMPARE(origin_vn_index_, rhs.origin_vn_index_);
+    KEY_COMPARE(encap_.size(), rhs.encap_.size());
+    for (size_t idx = 0; idx < encap_.size(); ++idx) {
+        KEY_COMPARE(encap_[idx], rhs.encap_[idx]);
+    }
+    KEY_COMPARE(tag_list_.size(), rhs.tag_list_.size());
+    for (size_t idx = 0; idx < tag_list_.size(); ++idx) {
+        KEY_COMPARE(tag_list_[idx], rhs.tag_list_[idx]);
+    }
+    return 0;
+}
+
 bool RibOutAttr::NextHop::operator==(const NextHop &rhs) const {
     return CompareTo(rhs) == 0;
 }
@@ -74,6 +98,87 @@ bool RibOutAttr::NextHop::operator<(const NextHop &rhs) const {
     return CompareTo(rhs) < 0;
 }
 
+//
+// Data base of SharedNextHopLists.
+//
+// There's a single instance for the process since the contents of a nexthop
+// list don't depend on the BgpServer, and since some RibOutAttrs are built
+// without a table. The instance is never freed so that RibOutAttrs that are
+// destroyed late during process exit can still release their lists.
+//
+class RibOutAttr::SharedNextHopListDB :
+    public BgpPathAttributeDB<SharedNextHopList, SharedNextHopListPtr,
+                              NextHopList, SharedNextHopListCompare,
+                              SharedNextHopListDB> {
+public:
+    SharedNextHopListDB() { }
+
+    static SharedNextHopListDB *GetInstance() {
+        static SharedNextHopListDB *instance = new SharedNextHopListDB;
+        return instance;
+    }
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(SharedNextHopListDB);
+};
+
+RibOutAttr::SharedNextHopList::SharedNextHopList(SharedNextHopListDB *db,
+    const NextHopList &spec)
+    : db_(db),
+      nexthop_list_(spec) {
+    refcount_ = 0;
+}
+
+void RibOutAttr::SharedNextHopList::Remove() {
+    db_->Delete(this);
+}
+
+int RibOutAttr::SharedNextHopList::CompareTo(
+    const SharedNextHopList &rhs) const {
+    KEY_COMPARE(nexthop_list_.size(), rhs.nexthop_list_.size());
+    for (size_t idx = 0; idx < nexthop_list_.size(); ++idx) {
+        KEY_COMPARE(nexthop_list_[idx], rhs.nexthop_list_[idx]);
+    }
+    return 0;
+}
+
+//
+// Only hash the address and labels of the nexthops. That's enough to spread
+// the lists across the partitions of the data base.
+//
+size_t hash_value(const RibOutAttr::SharedNextHopList &nh_list) {
+    size_t hash = 0;
+    BOOST_FOREACH(const RibOutAttr::NextHop &nexthop,
+        nh_list.nexthop_list()) {
+        const IpAddress &address = nexthop.address();
+        if (address.is_v4()) {
+            boost::hash_combine(hash, address.to_v4().to_ulong());
+        } else {
+            boost::hash_combine(hash, address.to_string());
+        }
+        boost::hash_combine(hash, nexthop.label());
+        boost::hash_combine(hash, nexthop.l3_label());
+    }
+    return hash;
+}
+
+void intrusive_ptr_release(const RibOutAttr::SharedNextHopList *cnh_list) {
+    int prev = cnh_list->refcount_.fetch_and_decrement();
+    if (prev == 1) {
+        RibOutAttr::SharedNextHopList *nh_list =
+            const_cast<RibOutAttr::SharedNextHopList *>(cnh_list);
+        nh_list->Remove();
+        assert(nh_list->refcount_ == 0);
+        delete nh_list;
+    }
+}
+
+const RibOutAttr::NextHopList RibOutAttr::kEmptyList;
+
+size_t RibOutAttr::SharedNextHopListCount() {
+    return SharedNextHopListDB::GetInstance()->Size();
+}
+
 RibOutAttr::RibOutAttr()
     : label_(0),
       l3_label_(0),
@@ -102,9 +207,11 @@ RibOutAttr::RibOutAttr(const BgpTable *table, const BgpAttr *attr,
       is_xmpp_(is_xmpp),
       vrf_originated_(false) {
     if (attr && is_xmpp) {
-        nexthop_list_.push_back(NextHop(table, attr->nexthop(),
+        NextHopList nexthop_list;
+        nexthop_list.push_back(NextHop(table, attr->nexthop(),
             attr->mac_address(), label, l3_label, attr->ext_community(),
             false));
+        set_nexthop_list(nexthop_list);
     }
 }
 
@@ -115,9 +222,11 @@ RibOutAttr::RibOutAttr(const BgpTable *table, const BgpRoute *route,
       vrf_originated_(route->BestPath()->IsVrfOriginated()) {
     if (attr && include_nh) {
         if (is_xmpp) {
-            nexthop_list_.push_back(NextHop(table, attr->nexthop(),
+            NextHopList nexthop_list;
+            nexthop_list.push_back(NextHop(table, attr->nexthop(),
                 attr->mac_address(), label, 0, attr->ext_community(),
                 vrf_originated_));
+            set_nexthop_list(nexthop_list);
         } else {
             label_ = label;
             l3_label_ = 0;
@@ -141,9 +250,13 @@ RibOutAttr::RibOutAttr(const BgpRoute *route, const BgpAttr *attr,
 
     // Encode ECMP nexthops only for XMPP peers.
     // Vrf Origination matters only for XMPP peers.
-    set_attr(table, attr, route->BestPath()->GetLabel(),
-        route->BestPath()->GetL3Label(), route->BestPath()->IsVrfOriginated(),
-        is_xmpp);
+    // Build the complete list before locating the shared copy.
+    attr_out_ = attr;
+    NextHopList nexthop_list;
+    nexthop_list.push_back(NextHop(table, attr->nexthop(),
+        attr->mac_address(), route->BestPath()->GetLabel(),
+        route->BestPath()->GetL3Label(), attr->ext_community(),
+        route->BestPath()->IsVrfOriginated()));
 
     for (Route::PathList::const_iterator it = route->GetPathList().begin();
         it != route->GetPathList().end(); ++it) {
@@ -168,12 +281,13 @@ RibOutAttr::RibOutAttr(const BgpRoute *route, const BgpAttr *attr,
             path->IsVrfOriginated());
 
         // Skip if we have already encoded this next-hop
-        if (find(nexthop_list_.begin(), nexthop_list_.end(), nexthop) !=
-                nexthop_list_.end()) {
+        if (find(nexthop_list.begin(), nexthop_list.end(), nexthop) !=
+                nexthop_list.end()) {
             continue;
         }
-        nexthop_list_.push_back(nexthop);
+        nexthop_list.push_back(nexthop);
     }
+    set_nexthop_list(nexthop_list);
 }
 
 //
@@ -194,12 +308,13 @@ RibOutAttr &RibOutAttr::operator=(const RibOutAttr &rhs) {
 // Comparator for RibOutAttr.
 // First compare the BgpAttr and then the nexthops.
 //
+// The nexthop lists are interned, so comparing the pointers is sufficient.
+// Note that the resulting order is not stable across runs, which is fine as
+// the comparator is only used to check for equality.
+//
 int RibOutAttr::CompareTo(const RibOutAttr &rhs) const {
     KEY_COMPARE(attr_out_.get(), rhs.attr_out_.get());
-    KEY_COMPARE(nexthop_list_.size(), rhs.nexthop_list_.size());
-    for (size_t idx = 0; idx < nexthop_list_.size(); ++idx) {
-        KEY_COMPARE(nexthop_list_[idx], rhs.nexthop_list_[idx]);
-    }
+    KEY_COMPARE(nexthop_list_.get(), rhs.nexthop_list_.get());
     KEY_COMPARE(label_, rhs.label());
     KEY_COMPARE(l3_label_, rhs.l3_label());
     KEY_COMPARE(is_xmpp_, rhs.is_xmpp());
@@ -211,11 +326,13 @@ void RibOutAttr::set_attr(const BgpTable *table, const BgpAttrPtr &attrp,
     uint32_t label, uint32_t l3_label, bool vrf_originated, bool is_xmpp) {
     if (!attr_out_) {
         attr_out_ = attrp;
-        assert(nexthop_list_.empty());
+        assert(!nexthop_list_);
         if (is_xmpp) {
-            NextHop nexthop(table, attrp->nexthop(), attrp->mac_address(),
-                label, l3_label, attrp->ext_community(), vrf_originated);
-            nexthop_list_.push_back(nexthop);
+            NextHopList nexthop_list;
+            nexthop_list.push_back(NextHop(table, attrp->nexthop(),
+                attrp->mac_address(), label, l3_label, attrp->ext_community(),
+                vrf_originated));
+            set_nexthop_list(nexthop_list);
         } else {
             label_ = label;
             l3_label_ = l3_label;
@@ -232,6 +349,15 @@ void RibOutAttr::set_attr(const BgpTable *table, const BgpAttrPtr &attrp,
     attr_out_ = attrp;
 }
 
+//
+// Locate the shared copy of the given nexthop list.
+//
+void RibOutAttr::set_nexthop_list(const NextHopList &nexthop_list) {
+    assert(!nexthop_list.empty());
+    nexthop_list_ =
+        SharedNextHopListDB::GetInstance()->Locate(nexthop_list);
+}
+
 RouteState::RouteState() {
 }
 
@@ -351,6 +477,7 @@ void RibOut::Register(IPeerUpdate *peer) {
     PeerState *ps = state_map_.Locate(peer);
     assert(ps != NULL);
     active_peerset_.set(ps->index);
+    RTargetPeerAdd(peer, ps);
     sender_->Join(this, peer);
     for (int idx = 0; idx < DB::PartitionCount(); ++idx) {
         if (updates_[idx]->QueueJoin(RibOutUpdates::QUPDATE, ps->index))
@@ -378,6 +505,7 @@ void RibOut::Unregister(IPeerUpdate *peer) {
         updates_[idx]->QueueLeave(RibOutUpdates::QBULK, ps->index);
     }
     sender_->Leave(this, peer);
+    RTargetPeerDelete(ps);
     state_map_.Remove(peer, ps->index);
 
     if (state_map_.empty()) {
@@ -385,6 +513,38 @@ void RibOut::Unregister(IPeerUpdate *peer) {
     }
 }
 
+//
+// Add the IPeerUpdate to the RTargetPeerSet if it's a BgpPeer that negotiated
+// the route target family. Also keep track of the bit index for the BgpPeer
+// index, so that the interested peers for a route target, which are tracked
+// by BgpPeer index, can be translated to a RibPeerSet without looking at all
+// the peers in the RibOut.
+//
+void RibOut::RTargetPeerAdd(IPeerUpdate *peer, PeerState *ps) {
+    if (!IsEncodingBgp() || ps->rtarget_peer_index >= 0)
+        return;
+    BgpPeer *bgp_peer = dynamic_cast<BgpPeer *>(peer);
+    if (!bgp_peer || bgp_peer->GetIndex() < 0)
+        return;
+    if (!bgp_peer->IsFamilyNegotiated(Address::RTARGET))
+        return;
+
+    size_t peer_index = bgp_peer->GetIndex();
+    if (peer_index >= rtarget_peer_index_map_.size())
+        rtarget_peer_index_map_.resize(peer_index + 1, -1);
+    rtarget_peer_index_map_[peer_index] = ps->index;
+    rtarget_peerset_.set(ps->index);
+    ps->rtarget_peer_index = peer_index;
+}
+
+void RibOut::RTargetPeerDelete(PeerState *ps) {
+    if (ps->rtarget_peer_index < 0)
+        return;
+    rtarget_peer_index_map_[ps->rtarget_peer_index] = -1;
+    rtarget_peerset_.reset(ps->index);
+    ps->rtarget_peer_index = -1;
+}
+
 //
 // Return true if the IPeerUpdate is registered to this RibOut.
 //
@@ -566,6 +726,8 @@ void RibOut::FillStatisticsInfo(vector<ShowRibOutStatistics> *sros_list) const {
         sros.set_marker_splits(stats.marker_split_count_);
         sros.set_marker_merges(stats.marker_merge_count_);
         sros.set_marker_moves(stats.marker_move_count_);
+        sros.set_attr_cache_hits(stats.attr_cache_hit_count_);
+        sros.set_attr_cache_misses(stats.attr_cache_miss_count_);
         sros_list->push_back(sros);
     }
 }
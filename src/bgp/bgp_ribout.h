@@ -5,8 +5,10 @@
 #ifndef SRC_BGP_BGP_RIBOUT_H_
 #define SRC_BGP_BGP_RIBOUT_H_
 
+#include <boost/intrusive_ptr.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/intrusive/slist.hpp>
+#include <tbb/atomic.h>
 
 #include <algorithm>
 #include <string>
@@ -57,10 +59,11 @@ public:
             uint32_t label() const { return label_; }
             uint32_t l3_label() const { return l3_label_; }
             int origin_vn_index() const { return origin_vn_index_; }
-            std::vector<std::string> encap() const { return encap_; }
-            std::vector<int> tag_list() const { return tag_list_; }
+            const std::vector<std::string> &encap() const { return encap_; }
+            const std::vector<int> &tag_list() const { return tag_list_; }
 
             int CompareTo(const NextHop &rhs) const;
+            int CompareToExceptLabel(const NextHop &rhs) const;
             bool operator==(const NextHop &rhs) const;
             bool operator!=(const NextHop &rhs) const;
             bool operator<(const NextHop &rhs) const;
@@ -77,6 +80,45 @@ public:
 
     typedef std::vector<NextHop> NextHopList;
 
+    class SharedNextHopListDB;
+
+    // This nested class represents an immutable NextHopList that is shared
+    // by all RibOutAttrs with the same nexthops. Instances are interned in a
+    // process wide SharedNextHopListDB, so copying a RibOutAttr only bumps
+    // the refcount and nexthop lists can be compared by pointer.
+    class SharedNextHopList {
+    public:
+        SharedNextHopList(SharedNextHopListDB *db, const NextHopList &spec);
+        void Remove();
+        int CompareTo(const SharedNextHopList &rhs) const;
+
+        const NextHopList &nexthop_list() const { return nexthop_list_; }
+
+        friend std::size_t hash_value(const SharedNextHopList &nh_list);
+
+    private:
+        friend int intrusive_ptr_add_ref(const SharedNextHopList *nh_list) {
+            return nh_list->refcount_.fetch_and_increment();
+        }
+        friend int intrusive_ptr_del_ref(const SharedNextHopList *nh_list) {
+            return nh_list->refcount_.fetch_and_decrement();
+        }
+        friend void intrusive_ptr_release(const SharedNextHopList *nh_list);
+
+        mutable tbb::atomic<int> refcount_;
+        SharedNextHopListDB *db_;
+        NextHopList nexthop_list_;
+    };
+
+    typedef boost::intrusive_ptr<SharedNextHopList> SharedNextHopListPtr;
+
+    struct SharedNextHopListCompare {
+        bool operator()(const SharedNextHopList *lhs,
+            const SharedNextHopList *rhs) const {
+            return lhs->CompareTo(*rhs) < 0;
+        }
+    };
+
     RibOutAttr();
     RibOutAttr(const RibOutAttr &rhs);
     RibOutAttr(const BgpRoute *route, const BgpAttr *attr, bool is_xmpp);
@@ -91,7 +133,9 @@ public:
     bool operator!=(const RibOutAttr &rhs) const { return CompareTo(rhs) != 0; }
     bool IsReachable() const { return attr_out_.get() != NULL; }
 
-    const NextHopList &nexthop_list() const { return nexthop_list_; }
+    const NextHopList &nexthop_list() const {
+        return nexthop_list_ ? nexthop_list_->nexthop_list() : kEmptyList;
+    }
     const BgpAttr *attr() const { return attr_out_.get(); }
     void set_attr(const BgpTable *table, const BgpAttrPtr &attrp) {
         set_attr(table, attrp, 0, 0, false, false);
@@ -105,13 +149,13 @@ public:
 
     void clear() {
         attr_out_.reset();
-        nexthop_list_.clear();
+        nexthop_list_.reset();
     }
     uint32_t label() const {
-        return nexthop_list_.empty() ? label_ : nexthop_list_[0].label();
+        return nexthop_list_ ? nexthop_list()[0].label() : label_;
     }
     uint32_t l3_label() const {
-        return nexthop_list_.empty() ? l3_label_ : nexthop_list_[0].l3_label();
+        return nexthop_list_ ? nexthop_list()[0].l3_label() : l3_label_;
     }
     bool is_xmpp() const { return is_xmpp_; }
     bool vrf_originated() const { return vrf_originated_; }
@@ -121,11 +165,17 @@ public:
         repr_.append(repr, pos, std::string::npos);
     }
 
+    // Number of distinct nexthop lists currently in use, for tests.
+    static size_t SharedNextHopListCount();
+
 private:
+    static const NextHopList kEmptyList;
+
     int CompareTo(const RibOutAttr &rhs) const;
+    void set_nexthop_list(const NextHopList &nexthop_list);
 
     BgpAttrPtr attr_out_;
-    NextHopList nexthop_list_;
+    SharedNextHopListPtr nexthop_list_;
     uint32_t label_;
     uint32_t l3_label_;
     bool is_xmpp_;
@@ -293,6 +343,18 @@ public:
     const RibPeerSet &PeerSet() const;
     void GetSubsetPeerSet(RibPeerSet *peerset, const IPeerUpdate *cpeer) const;
 
+    // Returns a bitmask with the peers that negotiated the route target
+    // family i.e. the peers that are subject to route target filtering.
+    const RibPeerSet &RTargetPeerSet() const { return rtarget_peerset_; }
+    // Returns the bit index of the BgpPeer with the given BgpPeer index, or
+    // -1 if it's not in the RTargetPeerSet.
+    int GetRTargetPeerIndex(int peer_index) const {
+        if (peer_index < 0 ||
+            static_cast<size_t>(peer_index) >= rtarget_peer_index_map_.size())
+            return -1;
+        return rtarget_peer_index_map_[peer_index];
+    }
+
     BgpTable *table() { return table_; }
     const BgpTable *table() const { return table_; }
     BgpUpdateSender *sender() { return sender_; }
@@ -338,20 +400,27 @@ public:
 
 private:
     struct PeerState {
-        explicit PeerState(IPeerUpdate *key) : peer(key), index(-1) {
+        explicit PeerState(IPeerUpdate *key)
+            : peer(key), index(-1), rtarget_peer_index(-1) {
         }
         void set_index(int idx) { index = idx; }
         IPeerUpdate *peer;
         int index;
+        int rtarget_peer_index;
     };
     typedef IndexMap<IPeerUpdate *, PeerState, RibPeerSet> PeerStateMap;
 
+    void RTargetPeerAdd(IPeerUpdate *peer, PeerState *ps);
+    void RTargetPeerDelete(PeerState *ps);
+
     BgpTable *table_;
     BgpUpdateSender *sender_;
     RibExportPolicy policy_;
     std::string name_;
     PeerStateMap state_map_;
     RibPeerSet active_peerset_;
+    RibPeerSet rtarget_peerset_;
+    std::vector<int> rtarget_peer_index_map_;
     int listener_id_;
     std::vector<RibOutUpdates *> updates_;
     boost::scoped_ptr<BgpExport> bgp_export_;
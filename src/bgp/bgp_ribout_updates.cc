@@ -41,8 +41,17 @@ RibOutUpdates::RibOutUpdates(RibOut *ribout, int index)
 //
 // Destructor.  Get rid of all the UpdateQueues.
 //
+// Also clear anything cached by the xmpp message for this partition on
+// behalf of the table, so that the message doesn't outlive the attributes
+// that it references.
+//
 RibOutUpdates::~RibOutUpdates() {
     STLDeleteValues(&queue_vec_);
+    if (ribout_->IsEncodingXmpp() &&
+        static_cast<size_t>(index_) < xmpp_messages_.size() &&
+        xmpp_messages_[index_]) {
+        xmpp_messages_[index_]->ClearCache(ribout_->table());
+    }
 }
 
 //
@@ -178,6 +187,10 @@ bool RibOutUpdates::DequeueCommon(UpdateQueue *queue, UpdateMarker *marker,
         if (msg_built) {
             UpdatePack(queue_id, message, uinfo, msgset);
             message->Finish();
+            stats_[queue_id].attr_cache_hit_count_ +=
+                message->num_attr_cache_hits();
+            stats_[queue_id].attr_cache_miss_count_ +=
+                message->num_attr_cache_misses();
             UpdateSend(queue_id, message, msgset, &msg_blocked);
         }
 
@@ -487,6 +500,9 @@ void RibOutUpdates::UpdateSend(int queue_id, Message *message,
         if (stats) {
             stats->UpdateTxReachRoute(message->num_reach_routes());
             stats->UpdateTxUnreachRoute(message->num_unreach_routes());
+            stats->UpdateTxPacking(
+                message->num_reach_routes() + message->num_unreach_routes(),
+                msgsize);
         }
     }
 }
@@ -693,4 +709,6 @@ void RibOutUpdates::AddStatisticsInfo(int queue_id, Stats *stats) const {
     stats->marker_split_count_   += stats_[queue_id].marker_split_count_;
     stats->marker_merge_count_   += stats_[queue_id].marker_merge_count_;
     stats->marker_move_count_    += stats_[queue_id].marker_move_count_;
+    stats->attr_cache_hit_count_ += stats_[queue_id].attr_cache_hit_count_;
+    stats->attr_cache_miss_count_ += stats_[queue_id].attr_cache_miss_count_;
 }
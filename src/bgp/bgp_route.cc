@@ -46,18 +46,18 @@ const BgpPath *BgpRoute::BestPath() const {
 //
 // Insert given path and redo path selection.
 //
+// The other paths are already sorted, so the path just needs to be inserted
+// at the right position.
+//
 void BgpRoute::InsertPath(BgpPath *path) {
     assert(!IsDeleted());
-    const Path *prev_front = front();
 
     BgpTable *table = static_cast<BgpTable *>(get_table());
     if (table && table->IsRoutingPolicySupported()) {
         RoutingInstance *rtinstance = table->routing_instance();
         rtinstance->ProcessRoutingPolicy(this, path);
     }
-    insert(path);
-
-    Sort(&BgpTable::PathSelection, prev_front);
+    insert(path, &BgpTable::PathSelection);
 
     // Update counters.
     if (table)
@@ -68,11 +68,18 @@ void BgpRoute::InsertPath(BgpPath *path) {
 //
 // Delete given path and redo path selection.
 //
+// Removing a path doesn't change the order of the remaining paths, so there
+// is no need to sort them again.
+//
 void BgpRoute::DeletePath(BgpPath *path) {
     const Path *prev_front = front();
 
     remove(path);
-    Sort(&BgpTable::PathSelection, prev_front);
+#ifndef NDEBUG
+    assert(IsSorted(&BgpTable::PathSelection));
+#endif
+    if (prev_front != front())
+        set_last_change_at_to_now();
 
     // Update counters.
     BgpTable *table = static_cast<BgpTable *>(get_table());
@@ -90,12 +97,12 @@ void BgpRoute::DeletePath(BgpPath *path) {
 const BgpPath *BgpRoute::FindPath(BgpPath::PathSource src) const {
     for (Route::PathList::const_iterator it = GetPathList().begin();
          it != GetPathList().end(); ++it) {
+        const BgpPath *path = static_cast<const BgpPath *>(it.operator->());
+
         // Skip secondary paths.
-        if (dynamic_cast<const BgpSecondaryPath *>(it.operator->())) {
+        if (path->IsReplicated()) {
             continue;
         }
-
-        const BgpPath *path = static_cast<const BgpPath *>(it.operator->());
         if (path->GetFlags() & BgpPath::ResolvedPath) {
             continue;
         }
@@ -114,18 +121,19 @@ BgpPath *BgpRoute::FindPath(const IPeer *peer) {
     for (Route::PathList::iterator it = GetPathList().begin();
          it != GetPathList().end(); ++it) {
         BgpPath *path = static_cast<BgpPath *>(it.operator->());
+        if (path->GetPeer() != peer) {
+            continue;
+        }
         if (path->GetSource() != BgpPath::BGP_XMPP) {
             continue;
         }
         if (path->GetFlags() & BgpPath::ResolvedPath) {
             continue;
         }
-        if (dynamic_cast<BgpSecondaryPath *>(it.operator->())) {
+        if (path->IsReplicated()) {
             continue;
         }
-        if (path->GetPeer() == peer) {
-            return path;
-        }
+        return path;
     }
     return NULL;
 }
@@ -138,19 +146,20 @@ BgpPath *BgpRoute::FindPath(BgpPath::PathSource src, const IPeer *peer,
                             uint32_t path_id) {
     for (Route::PathList::iterator it = GetPathList().begin();
          it != GetPathList().end(); ++it) {
-        // Skip secondary paths.
-        if (dynamic_cast<BgpSecondaryPath *>(it.operator->())) {
+        BgpPath *path = static_cast<BgpPath *>(it.operator->());
+        if (path->GetPeer() != peer || path->GetPathId() != path_id ||
+            path->GetSource() != src) {
             continue;
         }
-
-        BgpPath *path = static_cast<BgpPath *>(it.operator->());
         if (path->GetFlags() & BgpPath::ResolvedPath) {
             continue;
         }
-        if (path->GetPeer() == peer && path->GetPathId() == path_id &&
-            path->GetSource() == src) {
-            return path;
+
+        // Skip secondary paths.
+        if (path->IsReplicated()) {
+            continue;
         }
+        return path;
     }
     return NULL;
 }
@@ -173,19 +182,20 @@ bool BgpRoute::RemovePath(BgpPath::PathSource src, const IPeer *peer,
     for (Route::PathList::iterator it = GetPathList().begin();
          it != GetPathList().end(); it++) {
          BgpPath *path = static_cast<BgpPath *>(it.operator->());
+        if (path->GetPeer() != peer || path->GetPathId() != path_id ||
+            path->GetSource() != src) {
+            continue;
+        }
 
         //
         // Skip secondary paths.
         //
-        if (dynamic_cast<BgpSecondaryPath *>(it.operator->())) {
+        if (path->IsReplicated()) {
             continue;
         }
 
-        if (path->GetPeer() == peer && path->GetPathId() == path_id &&
-            path->GetSource() == src) {
-            DeletePath(path);
-            return true;
-        }
+        DeletePath(path);
+        return true;
     }
     return false;
 }
@@ -211,18 +221,19 @@ bool BgpRoute::RemovePath(const IPeer *peer) {
          it != GetPathList().end(); it = next) {
         next++;
         BgpPath *path = static_cast<BgpPath *>(it.operator->());
+        if (path->GetPeer() != peer) {
+            continue;
+        }
 
         //
         // Skip secondary paths.
         //
-        if (dynamic_cast<BgpSecondaryPath *>(it.operator->())) {
+        if (path->IsReplicated()) {
             continue;
         }
 
-        if (path->GetPeer() == peer) {
-            DeletePath(path);
-            ret = true;
-        }
+        DeletePath(path);
+        ret = true;
     }
     return ret;
 }
@@ -282,9 +293,11 @@ BgpPath *BgpRoute::FindSecondaryPath(BgpRoute *src_rt,
         BgpPath::PathSource src, const IPeer *peer, uint32_t path_id) {
     for (Route::PathList::iterator it = GetPathList().begin();
          it != GetPathList().end(); ++it) {
-        BgpSecondaryPath *path = dynamic_cast<BgpSecondaryPath *>(
-            it.operator->());
-        if (path && path->src_rt() == src_rt &&
+        BgpPath *bgp_path = static_cast<BgpPath *>(it.operator->());
+        if (!bgp_path->IsReplicated())
+            continue;
+        BgpSecondaryPath *path = static_cast<BgpSecondaryPath *>(bgp_path);
+        if (path->src_rt() == src_rt &&
             path->GetPeer() == peer && path->GetPathId() == path_id &&
             path->GetSource() == src) {
             return path;
@@ -301,9 +314,11 @@ bool BgpRoute::RemoveSecondaryPath(const BgpRoute *src_rt,
         BgpPath::PathSource src, const IPeer *peer, uint32_t path_id) {
     for (Route::PathList::iterator it = GetPathList().begin();
          it != GetPathList().end(); it++) {
-         BgpSecondaryPath *path =
-            dynamic_cast<BgpSecondaryPath *>(it.operator->());
-        if (path && path->src_rt() == src_rt &&
+        BgpPath *bgp_path = static_cast<BgpPath *>(it.operator->());
+        if (!bgp_path->IsReplicated())
+            continue;
+        BgpSecondaryPath *path = static_cast<BgpSecondaryPath *>(bgp_path);
+        if (path->src_rt() == src_rt &&
             path->GetPeer() == peer && path->GetPathId() == path_id &&
             path->GetSource() == src) {
             DeletePath(path);
@@ -8,6 +8,7 @@
 #include <boost/foreach.hpp>
 #include <sandesh/request_pipeline.h>
 
+#include "bgp/bgp_attr.h"
 #include "bgp/bgp_multicast.h"
 #include "bgp/bgp_peer.h"
 #include "bgp/bgp_peer_internal_types.h"
@@ -399,6 +400,38 @@ void ShowRouteVrfReq::HandleRequest() const {
 
 class ShowBgpServerHandler {
 public:
+    template <typename DB>
+    static void FillPathAttributeDBStats(const string &name, DB *db,
+        vector<ShowPathAttributeDBStats> *list) {
+        BgpPathAttributeDBStats stats;
+        db->GetStats(&stats);
+        ShowPathAttributeDBStats sdb_stats;
+        sdb_stats.set_name(name);
+        sdb_stats.set_partitions(stats.partitions);
+        sdb_stats.set_size(stats.size);
+        sdb_stats.set_hits(stats.hits);
+        sdb_stats.set_misses(stats.misses);
+        sdb_stats.set_contentions(stats.contentions);
+        list->push_back(sdb_stats);
+    }
+
+    static void FillPathAttributeDBStatsList(BgpServer *server,
+        vector<ShowPathAttributeDBStats> *list) {
+        FillPathAttributeDBStats("BgpAttr", server->attr_db(), list);
+        FillPathAttributeDBStats("AsPath", server->aspath_db(), list);
+        FillPathAttributeDBStats("Community", server->comm_db(), list);
+        FillPathAttributeDBStats("ExtCommunity", server->extcomm_db(), list);
+        FillPathAttributeDBStats("OriginVnPath", server->ovnpath_db(), list);
+        FillPathAttributeDBStats("ClusterList",
+            server->cluster_list_db(), list);
+        FillPathAttributeDBStats("PmsiTunnel", server->pmsi_tunnel_db(), list);
+        FillPathAttributeDBStats("EdgeDiscovery",
+            server->edge_discovery_db(), list);
+        FillPathAttributeDBStats("EdgeForwarding",
+            server->edge_forwarding_db(), list);
+        FillPathAttributeDBStats("OList", server->olist_db(), list);
+    }
+
     static bool CallbackS1(const Sandesh *sr,
             const RequestPipeline::PipeSpec ps, int stage, int instNum,
             RequestPipeline::InstData *data) {
@@ -415,6 +448,10 @@ public:
         bsc->bgp_server->session_manager()->GetTxSocketStats(&peer_socket_stats);
         resp->set_tx_socket_stats(peer_socket_stats);
 
+        vector<ShowPathAttributeDBStats> db_stats_list;
+        FillPathAttributeDBStatsList(bsc->bgp_server, &db_stats_list);
+        resp->set_path_attribute_db_stats(db_stats_list);
+
         resp->set_context(req->context());
         resp->Response();
         return true;
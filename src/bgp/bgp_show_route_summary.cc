@@ -42,6 +42,8 @@ static void FillRouteTableSummaryInfo(ShowRouteTableSummary *srts,
     srts->set_markers(markers);
     srts->set_listeners(table->GetListenerCount());
     srts->set_walkers(table->walker_count());
+    srts->set_route_size(table->GetRouteSize());
+    srts->set_route_bytes(table->Size() * table->GetRouteSize());
 }
 
 //
@@ -105,6 +105,8 @@ public:
                         UpdateInfoSList &uinfo_slist) = 0;
 
     virtual Address::Family family() const = 0;
+    // Size of a route in the table, not including paths and attributes.
+    virtual size_t GetRouteSize() const = 0;
     virtual bool IsVpnTable() const { return false; }
     virtual bool IsRoutingPolicySupported() const { return false; }
     virtual bool IsRouteAggregationSupported() const { return false; }
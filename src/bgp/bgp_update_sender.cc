@@ -11,9 +11,11 @@
 #include <string>
 
 #include "base/task_annotations.h"
+#include "base/timer.h"
 #include "bgp/ipeer.h"
 #include "bgp/bgp_ribout.h"
 #include "bgp/bgp_ribout_updates.h"
+#include "bgp/bgp_server.h"
 #include "db/db.h"
 
 using std::auto_ptr;
@@ -275,7 +277,8 @@ public:
     };
 
     explicit RibState(RibOut *ribout)
-        : key_(ribout), index_(-1), in_sync_(RibOutUpdates::QCOUNT, true) {
+        : key_(ribout), index_(-1), in_sync_(RibOutUpdates::QCOUNT, true),
+          qbatch_(0), qheld_(0) {
     }
 
     void Add(PeerState *ps);
@@ -285,6 +288,20 @@ public:
     void SetQueueSync(int queue_id);
     void SetQueueUnsync(int queue_id);
 
+    bool IsBatching(int queue_id) const {
+        return BitIsSet(qbatch_, queue_id);
+    }
+    void SetBatching(int queue_id, bool batching) {
+        if (batching) {
+            SetBit(qbatch_, queue_id);
+        } else {
+            ClearBit(qbatch_, queue_id);
+        }
+    }
+    bool IsHeld(int queue_id) const { return BitIsSet(qheld_, queue_id); }
+    void SetHeld(int queue_id) { SetBit(qheld_, queue_id); }
+    void ClearHeld(int queue_id) { ClearBit(qheld_, queue_id); }
+
     RibOut *ribout() { return key_; }
 
     iterator begin(const PeerStateMap &indexmap) {
@@ -307,6 +324,8 @@ private:
     size_t index_;
     BitSet peer_set_;
     vector<bool> in_sync_;
+    uint8_t qbatch_;        // queues in batching mode.
+    uint8_t qheld_;         // queues with a tail dequeue held for the timer.
 
     DISALLOW_COPY_AND_ASSIGN(RibState);
 };
@@ -410,12 +429,27 @@ private:
     BgpSenderPartition *partition_;
 };
 
+//
+// The batch hold time in msec can be set via the environment for now. The
+// default of 0 disables batching.
+//
+static int GetBatchHoldTime() {
+    char *batch_hold_time_str = getenv("BGP_UPDATE_BATCH_HOLD_TIME");
+    if (!batch_hold_time_str)
+        return 0;
+    int batch_hold_time = strtol(batch_hold_time_str, NULL, 0);
+    return (batch_hold_time > 0 ? batch_hold_time : 0);
+}
+
 BgpSenderPartition::BgpSenderPartition(BgpUpdateSender *sender, int index)
     : sender_(sender),
       index_(index),
       running_(false),
       disabled_(false),
-      worker_task_(NULL) {
+      worker_task_(NULL),
+      batch_hold_time_(GetBatchHoldTime()),
+      batch_timer_(TimerManager::CreateTimer(*sender->server()->ioservice(),
+          "BGP update batch timer", sender->task_id(), index)) {
 }
 
 BgpSenderPartition::~BgpSenderPartition() {
@@ -423,6 +457,7 @@ BgpSenderPartition::~BgpSenderPartition() {
         TaskScheduler *scheduler = TaskScheduler::GetInstance();
         scheduler->Cancel(worker_task_);
     }
+    TimerManager::DeleteTimer(batch_timer_);
     assert(peer_state_imap_.empty());
     assert(rib_state_imap_.empty());
 }
@@ -473,12 +508,58 @@ void BgpSenderPartition::Remove(RibOut *ribout, IPeerUpdate *peer) {
 // Create and enqueue new WorkRibOut entry since the RibOut is now
 // active.
 //
+// If the (RibOut, QueueId) is in batching mode, hold off the tail dequeue
+// till the batch timer expires instead.
+//
 void BgpSenderPartition::RibOutActive(RibOut *ribout, int queue_id) {
     CHECK_CONCURRENCY("db::DBTable", "bgp::SendUpdate", "bgp::PeerMembership");
 
+    if (batch_hold_time_ > 0) {
+        RibState *rs = rib_state_imap_.Find(ribout);
+        if (rs && rs->IsBatching(queue_id)) {
+            rs->SetHeld(queue_id);
+            batch_timer_->Start(batch_hold_time_,
+                boost::bind(&BgpSenderPartition::BatchTimerExpired, this));
+            return;
+        }
+    }
+
     WorkRibOutEnqueue(ribout, queue_id);
 }
 
+//
+// Enqueue a WorkRibOut for all (RibOut, QueueId) pairs that were held for
+// batching.
+//
+// The timer runs in the context of bgp::SendUpdate for this partition, so
+// it's mutually exclusive with the producers that call RibOutActive.
+//
+bool BgpSenderPartition::BatchTimerExpired() {
+    CHECK_CONCURRENCY("bgp::SendUpdate");
+
+    for (size_t i = rib_state_imap_.bits().find_first();
+         i != BitSet::npos; i = rib_state_imap_.bits().find_next(i)) {
+        RibState *rs = rib_state_imap_.At(i);
+        for (int queue_id = RibOutUpdates::QCOUNT - 1; queue_id >= 0;
+             --queue_id) {
+            if (!rs->IsHeld(queue_id))
+                continue;
+            rs->ClearHeld(queue_id);
+            WorkRibOutEnqueue(rs->ribout(), queue_id);
+        }
+    }
+    return false;
+}
+
+//
+// Return true if the (RibOut, QueueId) is in batching mode.
+// For unit testing.
+//
+bool BgpSenderPartition::IsBatching(RibOut *ribout, int queue_id) const {
+    RibState *rs = rib_state_imap_.Find(ribout);
+    return (rs ? rs->IsBatching(queue_id) : false);
+}
+
 //
 // Mark an IPeerUpdate to be send ready.
 //
@@ -787,6 +868,7 @@ void BgpSenderPartition::UpdateRibOut(RibOut *ribout, int queue_id) {
     BuildSyncBitSet(ribout, rs, &msync);
 
     // Drain the queue till we can do no more.
+    size_t queue_size = updates->queue_size(queue_id);
     RibPeerSet blocked, munsync;
     bool done = updates->TailDequeue(queue_id, msync, &blocked, &munsync);
     assert(msync.Contains(blocked));
@@ -794,6 +876,9 @@ void BgpSenderPartition::UpdateRibOut(RibOut *ribout, int queue_id) {
     // Mark peers as send blocked.
     SetSendBlocked(ribout, rs, queue_id, blocked);
 
+    // Decide whether to batch subsequent tail dequeues.
+    UpdateBatchState(rs, queue_id, queue_size, blocked);
+
     // Set the queue to be active for any unsync peers. If we don't do this,
     // we will forget to mark the (RibOut,QueueId) as active for these peers
     // since the blocked RibPeerSet does not contain peers that are already
@@ -808,6 +893,26 @@ void BgpSenderPartition::UpdateRibOut(RibOut *ribout, int queue_id) {
         rs->SetQueueUnsync(queue_id);
 }
 
+//
+// Switch the (RibOut, QueueId) to batching mode if the tail dequeue that
+// just finished left some peers blocked or if the queue was deep when it
+// started, and back to normal mode once the queue is shallow and all the
+// peers keep up. The gap between the high and low water marks avoids going
+// back and forth on every tail dequeue.
+//
+void BgpSenderPartition::UpdateBatchState(RibState *rs, int queue_id,
+    size_t queue_size, const RibPeerSet &blocked) {
+    CHECK_CONCURRENCY("bgp::SendUpdate");
+
+    if (batch_hold_time_ <= 0)
+        return;
+    if (!blocked.empty() || queue_size >= kBatchHighWater) {
+        rs->SetBatching(queue_id, true);
+    } else if (queue_size <= kBatchLowWater) {
+        rs->SetBatching(queue_id, false);
+    }
+}
+
 //
 // Go through all RibOuts for the IPeerUpdate and drain the given queue till it
 // is up-to date or it becomes blocked. If it's blocked, select the next RibOut
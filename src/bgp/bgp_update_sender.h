@@ -18,6 +18,7 @@ class BgpUpdateSender;
 class IPeerUpdate;
 class RibOut;
 class RibPeerSet;
+class Timer;
 
 //
 // This class maintains state to generate updates for a DB partition for all
@@ -45,8 +46,23 @@ class RibPeerSet;
 // WorkRibOut entry after adding a RouteUpdate to an empty UpdateQueue, and
 // IPeerUpdate class which creates a WorkPeer entry when it becomes unblocked.
 //
+// A BgpSenderPartition adapts how eagerly it does tail dequeues for each
+// (RibOut, QueueId) pair. A pair switches to batching mode when a tail
+// dequeue leaves some peers blocked i.e. their sockets are not writable,
+// or when the queue has at least kBatchHighWater updates. It switches back
+// once a tail dequeue starts with at most kBatchLowWater updates and no
+// peers get blocked. In batching mode, RibOutActive doesn't enqueue a
+// WorkRibOut right away. Instead the pair is marked as held and the batch
+// timer, which expires after the batch hold time, enqueues a WorkRibOut for
+// all held pairs. This lets updates accumulate so that more prefixes get
+// packed into each message for slow peers, while peers that keep up see no
+// additional latency. A batch hold time of 0 disables batching.
+//
 class BgpSenderPartition {
 public:
+    static const size_t kBatchHighWater = 1024;
+    static const size_t kBatchLowWater = 64;
+
     BgpSenderPartition(BgpUpdateSender *sender, int index);
     ~BgpSenderPartition();
 
@@ -65,8 +81,13 @@ public:
     int task_id() const;
     int index() const { return index_; }
 
+    int batch_hold_time() const { return batch_hold_time_; }
+
     // For unit testing.
     void set_disabled(bool disabled);
+    void set_batch_hold_time(int batch_hold_time) {
+        batch_hold_time_ = batch_hold_time;
+    }
 
 private:
     friend class BgpUpdateSenderTest;
@@ -133,6 +154,11 @@ private:
                         const RibPeerSet &blocked);
     void SetQueueSync(PeerState *ps, int queue_id);
 
+    void UpdateBatchState(RibState *rs, int queue_id, size_t queue_size,
+                          const RibPeerSet &blocked);
+    bool IsBatching(RibOut *ribout, int queue_id) const;
+    bool BatchTimerExpired();
+
     BgpUpdateSender *sender_;
     int index_;
     bool running_;
@@ -141,6 +167,8 @@ private:
     Worker *worker_task_;
     PeerStateMap peer_state_imap_;
     RibStateMap rib_state_imap_;
+    int batch_hold_time_;
+    Timer *batch_timer_;
 
     DISALLOW_COPY_AND_ASSIGN(BgpSenderPartition);
 };
@@ -169,6 +197,7 @@ public:
     bool PeerIsRegistered(IPeerUpdate *peer) const;
     bool PeerInSync(IPeerUpdate *peer) const;
 
+    BgpServer *server() { return server_; }
     int task_id() const { return task_id_; }
     bool CheckInvariants() const;
 
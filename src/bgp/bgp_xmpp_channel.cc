@@ -9,6 +9,7 @@
 #include <boost/regex.hpp>
 
 #include <limits>
+#include <map>
 #include <sstream>
 #include <vector>
 
@@ -66,8 +67,8 @@ using boost::regex_search;
 using boost::smatch;
 using boost::system::error_code;
 using pugi::xml_node;
-using std::auto_ptr;
 using std::make_pair;
+using std::map;
 using std::numeric_limits;
 using std::ostringstream;
 using std::pair;
@@ -241,8 +242,17 @@ public:
         parent_->stats_[TX].reach += count;
     }
 
+    virtual void GetTxPackingStats(PackingStats *stats) const {
+        *stats = packing_stats_;
+    }
+
+    virtual void UpdateTxPacking(uint64_t prefixes, uint64_t bytes) {
+        packing_stats_.Update(prefixes, bytes);
+    }
+
 private:
     BgpXmppChannel *parent_;
+    PackingStats packing_stats_;
 };
 
 class BgpXmppChannel::XmppPeer : public IPeer {
@@ -561,7 +571,16 @@ size_t BgpXmppChannel::GetMembershipRequestQueueSize() const {
     return table_membership_request_map_.size();
 }
 
-void BgpXmppChannel::RoutingInstanceCallback(string vrf_name, int op) {
+//
+// Handle creation of and changes to a routing instance.
+//
+// Tables of a new routing instance to which this channel had subscribed
+// before the instance got created are added to the register_map instead of
+// being registered right away. This lets the BgpXmppChannelManager register
+// all channels to each table in one go.
+//
+void BgpXmppChannel::RoutingInstanceCallback(string vrf_name, int op,
+    TableChannelListMap *register_map) {
     if (delete_in_progress_)
         return;
     if (vrf_name == BgpConfigManager::kMasterInstance)
@@ -579,7 +598,8 @@ void BgpXmppChannel::RoutingInstanceCallback(string vrf_name, int op) {
             GetInstanceMembershipState(vrf_name);
         if (!imr_state)
             return;
-        ProcessDeferredSubscribeRequest(rt_instance, *imr_state);
+        ProcessDeferredSubscribeRequest(rt_instance, *imr_state,
+            register_map);
         DeleteInstanceMembershipState(vrf_name);
     } else {
         SubscriptionState *sub_state = GetSubscriptionState(rt_instance);
@@ -1790,10 +1810,8 @@ bool BgpXmppChannel::ProcessEnetItem(string vrf_name,
     return true;
 }
 
-void BgpXmppChannel::DequeueRequest(const string &table_name,
-                                    DBRequest *request) {
-    auto_ptr<DBRequest> ptr(request);
-
+void BgpXmppChannel::DequeueRequests(const string &table_name,
+                                     const DBRequestList &req_list) {
     BgpTable *table = static_cast<BgpTable *>
         (bgp_server_->database()->FindTable(table_name));
     if (table == NULL || table->IsDeleted()) {
@@ -1812,13 +1830,17 @@ void BgpXmppChannel::DequeueRequest(const string &table_name,
                 "Not subscribed to table " << table->name());
             return;
         }
-        if (ptr->oper == DBRequest::DB_ENTRY_ADD_CHANGE) {
-            ((BgpTable::RequestData *)ptr->data.get())
-                ->set_subscription_gen_id(subscription_gen_id);
+        for (DBRequestList::const_iterator it = req_list.begin();
+             it != req_list.end(); ++it) {
+            DBRequest *request = *it;
+            if (request->oper == DBRequest::DB_ENTRY_ADD_CHANGE) {
+                ((BgpTable::RequestData *)request->data.get())
+                    ->set_subscription_gen_id(subscription_gen_id);
+            }
         }
     }
 
-    table->Enqueue(ptr.get());
+    table->Enqueue(req_list);
 }
 
 bool BgpXmppChannel::ResumeClose() {
@@ -1881,20 +1903,53 @@ void BgpXmppChannel::UnregisterTable(int line, BgpTable *table) {
 #define UnregisterTable(table) UnregisterTable(__LINE__, table)
 
 // Process all pending membership requests of various tables.
+//
+// This can be a large number of tables if the agent subscribed to many
+// instances while the close manager was using the membership manager.
+// Use the bulk APIs of the membership manager so that the registrations
+// and unregistrations for all tables get processed together. Tables are
+// grouped by instance id since the tables of a routing instance share the
+// same instance id.
 void BgpXmppChannel::ProcessPendingSubscriptions() {
     assert(!close_manager_->IsMembershipInUse());
+    typedef map<int, BgpMembershipManager::TableList> InstanceTableListMap;
+    InstanceTableListMap register_map;
+    BgpMembershipManager::TableList unregister_list;
     BOOST_FOREACH(TableMembershipRequestMap::value_type &entry,
                   table_membership_request_map_) {
         BgpTable *table = static_cast<BgpTable *>(
             bgp_server_->database()->FindTable(entry.first));
         const TableMembershipRequestState &tmr_state = entry.second;
-        if (tmr_state.current_req == SUBSCRIBE) {
+        if (tmr_state.current_req == SUBSCRIBE && tmr_state.no_ribout) {
             RegisterTable(table, &tmr_state);
+        } else if (tmr_state.current_req == SUBSCRIBE) {
+            BGP_LOG_PEER(Membership, Peer(), SandeshLevel::SYS_DEBUG,
+                         BGP_LOG_FLAG_ALL, BGP_PEER_DIR_NA,
+                         "Subscribe to table " << table->name() <<
+                         " with id " << tmr_state.instance_id);
+            register_map[tmr_state.instance_id].push_back(table);
+            channel_stats_.table_subscribe++;
         } else {
             assert(tmr_state.current_req == UNSUBSCRIBE);
-            UnregisterTable(table);
+            BGP_LOG_PEER(Membership, Peer(), SandeshLevel::SYS_DEBUG,
+                         BGP_LOG_FLAG_ALL, BGP_PEER_DIR_NA,
+                         "Unsubscribe to table " << table->name());
+            unregister_list.push_back(table);
+            channel_stats_.table_unsubscribe++;
         }
     }
+
+    BgpMembershipManager *mgr = bgp_server_->membership_mgr();
+    BOOST_FOREACH(InstanceTableListMap::value_type &entry, register_map) {
+        mgr->RegisterTableList(peer_.get(), entry.second, bgp_policy_,
+            entry.first);
+    }
+    mgr->UnregisterTableList(peer_.get(), unregister_list);
+
+    // If EndOfRib Send timer is running, cancel it and reschedule it after all
+    // outstanding membership registrations are complete.
+    if (!register_map.empty() && eor_send_timer_->running())
+        eor_send_timer_->Cancel();
 }
 
 size_t BgpXmppChannel::table_membership_requests() const {
@@ -1999,10 +2054,13 @@ bool BgpXmppChannel::ProcessMembershipResponse(string table_name,
         DeleteTableMembershipState(table_name);
     }
 
+    DBRequestList req_list;
     for (DeferQ::iterator it = defer_q_.find(vrf_n_table);
          it != defer_q_.end() && it->first.second == table->name(); ++it) {
-        DequeueRequest(table->name(), it->second);
+        req_list.push_back(it->second);
     }
+    DequeueRequests(table->name(), req_list);
+    STLDeleteValues(&req_list);
 
     // Erase all elements for the table
     defer_q_.erase(vrf_n_table);
@@ -2204,10 +2262,22 @@ const BgpXmppChannel::SubscriptionState *BgpXmppChannel::GetSubscriptionState(
     return (loc != routing_instances_.end() ? &loc->second : NULL);
 }
 
+//
+// Process a subscribe request that was received before the routing instance
+// got created.
+//
+// Tables that need a RibOut are added to the register_map so that the
+// caller can register this and other channels to them with one call. The
+// rest are handled via RegisterTable as usual, which also takes care of
+// deferring the registration if the close manager is using the membership
+// manager.
+//
 void BgpXmppChannel::ProcessDeferredSubscribeRequest(RoutingInstance *instance,
-    const InstanceMembershipRequestState &imr_state) {
+    const InstanceMembershipRequestState &imr_state,
+    TableChannelListMap *register_map) {
     int instance_id = imr_state.instance_id;
     bool no_ribout = imr_state.no_ribout;
+    bool registered = false;
     AddSubscriptionState(instance, instance_id);
     RoutingInstance::RouteTableList const rt_list = instance->GetTables();
     for (RoutingInstance::RouteTableList::const_iterator it = rt_list.begin();
@@ -2219,8 +2289,24 @@ void BgpXmppChannel::ProcessDeferredSubscribeRequest(RoutingInstance *instance,
         TableMembershipRequestState tmr_state(
             SUBSCRIBE, instance_id, no_ribout);
         AddTableMembershipState(table->name(), tmr_state);
-        RegisterTable(table, &tmr_state);
+        if (no_ribout || close_manager_->IsMembershipInUse()) {
+            RegisterTable(table, &tmr_state);
+            continue;
+        }
+
+        BGP_LOG_PEER(Membership, Peer(), SandeshLevel::SYS_DEBUG,
+                     BGP_LOG_FLAG_ALL, BGP_PEER_DIR_NA,
+                     "Subscribe to table " << table->name() <<
+                     " with id " << instance_id);
+        (*register_map)[make_pair(table, instance_id)].push_back(this);
+        channel_stats_.table_subscribe++;
+        registered = true;
     }
+
+    // If EndOfRib Send timer is running, cancel it and reschedule it after all
+    // outstanding membership registrations are complete.
+    if (registered && eor_send_timer_->running())
+        eor_send_timer_->Cancel();
 }
 
 void BgpXmppChannel::ProcessSubscriptionRequest(
@@ -2717,10 +2803,34 @@ void BgpXmppChannelManager::IdentifierUpdateCallback(
     }
 }
 
+//
+// Handle creation of and changes to a routing instance.
+//
+// Many agents may have subscribed to a routing instance before it got
+// created, e.g. when the configuration of the instance shows up after the
+// agents have subscribed to it. Register all their channels to each table
+// of the instance with one call to the membership manager, so that each
+// table is walked once for all of them instead of once per channel.
+// Channels are grouped by instance id. All of them use the same export
+// policy.
+//
 void BgpXmppChannelManager::RoutingInstanceCallback(string vrf_name, int op) {
     CHECK_CONCURRENCY("bgp::Config", "bgp::ConfigHelper");
+    BgpXmppChannel::TableChannelListMap register_map;
     BOOST_FOREACH(XmppChannelMap::value_type &i, channel_map_) {
-        i.second->RoutingInstanceCallback(vrf_name, op);
+        i.second->RoutingInstanceCallback(vrf_name, op, &register_map);
+    }
+
+    BgpMembershipManager *mgr = bgp_server_->membership_mgr();
+    BOOST_FOREACH(BgpXmppChannel::TableChannelListMap::value_type &entry,
+                  register_map) {
+        const BgpXmppChannel::ChannelList &channel_list = entry.second;
+        BgpMembershipManager::PeerList peer_list;
+        BOOST_FOREACH(BgpXmppChannel *channel, channel_list) {
+            peer_list.push_back(channel->Peer());
+        }
+        mgr->RegisterPeerList(peer_list, entry.first.first,
+            channel_list.front()->bgp_policy_, entry.first.second);
     }
 }
 
@@ -14,10 +14,12 @@
 #include <set>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "base/queue_task.h"
 #include "bgp/bgp_rib_policy.h"
 #include "bgp/routing-instance/routing_instance.h"
+#include "db/db_table.h"
 #include "io/tcp_session.h"
 #include "net/rd.h"
 #include "tbb/atomic.h"
@@ -31,7 +33,6 @@ class BgpGlobalSystemConfig;
 class BgpRouterState;
 class BgpServer;
 class BgpXmppRTargetManager;
-struct DBRequest;
 class IPeer;
 class PeerCloseManager;
 class XmppServer;
@@ -102,6 +103,12 @@ public:
          tbb::atomic<uint64_t> inet6_rx_bad_afi_safi_count;
     };
 
+    // BgpXmppChannels to be registered to a BgpTable, keyed by the BgpTable
+    // and the instance id.
+    typedef std::vector<BgpXmppChannel *> ChannelList;
+    typedef std::map<std::pair<BgpTable *, int>, ChannelList>
+        TableChannelListMap;
+
     explicit BgpXmppChannel(XmppChannel *channel, BgpServer *bgp_server = NULL,
                             BgpXmppChannelManager *manager = NULL);
     virtual ~BgpXmppChannel();
@@ -131,7 +138,8 @@ public:
     const ErrorStats &error_stats() const { return error_stats_; }
     void set_deleted(bool deleted) { deleted_ = deleted; }
     bool deleted() { return deleted_; }
-    void RoutingInstanceCallback(std::string vrf_name, int op);
+    void RoutingInstanceCallback(std::string vrf_name, int op,
+        TableChannelListMap *register_map);
     void ASNUpdateCallback(as_t old_asn, as_t old_local_asn);
     void IdentifierUpdateCallback(Ip4Address old_identifier);
     void FillInstanceMembershipInfo(BgpNeighborResp *resp) const;
@@ -313,14 +321,16 @@ private:
         const TableMembershipRequestState *tmr_state);
     void UnregisterTable(int line, BgpTable *table);
     void MembershipRequestCallback(BgpTable *table);
-    void DequeueRequest(const std::string &table_name, DBRequest *request);
+    void DequeueRequests(const std::string &table_name,
+        const DBRequestList &req_list);
     bool XmppDecodeAddress(int af, const std::string &address,
                            IpAddress *addrp, bool zero_ok = false);
     bool ResumeClose();
     void FlushDeferQ(std::string vrf_name);
     void FlushDeferQ(std::string vrf_name, std::string table_name);
     void ProcessDeferredSubscribeRequest(RoutingInstance *rt_instance,
-        const InstanceMembershipRequestState &imr_state);
+        const InstanceMembershipRequestState &imr_state,
+        TableChannelListMap *register_map);
     void ClearStaledSubscription(RoutingInstance *rt_instance,
                                  SubscriptionState *sub_state);
     bool ProcessMembershipResponse(std::string table_name,
@@ -34,6 +34,7 @@ public:
     virtual std::auto_ptr<DBEntry> AllocEntryStr(const std::string &key) const;
 
     virtual Address::Family family() const { return Address::ERMVPN; }
+    virtual size_t GetRouteSize() const { return sizeof(ErmVpnRoute); }
     bool IsMaster() const;
     virtual bool IsVpnTable() const { return IsMaster(); }
 
@@ -9,6 +9,8 @@
 #include "base/string_util.h"
 #include "bgp/bgp_server.h"
 #include "bgp/evpn/evpn_table.h"
+#include "bgp/inet/inet_table.h"
+#include "bgp/inet6/inet6_table.h"
 
 using std::copy;
 using std::string;
@@ -896,6 +898,242 @@ void EvpnPrefix::WriteIpAddress(BgpProtoPrefix *proto_prefix,
     }
 }
 
+//
+// Pack the IpAddress, preceded by a byte for the address type.
+//
+static uint8_t *PackIpAddress(uint8_t *data, const IpAddress &ip_address) {
+    if (ip_address.is_v4()) {
+        *data++ = 0;
+        const Ip4Address::bytes_type &bytes = ip_address.to_v4().to_bytes();
+        return copy(bytes.begin(), bytes.end(), data);
+    } else {
+        *data++ = 1;
+        const Ip6Address::bytes_type &bytes = ip_address.to_v6().to_bytes();
+        return copy(bytes.begin(), bytes.end(), data);
+    }
+}
+
+//
+// Unpack the IpAddress, preceded by a byte for the address type.
+//
+static const uint8_t *UnpackIpAddress(const uint8_t *data,
+    IpAddress *ip_address) {
+    if (*data++ == 0) {
+        Ip4Address::bytes_type bytes;
+        copy(data, data + bytes.size(), bytes.begin());
+        *ip_address = Ip4Address(bytes);
+        return data + bytes.size();
+    } else {
+        Ip6Address::bytes_type bytes;
+        copy(data, data + bytes.size(), bytes.begin());
+        *ip_address = Ip6Address(bytes);
+        return data + bytes.size();
+    }
+}
+
+EvpnPackedPrefix::EvpnPackedPrefix(const EvpnPrefix &prefix) {
+    uint8_t *data = data_;
+    *data++ = prefix.type_;
+
+    switch (prefix.type_) {
+    case EvpnPrefix::AutoDiscoveryRoute:
+        data = copy(prefix.rd_.GetData(),
+            prefix.rd_.GetData() + EvpnPrefix::kRdSize, data);
+        data = copy(prefix.esi_.GetData(),
+            prefix.esi_.GetData() + EvpnPrefix::kEsiSize, data);
+        put_value(data, EvpnPrefix::kTagSize, prefix.tag_);
+        data += EvpnPrefix::kTagSize;
+        break;
+    case EvpnPrefix::MacAdvertisementRoute:
+        data = copy(prefix.rd_.GetData(),
+            prefix.rd_.GetData() + EvpnPrefix::kRdSize, data);
+        put_value(data, EvpnPrefix::kTagSize, prefix.tag_);
+        data += EvpnPrefix::kTagSize;
+        data = copy(prefix.mac_addr_.GetData(),
+            prefix.mac_addr_.GetData() + EvpnPrefix::kMacSize, data);
+        data = PackIpAddress(data, prefix.ip_address_);
+        break;
+    case EvpnPrefix::InclusiveMulticastRoute:
+        data = copy(prefix.rd_.GetData(),
+            prefix.rd_.GetData() + EvpnPrefix::kRdSize, data);
+        put_value(data, EvpnPrefix::kTagSize, prefix.tag_);
+        data += EvpnPrefix::kTagSize;
+        data = PackIpAddress(data, prefix.ip_address_);
+        break;
+    case EvpnPrefix::SegmentRoute:
+        data = copy(prefix.rd_.GetData(),
+            prefix.rd_.GetData() + EvpnPrefix::kRdSize, data);
+        data = copy(prefix.esi_.GetData(),
+            prefix.esi_.GetData() + EvpnPrefix::kEsiSize, data);
+        data = PackIpAddress(data, prefix.ip_address_);
+        break;
+    case EvpnPrefix::IpPrefixRoute:
+        data = copy(prefix.rd_.GetData(),
+            prefix.rd_.GetData() + EvpnPrefix::kRdSize, data);
+        put_value(data, EvpnPrefix::kTagSize, prefix.tag_);
+        data += EvpnPrefix::kTagSize;
+        data = PackIpAddress(data, prefix.ip_address_);
+        *data++ = prefix.ip_prefixlen_;
+        break;
+    default:
+        break;
+    }
+
+    key_size_ = data - data_;
+    *data++ = prefix.family_;
+    assert(static_cast<size_t>(data - data_) <= kMaxSize);
+}
+
+EvpnPrefix EvpnPackedPrefix::ToPrefix() const {
+    EvpnPrefix prefix;
+    const uint8_t *data = data_;
+    prefix.type_ = *data++;
+
+    switch (prefix.type_) {
+    case EvpnPrefix::AutoDiscoveryRoute:
+        prefix.rd_ = RouteDistinguisher(data);
+        data += EvpnPrefix::kRdSize;
+        prefix.esi_ = EthernetSegmentId(data);
+        data += EvpnPrefix::kEsiSize;
+        prefix.tag_ = get_value(data, EvpnPrefix::kTagSize);
+        break;
+    case EvpnPrefix::MacAdvertisementRoute:
+        prefix.rd_ = RouteDistinguisher(data);
+        data += EvpnPrefix::kRdSize;
+        prefix.tag_ = get_value(data, EvpnPrefix::kTagSize);
+        data += EvpnPrefix::kTagSize;
+        prefix.mac_addr_ = MacAddress(data);
+        data += EvpnPrefix::kMacSize;
+        UnpackIpAddress(data, &prefix.ip_address_);
+        break;
+    case EvpnPrefix::InclusiveMulticastRoute:
+        prefix.rd_ = RouteDistinguisher(data);
+        data += EvpnPrefix::kRdSize;
+        prefix.tag_ = get_value(data, EvpnPrefix::kTagSize);
+        data += EvpnPrefix::kTagSize;
+        UnpackIpAddress(data, &prefix.ip_address_);
+        break;
+    case EvpnPrefix::SegmentRoute:
+        prefix.rd_ = RouteDistinguisher(data);
+        data += EvpnPrefix::kRdSize;
+        prefix.esi_ = EthernetSegmentId(data);
+        data += EvpnPrefix::kEsiSize;
+        UnpackIpAddress(data, &prefix.ip_address_);
+        break;
+    case EvpnPrefix::IpPrefixRoute:
+        prefix.rd_ = RouteDistinguisher(data);
+        data += EvpnPrefix::kRdSize;
+        prefix.tag_ = get_value(data, EvpnPrefix::kTagSize);
+        data += EvpnPrefix::kTagSize;
+        data = UnpackIpAddress(data, &prefix.ip_address_);
+        prefix.ip_prefixlen_ = *data;
+        break;
+    default:
+        break;
+    }
+
+    prefix.family_ = static_cast<Address::Family>(data_[key_size_]);
+    return prefix;
+}
+
+int EvpnPackedPrefix::CompareTo(const EvpnPackedPrefix &rhs) const {
+    int result = memcmp(data_, rhs.data_, std::min(key_size_, rhs.key_size_));
+    if (result != 0)
+        return result;
+    KEY_COMPARE(key_size_, rhs.key_size_);
+    return 0;
+}
+
+//
+// Locate the tag, MAC address and IpAddress in the packed key. Returns NULL
+// if the field is not present for the route type.
+//
+const uint8_t *EvpnPackedPrefix::tag_data() const {
+    const uint8_t *data = data_ + 1 + EvpnPrefix::kRdSize;
+    switch (type()) {
+    case EvpnPrefix::AutoDiscoveryRoute:
+        return data + EvpnPrefix::kEsiSize;
+    case EvpnPrefix::MacAdvertisementRoute:
+    case EvpnPrefix::InclusiveMulticastRoute:
+    case EvpnPrefix::IpPrefixRoute:
+        return data;
+    default:
+        return NULL;
+    }
+}
+
+const uint8_t *EvpnPackedPrefix::mac_data() const {
+    if (type() != EvpnPrefix::MacAdvertisementRoute)
+        return NULL;
+    return data_ + 1 + EvpnPrefix::kRdSize + EvpnPrefix::kTagSize;
+}
+
+const uint8_t *EvpnPackedPrefix::ip_data() const {
+    const uint8_t *data = data_ + 1 + EvpnPrefix::kRdSize;
+    switch (type()) {
+    case EvpnPrefix::MacAdvertisementRoute:
+        return data + EvpnPrefix::kTagSize + EvpnPrefix::kMacSize;
+    case EvpnPrefix::InclusiveMulticastRoute:
+    case EvpnPrefix::IpPrefixRoute:
+        return data + EvpnPrefix::kTagSize;
+    case EvpnPrefix::SegmentRoute:
+        return data + EvpnPrefix::kEsiSize;
+    default:
+        return NULL;
+    }
+}
+
+uint32_t EvpnPackedPrefix::tag() const {
+    const uint8_t *data = tag_data();
+    return data ? get_value(data, EvpnPrefix::kTagSize) : 0;
+}
+
+MacAddress EvpnPackedPrefix::mac_addr() const {
+    const uint8_t *data = mac_data();
+    return data ? MacAddress(data) : MacAddress();
+}
+
+IpAddress EvpnPackedPrefix::ip_address() const {
+    IpAddress ip_address;
+    const uint8_t *data = ip_data();
+    if (data)
+        UnpackIpAddress(data, &ip_address);
+    return ip_address;
+}
+
+size_t EvpnPackedPrefix::Hash() const {
+    if (type() == EvpnPrefix::MacAdvertisementRoute) {
+        MacAddress mac(mac_data());
+        if (mac.IsBroadcast())
+            return 0;
+        uint32_t value = get_value(mac_data() + 2, 4);
+        return boost::hash_value(value);
+    }
+    if (type() == EvpnPrefix::IpPrefixRoute) {
+        IpAddress ip_address;
+        const uint8_t *data = UnpackIpAddress(ip_data(), &ip_address);
+        if (ip_address.is_v4()) {
+            return InetTable::HashFunction(
+                Ip4Prefix(ip_address.to_v4(), *data));
+        } else {
+            return Inet6Table::HashFunction(
+                Inet6Prefix(ip_address.to_v6(), *data));
+        }
+    }
+    return 0;
+}
+
+string EvpnPackedPrefix::ToXmppIdString() const {
+    string str;
+    uint32_t tag_value = tag();
+    if (tag_value != 0)
+        str += integerToString(tag_value) + "-";
+    str += mac_addr().ToString();
+    str += "," + ip_address().to_string() + "/" +
+        integerToString(ip_address_length());
+    return str;
+}
+
 EvpnRoute::EvpnRoute(const EvpnPrefix &prefix)
     : prefix_(prefix) {
 }
@@ -906,7 +1144,7 @@ int EvpnRoute::CompareTo(const Route &rhs) const {
 }
 
 string EvpnRoute::ToString() const {
-    return prefix_.ToString();
+    return GetPrefix().ToString();
 }
 
 string EvpnRoute::ToXmppIdString() const {
@@ -967,12 +1205,12 @@ bool EvpnRoute::IsValid() const {
 void EvpnRoute::SetKey(const DBRequestKey *reqkey) {
     const EvpnTable::RequestKey *key =
         static_cast<const EvpnTable::RequestKey *>(reqkey);
-    prefix_ = key->prefix;
+    prefix_ = EvpnPackedPrefix(key->prefix);
 }
 
 void EvpnRoute::BuildProtoPrefix(BgpProtoPrefix *proto_prefix,
     const BgpAttr *attr, uint32_t label, uint32_t l3_label) const {
-    prefix_.BuildProtoPrefix(proto_prefix, attr, label, l3_label);
+    GetPrefix().BuildProtoPrefix(proto_prefix, attr, label, l3_label);
 }
 
 void EvpnRoute::BuildBgpProtoNextHop(vector<uint8_t> &nh,
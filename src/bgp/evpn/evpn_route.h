@@ -99,6 +99,8 @@ public:
     void set_route_distinguisher(const RouteDistinguisher &rd) { rd_ = rd; }
 
 private:
+    friend class EvpnPackedPrefix;
+
     uint8_t type_;
     RouteDistinguisher rd_;
     EthernetSegmentId esi_;
@@ -114,6 +116,64 @@ private:
     void WriteIpAddress(BgpProtoPrefix *proto_prefix, size_t ip_offset) const;
 };
 
+//
+// Compact representation of an EvpnPrefix, kept in each EvpnRoute.
+//
+// An EvpnPrefix has room for the fields of all route types as well as an
+// IpAddress that's big enough for an IPv6 address and scope id. This adds
+// up to 88 bytes, most of which are unused for any given route type.
+//
+// Only the fields that are relevant for the route type get packed into the
+// byte array, in network byte order and in the same order in which they get
+// compared by EvpnPrefix::CompareTo. The IpAddress is preceded by a byte for
+// the address type so that IPv4 addresses sort before IPv6 addresses, same
+// as with IpAddress. This way, comparing packed prefixes is just a memcmp of
+// the packed keys, which yields the same ordering as EvpnPrefix::CompareTo.
+//
+// The family follows the key. It's needed to rebuild the EvpnPrefix but is
+// not part of the key since EvpnPrefix::CompareTo doesn't look at it.
+//
+// The accessors read the fields straight out of the packed key, so hot paths
+// such as table hashing and the xmpp id don't need to rebuild the EvpnPrefix.
+// Hash returns the same value as EvpnTable::HashFunction for the EvpnPrefix.
+//
+class EvpnPackedPrefix {
+public:
+    // Type, RD, ESI, IPv6 address with type byte and family.
+    static const size_t kMaxSize = 1 + 8 + 10 + 1 + 16 + 1;
+
+    explicit EvpnPackedPrefix(const EvpnPrefix &prefix);
+
+    EvpnPrefix ToPrefix() const;
+    int CompareTo(const EvpnPackedPrefix &rhs) const;
+
+    uint8_t type() const { return data_[0]; }
+    RouteDistinguisher route_distinguisher() const {
+        return RouteDistinguisher(data_ + 1);
+    }
+    uint32_t tag() const;
+    MacAddress mac_addr() const;
+    IpAddress ip_address() const;
+    Address::Family family() const {
+        return static_cast<Address::Family>(data_[key_size_]);
+    }
+    uint8_t ip_address_length() const {
+        return family() == Address::INET6 ? 128 : 32;
+    }
+    size_t key_size() const { return key_size_; }
+
+    size_t Hash() const;
+    std::string ToXmppIdString() const;
+
+private:
+    const uint8_t *tag_data() const;
+    const uint8_t *mac_data() const;
+    const uint8_t *ip_data() const;
+
+    uint8_t key_size_;
+    uint8_t data_[kMaxSize];
+};
+
 class EvpnRoute : public BgpRoute {
 public:
     explicit EvpnRoute(const EvpnPrefix &prefix);
@@ -122,7 +182,8 @@ public:
     virtual std::string ToXmppIdString() const;
     virtual bool IsValid() const;
 
-    const EvpnPrefix &GetPrefix() const { return prefix_; }
+    EvpnPrefix GetPrefix() const { return prefix_.ToPrefix(); }
+    const EvpnPackedPrefix &GetPackedPrefix() const { return prefix_; }
 
     virtual KeyPtr GetDBRequestKey() const;
     virtual void SetKey(const DBRequestKey *reqkey);
@@ -144,7 +205,7 @@ public:
     virtual u_int8_t XmppSafi() const { return BgpAf::Enet; }
 
 private:
-    EvpnPrefix prefix_;
+    EvpnPackedPrefix prefix_;
     mutable std::string xmpp_id_str_;
 
     DISALLOW_COPY_AND_ASSIGN(EvpnRoute);
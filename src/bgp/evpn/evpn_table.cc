@@ -58,7 +58,7 @@ void EvpnTable::AddRemoveCallback(const DBEntryBase *entry, bool add) const {
     if (IsVpnTable())
         return;
     const EvpnRoute *evpn_rt = static_cast<const EvpnRoute *>(entry);
-    const EvpnPrefix &evpn_prefix = evpn_rt->GetPrefix();
+    const EvpnPackedPrefix &evpn_prefix = evpn_rt->GetPackedPrefix();
     switch (evpn_prefix.type()) {
     case EvpnPrefix::MacAdvertisementRoute:
         // Ignore Broadcast MAC routes.
@@ -103,7 +103,7 @@ size_t EvpnTable::Hash(const DBRequestKey *key) const {
 
 size_t EvpnTable::Hash(const DBEntry *entry) const {
     const EvpnRoute *rt_entry = static_cast<const EvpnRoute *>(entry);
-    size_t value = HashFunction(rt_entry->GetPrefix());
+    size_t value = rt_entry->GetPackedPrefix().Hash();
     return value % DB::PartitionCount();
 }
 
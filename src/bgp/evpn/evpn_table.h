@@ -30,6 +30,7 @@ public:
     virtual void AddRemoveCallback(const DBEntryBase *entry, bool add) const;
 
     virtual Address::Family family() const { return Address::EVPN; }
+    virtual size_t GetRouteSize() const { return sizeof(EvpnRoute); }
     bool IsMaster() const;
     virtual bool IsVpnTable() const { return IsMaster(); }
 
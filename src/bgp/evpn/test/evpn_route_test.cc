@@ -245,6 +245,155 @@ TEST_F(EvpnIpPrefixRouteTest, GetDBRequestKey) {
     }
 }
 
+class EvpnPackedPrefixTest : public EvpnRouteTest {
+protected:
+    void BuildPrefixList(vector<EvpnPrefix> *prefix_list) {
+        const char *prefix_str_list[] = {
+            "1-10.1.1.1:65535-00:01:02:03:04:05:06:07:08:09-0",
+            "1-10.1.1.1:65535-00:01:02:03:04:05:06:07:08:09-4094",
+            "1-10.1.1.2:1-00:01:02:03:04:05:06:07:08:09-100",
+            "1-10.1.1.2:1-00:01:02:03:04:05:06:07:08:0a-100",
+            "2-10.1.1.1:65535-0-11:12:13:14:15:16,0.0.0.0",
+            "2-10.1.1.1:65535-0-11:12:13:14:15:16,192.1.1.1",
+            "2-10.1.1.1:65535-0-11:12:13:14:15:16,2001:db8::1",
+            "2-10.1.1.1:65535-0-11:12:13:14:15:17,192.1.1.1",
+            "2-10.1.1.1:65535-100-11:12:13:14:15:16,192.1.1.1",
+            "3-10.1.1.1:65535-0-192.1.1.1",
+            "3-10.1.1.1:65535-0-2001:db8::1",
+            "3-10.1.1.1:65535-100-192.1.1.1",
+            "4-10.1.1.1:65535-00:01:02:03:04:05:06:07:08:09-192.1.1.1",
+            "4-10.1.1.1:65535-00:01:02:03:04:05:06:07:08:09-2001:db8::1",
+            "5-10.1.1.1:65535-0-192.1.1.0/24",
+            "5-10.1.1.1:65535-0-192.1.1.0/25",
+            "5-10.1.1.1:65535-0-2001:db8::/64",
+            "5-10.1.1.1:65535-100-192.1.1.0/24",
+        };
+        BOOST_FOREACH(const char *prefix_str, prefix_str_list) {
+            boost::system::error_code ec;
+            prefix_list->push_back(EvpnPrefix::FromString(prefix_str, &ec));
+            EXPECT_FALSE(ec) << prefix_str;
+        }
+        prefix_list->push_back(EvpnPrefix::kNullPrefix);
+    }
+};
+
+//
+// The prefix in the route is the same as the one it was created with.
+//
+TEST_F(EvpnPackedPrefixTest, ToPrefix) {
+    vector<EvpnPrefix> prefix_list;
+    BuildPrefixList(&prefix_list);
+    BOOST_FOREACH(const EvpnPrefix &prefix, prefix_list) {
+        EvpnRoute route(prefix);
+        EvpnPrefix route_prefix = route.GetPrefix();
+        EXPECT_EQ(prefix, route_prefix);
+        EXPECT_EQ(prefix.ToString(), route_prefix.ToString());
+        EXPECT_EQ(prefix.family(), route_prefix.family());
+        EXPECT_EQ(prefix.ip_prefix_length(), route_prefix.ip_prefix_length());
+        EXPECT_EQ(prefix.esi(), route_prefix.esi());
+        EXPECT_EQ(prefix.mac_addr(), route_prefix.mac_addr());
+        EXPECT_EQ(prefix.ip_address(), route_prefix.ip_address());
+    }
+}
+
+//
+// A MacAdvertisementRoute with an unspecified IPv4 address received from a
+// peer has family INET. The family is preserved although it's not part of
+// the key.
+//
+TEST_F(EvpnPackedPrefixTest, Family) {
+    string prefix_str("2-10.1.1.1:65535-0-11:12:13:14:15:16,0.0.0.0");
+    EvpnPrefix prefix1(EvpnPrefix::FromString(prefix_str));
+    EXPECT_EQ(Address::UNSPEC, prefix1.family());
+
+    // RD, ESI, tag, MAC length, MAC, IP length and IP address 0.0.0.0.
+    BgpProtoPrefix proto_prefix;
+    proto_prefix.type = EvpnPrefix::MacAdvertisementRoute;
+    const uint8_t *rd_data = prefix1.route_distinguisher().GetData();
+    proto_prefix.prefix.insert(proto_prefix.prefix.end(),
+        rd_data, rd_data + EvpnPrefix::kRdSize);
+    proto_prefix.prefix.resize(
+        EvpnPrefix::kRdSize + EvpnPrefix::kEsiSize + EvpnPrefix::kTagSize, 0);
+    proto_prefix.prefix.push_back(48);
+    const uint8_t *mac_data = prefix1.mac_addr().GetData();
+    proto_prefix.prefix.insert(proto_prefix.prefix.end(),
+        mac_data, mac_data + EvpnPrefix::kMacSize);
+    proto_prefix.prefix.push_back(32);
+    proto_prefix.prefix.resize(proto_prefix.prefix.size() + 4, 0);
+    proto_prefix.prefixlen = proto_prefix.prefix.size() * 8;
+
+    EvpnPrefix prefix2;
+    BgpAttrPtr attr_out;
+    uint32_t label;
+    int result = EvpnPrefix::FromProtoPrefix(&server_, proto_prefix, NULL,
+        &prefix2, &attr_out, &label);
+    EXPECT_EQ(0, result);
+    EXPECT_EQ(Address::INET, prefix2.family());
+    EXPECT_EQ(prefix1, prefix2);
+
+    EvpnRoute route1(prefix1);
+    EvpnRoute route2(prefix2);
+    EXPECT_EQ(0, route1.CompareTo(route2));
+    EXPECT_EQ(Address::UNSPEC, route1.GetPrefix().family());
+    EXPECT_EQ(Address::INET, route2.GetPrefix().family());
+}
+
+//
+// Routes compare the same way as their prefixes.
+//
+TEST_F(EvpnPackedPrefixTest, CompareTo) {
+    vector<EvpnPrefix> prefix_list;
+    BuildPrefixList(&prefix_list);
+    BOOST_FOREACH(const EvpnPrefix &prefix1, prefix_list) {
+        EvpnRoute route1(prefix1);
+        BOOST_FOREACH(const EvpnPrefix &prefix2, prefix_list) {
+            EvpnRoute route2(prefix2);
+            int prefix_result = prefix1.CompareTo(prefix2);
+            int route_result = route1.CompareTo(route2);
+            EXPECT_EQ(prefix_result < 0, route_result < 0)
+                << prefix1.ToString() << " " << prefix2.ToString();
+            EXPECT_EQ(prefix_result > 0, route_result > 0)
+                << prefix1.ToString() << " " << prefix2.ToString();
+        }
+    }
+}
+
+//
+// The accessors read the same values as the prefix, and the packed prefix
+// hashes to the same value as the prefix.
+//
+TEST_F(EvpnPackedPrefixTest, Accessors) {
+    vector<EvpnPrefix> prefix_list;
+    BuildPrefixList(&prefix_list);
+    prefix_list.push_back(EvpnPrefix::FromString(
+        "2-10.1.1.1:65535-0-ff:ff:ff:ff:ff:ff,0.0.0.0"));
+    BOOST_FOREACH(const EvpnPrefix &prefix, prefix_list) {
+        EvpnRoute route(prefix);
+        const EvpnPackedPrefix &packed = route.GetPackedPrefix();
+        EXPECT_EQ(prefix.type(), packed.type());
+        if (prefix.type() != EvpnPrefix::Unspecified) {
+            EXPECT_EQ(prefix.route_distinguisher(),
+                packed.route_distinguisher());
+        }
+        EXPECT_EQ(prefix.tag(), packed.tag()) << prefix.ToString();
+        EXPECT_EQ(prefix.mac_addr(), packed.mac_addr()) << prefix.ToString();
+        EXPECT_EQ(prefix.ip_address(), packed.ip_address())
+            << prefix.ToString();
+        EXPECT_EQ(prefix.family(), packed.family());
+        EXPECT_EQ(prefix.ip_address_length(), packed.ip_address_length());
+        EXPECT_EQ(prefix.ToXmppIdString(), route.ToXmppIdString());
+        EXPECT_EQ(EvpnTable::HashFunction(prefix), packed.Hash())
+            << prefix.ToString();
+    }
+}
+
+TEST_F(EvpnPackedPrefixTest, Size) {
+    EXPECT_LT(sizeof(EvpnPackedPrefix), sizeof(EvpnPrefix));
+    std::cout << "EvpnPrefix " << sizeof(EvpnPrefix)
+        << " EvpnPackedPrefix " << sizeof(EvpnPackedPrefix)
+        << " EvpnRoute " << sizeof(EvpnRoute) << std::endl;
+}
+
 int main(int argc, char **argv) {
     bgp_log_test::init();
     ::testing::InitGoogleTest(&argc, argv);
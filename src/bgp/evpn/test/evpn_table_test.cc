@@ -5,7 +5,12 @@
 #include "bgp/evpn/evpn_table.h"
 
 
+#include <boost/foreach.hpp>
+
+#include <iostream>
+
 #include "base/task_annotations.h"
+#include "base/time_util.h"
 #include "bgp/bgp_evpn.h"
 #include "bgp/bgp_factory.h"
 #include "bgp/origin-vn/origin_vn.h"
@@ -1951,6 +1956,99 @@ TEST_F(EvpnTableIpPrefixTest, ReplicateRouteVRFToVRF2) {
     TASK_UTIL_EXPECT_EQ(0, blue_si_->Size());
 }
 
+class EvpnTableBenchmarkTest : public EvpnTableTest {
+protected:
+    string BuildPrefix(int idx, bool mac_route) {
+        char prefix_str[64];
+        if (mac_route) {
+            snprintf(prefix_str, sizeof(prefix_str),
+                "2-10.1.1.1:65535-0-00:00:00:%02x:%02x:%02x,192.1.%d.%d",
+                (idx >> 16) & 0xff, (idx >> 8) & 0xff, idx & 0xff,
+                (idx >> 8) & 0xff, idx & 0xff);
+        } else {
+            snprintf(prefix_str, sizeof(prefix_str),
+                "5-10.1.1.1:65535-0-10.%d.%d.0/24",
+                (idx >> 8) & 0xff, idx & 0xff);
+        }
+        return prefix_str;
+    }
+};
+
+//
+// Time insert and lookup of MAC and IP prefix routes. Lookup by route hashes
+// the packed prefix in the route. The decode and packed numbers compare the
+// cost of hashing the EvpnPrefix rebuilt from the route with hashing the
+// packed prefix directly.
+//
+TEST_F(EvpnTableBenchmarkTest, InsertLookup) {
+    static const int kRouteCounts[] = { 1024, 8192 };
+    static const int kHashRounds = 16;
+
+    for (int mode = 0; mode < 2; ++mode) {
+        bool mac_route = (mode == 0);
+        BOOST_FOREACH(int route_count, kRouteCounts) {
+            uint64_t start = ClockMonotonicUsec();
+            for (int idx = 0; idx < route_count; ++idx) {
+                AddRoute(master_, BuildPrefix(idx, mac_route));
+            }
+            task_util::WaitForIdle();
+            uint64_t insert_usec = ClockMonotonicUsec() - start;
+            TASK_UTIL_EXPECT_EQ(route_count, master_->Size());
+
+            vector<EvpnRoute *> route_list;
+            start = ClockMonotonicUsec();
+            for (int idx = 0; idx < route_count; ++idx) {
+                EvpnPrefix prefix(
+                    EvpnPrefix::FromString(BuildPrefix(idx, mac_route)));
+                EvpnTable::RequestKey key(prefix, NULL);
+                route_list.push_back(
+                    static_cast<EvpnRoute *>(master_->Find(&key)));
+            }
+            uint64_t key_lookup_usec = ClockMonotonicUsec() - start;
+
+            start = ClockMonotonicUsec();
+            BOOST_FOREACH(EvpnRoute *route, route_list) {
+                EXPECT_EQ(route, master_->Find(route));
+            }
+            uint64_t route_lookup_usec = ClockMonotonicUsec() - start;
+
+            size_t decode_sum = 0;
+            start = ClockMonotonicUsec();
+            for (int round = 0; round < kHashRounds; ++round) {
+                BOOST_FOREACH(EvpnRoute *route, route_list) {
+                    decode_sum += EvpnTable::HashFunction(route->GetPrefix());
+                }
+            }
+            uint64_t decode_usec = ClockMonotonicUsec() - start;
+
+            size_t packed_sum = 0;
+            start = ClockMonotonicUsec();
+            for (int round = 0; round < kHashRounds; ++round) {
+                BOOST_FOREACH(EvpnRoute *route, route_list) {
+                    packed_sum += route->GetPackedPrefix().Hash();
+                }
+            }
+            uint64_t packed_usec = ClockMonotonicUsec() - start;
+            EXPECT_EQ(decode_sum, packed_sum);
+
+            std::cout << (mac_route ? "MAC" : "IP prefix")
+                << " Routes " << route_count
+                << " Insert " << insert_usec << " usec"
+                << " Lookup by key " << key_lookup_usec << " usec"
+                << " Lookup by route " << route_lookup_usec << " usec"
+                << " Hash x" << kHashRounds
+                << " decode " << decode_usec << " usec"
+                << " packed " << packed_usec << " usec" << std::endl;
+
+            for (int idx = 0; idx < route_count; ++idx) {
+                DelRoute(master_, BuildPrefix(idx, mac_route));
+            }
+            task_util::WaitForIdle();
+            TASK_UTIL_EXPECT_EQ(0, master_->Size());
+        }
+    }
+}
+
 int main(int argc, char **argv) {
     bgp_log_test::init();
     ::testing::InitGoogleTest(&argc, argv);
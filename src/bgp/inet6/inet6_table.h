@@ -34,6 +34,7 @@ public:
     virtual std::auto_ptr<DBEntry> AllocEntryStr(const std::string &key) const;
 
     virtual Address::Family family() const { return Address::INET6; }
+    virtual size_t GetRouteSize() const { return sizeof(Inet6Route); }
 
     virtual size_t Hash(const DBEntry *entry) const;
     virtual size_t Hash(const DBRequestKey *key) const;
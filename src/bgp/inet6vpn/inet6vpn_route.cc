@@ -4,6 +4,8 @@
 
 #include "bgp/inet6vpn/inet6vpn_route.h"
 
+#include <boost/functional/hash.hpp>
+
 #include <algorithm>
 
 #include "bgp/inet6vpn/inet6vpn_table.h"
@@ -149,19 +151,43 @@ bool Inet6VpnPrefix::operator==(const Inet6VpnPrefix &rhs) const {
             prefixlen_ == rhs.prefixlen_);
 }
 
-Inet6VpnRoute::Inet6VpnRoute(const Inet6VpnPrefix &prefix) : prefix_(prefix) {
+Inet6VpnRoute::Inet6VpnRoute(const Inet6VpnPrefix &prefix) {
+    SetPrefix(prefix);
+}
+
+void Inet6VpnRoute::SetPrefix(const Inet6VpnPrefix &prefix) {
+    uint8_t *data = copy(prefix.route_distinguisher().GetData(),
+        prefix.route_distinguisher().GetData() + RouteDistinguisher::kSize,
+        prefix_);
+    const Ip6Address::bytes_type &addr_bytes = prefix.addr().to_bytes();
+    data = copy(addr_bytes.begin(), addr_bytes.end(), data);
+    *data = prefix.prefixlen();
+}
+
+Inet6VpnPrefix Inet6VpnRoute::GetPrefix() const {
+    const uint8_t *data = prefix_ + RouteDistinguisher::kSize;
+    Ip6Address::bytes_type addr_bytes;
+    copy(data, data + addr_bytes.size(), addr_bytes.begin());
+    return Inet6VpnPrefix(RouteDistinguisher(prefix_), Ip6Address(addr_bytes),
+        data[addr_bytes.size()]);
+}
+
+size_t Inet6VpnRoute::Hash() const {
+    const uint8_t *data = prefix_ + RouteDistinguisher::kSize;
+    return boost::hash_range(data, data + sizeof(Ip6Address::bytes_type));
 }
 
 int Inet6VpnRoute::CompareTo(const Route &rhs) const {
     const Inet6VpnRoute &other = static_cast<const Inet6VpnRoute &>(rhs);
-    return prefix_.CompareTo(other.GetPrefix());
+    return memcmp(prefix_, other.prefix_, kPrefixSize);
 }
 
 string Inet6VpnRoute::ToString() const {
-    string repr = prefix_.route_distinguisher().ToString() + ":";
-    repr += prefix_.addr().to_string();
+    Inet6VpnPrefix prefix = GetPrefix();
+    string repr = prefix.route_distinguisher().ToString() + ":";
+    repr += prefix.addr().to_string();
     char strplen[5];
-    snprintf(strplen, sizeof(strplen), "/%d", prefix_.prefixlen());
+    snprintf(strplen, sizeof(strplen), "/%d", prefix.prefixlen());
     repr.append(strplen);
 
     return repr;
@@ -170,14 +196,14 @@ string Inet6VpnRoute::ToString() const {
 void Inet6VpnRoute::SetKey(const DBRequestKey *reqkey) {
     const Inet6VpnTable::RequestKey *key =
         static_cast<const Inet6VpnTable::RequestKey *>(reqkey);
-    prefix_ = key->prefix;
+    SetPrefix(key->prefix);
 }
 
 void Inet6VpnRoute::BuildProtoPrefix(BgpProtoPrefix *prefix,
                                      const BgpAttr*,
                                     uint32_t label,
                                     uint32_t l3_label) const {
-    prefix_.BuildProtoPrefix(label, prefix);
+    GetPrefix().BuildProtoPrefix(label, prefix);
 }
 
 // XXX dest_nh should have been pointer. See if can change
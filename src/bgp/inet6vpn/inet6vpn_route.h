@@ -56,13 +56,15 @@ public:
 
     virtual std::string ToString() const;
 
-    const Inet6VpnPrefix &GetPrefix() const {
-        return prefix_;
-    }
+    Inet6VpnPrefix GetPrefix() const;
     virtual RouteDistinguisher GetRouteDistinguisher() const {
-        return prefix_.route_distinguisher();
+        return RouteDistinguisher(prefix_);
     }
 
+    // Same value as Inet6Table::HashFunction for the address, but computed
+    // from the packed prefix without rebuilding the Inet6VpnPrefix.
+    size_t Hash() const;
+
     virtual KeyPtr GetDBRequestKey() const;
     virtual void SetKey(const DBRequestKey *reqkey);
     virtual void BuildProtoPrefix(BgpProtoPrefix *prefix, const BgpAttr *attr,
@@ -82,7 +84,15 @@ public:
     virtual bool IsLessSpecific(const std::string &other) const;
 
 private:
-    Inet6VpnPrefix prefix_;
+    // The prefix is kept packed as RD, address and prefix length, which
+    // compare the same way as the Inet6VpnPrefix when using memcmp. This
+    // avoids the padding and the scope id in the Inet6VpnPrefix.
+    static const size_t kPrefixSize =
+        RouteDistinguisher::kSize + sizeof(Ip6Address::bytes_type) + 1;
+
+    void SetPrefix(const Inet6VpnPrefix &prefix);
+
+    uint8_t prefix_[kPrefixSize];
     DISALLOW_COPY_AND_ASSIGN(Inet6VpnRoute);
 };
 
@@ -28,9 +28,7 @@ Inet6VpnTable::AllocEntryStr(const std::string &key_str) const {
 
 size_t Inet6VpnTable::Hash(const DBEntry *entry) const {
     const Inet6VpnRoute *vpn_route = static_cast<const Inet6VpnRoute *>(entry);
-    const Inet6VpnPrefix &vpn_prefix = vpn_route->GetPrefix();
-    Inet6Prefix prefix(vpn_prefix.addr(), vpn_prefix.prefixlen());
-    size_t value = Inet6Table::HashFunction(prefix);
+    size_t value = vpn_route->Hash();
     return value % DB::PartitionCount();
 }
 
@@ -31,6 +31,7 @@ public:
     virtual std::auto_ptr<DBEntry> AllocEntryStr(const std::string &key) const;
 
     virtual Address::Family family() const { return Address::INET6VPN; }
+    virtual size_t GetRouteSize() const { return sizeof(Inet6VpnRoute); }
     virtual bool IsVpnTable() const { return true; }
 
     virtual size_t Hash(const DBEntry *entry) const;
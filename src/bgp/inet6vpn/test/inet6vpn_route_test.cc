@@ -4,6 +4,7 @@
 
 
 #include "bgp/bgp_log.h"
+#include "bgp/inet6/inet6_table.h"
 #include "bgp/inet6vpn/inet6vpn_table.h"
 #include "control-node/control_node.h"
 #include "testing/gunit.h"
@@ -403,6 +404,30 @@ TEST_F(Inet6VpnRouteTest, IsLessSpecific2) {
         "20.1.1.1:255:2001:0db8:85a3:f85d::/64"));
 }
 
+// The prefix in the route is the same as the one it was created with.
+TEST_F(Inet6VpnRouteTest, GetPrefix) {
+    const char *prefix_str_list[] = {
+        "100:65535:2001:db8:85a3::8a2e:370:aaaa/128",
+        "20.1.1.1:255:2001:0db8:85a3:f85d::/64",
+        "100:1:2001:db8::/32",
+    };
+    for (size_t idx = 0;
+         idx < sizeof(prefix_str_list) / sizeof(prefix_str_list[0]); ++idx) {
+        boost::system::error_code ec;
+        Inet6VpnPrefix prefix =
+            Inet6VpnPrefix::FromString(prefix_str_list[idx], &ec);
+        EXPECT_FALSE(ec);
+        Inet6VpnRoute route(prefix);
+        EXPECT_EQ(prefix, route.GetPrefix());
+        EXPECT_EQ(prefix.route_distinguisher(),
+            route.GetRouteDistinguisher());
+        EXPECT_EQ(prefix.ToString(), route.GetPrefix().ToString());
+        EXPECT_EQ(Inet6Table::HashFunction(
+            Inet6Prefix(prefix.addr(), prefix.prefixlen())), route.Hash());
+    }
+    EXPECT_LT(sizeof(Inet6VpnRoute) - sizeof(BgpRoute), sizeof(Inet6VpnPrefix));
+}
+
 int main(int argc, char **argv) {
     bgp_log_test::init();
     ::testing::InitGoogleTest(&argc, argv);
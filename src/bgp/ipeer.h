@@ -120,6 +120,37 @@ public:
         tbb::atomic<uint64_t> blocked_duration_usecs;
     };
 
+    //
+    // Histograms of the number of prefixes and the number of bytes in the
+    // update messages sent to the peer. Bucket 0 counts messages with a
+    // value of 0, bucket i messages with a value in [2^(i-1), 2^i) and the
+    // last bucket everything larger.
+    //
+    struct PackingStats {
+        static const int kBucketCount = 18;
+
+        PackingStats() {
+            for (int idx = 0; idx < kBucketCount; ++idx) {
+                prefixes[idx] = 0;
+                bytes[idx] = 0;
+            }
+        }
+        static int Bucket(uint64_t value) {
+            int bucket = 0;
+            while (value && bucket < kBucketCount - 1) {
+                value >>= 1;
+                bucket++;
+            }
+            return bucket;
+        }
+        void Update(uint64_t prefix_count, uint64_t byte_count) {
+            prefixes[Bucket(prefix_count)]++;
+            bytes[Bucket(byte_count)]++;
+        }
+        tbb::atomic<uint64_t> prefixes[kBucketCount];
+        tbb::atomic<uint64_t> bytes[kBucketCount];
+    };
+
     virtual ~IPeerDebugStats() { }
 
     // Reset all counters
@@ -148,9 +179,11 @@ public:
     virtual void GetTxProtoStats(ProtoStats *stats) const = 0;
     virtual void GetTxRouteUpdateStats(UpdateStats *stats) const = 0;
     virtual void GetTxSocketStats(SocketStats *stats) const = 0;
+    virtual void GetTxPackingStats(PackingStats *stats) const = 0;
 
     virtual void UpdateTxReachRoute(uint64_t count) = 0;
     virtual void UpdateTxUnreachRoute(uint64_t count) = 0;
+    virtual void UpdateTxPacking(uint64_t prefixes, uint64_t bytes) = 0;
 };
 
 // Interface for PeerCloseManager clients
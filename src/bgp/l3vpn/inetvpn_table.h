@@ -32,7 +32,9 @@ public:
     virtual std::auto_ptr<DBEntry> AllocEntryStr(const std::string &key) const;
 
     virtual Address::Family family() const { return Address::INETVPN; }
+    virtual size_t GetRouteSize() const { return sizeof(InetVpnRoute); }
     virtual bool IsVpnTable() const { return true; }
+    virtual bool UseBTreeIndex() const { return true; }
 
     virtual size_t Hash(const DBEntry *entry) const;
     virtual size_t Hash(const DBRequestKey *key) const;
@@ -19,7 +19,10 @@ class RibOut;
 
 class Message {
 public:
-    Message() : num_reach_route_(0), num_unreach_route_(0) { }
+    Message()
+        : num_reach_route_(0), num_unreach_route_(0),
+          num_attr_cache_hit_(0), num_attr_cache_miss_(0) {
+    }
     virtual ~Message() { }
     virtual bool Start(const RibOut *ribout, bool cache_routes,
         const RibOutAttr *roattr, const BgpRoute *route) = 0;
@@ -27,16 +30,23 @@ public:
     virtual void Finish() = 0;
     virtual const uint8_t *GetData(IPeerUpdate *peer_update, size_t *lenp,
         const std::string **msg_str) = 0;
+    virtual void ClearCache(const BgpTable *table) { }
     uint64_t num_reach_routes() const { return num_reach_route_; }
     uint64_t num_unreach_routes() const { return num_unreach_route_; }
+    uint64_t num_attr_cache_hits() const { return num_attr_cache_hit_; }
+    uint64_t num_attr_cache_misses() const { return num_attr_cache_miss_; }
 
 protected:
     uint64_t num_reach_route_;
     uint64_t num_unreach_route_;
+    uint64_t num_attr_cache_hit_;
+    uint64_t num_attr_cache_miss_;
 
     virtual void Reset() {
         num_reach_route_ =  0;
         num_unreach_route_ = 0;
+        num_attr_cache_hit_ = 0;
+        num_attr_cache_miss_ = 0;
     }
 
 private:
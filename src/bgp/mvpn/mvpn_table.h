@@ -33,6 +33,7 @@ public:
     virtual std::auto_ptr<DBEntry> AllocEntryStr(const std::string &key) const;
 
     virtual Address::Family family() const { return Address::MVPN; }
+    virtual size_t GetRouteSize() const { return sizeof(MvpnRoute); }
     bool IsMaster() const;
     virtual bool IsVpnTable() const { return IsMaster(); }
 
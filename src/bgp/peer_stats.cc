@@ -4,6 +4,10 @@
 
 #include "bgp/peer_stats.h"
 
+#include <vector>
+
+using std::vector;
+
 void PeerStats::FillProtoStats(const IPeerDebugStats::ProtoStats &stats,
                                PeerProtoStats *proto_stats) {
     proto_stats->set_open(stats.open);
@@ -38,6 +42,19 @@ void PeerStats::FillRxRouteStats(const IPeerDebugStats::RxRouteStats &src,
     dest->set_primary_path_count(src.primary_path_count);
 }
 
+void PeerStats::FillTxPackingStats(const IPeerDebugStats::PackingStats &src,
+                                   PeerTxPackingStats *dest) {
+    vector<uint64_t> prefixes;
+    vector<uint64_t> bytes;
+    for (int idx = 0; idx < IPeerDebugStats::PackingStats::kBucketCount;
+         ++idx) {
+        prefixes.push_back(src.prefixes[idx]);
+        bytes.push_back(src.bytes[idx]);
+    }
+    dest->set_prefixes_per_message(prefixes);
+    dest->set_bytes_per_message(bytes);
+}
+
 void PeerStats::FillPeerUpdateStats(const IPeerDebugStats *peer_stats,
                                     PeerUpdateStats *rt_stats_rx,
                                     PeerUpdateStats *rt_stats_tx) {
@@ -69,6 +86,7 @@ void PeerStats::FillPeerDebugStats(const IPeerDebugStats *peer_stats,
     PeerUpdateStats rt_stats_tx;
     PeerRxErrorStats dest_error_stats_rx;
     PeerRxRouteStats dest_route_stats_rx;
+    PeerTxPackingStats dest_packing_stats_tx;
 
     IPeerDebugStats::ProtoStats stats_rx;
     peer_stats->GetRxProtoStats(&stats_rx);
@@ -88,10 +106,15 @@ void PeerStats::FillPeerDebugStats(const IPeerDebugStats *peer_stats,
     peer_stats->GetRxRouteStats(&src_route_stats_rx);
     FillRxRouteStats(src_route_stats_rx, &dest_route_stats_rx);
 
+    IPeerDebugStats::PackingStats src_packing_stats_tx;
+    peer_stats->GetTxPackingStats(&src_packing_stats_tx);
+    FillTxPackingStats(src_packing_stats_tx, &dest_packing_stats_tx);
+
     stats->set_rx_proto_stats(proto_stats_rx);
     stats->set_tx_proto_stats(proto_stats_tx);
     stats->set_rx_update_stats(rt_stats_rx);
     stats->set_tx_update_stats(rt_stats_tx);
     stats->set_rx_error_stats(dest_error_stats_rx);
     stats->set_rx_route_stats(dest_route_stats_rx);
+    stats->set_tx_packing_stats(dest_packing_stats_tx);
 }
@@ -24,6 +24,8 @@ private:
                                  PeerRxErrorStats *dest);
     static void FillRxRouteStats(const IPeerDebugStats::RxRouteStats &src,
                                  PeerRxRouteStats *dest);
+    static void FillTxPackingStats(const IPeerDebugStats::PackingStats &src,
+                                   PeerTxPackingStats *dest);
     static void FillPeerUpdateStats(const IPeerDebugStats *peer_stats,
                                     PeerUpdateStats *rt_stats_rx,
                                     PeerUpdateStats *rt_stats_tx);
@@ -11,6 +11,8 @@
 #include "base/task.h"
 #include "base/task_annotations.h"
 #include "base/task_trigger.h"
+#include "base/time_util.h"
+#include "base/timer.h"
 #include "bgp/bgp_log.h"
 #include "bgp/bgp_peer_types.h"
 #include "bgp/bgp_server.h"
@@ -43,6 +45,18 @@ static bool RoutePrefixIsAddress(Address::Family family, const BgpRoute *route,
     return false;
 }
 
+//
+// The nexthop hold time in msec can be set via the environment for now.
+// The default of 0 disables coalescing of ResolverNexthop updates.
+//
+static int GetNexthopHoldTime() {
+    char *hold_time_str = getenv("BGP_RESOLVER_NEXTHOP_HOLD_TIME");
+    if (!hold_time_str)
+        return 0;
+    int hold_time = strtol(hold_time_str, NULL, 0);
+    return (hold_time > 0 ? hold_time : 0);
+}
+
 class PathResolver::DeleteActor : public LifetimeActor {
 public:
     explicit DeleteActor(PathResolver *resolver)
@@ -86,6 +100,14 @@ PathResolver::PathResolver(BgpTable *table)
           boost::bind(&PathResolver::ProcessResolverNexthopUpdateList, this),
           TaskScheduler::GetInstance()->GetTaskId("bgp::ResolverNexthop"),
           0)),
+      nexthop_hold_time_(GetNexthopHoldTime()),
+      nexthop_hold_timer_(TimerManager::CreateTimer(
+          *table->server()->ioservice(), "PathResolver nexthop hold timer",
+          TaskScheduler::GetInstance()->GetTaskId("bgp::ResolverNexthop"),
+          0)),
+      nexthop_update_time_(0),
+      nexthop_update_count_(0),
+      nexthop_processed_count_(0),
       deleter_(new DeleteActor(this)),
       table_delete_ref_(this, table->deleter()) {
     for (int part_id = 0; part_id < DB::PartitionCount(); ++part_id) {
@@ -108,6 +130,7 @@ PathResolver::~PathResolver() {
     STLDeleteValues(&partitions_);
     nexthop_reg_unreg_trigger_->Reset();
     nexthop_update_trigger_->Reset();
+    TimerManager::DeleteTimer(nexthop_hold_timer_);
 }
 
 //
@@ -192,10 +215,22 @@ void PathResolver::RegisterUnregisterResolverNexthop(
 // Add a ResolverNexthop to the update list and start the Task to process the
 // list.
 //
+// If there's a nexthop hold time, start the hold timer instead. This is a
+// noop if the timer is already running. Any further updates to the same
+// ResolverNexthop before the timer fires get coalesced with this one.
+//
 void PathResolver::UpdateResolverNexthop(ResolverNexthop *rnexthop) {
     tbb::mutex::scoped_lock lock(mutex_);
+    nexthop_update_count_++;
+    if (nexthop_update_list_.empty())
+        nexthop_update_time_ = ClockMonotonicUsec();
     nexthop_update_list_.insert(rnexthop);
-    nexthop_update_trigger_->Set();
+    if (nexthop_hold_time_ == 0) {
+        nexthop_update_trigger_->Set();
+    } else {
+        nexthop_hold_timer_->Start(nexthop_hold_time_,
+            boost::bind(&PathResolver::NexthopHoldTimerExpired, this));
+    }
 }
 
 //
@@ -379,6 +414,10 @@ bool PathResolver::ProcessResolverNexthopRegUnregList() {
 //
 // Handle processing of all ResolverNexthops on the update list.
 //
+// The time at which the first ResolverNexthop was added to the list is
+// passed on to the PathResolverPartitions so that they can account for
+// the full resolution latency.
+//
 bool PathResolver::ProcessResolverNexthopUpdateList() {
     CHECK_CONCURRENCY("bgp::ResolverNexthop");
 
@@ -386,12 +425,25 @@ bool PathResolver::ProcessResolverNexthopUpdateList() {
          it != nexthop_update_list_.end(); ++it) {
         ResolverNexthop *rnexthop = *it;
         assert(!rnexthop->deleted());
-        rnexthop->TriggerAllResolverPaths();
+        rnexthop->TriggerAllResolverPaths(nexthop_update_time_);
     }
+    nexthop_processed_count_ += nexthop_update_list_.size();
     nexthop_update_list_.clear();
+    nexthop_update_time_ = 0;
     return true;
 }
 
+//
+// Handler for the nexthop hold timer.
+// Start the Task to process the update list.
+//
+bool PathResolver::NexthopHoldTimerExpired() {
+    CHECK_CONCURRENCY("bgp::ResolverNexthop");
+
+    nexthop_update_trigger_->Set();
+    return false;
+}
+
 //
 // Return true if the DeleteActor is marked deleted.
 //
@@ -505,6 +557,15 @@ size_t PathResolver::GetResolverNexthopUpdateListSize() const {
     return nexthop_update_list_.size();
 }
 
+//
+// Set the nexthop hold time.
+// For testing only.
+//
+void PathResolver::SetResolverNexthopHoldTime(int hold_time) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    nexthop_hold_time_ = hold_time;
+}
+
 //
 // Disable processing of the path update list in all partitions.
 // For testing only.
@@ -565,11 +626,18 @@ void PathResolver::FillShowInfo(ShowPathResolver *spr, bool summary) const {
 
     size_t path_count = 0;
     size_t modified_path_count = 0;
+    uint64_t update_count = 0;
+    uint64_t total_latency_usecs = 0;
+    uint64_t max_latency_usecs = 0;
     vector<ShowPathResolverPath> sprp_list;
     for (int part_id = 0; part_id < DB::PartitionCount(); ++part_id) {
         const PathResolverPartition *partition = partitions_[part_id];
         path_count += partition->rpath_map_.size();
         modified_path_count += partition->rpath_update_list_.size();
+        update_count += partition->update_count_;
+        total_latency_usecs += partition->total_latency_usecs_;
+        if (partition->max_latency_usecs_ > max_latency_usecs)
+            max_latency_usecs = partition->max_latency_usecs_;
         if (summary)
             continue;
         for (PathResolverPartition::PathToResolverPathMap::const_iterator it =
@@ -588,6 +656,16 @@ void PathResolver::FillShowInfo(ShowPathResolver *spr, bool summary) const {
     spr->set_nexthop_count(nexthop_map_.size());
     spr->set_modified_nexthop_count(nexthop_reg_unreg_list_.size() +
         nexthop_delete_list_.size() + nexthop_update_list_.size());
+    spr->set_nexthop_hold_time(nexthop_hold_time_);
+    spr->set_nexthop_update_count(nexthop_update_count_);
+    spr->set_nexthop_processed_count(nexthop_processed_count_);
+    spr->set_nexthop_coalesce_ratio(nexthop_processed_count_ ?
+        static_cast<double>(nexthop_update_count_) / nexthop_processed_count_ :
+        0.0);
+    spr->set_path_update_count(update_count);
+    spr->set_path_update_avg_latency_usecs(
+        update_count ? total_latency_usecs / update_count : 0);
+    spr->set_path_update_max_latency_usecs(max_latency_usecs);
 
     if (summary)
         return;
@@ -626,7 +704,11 @@ PathResolverPartition::PathResolverPartition(int part_id,
           boost::bind(&PathResolverPartition::ProcessResolverPathUpdateList,
               this),
           TaskScheduler::GetInstance()->GetTaskId("bgp::ResolverPath"),
-          part_id)) {
+          part_id)),
+      rpath_update_time_(0),
+      update_count_(0),
+      total_latency_usecs_(0),
+      max_latency_usecs_(0) {
 }
 
 //
@@ -707,10 +789,29 @@ void PathResolverPartition::TriggerPathResolution(ResolverPath *rpath) {
     CHECK_CONCURRENCY("db::DBTable", "bgp::ResolverNexthop",
         "bgp::Config", "bgp::ConfigHelper", "bgp::RouteAggregation");
 
+    if (rpath_update_time_ == 0)
+        rpath_update_time_ = ClockMonotonicUsec();
     rpath_update_list_.insert(rpath);
     rpath_update_trigger_->Set();
 }
 
+//
+// Add a list of ResolverPaths to the update list and start Task to process
+// the list. This is used to queue all dependents of a ResolverNexthop in one
+// shot. The update_time is when the ResolverNexthop changed.
+//
+void PathResolverPartition::TriggerPathResolution(
+    const ResolverPathList &rpath_list, uint64_t update_time) {
+    CHECK_CONCURRENCY("bgp::ResolverNexthop");
+
+    if (rpath_list.empty())
+        return;
+    if (rpath_update_time_ == 0 || update_time < rpath_update_time_)
+        rpath_update_time_ = update_time;
+    rpath_update_list_.insert(rpath_list.begin(), rpath_list.end());
+    rpath_update_trigger_->Set();
+}
+
 //
 // Add a ResolverPath to the update list and start Task to process the list.
 // This is used to defer re-evaluation of the ResolverPath when the update
@@ -719,6 +820,8 @@ void PathResolverPartition::TriggerPathResolution(ResolverPath *rpath) {
 void PathResolverPartition::DeferPathResolution(ResolverPath *rpath) {
     CHECK_CONCURRENCY("bgp::ResolverPath");
 
+    if (rpath_update_time_ == 0)
+        rpath_update_time_ = ClockMonotonicUsec();
     rpath_update_list_.insert(rpath);
     rpath_update_trigger_->Set();
 }
@@ -775,6 +878,8 @@ bool PathResolverPartition::ProcessResolverPathUpdateList() {
 
     ResolverPathList update_list;
     rpath_update_list_.swap(update_list);
+    uint64_t update_time = rpath_update_time_;
+    rpath_update_time_ = 0;
     for (ResolverPathList::iterator it = update_list.begin();
          it != update_list.end(); ++it) {
         ResolverPath *rpath = *it;
@@ -782,6 +887,14 @@ bool PathResolverPartition::ProcessResolverPathUpdateList() {
             delete rpath;
     }
 
+    if (update_time) {
+        uint64_t latency_usecs = ClockMonotonicUsec() - update_time;
+        update_count_++;
+        total_latency_usecs_ += latency_usecs;
+        if (latency_usecs > max_latency_usecs_)
+            max_latency_usecs_ = latency_usecs;
+    }
+
     return rpath_update_list_.empty();
 }
 
@@ -1204,15 +1317,12 @@ ResolverRouteState *ResolverNexthop::GetResolverRouteState() {
 // the ResolverNexthop. Actual update of the resolved BgpPaths happens when
 // the PathResolverPartitions process their update lists.
 //
-void ResolverNexthop::TriggerAllResolverPaths() const {
+void ResolverNexthop::TriggerAllResolverPaths(uint64_t update_time) const {
     CHECK_CONCURRENCY("bgp::ResolverNexthop");
 
     for (int part_id = 0; part_id < DB::PartitionCount(); ++part_id) {
-        for (ResolverPathList::iterator it = rpath_lists_[part_id].begin();
-             it != rpath_lists_[part_id].end(); ++it) {
-            ResolverPath *rpath = *it;
-            resolver_->GetPartition(part_id)->TriggerPathResolution(rpath);
-        }
+        resolver_->GetPartition(part_id)->TriggerPathResolution(
+            rpath_lists_[part_id], update_time);
     }
 }
 
@@ -37,6 +37,7 @@ class ResolverPath;
 class ResolverRouteState;
 class ShowPathResolver;
 class TaskTrigger;
+class Timer;
 
 //
 // This represents an instance of the resolver per BgpTable. A BgpTable that
@@ -73,7 +74,26 @@ class TaskTrigger;
 //
 // The update list is processed in the context of bgp::ResolverNexthop Task.
 // When an entry on this list is processed all it's dependent ResolverPaths
-// are queued for re-evaluation in the PathResolverPartition.
+// are queued for re-evaluation in the PathResolverPartition. Dependents are
+// queued in bulk, one set per partition, rather than one at a time.
+//
+// If a non-zero nexthop hold time is configured, the update list is not
+// processed right away when the first ResolverNexthop gets added to it.
+// Instead, the hold timer is started and the list is processed when it
+// fires. Changes to the same ResolverNexthop within the hold time coalesce
+// into a single entry on the list, so intermediate states of the nexthop
+// BgpRoute are never used for resolution. The timer runs in the context of
+// the bgp::ResolverNexthop Task, which is mutually exclusive with the
+// db::DBTable Task that adds entries to the list, so it can't fire while
+// the list is being updated.
+//
+// The PathResolver keeps track of the number of updates to ResolverNexthops
+// and the number of ResolverNexthops processed from the update list. Their
+// ratio is the coalesce ratio. Each PathResolverPartition keeps track of the
+// resolution latency i.e. the time from when the first entry is added to an
+// empty update list till the list has been processed. For nexthop changes,
+// this is measured from when the ResolverNexthop was added to the update
+// list in the PathResolver.
 //
 // Concurrency Notes:
 //
@@ -136,6 +156,7 @@ private:
     bool ProcessResolverNexthopRegUnreg(ResolverNexthop *rnexthop);
     bool ProcessResolverNexthopRegUnregList();
     bool ProcessResolverNexthopUpdateList();
+    bool NexthopHoldTimerExpired();
 
     bool RouteListener(DBTablePartBase *root, DBEntryBase *entry);
 
@@ -149,6 +170,7 @@ private:
     void DisableResolverNexthopUpdateProcessing();
     void EnableResolverNexthopUpdateProcessing();
     size_t GetResolverNexthopUpdateListSize() const;
+    void SetResolverNexthopHoldTime(int hold_time);
 
     void DisableResolverPathUpdateProcessing();
     void EnableResolverPathUpdateProcessing();
@@ -164,6 +186,11 @@ private:
     boost::scoped_ptr<TaskTrigger> nexthop_reg_unreg_trigger_;
     ResolverNexthopList nexthop_update_list_;
     boost::scoped_ptr<TaskTrigger> nexthop_update_trigger_;
+    int nexthop_hold_time_;
+    Timer *nexthop_hold_timer_;
+    uint64_t nexthop_update_time_;
+    uint64_t nexthop_update_count_;
+    uint64_t nexthop_processed_count_;
     ResolverNexthopList nexthop_delete_list_;
     std::vector<PathResolverPartition *> partitions_;
 
@@ -193,6 +220,8 @@ private:
 //
 class PathResolverPartition {
 public:
+    typedef std::set<ResolverPath *> ResolverPathList;
+
     PathResolverPartition(int part_id, PathResolver *resolver);
     ~PathResolverPartition();
 
@@ -203,6 +232,8 @@ public:
     void StopPathResolution(const BgpPath *path);
 
     void TriggerPathResolution(ResolverPath *rpath);
+    void TriggerPathResolution(const ResolverPathList &rpath_list,
+        uint64_t update_time);
     void DeferPathResolution(ResolverPath *rpath);
 
     int part_id() const { return part_id_; }
@@ -217,7 +248,6 @@ private:
     friend class PathResolver;
 
     typedef std::map<const BgpPath *, ResolverPath *> PathToResolverPathMap;
-    typedef std::set<ResolverPath *> ResolverPathList;
 
     ResolverPath *CreateResolverPath(const BgpPath *path, BgpRoute *route,
         ResolverNexthop *rnexthop);
@@ -236,6 +266,10 @@ private:
     PathToResolverPathMap rpath_map_;
     ResolverPathList rpath_update_list_;
     boost::scoped_ptr<TaskTrigger> rpath_update_trigger_;
+    uint64_t rpath_update_time_;
+    uint64_t update_count_;
+    uint64_t total_latency_usecs_;
+    uint64_t max_latency_usecs_;
 
     DISALLOW_COPY_AND_ASSIGN(PathResolverPartition);
 };
@@ -396,7 +430,7 @@ public:
     void RemoveResolverPath(int part_id, ResolverPath *rpath);
     ResolverRouteState *GetResolverRouteState();
 
-    void TriggerAllResolverPaths() const;
+    void TriggerAllResolverPaths(uint64_t update_time) const;
 
     void ManagedDelete() { }
 
@@ -409,7 +443,7 @@ public:
     void set_registered() { registered_ = true; }
 
 private:
-    typedef std::set<ResolverPath *> ResolverPathList;
+    typedef PathResolverPartition::ResolverPathList ResolverPathList;
 
     PathResolver *resolver_;
     IpAddress address_;
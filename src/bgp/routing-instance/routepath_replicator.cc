@@ -146,6 +146,20 @@ void RtReplicated::DeleteRouteInfo(BgpTable *table, BgpRoute *rt,
     replicate_list_.erase(it);
 }
 
+void RtReplicated::AddRouteTarget(TableState *ts, int part_id, BgpRoute *rt,
+    RouteTargetList::const_iterator it) {
+    pair<RouteTargetList::iterator, bool> result;
+    result = rtarget_list_.insert(*it);
+    assert(result.second);
+    replicator_->AddDepRoute(ts, part_id, rt, *it);
+}
+
+void RtReplicated::DeleteRouteTarget(TableState *ts, int part_id,
+    BgpRoute *rt, RouteTargetList::const_iterator it) {
+    replicator_->RemoveDepRoute(part_id, rt, *it);
+    rtarget_list_.erase(it);
+}
+
 //
 // Return the list of secondary table names for the given primary path.
 // We go through all SecondaryRouteInfos and skip the ones that don't
@@ -170,11 +184,23 @@ RoutePathReplicator::RoutePathReplicator(BgpServer *server,
     : server_(server),
       family_(family),
       vpn_table_(NULL),
+      rtarget_dep_(DB::PartitionCount()),
+      rtarget_trigger_lists_(DB::PartitionCount()),
       trace_buf_(SandeshTraceBufferCreate("RoutePathReplicator", 500)) {
+    for (int idx = 0; idx < DB::PartitionCount(); ++idx) {
+        rtarget_dep_triggers_.push_back(boost::shared_ptr<TaskTrigger>(
+            new TaskTrigger(
+                boost::bind(&RoutePathReplicator::ProcessRouteTargetList,
+                    this, idx),
+                TaskScheduler::GetInstance()->GetTaskId("db::DBTable"), idx)));
+    }
 }
 
 RoutePathReplicator::~RoutePathReplicator() {
     assert(table_state_list_.empty());
+    for (int idx = 0; idx < DB::PartitionCount(); ++idx) {
+        assert(rtarget_dep_[idx].empty());
+    }
 }
 
 void RoutePathReplicator::Initialize() {
@@ -264,6 +290,70 @@ RoutePathReplicator::BulkReplicationDone(DBTableBase *dbtable) {
     ts->RetryDelete();
 }
 
+void RoutePathReplicator::AddDepRoute(TableState *ts, int part_id,
+    BgpRoute *rt, const RouteTarget &rtarget) {
+    CHECK_CONCURRENCY("db::DBTable");
+    rtarget_dep_[part_id][rtarget].insert(make_pair(rt, ts));
+}
+
+void RoutePathReplicator::RemoveDepRoute(int part_id, BgpRoute *rt,
+    const RouteTarget &rtarget) {
+    CHECK_CONCURRENCY("db::DBTable");
+    RouteTargetDepMap::iterator loc = rtarget_dep_[part_id].find(rtarget);
+    assert(loc != rtarget_dep_[part_id].end());
+    loc->second.erase(rt);
+    if (loc->second.empty())
+        rtarget_dep_[part_id].erase(loc);
+}
+
+//
+// Trigger evaluation of all VRF routes with the given RouteTarget.
+//
+void RoutePathReplicator::NotifyDepRoutes(const RouteTarget &rtarget) {
+    CHECK_CONCURRENCY("bgp::Config", "bgp::ConfigHelper");
+    for (int idx = 0; idx < DB::PartitionCount(); ++idx) {
+        rtarget_trigger_lists_[idx].insert(rtarget);
+        rtarget_dep_triggers_[idx]->Set();
+    }
+}
+
+//
+// Evaluate the VRF routes in the partition that have any of the RouteTargets
+// on the trigger list.  The list of dependent routes gets updated when the
+// route targets of a route change, so go through a copy of it.
+//
+bool RoutePathReplicator::ProcessRouteTargetList(int part_id) {
+    CHECK_CONCURRENCY("db::DBTable");
+
+    BOOST_FOREACH(const RouteTarget &rtarget, rtarget_trigger_lists_[part_id]) {
+        RouteTargetDepMap::const_iterator loc =
+            rtarget_dep_[part_id].find(rtarget);
+        if (loc == rtarget_dep_[part_id].end())
+            continue;
+        DepRouteList dep_list = loc->second;
+        for (DepRouteList::const_iterator it = dep_list.begin();
+             it != dep_list.end(); ++it) {
+            BgpRoute *rt = it->first;
+            RouteListener(it->second, rt->get_table_partition(), rt);
+        }
+    }
+
+    rtarget_trigger_lists_[part_id].clear();
+    return true;
+}
+
+void RoutePathReplicator::DisableRouteTargetProcessing() {
+    for (int idx = 0; idx < DB::PartitionCount(); ++idx) {
+        rtarget_dep_triggers_[idx]->set_disable();
+    }
+}
+
+void RoutePathReplicator::EnableRouteTargetProcessing() {
+    for (int idx = 0; idx < DB::PartitionCount(); ++idx) {
+        rtarget_dep_triggers_[idx]->set_enable();
+    }
+}
+
 void RoutePathReplicator::JoinVpnTable(RtGroup *group) {
     CHECK_CONCURRENCY("bgp::Config", "bgp::ConfigHelper");
     TableState *vpn_ts = FindTableState(vpn_table_);
@@ -308,11 +398,7 @@ void RoutePathReplicator::Join(BgpTable *table, const RouteTarget &rt,
             server()->rtarget_group_mgr()->NotifyRtGroup(rt);
         if (family_ == Address::INETVPN)
             server_->NotifyAllStaticRoutes();
-        BOOST_FOREACH(BgpTable *sec_table, group->GetExportTables(family())) {
-            if (sec_table->IsVpnTable() || sec_table->empty())
-                continue;
-            RequestWalk(sec_table);
-        }
+        NotifyDepRoutes(rt);
     } else {
         first = group->AddExportTable(family(), table);
         AddTableState(table, group);
@@ -346,11 +432,7 @@ void RoutePathReplicator::Leave(BgpTable *table, const RouteTarget &rt,
             server()->rtarget_group_mgr()->NotifyRtGroup(rt);
         if (family_ == Address::INETVPN)
             server_->NotifyAllStaticRoutes();
-        BOOST_FOREACH(BgpTable *sec_table, group->GetExportTables(family())) {
-            if (sec_table->IsVpnTable() || sec_table->empty())
-                continue;
-            RequestWalk(sec_table);
-        }
+        NotifyDepRoutes(rt);
     } else {
         group->RemoveExportTable(family(), table);
         RemoveTableState(table, group);
@@ -368,12 +450,20 @@ void RoutePathReplicator::Leave(BgpTable *table, const RouteTarget &rt,
 
 void RoutePathReplicator::DBStateSync(BgpTable *table, TableState *ts,
     BgpRoute *rt, RtReplicated *dbstate,
-    const RtReplicated::ReplicatedRtPathList *future) {
+    const RtReplicated::ReplicatedRtPathList *future,
+    const RtReplicated::RouteTargetList *future_rtargets) {
     set_synchronize(dbstate->GetMutableList(), future,
         boost::bind(&RtReplicated::AddRouteInfo, dbstate, table, rt, _1),
         boost::bind(&RtReplicated::DeleteRouteInfo, dbstate, table, rt, _1));
 
-    if (dbstate->GetList().empty()) {
+    int part_id = rt->get_table_partition()->index();
+    set_synchronize(dbstate->GetMutableRouteTargetList(), future_rtargets,
+        boost::bind(&RtReplicated::AddRouteTarget, dbstate, ts, part_id, rt,
+            _1),
+        boost::bind(&RtReplicated::DeleteRouteTarget, dbstate, ts, part_id, rt,
+            _1));
+
+    if (dbstate->GetList().empty() && dbstate->GetRouteTargetList().empty()) {
         rt->ClearState(table, ts->listener_id());
         delete dbstate;
         if (table->GetDBStateCount(ts->listener_id()) == 0)
@@ -432,12 +522,45 @@ static ExtCommunityPtr UpdateExtCommunity(BgpServer *server,
     return ExtCommunityPtr(ext_community);
 }
 
+//
+// Build the list of RouteTargets that a route in a VRF table is exported
+// with i.e. the export targets of the instance and the RouteTargets in the
+// primary paths.  Paths from peers that are not ready are included as well
+// since they don't get a notification when the peer becomes ready.
+//
+void RoutePathReplicator::BuildRouteTargetList(
+    const RoutingInstance *rtinstance, const BgpRoute *rt,
+    RtReplicated::RouteTargetList *rtarget_list) {
+    bool primary = false;
+    for (Route::PathList::const_iterator it = rt->GetPathList().begin();
+        it != rt->GetPathList().end(); ++it) {
+        const BgpPath *path = static_cast<const BgpPath *>(it.operator->());
+        if (path->IsReplicated())
+            continue;
+        primary = true;
+        const ExtCommunity *ext_community = path->GetAttr()->ext_community();
+        if (!ext_community)
+            continue;
+        BOOST_FOREACH(const ExtCommunity::ExtCommunityValue &comm,
+                      ext_community->communities()) {
+            if (ExtCommunity::is_route_target(comm))
+                rtarget_list->insert(RouteTarget(comm));
+        }
+    }
+    if (!primary)
+        return;
+    BOOST_FOREACH(const RouteTarget &rtarget, rtinstance->GetExportList()) {
+        rtarget_list->insert(rtarget);
+    }
+}
+
 //
 // Concurrency: Called in the context of the DB partition task.
 //
 // This function handles
 //   1. Table Notification for path replication
-//   2. Table walk for import/export of new targets
+//   2. Table walk for export of new targets
+//   3. Evaluation of dependent routes for import of new targets
 //
 // Replicate a path (clone the BgpPath) to secondary BgpTables based on the
 // export targets of the primary BgpTable.
@@ -459,22 +582,32 @@ bool RoutePathReplicator::RouteListener(TableState *ts,
     RtReplicated *dbstate =
         static_cast<RtReplicated *>(rt->GetState(table, id));
     RtReplicated::ReplicatedRtPathList replicated_path_list;
+    RtReplicated::RouteTargetList rtarget_list;
 
-    //
     // Cleanup if the route is not usable.
-    // If route aggregation is enabled, contributing route/more specific route
-    // for a aggregate route will NOT be replicated to destination table
-    //
-    if (!rt->IsUsable() || (table->IsRouteAggregationSupported() &&
-                            !rtinstance->deleted() &&
-                            table->IsContributingRoute(rt))) {
+    if (!rt->IsUsable()) {
         if (!dbstate) {
             return true;
         }
-        DBStateSync(table, ts, rt, dbstate, &replicated_path_list);
+        DBStateSync(table, ts, rt, dbstate, &replicated_path_list,
+            &rtarget_list);
         return true;
     }
 
+    // Keep track of the RouteTargets of routes in VRF tables, so that they
+    // get evaluated when a table starts or stops importing any of them.
+    if (!rtinstance->IsMasterRoutingInstance())
+        BuildRouteTargetList(rtinstance, rt, &rtarget_list);
+
+    //
+    // If route aggregation is enabled, contributing route/more specific route
+    // for a aggregate route will NOT be replicated to destination table
+    //
+    bool contributing = table->IsRouteAggregationSupported() &&
+        !rtinstance->deleted() && table->IsContributingRoute(rt);
+    if (contributing && !dbstate && rtarget_list.empty())
+        return true;
+
     // Create and set new DBState on the route.  This will get cleaned up via
     // via the call to DBStateSync if we don't need to replicate the route to
     // any tables.
@@ -483,6 +616,12 @@ bool RoutePathReplicator::RouteListener(TableState *ts,
         rt->SetState(table, id, dbstate);
     }
 
+    if (contributing) {
+        DBStateSync(table, ts, rt, dbstate, &replicated_path_list,
+            &rtarget_list);
+        return true;
+    }
+
     // Get the export route target list from the routing instance.
     ExtCommunity::ExtCommunityList export_list;
     if (!rtinstance->IsMasterRoutingInstance()) {
@@ -600,9 +739,9 @@ bool RoutePathReplicator::RouteListener(TableState *ts,
         }
     }
 
-    // Update the DBState to reflect the new list of secondary paths. The
-    // DBState will get cleared if the list is empty.
-    DBStateSync(table, ts, rt, dbstate, &replicated_path_list);
+    // Update the DBState to reflect the new list of secondary paths and
+    // RouteTargets. The DBState will get cleared if both lists are empty.
+    DBStateSync(table, ts, rt, dbstate, &replicated_path_list, &rtarget_list);
     return true;
 }
 
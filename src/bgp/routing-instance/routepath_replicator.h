@@ -6,6 +6,7 @@
 #define SRC_BGP_ROUTING_INSTANCE_ROUTEPATH_REPLICATOR_H_
 
 #include <boost/ptr_container/ptr_map.hpp>
+#include <boost/shared_ptr.hpp>
 #include <sandesh/sandesh_trace.h>
 #include <tbb/mutex.h>
 
@@ -18,15 +19,17 @@
 #include "base/lifetime.h"
 #include "base/util.h"
 #include "bgp/bgp_path.h"
+#include "bgp/rtarget/rtarget_address.h"
 #include "db/db_entry.h"
 #include "db/db_table.h"
 
 class BgpRoute;
 class BgpServer;
 class BgpTable;
+class RoutingInstance;
 class RtGroup;
 class RoutePathReplicator;
-class RouteTarget;
+class TaskTrigger;
 
 //
 // This keeps track of a RoutePathReplicator's listener state for a BgpTable.
@@ -125,8 +128,13 @@ private:
 // route, changes in the export targets of the primary table or changes in the
 // import targets of secondary tables.
 //
+// For routes in VRF tables, the RouteTargetList keeps the route targets that
+// the route is exported with i.e. the export targets of the table and the
+// route targets in the attributes of the primary paths. The route is present
+// in the RoutePathReplicator's RouteTargetDepMap for each of them.
+//
 // A RtReplicated is deleted when the route in the primary table is no longer
-// replicated to any secondary tables.
+// replicated to any secondary tables and has no route targets.
 //
 class RtReplicated : public DBState {
 public:
@@ -165,6 +173,7 @@ public:
     };
 
     typedef std::set<SecondaryRouteInfo> ReplicatedRtPathList;
+    typedef std::set<RouteTarget> RouteTargetList;
 
     explicit RtReplicated(RoutePathReplicator *replicator);
 
@@ -172,14 +181,21 @@ public:
         ReplicatedRtPathList::const_iterator it);
     void DeleteRouteInfo(BgpTable *table, BgpRoute *rt,
         ReplicatedRtPathList::const_iterator it);
+    void AddRouteTarget(TableState *ts, int part_id, BgpRoute *rt,
+        RouteTargetList::const_iterator it);
+    void DeleteRouteTarget(TableState *ts, int part_id, BgpRoute *rt,
+        RouteTargetList::const_iterator it);
 
     const ReplicatedRtPathList &GetList() const { return replicate_list_; }
     ReplicatedRtPathList *GetMutableList() { return &replicate_list_; }
+    const RouteTargetList &GetRouteTargetList() const { return rtarget_list_; }
+    RouteTargetList *GetMutableRouteTargetList() { return &rtarget_list_; }
     std::vector<std::string> GetTableNameList(const BgpPath *path) const;
 
 private:
     RoutePathReplicator *replicator_;
     ReplicatedRtPathList replicate_list_;
+    RouteTargetList rtarget_list_;
 };
 
 //
@@ -207,11 +223,14 @@ private:
 // 1. When an export target is added to or removed from a VRF table, walk all
 //    routes in the VRF table to re-evaluate the new set of secondary paths.
 //    The DBTableWalkMgr provides this functionality.
-// 2. When an import target is added to or removed from a VRF table, walk all
-//    VRF tables that have the target in question as an export target.  The
-//    list of tables that export a target is maintained in the RTargetGroupMgr.
-//    This list is updated by the replicator (by calling RTargetGroupMgr APIs)
-//    based on configuration changes in the routing instance.
+// 2. When an import target is added to or removed from a VRF table, evaluate
+//    all VRF routes with the target in question.  This dependency is kept in
+//    the RouteTargetDepMap, an inverted index from RouteTarget to the routes
+//    exported with it, which is built by the replicator while processing the
+//    routes.  Each entry in the vector corresponds to a DB partition.  The
+//    routes are evaluated from the db::DBTable task for the partition, so
+//    that only the affected routes are visited instead of walking all VRF
+//    tables that export the target.
 // 3. When an import target is added to or removed from a VRF tables, walk all
 //    VPN routes with the target in question.  This dependency is maintained
 //    by RTargetGroupMgr.
@@ -248,6 +267,10 @@ public:
     const RtReplicated *GetReplicationState(BgpTable *table,
                                             BgpRoute *rt) const;
 
+    // Used only for unit testing.
+    void DisableRouteTargetProcessing();
+    void EnableRouteTargetProcessing();
+
 private:
     friend class ReplicationTest;
     friend class RtReplicated;
@@ -255,6 +278,9 @@ private:
 
     typedef std::map<BgpTable *, TableState *> TableStateList;
     typedef std::set<BgpTable *> UnregTableList;
+    typedef std::map<BgpRoute *, TableState *> DepRouteList;
+    typedef std::map<RouteTarget, DepRouteList> RouteTargetDepMap;
+    typedef std::set<RouteTarget> RouteTargetTriggerList;
 
     void RequestWalk(BgpTable *table);
     void BulkReplicationDone(DBTableBase *dbtable);
@@ -270,13 +296,24 @@ private:
     void JoinVpnTable(RtGroup *group);
     void LeaveVpnTable(RtGroup *group);
 
+    void AddDepRoute(TableState *ts, int part_id, BgpRoute *rt,
+                     const RouteTarget &rtarget);
+    void RemoveDepRoute(int part_id, BgpRoute *rt,
+                        const RouteTarget &rtarget);
+    void NotifyDepRoutes(const RouteTarget &rtarget);
+    bool ProcessRouteTargetList(int part_id);
+    void BuildRouteTargetList(const RoutingInstance *rtinstance,
+                              const BgpRoute *rt,
+                              RtReplicated::RouteTargetList *rtarget_list);
+
     bool RouteListener(TableState *ts, DBTablePartBase *root,
                        DBEntryBase *entry);
     void DeleteSecondaryPath(BgpTable  *table, BgpRoute *rt,
                              const RtReplicated::SecondaryRouteInfo &rtinfo);
     void DBStateSync(BgpTable *table, TableState *ts, BgpRoute *rt,
                      RtReplicated *dbstate,
-                     const RtReplicated::ReplicatedRtPathList *future);
+                     const RtReplicated::ReplicatedRtPathList *future,
+                     const RtReplicated::RouteTargetList *future_rtargets);
 
     BgpServer *server() { return server_; }
     Address::Family family() const { return family_; }
@@ -287,6 +324,9 @@ private:
     TableStateList table_state_list_;
     Address::Family family_;
     BgpTable *vpn_table_;
+    std::vector<RouteTargetDepMap> rtarget_dep_;
+    std::vector<RouteTargetTriggerList> rtarget_trigger_lists_;
+    std::vector<boost::shared_ptr<TaskTrigger> > rtarget_dep_triggers_;
     SandeshTraceBufferPtr trace_buf_;
 
     DISALLOW_COPY_AND_ASSIGN(RoutePathReplicator);
@@ -409,9 +409,24 @@ void RTargetGroupMgr::RemoveRtGroup(const RouteTarget &rt) {
     remove_rtgroup_trigger_->Set();
 }
 
+//
+// Remove peers that are not interested in any of the route targets in the
+// ExtCommunity from the new_peerset.
+//
+// Only peers in the RTargetPeerSet of the RibOut are subject to filtering.
+// The interested peers of the RtGroups are tracked by BgpPeer index, so they
+// get translated to bit indices of the RibOut. This keeps the cost for each
+// route proportional to the number of interested peers rather than to the
+// number of peers in the RibOut.
+//
 void RTargetGroupMgr::GetRibOutInterestedPeers(RibOut *ribout,
              const ExtCommunity *ext_community,
              const RibPeerSet &peerset, RibPeerSet *new_peerset) {
+    RibPeerSet filtered_peerset;
+    filtered_peerset.BuildIntersection(peerset, ribout->RTargetPeerSet());
+    if (filtered_peerset.empty())
+        return;
+
     RtGroupInterestedPeerSet peer_set;
     RtGroup *null_rtgroup = GetRtGroup(RouteTarget::null_rtarget);
     if (null_rtgroup) peer_set = null_rtgroup->GetInterestedPeers();
@@ -423,18 +438,14 @@ void RTargetGroupMgr::GetRibOutInterestedPeers(RibOut *ribout,
             peer_set |= rtgroup->GetInterestedPeers();
         }
     }
-    RibOut::PeerIterator iter(ribout, peerset);
-    while (iter.HasNext()) {
-        int current_index = iter.index();
-        IPeerUpdate *peer = iter.Next();
-        BgpPeer *tmp = dynamic_cast<BgpPeer *>(peer);
-        assert(tmp);
-        if (tmp->IsFamilyNegotiated(Address::RTARGET)) {
-            if (!peer_set.test(tmp->GetIndex())) {
-                new_peerset->reset(current_index);
-            }
-        }
+    for (size_t peer_index = peer_set.find_first();
+         peer_index != RtGroupInterestedPeerSet::npos;
+         peer_index = peer_set.find_next(peer_index)) {
+        int index = ribout->GetRTargetPeerIndex(peer_index);
+        if (index >= 0)
+            filtered_peerset.reset(index);
     }
+    new_peerset->Reset(filtered_peerset);
 }
 
 void RTargetGroupMgr::UnregisterTables() {
@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <tbb/atomic.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "base/test/task_test_util.h"
+#include "base/time_util.h"
+#include "bgp/bgp_attr.h"
+#include "bgp/bgp_log.h"
+#include "bgp/bgp_server.h"
+#include "control-node/control_node.h"
+
+using std::string;
+using std::vector;
+
+//
+// Hammer the path attribute data bases from all tbb worker threads.
+//
+// Each task locates attributes built from a fixed set of specs, so that all
+// tasks compete for the same entries in the same partitions. BgpAttr entries
+// in turn locate AsPath, Community, ExtCommunity and OriginVnPath entries.
+//
+class BgpAttrDBStressTest : public ::testing::Test {
+protected:
+    static const int kAttrCount = 1024;
+    static const int kRounds = 64;
+
+    class LocateTask : public Task {
+    public:
+        LocateTask(BgpAttrDBStressTest *test, int index, bool release)
+            : Task(TaskScheduler::GetInstance()->GetTaskId(
+                  "bgp::AttrDBStressTest"), Task::kTaskInstanceAny),
+              test_(test),
+              index_(index),
+              release_(release) {
+        }
+
+        virtual bool Run() {
+            test_->LocateAttributes(index_, release_);
+            return true;
+        }
+        string Description() const { return "LocateTask"; }
+
+    private:
+        BgpAttrDBStressTest *test_;
+        int index_;
+        bool release_;
+    };
+
+    BgpAttrDBStressTest()
+        : server_(&evm_),
+          attr_db_(server_.attr_db()),
+          aspath_db_(server_.aspath_db()),
+          comm_db_(server_.comm_db()),
+          extcomm_db_(server_.extcomm_db()),
+          ovnpath_db_(server_.ovnpath_db()) {
+        locate_count_ = 0;
+    }
+
+    virtual void TearDown() {
+        pinned_.clear();
+        EXPECT_EQ(0, attr_db_->Size());
+        EXPECT_EQ(0, aspath_db_->Size());
+        EXPECT_EQ(0, comm_db_->Size());
+        EXPECT_EQ(0, extcomm_db_->Size());
+        EXPECT_EQ(0, ovnpath_db_->Size());
+        server_.Shutdown();
+        task_util::WaitForIdle();
+    }
+
+    BgpAttrPtr LocateAttribute(int idx) {
+        BgpAttrSpec spec;
+
+        BgpAttrOrigin origin(BgpAttrOrigin::IGP);
+        spec.push_back(&origin);
+        BgpAttrNextHop nexthop(static_cast<uint32_t>(0x0a000000 + idx % 64));
+        spec.push_back(&nexthop);
+        BgpAttrLocalPref local_pref(100 + idx);
+        spec.push_back(&local_pref);
+
+        AsPathSpec aspath;
+        AsPathSpec::PathSegment *ps = new AsPathSpec::PathSegment;
+        ps->path_segment_type = AsPathSpec::PathSegment::AS_SEQUENCE;
+        ps->path_segment.push_back(64512);
+        ps->path_segment.push_back(64512 + idx % 128);
+        aspath.path_segments.push_back(ps);
+        spec.push_back(&aspath);
+
+        CommunitySpec community;
+        community.communities.push_back(0xFFFF0000 + idx % 32);
+        spec.push_back(&community);
+
+        ExtCommunitySpec ext_community;
+        ext_community.communities.push_back(0x0002fc0000000000ULL + idx % 256);
+        spec.push_back(&ext_community);
+
+        OriginVnPathSpec origin_vn_path;
+        origin_vn_path.origin_vns.push_back(0x8000fc0000000000ULL + idx % 16);
+        spec.push_back(&origin_vn_path);
+
+        return attr_db_->Locate(spec);
+    }
+
+    // Locate all attributes kRounds times, starting at a different offset in
+    // each task. If release is false, verify that the located entries are the
+    // ones pinned by the test.
+    void LocateAttributes(int index, bool release) {
+        vector<BgpAttrPtr> attrs;
+        if (!release)
+            attrs.reserve(kAttrCount);
+        for (int round = 0; round < kRounds; ++round) {
+            for (int count = 0; count < kAttrCount; ++count) {
+                int idx = (index * 97 + round * 13 + count) % kAttrCount;
+                BgpAttrPtr attr = LocateAttribute(idx);
+                EXPECT_EQ(100 + idx, attr->local_pref());
+                if (!release) {
+                    EXPECT_EQ(pinned_[idx].get(), attr.get());
+                    attrs.push_back(attr);
+                }
+            }
+            attrs.clear();
+        }
+        locate_count_ += kRounds * kAttrCount;
+    }
+
+    uint64_t RunTasks(bool release) {
+        TaskScheduler *scheduler = TaskScheduler::GetInstance();
+        int task_count = TaskScheduler::GetThreadCount();
+        uint64_t start = ClockMonotonicUsec();
+        for (int idx = 0; idx < task_count; ++idx) {
+            scheduler->Enqueue(new LocateTask(this, idx, release));
+        }
+        task_util::WaitForIdle(600);
+        EXPECT_EQ(task_count * kRounds * kAttrCount,
+            static_cast<uint64_t>(locate_count_));
+        return ClockMonotonicUsec() - start;
+    }
+
+    template <typename DB>
+    static BgpPathAttributeDBStats GetStats(DB *db) {
+        BgpPathAttributeDBStats stats;
+        db->GetStats(&stats);
+        return stats;
+    }
+
+    template <typename DB>
+    static void PrintStats(const string &name, DB *db) {
+        BgpPathAttributeDBStats stats = GetStats(db);
+        std::cout << name << ": partitions " << stats.partitions
+            << " hits " << stats.hits << " misses " << stats.misses
+            << " contentions " << stats.contentions << std::endl;
+    }
+
+    void PrintStats(uint64_t elapsed) {
+        std::cout << "Located " << locate_count_ << " attributes from "
+            << TaskScheduler::GetThreadCount() << " threads in "
+            << elapsed << " usec" << std::endl;
+        PrintStats("BgpAttr", attr_db_);
+        PrintStats("AsPath", aspath_db_);
+        PrintStats("Community", comm_db_);
+        PrintStats("ExtCommunity", extcomm_db_);
+        PrintStats("OriginVnPath", ovnpath_db_);
+    }
+
+    EventManager evm_;
+    BgpServer server_;
+    BgpAttrDB *attr_db_;
+    AsPathDB *aspath_db_;
+    CommunityDB *comm_db_;
+    ExtCommunityDB *extcomm_db_;
+    OriginVnPathDB *ovnpath_db_;
+    vector<BgpAttrPtr> pinned_;
+    tbb::atomic<uint64_t> locate_count_;
+};
+
+//
+// All entries are present in the data bases, so every locate is a hit and
+// no new entry gets inserted.
+//
+TEST_F(BgpAttrDBStressTest, LocateExisting) {
+    for (int idx = 0; idx < kAttrCount; ++idx) {
+        pinned_.push_back(LocateAttribute(idx));
+    }
+    EXPECT_EQ(kAttrCount, attr_db_->Size());
+    BgpPathAttributeDBStats before = GetStats(attr_db_);
+
+    uint64_t elapsed = RunTasks(false);
+    BgpPathAttributeDBStats after = GetStats(attr_db_);
+    EXPECT_EQ(static_cast<uint64_t>(locate_count_),
+        after.hits - before.hits);
+    EXPECT_EQ(before.misses, after.misses);
+    EXPECT_EQ(kAttrCount, attr_db_->Size());
+    PrintStats(elapsed);
+}
+
+//
+// Entries are released as soon as they're located, so tasks race to insert
+// entries that other tasks are in the process of deleting.
+//
+TEST_F(BgpAttrDBStressTest, LocateAndRelease) {
+    BgpPathAttributeDBStats before = GetStats(attr_db_);
+
+    uint64_t elapsed = RunTasks(true);
+    BgpPathAttributeDBStats after = GetStats(attr_db_);
+    EXPECT_EQ(static_cast<uint64_t>(locate_count_),
+        (after.hits - before.hits) + (after.misses - before.misses));
+    EXPECT_NE(0, after.misses - before.misses);
+    EXPECT_EQ(0, attr_db_->Size());
+    PrintStats(elapsed);
+}
+
+static void SetUp() {
+    bgp_log_test::init();
+    ControlNode::SetDefaultSchedulingPolicy();
+}
+
+static void TearDown() {
+    task_util::WaitForIdle();
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    scheduler->Terminate();
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    SetUp();
+    int result = RUN_ALL_TESTS();
+    TearDown();
+    return result;
+}
@@ -1,11 +1,15 @@
 /*
  * Copyright (c) 2016 Juniper Networks, Inc. All rights reserved.
  */
+#include <boost/foreach.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/uuid/random_generator.hpp>
 #include <tbb/atomic.h>
 
+#include <iostream>
+
 #include "base/task_annotations.h"
+#include "base/time_util.h"
 #include "control-node/control_node.h"
 #include "bgp/inet/inet_table.h"
 #include "bgp/bgp_config_ifmap.h"
@@ -106,11 +110,12 @@ protected:
         task_util::WaitForIdle();
     }
 
-    void CreatePeers() {
+    // Create peers till there's a total of count peers.
+    void CreatePeers(int count = 3) {
         RoutingInstance *rtinstance =
             server_->routing_instance_mgr()->GetRoutingInstance(
                 BgpConfigManager::kMasterInstance);
-        for (int idx = 0; idx < 3; idx++) {
+        for (int idx = peers_.size(); idx < count; idx++) {
             ostringstream out;
             out << "A" << idx;
             BgpNeighborConfig *config = new BgpNeighborConfig();
@@ -182,6 +187,40 @@ protected:
             mgr_, peer, table), "bgp::StateMachine");
     }
 
+    void RegisterTableList(BgpTestPeer *peer,
+        const vector<BgpTable *> &table_list) {
+        task_util::TaskFire(
+            boost::bind(&BgpMembershipManager::RegisterTableList, mgr_, peer,
+                table_list, peer->GetRibExportPolicy(), -1),
+            "bgp::StateMachine");
+    }
+
+    void RegisterPeerList(const vector<BgpTestPeer *> &peer_list,
+        BgpTable *table) {
+        BgpMembershipManager::PeerList ipeer_list(
+            peer_list.begin(), peer_list.end());
+        task_util::TaskFire(
+            boost::bind(&BgpMembershipManager::RegisterPeerList, mgr_,
+                ipeer_list, table, peer_list[0]->GetRibExportPolicy(), -1),
+            "bgp::StateMachine");
+    }
+
+    void UnregisterTableList(BgpTestPeer *peer,
+        const vector<BgpTable *> &table_list) {
+        task_util::TaskFire(
+            boost::bind(&BgpMembershipManager::UnregisterTableList, mgr_, peer,
+                table_list), "bgp::StateMachine");
+    }
+
+    void UnregisterPeerList(const vector<BgpTestPeer *> &peer_list,
+        BgpTable *table) {
+        BgpMembershipManager::PeerList ipeer_list(
+            peer_list.begin(), peer_list.end());
+        task_util::TaskFire(
+            boost::bind(&BgpMembershipManager::UnregisterPeerList, mgr_,
+                ipeer_list, table), "bgp::StateMachine");
+    }
+
     void AddRoute(BgpTestPeer *peer, BgpTable *table,
         const string &prefix_str, const string &nexthop_str) {
         boost::system::error_code ec;
@@ -231,6 +270,52 @@ protected:
     }
     void WalkerPostponeWalk() { walker_->PostponeWalk(); }
     void WalkerResumeWalk() { walker_->ResumeWalk(); }
+    size_t GetWalkerWalkCount() { return walker_->GetWalkCount(); }
+    int GetWalkerDefaultConcurrentWalks() {
+        return BgpMembershipManager::Walker::kDefaultConcurrentWalks;
+    }
+    void SetWalkerMaxConcurrentWalks(int max_concurrent_walks) {
+        walker_->SetMaxConcurrentWalks(max_concurrent_walks);
+    }
+
+    void CreateInstances(int count, vector<BgpTable *> *table_list) {
+        ConcurrencyScope scope("bgp::Config");
+        for (int idx = 0; idx < count; ++idx) {
+            BgpInstanceConfig config("vrf" + integerToString(idx));
+            RoutingInstance *rtinstance =
+                server_->routing_instance_mgr()->CreateRoutingInstance(
+                    &config);
+            table_list->push_back(rtinstance->GetTable(Address::INET));
+        }
+    }
+
+    // Request WalkRibIn for the given number of peers in all tables, as done
+    // by PeerCloseManager when sweeping stale paths. Return the time taken
+    // till all the walks are complete.
+    uint64_t WalkRibInAll(const vector<BgpTable *> &table_list,
+        int peer_count, int route_count) {
+        vector<uint64_t> path_cb_counts;
+        for (int idx = 0; idx < peer_count; ++idx) {
+            path_cb_counts.push_back(peers_[idx]->path_cb_count());
+        }
+
+        uint64_t start = ClockMonotonicUsec();
+        for (int idx = 0; idx < peer_count; ++idx) {
+            BOOST_FOREACH(BgpTable *table, table_list) {
+                WalkRibIn(peers_[idx], table);
+            }
+        }
+        task_util::WaitForIdle();
+        TASK_UTIL_EXPECT_TRUE(mgr_->IsQueueEmpty());
+        uint64_t elapsed = ClockMonotonicUsec() - start;
+
+        for (int idx = 0; idx < peer_count; ++idx) {
+            TASK_UTIL_EXPECT_EQ(path_cb_counts[idx] +
+                table_list.size() * route_count,
+                peers_[idx]->path_cb_count());
+        }
+        return elapsed;
+    }
 
     BgpMembershipManager *mgr_;
     BgpMembershipManager::Walker *walker_;
@@ -1089,6 +1174,358 @@ TEST_F(BgpMembershipTest, MultiplePeersMultipleTable) {
     TASK_UTIL_EXPECT_EQ(red_walk_count + 2, red_tbl_->walk_complete_count());
 }
 
+//
+// Verify that walks for multiple tables run concurrently, up to the maximum
+// number of concurrent walks.
+//
+TEST_F(BgpMembershipTest, ConcurrentWalks) {
+    uint64_t blue_walk_count = blue_tbl_->walk_complete_count();
+    uint64_t red_walk_count = red_tbl_->walk_complete_count();
+    uint64_t gray_walk_count = gray_tbl_->walk_complete_count();
+    SetWalkerMaxConcurrentWalks(2);
+
+    // Disable walker.
+    SetWalkerDisable(true);
+
+    // Register to blue, red and gray.
+    Register(peers_[0], blue_tbl_);
+    Register(peers_[0], red_tbl_);
+    Register(peers_[0], gray_tbl_);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(3, GetWalkerQueueSize());
+
+    // Postpone walk.
+    WalkerPostponeWalk();
+
+    // Enable walker.
+    SetWalkerDisable(false);
+    task_util::WaitForIdle();
+
+    TASK_UTIL_EXPECT_EQ(1, GetWalkerQueueSize());
+    TASK_UTIL_EXPECT_EQ(2, GetWalkerWalkCount());
+    TASK_UTIL_EXPECT_EQ(2, GetWalkerRibOutStateListSize());
+
+    // Register another peer to blue while it's walk is in progress.
+    // It gets serviced by a subsequent walk of blue.
+    Register(peers_[1], blue_tbl_);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(2, GetWalkerQueueSize());
+    TASK_UTIL_EXPECT_EQ(2, GetWalkerWalkCount());
+
+    // Resume walk.
+    WalkerResumeWalk();
+    task_util::WaitForIdle();
+
+    TASK_UTIL_EXPECT_TRUE(IsWalkerQueueEmpty());
+    TASK_UTIL_EXPECT_EQ(0, GetWalkerWalkCount());
+    TASK_UTIL_EXPECT_EQ(4, mgr_->GetMembershipCount());
+    TASK_UTIL_EXPECT_EQ(blue_walk_count + 2, blue_tbl_->walk_complete_count());
+    TASK_UTIL_EXPECT_EQ(red_walk_count + 1, red_tbl_->walk_complete_count());
+    TASK_UTIL_EXPECT_EQ(gray_walk_count + 1, gray_tbl_->walk_complete_count());
+
+    // Unregister all peers.
+    Unregister(peers_[0], blue_tbl_);
+    Unregister(peers_[0], red_tbl_);
+    Unregister(peers_[0], gray_tbl_);
+    Unregister(peers_[1], blue_tbl_);
+    task_util::WaitForIdle();
+
+    TASK_UTIL_EXPECT_TRUE(IsWalkerQueueEmpty());
+    TASK_UTIL_EXPECT_EQ(0, mgr_->GetMembershipCount());
+}
+
+//
+// Verify bulk register and unregister of 1 peer to multiple tables.
+//
+TEST_F(BgpMembershipTest, TableList) {
+    uint64_t blue_walk_count = blue_tbl_->walk_complete_count();
+    uint64_t red_walk_count = red_tbl_->walk_complete_count();
+    uint64_t gray_walk_count = gray_tbl_->walk_complete_count();
+
+    vector<BgpTable *> table_list;
+    table_list.push_back(blue_tbl_);
+    table_list.push_back(red_tbl_);
+    table_list.push_back(gray_tbl_);
+
+    // Disable walker.
+    SetWalkerDisable(true);
+
+    // Register to all tables.
+    RegisterTableList(peers_[0], table_list);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(3, GetWalkerQueueSize());
+
+    // Enable walker.
+    SetWalkerDisable(false);
+    task_util::WaitForIdle();
+
+    TASK_UTIL_EXPECT_TRUE(IsWalkerQueueEmpty());
+    TASK_UTIL_EXPECT_TRUE(mgr_->GetRegistrationInfo(peers_[0], blue_tbl_));
+    TASK_UTIL_EXPECT_TRUE(mgr_->GetRegistrationInfo(peers_[0], red_tbl_));
+    TASK_UTIL_EXPECT_TRUE(mgr_->GetRegistrationInfo(peers_[0], gray_tbl_));
+    TASK_UTIL_EXPECT_EQ(3, mgr_->GetMembershipCount());
+    TASK_UTIL_EXPECT_EQ(0, mgr_->current_jobs_count());
+    TASK_UTIL_EXPECT_EQ(blue_walk_count + 1, blue_tbl_->walk_complete_count());
+    TASK_UTIL_EXPECT_EQ(red_walk_count + 1, red_tbl_->walk_complete_count());
+    TASK_UTIL_EXPECT_EQ(gray_walk_count + 1, gray_tbl_->walk_complete_count());
+
+    // Unregister from all tables.
+    UnregisterTableList(peers_[0], table_list);
+    task_util::WaitForIdle();
+
+    TASK_UTIL_EXPECT_TRUE(IsWalkerQueueEmpty());
+    TASK_UTIL_EXPECT_FALSE(mgr_->GetRegistrationInfo(peers_[0], blue_tbl_));
+    TASK_UTIL_EXPECT_FALSE(mgr_->GetRegistrationInfo(peers_[0], red_tbl_));
+    TASK_UTIL_EXPECT_FALSE(mgr_->GetRegistrationInfo(peers_[0], gray_tbl_));
+    TASK_UTIL_EXPECT_EQ(0, mgr_->GetMembershipCount());
+    TASK_UTIL_EXPECT_EQ(0, mgr_->current_jobs_count());
+    TASK_UTIL_EXPECT_EQ(blue_walk_count + 2, blue_tbl_->walk_complete_count());
+    TASK_UTIL_EXPECT_EQ(red_walk_count + 2, red_tbl_->walk_complete_count());
+    TASK_UTIL_EXPECT_EQ(gray_walk_count + 2, gray_tbl_->walk_complete_count());
+}
+
+//
+// Verify bulk register and unregister of multiple peers to 1 table.
+// The table gets walked once for all peers even though the walker is not
+// disabled.
+// Bulk unregister handles peers that are registered only for RibIn.
+//
+TEST_F(BgpMembershipTest, PeerList) {
+    uint64_t blue_walk_count = blue_tbl_->walk_complete_count();
+
+    // Register all peers, except the last one which is registered for RibIn.
+    vector<BgpTestPeer *> peer_list(peers_.begin(), peers_.end() - 1);
+    RegisterPeerList(peer_list, blue_tbl_);
+    RegisterRibIn(peers_[2], blue_tbl_);
+    task_util::WaitForIdle();
+
+    TASK_UTIL_EXPECT_TRUE(IsWalkerQueueEmpty());
+    TASK_UTIL_EXPECT_TRUE(mgr_->IsRibOutRegistered(peers_[0], blue_tbl_));
+    TASK_UTIL_EXPECT_TRUE(mgr_->IsRibOutRegistered(peers_[1], blue_tbl_));
+    TASK_UTIL_EXPECT_FALSE(mgr_->IsRibOutRegistered(peers_[2], blue_tbl_));
+    TASK_UTIL_EXPECT_TRUE(mgr_->IsRibInRegistered(peers_[2], blue_tbl_));
+    TASK_UTIL_EXPECT_EQ(3, mgr_->GetMembershipCount());
+    TASK_UTIL_EXPECT_EQ(0, mgr_->current_jobs_count());
+    TASK_UTIL_EXPECT_EQ(blue_walk_count + 1, blue_tbl_->walk_complete_count());
+
+    // Disable walker.
+    SetWalkerDisable(true);
+
+    // Unregister all peers.
+    UnregisterPeerList(peers_, blue_tbl_);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(1, GetWalkerQueueSize());
+
+    // Enable walker.
+    SetWalkerDisable(false);
+    task_util::WaitForIdle();
+
+    TASK_UTIL_EXPECT_TRUE(IsWalkerQueueEmpty());
+    TASK_UTIL_EXPECT_FALSE(mgr_->GetRegistrationInfo(peers_[0], blue_tbl_));
+    TASK_UTIL_EXPECT_FALSE(mgr_->GetRegistrationInfo(peers_[1], blue_tbl_));
+    TASK_UTIL_EXPECT_FALSE(mgr_->GetRegistrationInfo(peers_[2], blue_tbl_));
+    TASK_UTIL_EXPECT_EQ(0, mgr_->GetMembershipCount());
+    TASK_UTIL_EXPECT_EQ(0, mgr_->current_jobs_count());
+    TASK_UTIL_EXPECT_EQ(blue_walk_count + 2, blue_tbl_->walk_complete_count());
+}
+
+//
+// Verify that bulk unregister handles tables to which the peer is registered
+// only for RibIn.
+//
+TEST_F(BgpMembershipTest, TableListRibIn) {
+    uint64_t blue_walk_count = blue_tbl_->walk_complete_count();
+    uint64_t red_walk_count = red_tbl_->walk_complete_count();
+
+    // Register to blue table and register to red table for RibIn.
+    Register(peers_[0], blue_tbl_);
+    RegisterRibIn(peers_[0], red_tbl_);
+    task_util::WaitForIdle();
+
+    TASK_UTIL_EXPECT_TRUE(mgr_->IsRibOutRegistered(peers_[0], blue_tbl_));
+    TASK_UTIL_EXPECT_FALSE(mgr_->IsRibOutRegistered(peers_[0], red_tbl_));
+    TASK_UTIL_EXPECT_TRUE(mgr_->IsRibInRegistered(peers_[0], red_tbl_));
+    TASK_UTIL_EXPECT_EQ(2, mgr_->GetMembershipCount());
+    TASK_UTIL_EXPECT_EQ(0, mgr_->current_jobs_count());
+
+    // Unregister from both tables.
+    vector<BgpTable *> table_list;
+    table_list.push_back(blue_tbl_);
+    table_list.push_back(red_tbl_);
+    UnregisterTableList(peers_[0], table_list);
+    task_util::WaitForIdle();
+
+    TASK_UTIL_EXPECT_TRUE(IsWalkerQueueEmpty());
+    TASK_UTIL_EXPECT_FALSE(mgr_->GetRegistrationInfo(peers_[0], blue_tbl_));
+    TASK_UTIL_EXPECT_FALSE(mgr_->GetRegistrationInfo(peers_[0], red_tbl_));
+    TASK_UTIL_EXPECT_EQ(0, mgr_->GetMembershipCount());
+    TASK_UTIL_EXPECT_EQ(0, mgr_->current_jobs_count());
+    TASK_UTIL_EXPECT_EQ(blue_walk_count + 2, blue_tbl_->walk_complete_count());
+    TASK_UTIL_EXPECT_EQ(red_walk_count + 1, red_tbl_->walk_complete_count());
+}
+
+//
+// Measure the time to walk RibIns for all tables as done on peer close for
+// different numbers of peers and routes, with table walks done one at a time
+// and concurrently.
+//
+TEST_F(BgpMembershipTest, WalkRibInBenchmark) {
+    static const int kInstanceCount = 64;
+    static const int kRouteCounts[] = { 64, 512 };
+    static const int kPeerCounts[] = { 1, 3 };
+    const int kConcurrentWalks[] = { 1, GetWalkerDefaultConcurrentWalks() };
+
+    vector<BgpTable *> table_list;
+    CreateInstances(kInstanceCount, &table_list);
+    task_util::WaitForIdle();
+
+    for (int idx = 0; idx < 3; ++idx) {
+        BOOST_FOREACH(BgpTable *table, table_list) {
+            Register(peers_[idx], table);
+        }
+    }
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(3 * kInstanceCount, mgr_->GetMembershipCount());
+
+    BOOST_FOREACH(int route_count, kRouteCounts) {
+        for (int idx = 0; idx < 3; ++idx) {
+            string nexthop = "192.168.1." + integerToString(idx);
+            BOOST_FOREACH(BgpTable *table, table_list) {
+                for (int rt_idx = 0; rt_idx < route_count; ++rt_idx) {
+                    AddRoute(peers_[idx], table, BuildPrefix(rt_idx), nexthop);
+                }
+            }
+        }
+        task_util::WaitForIdle();
+
+        BOOST_FOREACH(int peer_count, kPeerCounts) {
+            BOOST_FOREACH(int max_walks, kConcurrentWalks) {
+                SetWalkerMaxConcurrentWalks(max_walks);
+                uint64_t elapsed =
+                    WalkRibInAll(table_list, peer_count, route_count);
+                std::cout << "Tables " << kInstanceCount
+                    << " Routes " << route_count
+                    << " Peers " << peer_count
+                    << " Concurrent walks " << max_walks
+                    << " : " << elapsed << " usec" << std::endl;
+            }
+        }
+
+        for (int idx = 0; idx < 3; ++idx) {
+            BOOST_FOREACH(BgpTable *table, table_list) {
+                for (int rt_idx = 0; rt_idx < route_count; ++rt_idx) {
+                    DeleteRoute(peers_[idx], table, BuildPrefix(rt_idx));
+                }
+            }
+        }
+        task_util::WaitForIdle();
+    }
+
+    for (int idx = 0; idx < 3; ++idx) {
+        BOOST_FOREACH(BgpTable *table, table_list) {
+            Unregister(peers_[idx], table);
+        }
+    }
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_TRUE(IsWalkerQueueEmpty());
+    TASK_UTIL_EXPECT_EQ(0, mgr_->GetMembershipCount());
+}
+
+//
+// Measure the time till all peers are in sync after they register to all
+// tables at about the same time, as happens when all agents resubscribe
+// after a control-node restart. Compare registering one table at a time
+// with registering each peer to all tables and all peers to each table
+// using the bulk APIs, and report the number of table walks needed.
+//
+TEST_F(BgpMembershipTest, RegisterBenchmark) {
+    static const int kInstanceCount = 256;
+    static const int kRouteCount = 64;
+    static const int kPeerCounts[] = { 3, 16, 64 };
+
+    vector<BgpTable *> table_list;
+    CreateInstances(kInstanceCount, &table_list);
+    {
+        ConcurrencyScope scope("bgp::Config");
+        CreatePeers(kPeerCounts[2] + 1);
+    }
+    task_util::WaitForIdle();
+
+    // The last peer adds routes to all tables.
+    BgpTestPeer *source_peer = peers_.back();
+    BOOST_FOREACH(BgpTable *table, table_list) {
+        RegisterRibIn(source_peer, table);
+    }
+    BOOST_FOREACH(BgpTable *table, table_list) {
+        for (int rt_idx = 0; rt_idx < kRouteCount; ++rt_idx) {
+            AddRoute(source_peer, table, BuildPrefix(rt_idx), "192.168.1.1");
+        }
+    }
+    task_util::WaitForIdle();
+
+    BOOST_FOREACH(int peer_count, kPeerCounts) {
+        for (int mode = 0; mode < 3; ++mode) {
+            uint64_t walk_count = 0;
+            BOOST_FOREACH(BgpTable *table, table_list) {
+                walk_count -= table->walk_complete_count();
+            }
+
+            uint64_t start = ClockMonotonicUsec();
+            if (mode == 2) {
+                vector<BgpTestPeer *> peer_list(
+                    peers_.begin(), peers_.begin() + peer_count);
+                BOOST_FOREACH(BgpTable *table, table_list) {
+                    RegisterPeerList(peer_list, table);
+                }
+            }
+            for (int idx = 0; mode != 2 && idx < peer_count; ++idx) {
+                if (mode == 1) {
+                    RegisterTableList(peers_[idx], table_list);
+                    continue;
+                }
+                BOOST_FOREACH(BgpTable *table, table_list) {
+                    Register(peers_[idx], table);
+                }
+            }
+            task_util::WaitForIdle();
+            TASK_UTIL_EXPECT_EQ(0, mgr_->current_jobs_count());
+            uint64_t elapsed = ClockMonotonicUsec() - start;
+
+            BOOST_FOREACH(BgpTable *table, table_list) {
+                walk_count += table->walk_complete_count();
+            }
+            TASK_UTIL_EXPECT_EQ(kInstanceCount * (peer_count + 1),
+                mgr_->GetMembershipCount());
+            std::cout << "Tables " << kInstanceCount
+                << " Routes " << kRouteCount
+                << " Peers " << peer_count
+                << (mode == 2 ? " PeerList" :
+                    (mode == 1 ? " TableList" : " Single"))
+                << " : " << elapsed << " usec"
+                << " Walks " << walk_count << std::endl;
+
+            for (int idx = 0; idx < peer_count; ++idx) {
+                UnregisterTableList(peers_[idx], table_list);
+            }
+            task_util::WaitForIdle();
+            TASK_UTIL_EXPECT_EQ(kInstanceCount, mgr_->GetMembershipCount());
+        }
+    }
+
+    BOOST_FOREACH(BgpTable *table, table_list) {
+        for (int rt_idx = 0; rt_idx < kRouteCount; ++rt_idx) {
+            DeleteRoute(source_peer, table, BuildPrefix(rt_idx));
+        }
+    }
+    task_util::WaitForIdle();
+    BOOST_FOREACH(BgpTable *table, table_list) {
+        UnregisterRibIn(source_peer, table);
+    }
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_TRUE(IsWalkerQueueEmpty());
+    TASK_UTIL_EXPECT_EQ(0, mgr_->GetMembershipCount());
+}
+
 //
 // Duplicate register causes assertion.
 // Duplicate register happens after original is fully processed.
@@ -4,6 +4,7 @@
 
 #include "base/proto.h"
 #include "base/test/task_test_util.h"
+#include "base/time_util.h"
 #include "control-node/control_node.h"
 #include <boost/assign/list_of.hpp>
 #include "net/bgp_af.h"
@@ -62,6 +63,55 @@ protected:
         if (msg) delete msg;
     }
 
+    // Decode with the generic decoder only.
+    BgpProto::BgpMessage *GenericDecode(const uint8_t *data, size_t size,
+                                        ParseErrorContext *ec = NULL) {
+        bool fast_path = BgpProto::UseUpdateFastPath();
+        BgpProto::SetUseUpdateFastPath(false);
+        BgpProto::BgpMessage *msg = BgpProto::Decode(data, size, ec);
+        BgpProto::SetUseUpdateFastPath(fast_path);
+        return msg;
+    }
+
+    //
+    // If the fast path decoder accepts a message, the generic decoder must
+    // accept it as well and build the same update.
+    // Returns true if the fast path decoder accepted the message.
+    //
+    bool VerifyFastPath(const uint8_t *data, size_t size) {
+        auto_ptr<BgpProto::Update> fast(BgpProto::Update::Decode(data, size));
+        auto_ptr<BgpProto::BgpMessage> generic(GenericDecode(data, size));
+        if (!fast.get())
+            return false;
+        EXPECT_TRUE(generic.get() != NULL);
+        if (!generic.get())
+            return true;
+        EXPECT_EQ(BgpProto::UPDATE, generic->type);
+        EXPECT_EQ(0, fast->CompareTo(
+            *static_cast<const BgpProto::Update *>(generic.get())));
+        return true;
+    }
+
+    //
+    // Change a few random bytes after the header or truncate the message.
+    // The length in the header is kept consistent most of the time, so that
+    // the fast path decoder gets to look at the contents.
+    //
+    size_t MutateMessage(uint8_t *data, size_t size) {
+        size_t body_size = size - BgpProto::kMinMessageSize;
+        if (rand() % 4 == 0) {
+            size = BgpProto::kMinMessageSize + rand() % (body_size + 1);
+        } else {
+            for (int count = 1 + rand() % 4; count > 0; count--) {
+                data[BgpProto::kMinMessageSize + rand() % body_size] = rand();
+            }
+        }
+        if (rand() % 8 != 0) {
+            put_value(data + 16, 2, size);
+        }
+        return size;
+    }
+
     const BgpAttribute *BgpFindAttribute(const BgpProto::Update *update,
         BgpAttribute::Code code) {
         for (vector<BgpAttribute *>::const_iterator it =
@@ -1103,6 +1153,203 @@ TEST_F(BgpProtoTest, RandomError) {
     }
 }
 
+//
+// An update with all the attributes that the fast path decoder handles.
+//
+TEST_F(BgpProtoTest, UpdateFastPath) {
+    BgpProto::Update update;
+    BgpMessageTest::GenerateUpdateMessage(&update, BgpAf::IPv4, BgpAf::Unicast);
+    update.path_attributes.push_back(new BgpAttrMultiExitDisc(100));
+    update.path_attributes.push_back(new BgpAttrLocalPref(200));
+    update.path_attributes.push_back(new BgpAttrOriginatorId(0x0a010102));
+    ClusterListSpec *cluster_list = new ClusterListSpec;
+    cluster_list->cluster_list.push_back(0x0a010103);
+    update.path_attributes.push_back(cluster_list);
+    OriginVnPathSpec *ovnpath = new OriginVnPathSpec;
+    ovnpath->origin_vns.push_back(0x0002fc0000000001ULL);
+    update.path_attributes.push_back(ovnpath);
+    for (int idx = 0; idx < 8; ++idx) {
+        BgpProtoPrefix *prefix = new BgpProtoPrefix;
+        prefix->prefixlen = 8 * idx;
+        prefix->prefix.resize(idx, idx);
+        update.withdrawn_routes.push_back(prefix);
+    }
+
+    uint8_t data[BgpProto::kMaxMessageSize];
+    int res = BgpProto::Encode(&update, data, sizeof(data));
+    ASSERT_LT(0, res);
+
+    auto_ptr<BgpProto::Update> result(BgpProto::Update::Decode(data, res));
+    ASSERT_TRUE(result.get() != NULL);
+    EXPECT_EQ(0, result->CompareTo(update));
+    EXPECT_TRUE(VerifyFastPath(data, res));
+
+    // The generic decoder would accept trailing bytes after the message.
+    EXPECT_TRUE(BgpProto::Update::Decode(data, res + 1) == NULL);
+}
+
+TEST_F(BgpProtoTest, UpdateFastPathMpNlri) {
+    BgpProto::Update update;
+    update.path_attributes.push_back(new BgpAttrOrigin(BgpAttrOrigin::IGP));
+    update.path_attributes.push_back(new AsPathSpec);
+
+    boost::system::error_code ec;
+    Ip4Address addr = Ip4Address::from_string("10.1.1.1", ec);
+    const Ip4Address::bytes_type &bytes = addr.to_bytes();
+    vector<uint8_t> nexthop(RouteDistinguisher::kSize, 0);
+    nexthop.insert(nexthop.end(), bytes.begin(), bytes.end());
+    BgpMpNlri *mp_reach = new BgpMpNlri(
+        BgpAttribute::MPReachNlri, BgpAf::IPv4, BgpAf::Vpn, nexthop);
+    for (int idx = 0; idx < 64; ++idx) {
+        BgpProtoPrefix *prefix = new BgpProtoPrefix;
+        prefix->prefixlen = 3 * 8 + RouteDistinguisher::kSize * 8 + 24;
+        prefix->prefix.resize(prefix->prefixlen / 8, idx);
+        mp_reach->nlri.push_back(prefix);
+    }
+    update.path_attributes.push_back(mp_reach);
+
+    // End-of-RIB marker for inet6.
+    update.path_attributes.push_back(new BgpMpNlri(
+        BgpAttribute::MPUnreachNlri, BgpAf::IPv6, BgpAf::Unicast));
+
+    uint8_t data[BgpProto::kMaxMessageSize];
+    int res = BgpProto::Encode(&update, data, sizeof(data));
+    ASSERT_LT(0, res);
+
+    auto_ptr<BgpProto::Update> result(BgpProto::Update::Decode(data, res));
+    ASSERT_TRUE(result.get() != NULL);
+    EXPECT_EQ(0, result->CompareTo(update));
+    EXPECT_TRUE(VerifyFastPath(data, res));
+}
+
+//
+// Messages that the fast path decoder does not handle get decoded by the
+// generic decoder, and errors are reported as before.
+//
+TEST_F(BgpProtoTest, UpdateFastPathFallback) {
+    BgpProto::Update update;
+    BgpMessageTest::GenerateUpdateMessage(&update, BgpAf::IPv4, BgpAf::Unicast);
+    PmsiTunnelSpec *pmsispec = new PmsiTunnelSpec;
+    pmsispec->tunnel_flags = PmsiTunnelSpec::EdgeReplicationSupported;
+    pmsispec->tunnel_type = PmsiTunnelSpec::IngressReplication;
+    pmsispec->SetLabel(10000);
+    update.path_attributes.push_back(pmsispec);
+
+    uint8_t data[BgpProto::kMaxMessageSize];
+    int res = BgpProto::Encode(&update, data, sizeof(data));
+    ASSERT_LT(0, res);
+    EXPECT_TRUE(BgpProto::Update::Decode(data, res) == NULL);
+    auto_ptr<const BgpProto::Update> result(
+        static_cast<const BgpProto::Update *>(BgpProto::Decode(data, res)));
+    ASSERT_TRUE(result.get() != NULL);
+    EXPECT_EQ(0, result->CompareTo(update));
+
+    BgpProto::Update bad_update;
+    bad_update.path_attributes.push_back(new BgpAttrOrigin(3));
+    res = BgpProto::Encode(&bad_update, data, sizeof(data));
+    ASSERT_LT(0, res);
+    EXPECT_TRUE(BgpProto::Update::Decode(data, res) == NULL);
+    ParseAndVerifyError(data, res, BgpProto::Notification::UpdateMsgErr,
+            BgpProto::Notification::InvalidOrigin, "BgpAttrOrigin", 23, 4);
+}
+
+//
+// Differential test of the fast path decoder against the generic decoder
+// with random updates.
+//
+TEST_F(BgpProtoTest, RandomUpdateFastPath) {
+    uint8_t data[BgpProto::kMaxMessageSize];
+    int count = 10000;
+    if (getenv("HEAPCHECK")) count = 100;
+
+    int fast_count = 0;
+    for (int i = 0; i < count; i++) {
+        BgpProto::Update update;
+        BuildUpdateMessage::Generate(&update);
+        int msglen = BgpProto::Encode(&update, data, sizeof(data));
+        if (msglen == -1) {
+            continue;
+        }
+        auto_ptr<BgpProto::Update> result(
+            BgpProto::Update::Decode(data, msglen));
+        if (result.get()) {
+            EXPECT_EQ(0, result->CompareTo(update));
+        }
+        if (VerifyFastPath(data, msglen))
+            fast_count++;
+    }
+    EXPECT_LT(0, fast_count);
+}
+
+//
+// Fuzz the fast path decoder with random updates that have a few bytes
+// changed or are truncated. Whatever the fast path accepts must be accepted
+// by the generic decoder, with the same result.
+//
+TEST_F(BgpProtoTest, RandomErrorFastPath) {
+    uint8_t data[BgpProto::kMaxMessageSize];
+    int count = 20000;
+    if (getenv("HEAPCHECK")) count = 100;
+
+    for (int i = 0; i < count; i++) {
+        BgpProto::Update update;
+        BuildUpdateMessage::Generate(&update);
+        int msglen = BgpProto::Encode(&update, data, sizeof(data));
+        if (msglen == -1) {
+            continue;
+        }
+        size_t size = MutateMessage(data, msglen);
+        VerifyFastPath(data, size);
+
+        // Same outcome from BgpProto::Decode with and without fast path.
+        auto_ptr<BgpProto::BgpMessage> msg(BgpProto::Decode(data, size));
+        auto_ptr<BgpProto::BgpMessage> generic(GenericDecode(data, size));
+        EXPECT_EQ(generic.get() != NULL, msg.get() != NULL);
+    }
+}
+
+//
+// Time taken to decode a typical update from a full table feed, with the
+// generic decoder and the fast path decoder.
+//
+TEST_F(BgpProtoTest, UpdateDecodeBenchmark) {
+    const int kDecodeCount = 10000;
+    BgpProto::Update update;
+    BgpMessageTest::GenerateUpdateMessage(&update, BgpAf::IPv4, BgpAf::Unicast);
+    update.path_attributes.push_back(new BgpAttrMultiExitDisc(100));
+    update.path_attributes.push_back(new BgpAttrLocalPref(200));
+    for (int idx = 0; idx < 800; ++idx) {
+        BgpProtoPrefix *prefix = new BgpProtoPrefix;
+        prefix->prefixlen = 24;
+        prefix->prefix.push_back(10 + idx / 256);
+        prefix->prefix.push_back(idx % 256);
+        prefix->prefix.push_back(0);
+        update.nlri.push_back(prefix);
+    }
+
+    uint8_t data[BgpProto::kMaxMessageSize];
+    int res = BgpProto::Encode(&update, data, sizeof(data));
+    ASSERT_LT(0, res);
+    EXPECT_TRUE(VerifyFastPath(data, res));
+
+    uint64_t start = ClockMonotonicUsec();
+    for (int idx = 0; idx < kDecodeCount; ++idx) {
+        delete GenericDecode(data, res);
+    }
+    uint64_t generic_time = ClockMonotonicUsec() - start;
+
+    start = ClockMonotonicUsec();
+    for (int idx = 0; idx < kDecodeCount; ++idx) {
+        delete BgpProto::Decode(data, res);
+    }
+    uint64_t fast_time = ClockMonotonicUsec() - start;
+
+    cout << "Decoded " << kDecodeCount << " updates of " << res
+        << " bytes with " << update.nlri.size() << " prefixes" << endl;
+    cout << "Generic decoder   : " << generic_time << " usec" << endl;
+    cout << "Fast path decoder : " << fast_time << " usec" << endl;
+}
+
 class EncodeLengthTest : public testing::Test {
   protected:
 
@@ -2,7 +2,12 @@
  * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
  */
 
+#include <boost/foreach.hpp>
 
+#include <iostream>
+#include <vector>
+
+#include "base/time_util.h"
 #include "base/test/task_test_util.h"
 #include "bgp/bgp_config.h"
 #include "bgp/bgp_log.h"
@@ -77,6 +82,19 @@ protected:
         task_util::WaitForIdle();
     }
 
+    // Attribute with the given local pref, so that paths can be ordered.
+    BgpAttrPtr LocateAttr(uint32_t local_pref) {
+        BgpAttrSpec spec;
+        BgpAttrLocalPref attr_local_pref(local_pref);
+        spec.push_back(&attr_local_pref);
+        return server_.attr_db()->Locate(spec);
+    }
+
+    // Verify that the paths are in the order picked by path selection.
+    void VerifyPathOrder(const BgpRoute &route) {
+        EXPECT_TRUE(route.IsSorted(&BgpTable::PathSelection));
+    }
+
     EventManager evm_;
     BgpServer server_;
     DB db_;
@@ -1318,6 +1336,155 @@ TEST_F(BgpRouteTest, PathCompareLlgrStale6) {
     EXPECT_EQ(0, path2.PathCompare(path1, false));
 }
 
+//
+// Paths get inserted at the position picked by path selection, so that the
+// path list is always sorted.
+//
+TEST_F(BgpRouteTest, PathOrder) {
+    static const int kPathCount = 16;
+    std::vector<PeerMock *> peers;
+    for (int idx = 0; idx < kPathCount; ++idx) {
+        peers.push_back(new PeerMock(BgpProto::IBGP,
+            Ip4Address(0x0a010100 + idx)));
+    }
+
+    Ip4Prefix prefix;
+    InetRoute route(prefix);
+    std::vector<BgpPath *> paths;
+    for (int idx = 0; idx < kPathCount; ++idx) {
+        BgpAttrPtr attr = LocateAttr(100 + (idx * 7) % 4);
+        BgpPath *path =
+            new BgpPath(peers[idx], BgpPath::BGP_XMPP, attr, 0, 0);
+        paths.push_back(path);
+        route.InsertPath(path);
+        VerifyPathOrder(route);
+    }
+    EXPECT_EQ(kPathCount, route.count());
+    EXPECT_EQ(paths[5], route.FindPath(BgpPath::BGP_XMPP, peers[5], 0));
+
+    // Sorting the list doesn't change the order.
+    std::vector<const Path *> path_order;
+    BOOST_FOREACH(const Path &path, route.GetPathList()) {
+        path_order.push_back(&path);
+    }
+    route.Sort(&BgpTable::PathSelection, route.front());
+    size_t order_idx = 0;
+    BOOST_FOREACH(const Path &path, route.GetPathList()) {
+        EXPECT_EQ(path_order[order_idx++], &path);
+    }
+
+    // Removing the best path keeps the other paths in order.
+    const BgpPath *best_path = route.BestPath();
+    EXPECT_TRUE(route.RemovePath(BgpPath::BGP_XMPP, best_path->GetPeer(), 0));
+    EXPECT_EQ(kPathCount - 1, route.count());
+    EXPECT_EQ(path_order[1], route.front());
+    VerifyPathOrder(route);
+
+    for (int idx = 0; idx < kPathCount; ++idx) {
+        route.RemovePath(peers[idx]);
+    }
+    STLDeleteValues(&peers);
+}
+
+//
+// Cost of adding paths and of best path changes for routes with 5 to 50
+// paths, as is common for routes with secondary paths in VPN tables.
+//
+// For comparison, also report the cost of adding paths when the whole path
+// list gets sorted after each add.
+//
+TEST_F(BgpRouteTest, PathBenchmark) {
+    static const int kPathCounts[] = { 5, 10, 50 };
+    static const int kRouteCount = 1024;
+
+    for (size_t count_idx = 0;
+         count_idx < sizeof(kPathCounts) / sizeof(kPathCounts[0]);
+         ++count_idx) {
+        int path_count = kPathCounts[count_idx];
+        std::vector<PeerMock *> peers;
+        std::vector<BgpAttrPtr> attrs;
+        for (int idx = 0; idx < path_count; ++idx) {
+            peers.push_back(new PeerMock(BgpProto::IBGP,
+                Ip4Address(0x0a010100 + idx)));
+            attrs.push_back(LocateAttr(100 + (idx * 7919) % path_count));
+        }
+        BgpAttrPtr best_attr = LocateAttr(100 + path_count);
+
+        std::vector<InetRoute *> routes;
+        for (int idx = 0; idx < kRouteCount; ++idx) {
+            routes.push_back(new InetRoute(Ip4Prefix(Ip4Address(idx), 32)));
+        }
+
+        // Add paths.
+        uint64_t start = ClockMonotonicUsec();
+        BOOST_FOREACH(InetRoute *route, routes) {
+            for (int idx = 0; idx < path_count; ++idx) {
+                route->InsertPath(new BgpPath(peers[idx],
+                    BgpPath::BGP_XMPP, attrs[idx], 0, 0));
+            }
+        }
+        uint64_t add_time = ClockMonotonicUsec() - start;
+
+        // Find paths.
+        start = ClockMonotonicUsec();
+        BOOST_FOREACH(InetRoute *route, routes) {
+            for (int idx = 0; idx < path_count; ++idx) {
+                EXPECT_TRUE(
+                    route->FindPath(BgpPath::BGP_XMPP, peers[idx], 0) != NULL);
+            }
+        }
+        uint64_t find_time = ClockMonotonicUsec() - start;
+
+        // Best path changes: replace the path from a peer with a better one
+        // and then restore the original path.
+        start = ClockMonotonicUsec();
+        BOOST_FOREACH(InetRoute *route, routes) {
+            for (int idx = 0; idx < path_count; ++idx) {
+                route->RemovePath(BgpPath::BGP_XMPP, peers[idx], 0);
+                route->InsertPath(new BgpPath(peers[idx],
+                    BgpPath::BGP_XMPP, best_attr, 0, 0));
+                route->RemovePath(BgpPath::BGP_XMPP, peers[idx], 0);
+                route->InsertPath(new BgpPath(peers[idx],
+                    BgpPath::BGP_XMPP, attrs[idx], 0, 0));
+            }
+        }
+        uint64_t change_time = ClockMonotonicUsec() - start;
+
+        BOOST_FOREACH(InetRoute *route, routes) {
+            VerifyPathOrder(*route);
+            for (int idx = 0; idx < path_count; ++idx) {
+                route->RemovePath(peers[idx]);
+            }
+        }
+
+        // Add paths and sort the whole list after each add.
+        start = ClockMonotonicUsec();
+        BOOST_FOREACH(InetRoute *route, routes) {
+            for (int idx = 0; idx < path_count; ++idx) {
+                route->InsertPath(new BgpPath(peers[idx],
+                    BgpPath::BGP_XMPP, attrs[idx], 0, 0));
+                route->Sort(&BgpTable::PathSelection, route->front());
+            }
+        }
+        uint64_t sort_time = ClockMonotonicUsec() - start;
+
+        BOOST_FOREACH(InetRoute *route, routes) {
+            for (int idx = 0; idx < path_count; ++idx) {
+                route->RemovePath(peers[idx]);
+            }
+        }
+        STLDeleteValues(&routes);
+        STLDeleteValues(&peers);
+
+        uint64_t ops = static_cast<uint64_t>(kRouteCount) * path_count;
+        std::cout << path_count << " paths per route: add "
+            << add_time * 1000 / ops << " nsec, add and sort "
+            << sort_time * 1000 / ops << " nsec, find "
+            << find_time * 1000 / ops << " nsec, best path change "
+            << change_time * 1000 / ops / 2 << " nsec" << std::endl;
+    }
+}
+
 static void SetUp() {
     bgp_log_test::init();
     ControlNode::SetDefaultSchedulingPolicy();
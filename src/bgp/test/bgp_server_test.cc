@@ -274,6 +274,13 @@ void BgpServerUnitTest::ValidateShowBgpServerResponse(Sandesh *sandesh) {
     EXPECT_NE(0, tx_stats.calls);
     EXPECT_NE(0, tx_stats.bytes);
     EXPECT_NE(0, tx_stats.average_bytes);
+    const vector<ShowPathAttributeDBStats> &db_stats_list =
+        resp->get_path_attribute_db_stats();
+    EXPECT_EQ(10, db_stats_list.size());
+    for (size_t idx = 0; idx < db_stats_list.size(); ++idx) {
+        EXPECT_FALSE(db_stats_list[idx].name.empty());
+        EXPECT_NE(0, db_stats_list[idx].partitions);
+    }
     validate_done_ = true;
 }
 
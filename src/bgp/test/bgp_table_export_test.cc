@@ -5,6 +5,7 @@
 #include <boost/assign/list_of.hpp>
 
 #include "base/task_annotations.h"
+#include "base/time_util.h"
 #include "bgp/bgp_factory.h"
 #include "bgp/bgp_route.h"
 #include "bgp/bgp_update.h"
@@ -274,12 +275,33 @@ protected:
     }
 
     void UnregisterRibOutPeers() {
-        for (int idx = 0; idx < 3; ++idx) {
+        for (size_t idx = 0; idx < ribout_peers_.size(); ++idx) {
             UnregisterRibOut(ribout_peers_[idx]);
         }
         STLDeleteValues(&ribout_peers_);
     }
 
+    // Register more peers so that the RibOut has count peers in all.
+    void AddRibOutPeers(size_t count) {
+        bool internal = (ribout_->peer_type() == BgpProto::IBGP);
+        for (size_t idx = ribout_peers_.size(); idx < count; ++idx) {
+            BgpTestPeer *peer = new BgpTestPeer(16 + idx, internal);
+            ribout_peers_.push_back(peer);
+            RegisterRibOut(peer);
+        }
+    }
+
+    // Run export for the route count times and return the average time
+    // taken in nanoseconds.
+    uint64_t RunExportBenchmark(int count) {
+        uint64_t start = ClockMonotonicUsec();
+        for (int idx = 0; idx < count; ++idx) {
+            uinfo_slist_->clear_and_dispose(UpdateInfoDisposer());
+            RunExport();
+        }
+        return (ClockMonotonicUsec() - start) * 1000 / count;
+    }
+
     void SetAttrAsPath(as_t as_number) {
         BgpAttr *attr = new BgpAttr(*attr_ptr_);
         const AsPathSpec &path_spec = attr_ptr_->as_path()->path();
@@ -1537,6 +1559,59 @@ INSTANTIATE_TEST_CASE_P(Instance, BgpTableExportParamTest6,
         ::testing::Bool(),
         ::testing::Bool()));
 
+//
+// Export cost per route as the number of peers in the RibOut goes up.
+//
+// The RibOutAttr is computed once for each route and the per peer checks are
+// bitmask operations on the RibPeerSet, so the cost should stay more or less
+// flat.
+//
+class BgpTableExportBenchmarkTest :
+    public BgpTableExportTest,
+    public ::testing::WithParamInterface<const char *> {
+protected:
+    static const int kExportCount = 64 * 1024;
+
+    virtual void SetUp() {
+        table_name_ = GetParam();
+        internal_ = false;
+        BgpTableExportTest::SetUp();
+    }
+
+    virtual void TearDown() {
+        BgpTableExportTest::TearDown();
+    }
+
+    void RunBenchmark(const string &name) {
+        static const size_t kPeerCounts[] = { 16, 256, 1024, 4096 };
+        AddPath();
+        for (size_t idx = 0;
+             idx < sizeof(kPeerCounts) / sizeof(kPeerCounts[0]); ++idx) {
+            AddRibOutPeers(kPeerCounts[idx]);
+            uint64_t export_time = RunExportBenchmark(kExportCount);
+            VerifyExportAccept();
+            cout << table_name_ << " " << name << " RibOut with "
+                << kPeerCounts[idx] << " peers: " << export_time
+                << " nsec per route" << endl;
+        }
+    }
+};
+
+TEST_P(BgpTableExportBenchmarkTest, EBgp) {
+    CreateRibOut(BgpProto::EBGP, RibExportPolicy::BGP, 300);
+    SetAttrExtCommunity(12345);
+    RunBenchmark("eBGP");
+}
+
+TEST_P(BgpTableExportBenchmarkTest, Xmpp) {
+    CreateRibOut(BgpProto::XMPP, RibExportPolicy::XMPP);
+    SetAttrExtCommunity(12345);
+    RunBenchmark("XMPP");
+}
+
+INSTANTIATE_TEST_CASE_P(Instance, BgpTableExportBenchmarkTest,
+    ::testing::Values("inet.0", "bgp.l3vpn.0"));
+
 static void SetUp() {
     bgp_log_test::init();
     ControlNode::SetDefaultSchedulingPolicy();
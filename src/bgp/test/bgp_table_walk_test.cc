@@ -9,6 +9,7 @@
 #include "control-node/control_node.h"
 #include "db/db_table.h"
 #include "db/db_table_walk_mgr.h"
+#include "db/db_types.h"
 
 using namespace boost;
 using namespace std;
@@ -229,6 +230,18 @@ public:
         walk_mgr->EnableWalkDoneTrigger();
     }
 
+    void SetMaxConcurrentWalks(int count) {
+        DBTableWalkMgr *walk_mgr = server_.database()->GetWalkMgr();
+        walk_mgr->SetMaxConcurrentWalks(count);
+    }
+
+    DBTableWalkMgrStats GetWalkMgrStats() {
+        DBTableWalkMgr *walk_mgr = server_.database()->GetWalkMgr();
+        DBTableWalkMgrStats stats;
+        walk_mgr->GetStats(&stats);
+        return stats;
+    }
+
     void PauseTableWalk() {
         pause_walk_ = true;
     }
@@ -522,6 +535,138 @@ TEST_F(BgpTableWalkTest, SerialWalk_1) {
     DeleteInetRoute(purple_, "33.3.3.0/24");
 }
 
+//
+// Trigger walk on multiple tables at same time with concurrency of 2.
+// Verify that 2 tables are walked at the same time and the third one is
+// walked once one of those is done
+//
+TEST_F(BgpTableWalkTest, ParallelWalk) {
+    AddInetRoute(red_, "11.1.1.0/24");
+    AddInetRoute(blue_, "22.2.2.0/24");
+    AddInetRoute(purple_, "33.3.3.0/24");
+
+    DBTable::DBTableWalkRef walk_ref_1 = red_->AllocWalker(
+              boost::bind(&BgpTableWalkTest::WalkTableCallback, this, _1, _2),
+              boost::bind(&BgpTableWalkTest::WalkDone, this, _1, _2));
+    DBTable::DBTableWalkRef walk_ref_2 = blue_->AllocWalker(
+              boost::bind(&BgpTableWalkTest::WalkTableCallback, this, _1, _2),
+              boost::bind(&BgpTableWalkTest::WalkDone, this, _1, _2));
+    DBTable::DBTableWalkRef walk_ref_3 = purple_->AllocWalker(
+              boost::bind(&BgpTableWalkTest::WalkTableCallback, this, _1, _2),
+              boost::bind(&BgpTableWalkTest::WalkDone, this, _1, _2));
+
+    SetMaxConcurrentWalks(2);
+    task_util::WaitForIdle();
+
+    // Hold the walk done processing so that the first 2 walks stay active
+    DisableWalkDoneProcessing();
+    DisableWalkProcessing();
+    WalkTable(red_, walk_ref_1);
+    WalkTable(blue_, walk_ref_2);
+    WalkTable(purple_, walk_ref_3);
+    EnableWalkProcessing();
+
+    TASK_UTIL_EXPECT_EQ(1, red_->walk_complete_count());
+    TASK_UTIL_EXPECT_EQ(1, blue_->walk_complete_count());
+    TASK_UTIL_EXPECT_EQ(2, walk_count_);
+    // Ensure that walk did not start on PURPLE table
+    TASK_UTIL_EXPECT_EQ(0, purple_->walk_count());
+    TASK_UTIL_EXPECT_FALSE(walk_done_);
+    TASK_UTIL_EXPECT_EQ(2, GetWalkMgrStats().get_active_walks());
+    TASK_UTIL_EXPECT_EQ(1, GetWalkMgrStats().get_queue_depth());
+
+    EnableWalkDoneProcessing();
+    TASK_UTIL_EXPECT_EQ(3, walk_done_count_);
+    TASK_UTIL_EXPECT_EQ(3, walk_count_);
+    TASK_UTIL_EXPECT_EQ(1, purple_->walk_count());
+    TASK_UTIL_EXPECT_EQ(1, purple_->walk_complete_count());
+    TASK_UTIL_EXPECT_EQ(0, GetWalkMgrStats().get_active_walks());
+    TASK_UTIL_EXPECT_EQ(0, GetWalkMgrStats().get_queue_depth());
+
+    SetMaxConcurrentWalks(1);
+    DeleteInetRoute(red_, "11.1.1.0/24");
+    DeleteInetRoute(blue_, "22.2.2.0/24");
+    DeleteInetRoute(purple_, "33.3.3.0/24");
+}
+
+//
+// With concurrency of 2, WalkAgain on a table that is being walked is not
+// started till the current walk on the table is done, even though a slot is
+// available.
+//
+TEST_F(BgpTableWalkTest, ParallelWalk_1) {
+    AddInetRoute(red_, "11.1.1.0/24");
+
+    DBTable::DBTableWalkRef walk_ref = red_->AllocWalker(
+              boost::bind(&BgpTableWalkTest::WalkTableCallback, this, _1, _2),
+              boost::bind(&BgpTableWalkTest::WalkDone, this, _1, _2));
+
+    SetMaxConcurrentWalks(2);
+    task_util::WaitForIdle();
+
+    DisableWalkDoneProcessing();
+    WalkTable(red_, walk_ref);
+    TASK_UTIL_EXPECT_EQ(1, red_->walk_complete_count());
+
+    WalkAgain(red_, walk_ref);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(1, red_->walk_count());
+    TASK_UTIL_EXPECT_EQ(1, GetWalkMgrStats().get_queue_depth());
+
+    EnableWalkDoneProcessing();
+    TASK_UTIL_EXPECT_EQ(2, red_->walk_complete_count());
+    TASK_UTIL_EXPECT_TRUE(walk_done_);
+    TASK_UTIL_EXPECT_EQ(1, walk_done_count_);
+    TASK_UTIL_EXPECT_EQ(2, walk_count_);
+
+    SetMaxConcurrentWalks(1);
+    DeleteInetRoute(red_, "11.1.1.0/24");
+}
+
+//
+// Verify the walk request and clubbing stats of the walk manager
+//
+TEST_F(BgpTableWalkTest, WalkMgrStats) {
+    AddInetRoute(red_, "11.1.1.0/24");
+    task_util::WaitForIdle();
+    DBTableWalkMgrStats stats_before = GetWalkMgrStats();
+
+    DBTable::DBTableWalkRef walk_ref_1 = red_->AllocWalker(
+              boost::bind(&BgpTableWalkTest::WalkTableCallback, this, _1, _2),
+              boost::bind(&BgpTableWalkTest::WalkDone, this, _1, _2));
+    DBTable::DBTableWalkRef walk_ref_2 = red_->AllocWalker(
+              boost::bind(&BgpTableWalkTest::WalkTableCallback, this, _1, _2),
+              boost::bind(&BgpTableWalkTest::WalkDone, this, _1, _2));
+
+    DisableWalkProcessing();
+    WalkTable(red_, walk_ref_1);
+    WalkTable(red_, walk_ref_2);
+    WalkAgain(red_, walk_ref_1);
+    task_util::WaitForIdle();
+    EXPECT_EQ(1, GetWalkMgrStats().get_queue_depth());
+    EnableWalkProcessing();
+
+    TASK_UTIL_EXPECT_EQ(2, walk_done_count_);
+    task_util::WaitForIdle();
+    DBTableWalkMgrStats stats = GetWalkMgrStats();
+    EXPECT_EQ(1, stats.get_max_concurrent_walks());
+    EXPECT_EQ(0, stats.get_active_walks());
+    EXPECT_EQ(0, stats.get_queue_depth());
+    EXPECT_LE(1, stats.get_max_queue_depth());
+    EXPECT_EQ(stats_before.get_walk_requests() + 3, stats.get_walk_requests());
+    EXPECT_EQ(stats_before.get_walk_requests_clubbed() + 2,
+              stats.get_walk_requests_clubbed());
+    EXPECT_EQ(stats_before.get_walks_started() + 1, stats.get_walks_started());
+    EXPECT_EQ(stats_before.get_walks_completed() + 1,
+              stats.get_walks_completed());
+    EXPECT_LE(stats.get_max_walk_time_usecs(),
+              stats.get_total_walk_time_usecs());
+    EXPECT_LE(stats.get_max_wait_time_usecs(),
+              stats.get_total_wait_time_usecs());
+
+    DeleteInetRoute(red_, "11.1.1.0/24");
+}
+
 //
 // Release the walker after starting the walk and before infra actually started
 // the walk.
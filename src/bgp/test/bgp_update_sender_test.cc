@@ -254,6 +254,16 @@ protected:
         VerifyOddEvenPeerInSync(start_idx, end_idx, false, true, in_sync);
     }
 
+    void BatchTimerExpired() {
+        task_util::TaskFire(
+            boost::bind(&BgpSenderPartition::BatchTimerExpired, spartition_),
+            "bgp::SendUpdate", spartition_->index());
+    }
+
+    bool IsBatching(int ro_idx, int qid) {
+        return spartition_->IsBatching(ribouts_[ro_idx], qid);
+    }
+
     int PeerStateCount() { return spartition_->peer_state_imap_.count(); }
     int RibStateCount() { return spartition_->rib_state_imap_.count(); }
 
@@ -533,6 +543,87 @@ TEST_F(BgpUpdateSenderTest, TailDequeueProgressiveBlock2) {
     VerifyPeerBlock(0, kPeerCount-1, true);
 }
 
+//
+// A (RibOut, QueueId) stays out of batching mode when the batch hold time
+// is 0, even if TailDequeue blocks some peers.
+//
+TEST_F(BgpUpdateSenderTest, TailDequeueBatch1) {
+    RibPeerSet peerset, blocked_peerset;
+    BuildPeerSet(peerset, 0, 0, kPeerCount-1);
+    BuildPeerSet(blocked_peerset, 0, 0);
+
+    EXPECT_EQ(0, spartition_->batch_hold_time());
+    EXPECT_CALL(*updates_[0],
+        TailDequeue(RibOutUpdates::QUPDATE, peerset,
+                    Property(&RibPeerSet::empty, true),
+                    Property(&RibPeerSet::empty, true)))
+        .Times(1)
+        .WillOnce(DoAll(SetArgPointee<2>(blocked_peerset), Return(true)));
+
+    RibOutActive(ribouts_[0], RibOutUpdates::QUPDATE);
+    task_util::WaitForIdle();
+    EXPECT_FALSE(IsBatching(0, RibOutUpdates::QUPDATE));
+}
+
+//
+// A TailDequeue that blocks a peer puts the (RibOut, QueueId) in batching
+// mode. Subsequent calls to RibOutActive don't cause a TailDequeue till the
+// batch timer expires, at which point there's one TailDequeue for each of
+// the held queues. The (RibOut, QueueId) leaves batching mode when the
+// TailDequeue finds a shallow queue and doesn't block any peers.
+//
+TEST_F(BgpUpdateSenderTest, TailDequeueBatch2) {
+    RibPeerSet peerset, blocked_peerset, sync_peerset;
+    BuildPeerSet(peerset, 0, 0, kPeerCount-1);
+    BuildPeerSet(blocked_peerset, 0, 0);
+    BuildPeerSet(sync_peerset, 0, 1, kPeerCount-1);
+
+    spartition_->set_batch_hold_time(60000);
+
+    // Expect 1 call to TailDequeue for each qid. Block peer 0 for both.
+    for (int qid = RibOutUpdates::QFIRST; qid < RibOutUpdates::QCOUNT;
+         qid++) {
+        RibPeerSet &msync = (qid == RibOutUpdates::QFIRST) ?
+            peerset : sync_peerset;
+        EXPECT_CALL(*updates_[0],
+            TailDequeue(qid, msync,
+                        Property(&RibPeerSet::empty, true),
+                        Property(&RibPeerSet::empty, true)))
+            .Times(1)
+            .WillOnce(DoAll(SetArgPointee<2>(blocked_peerset), Return(true)));
+        RibOutActive(ribouts_[0], qid);
+        task_util::WaitForIdle();
+        EXPECT_TRUE(IsBatching(0, qid));
+    }
+
+    // No calls to TailDequeue since both qids are in batching mode.
+    for (int idx = 0; idx < 5; idx++) {
+        for (int qid = RibOutUpdates::QFIRST; qid < RibOutUpdates::QCOUNT;
+             qid++) {
+            RibOutActive(ribouts_[0], qid);
+        }
+    }
+    task_util::WaitForIdle();
+
+    // Expect 1 call to TailDequeue for each qid when the timer expires.
+    for (int qid = RibOutUpdates::QFIRST; qid < RibOutUpdates::QCOUNT;
+         qid++) {
+        EXPECT_CALL(*updates_[0],
+            TailDequeue(qid, sync_peerset,
+                        Property(&RibPeerSet::empty, true),
+                        Property(&RibPeerSet::empty, true)))
+            .Times(1)
+            .WillOnce(Return(true));
+    }
+    BatchTimerExpired();
+    task_util::WaitForIdle();
+
+    for (int qid = RibOutUpdates::QFIRST; qid < RibOutUpdates::QCOUNT;
+         qid++) {
+        EXPECT_FALSE(IsBatching(0, qid));
+    }
+}
+
 //
 // PeerDequeue is called when peers get unblocked.  Should not get called
 // for qid that is not active.
@@ -12,6 +12,7 @@
 #include "sandesh/sandesh_types.h"
 #include "sandesh/sandesh.h"
 #include "sandesh/sandesh_trace.h"
+#include "base/timer.h"
 #include "bgp/bgp_factory.h"
 #include "bgp/bgp_peer_types.h"
 #include "bgp/bgp_sandesh.h"
@@ -512,6 +513,36 @@ protected:
         return table->path_resolver()->GetResolverNexthopUpdateListSize();
     }
 
+    void SetResolverNexthopHoldTime(const string &instance, int hold_time) {
+        BgpTable *table = GetTable(instance);
+        table->path_resolver()->SetResolverNexthopHoldTime(hold_time);
+    }
+
+    bool IsResolverNexthopHoldTimerRunning(const string &instance) {
+        BgpTable *table = GetTable(instance);
+        return table->path_resolver()->nexthop_hold_timer_->running();
+    }
+
+    void FireResolverNexthopHoldTimerCallback(PathResolver *resolver) {
+        resolver->nexthop_hold_timer_->Cancel();
+        resolver->NexthopHoldTimerExpired();
+    }
+
+    // Fire the nexthop hold timer right away instead of waiting for it.
+    void FireResolverNexthopHoldTimer(const string &instance) {
+        BgpTable *table = GetTable(instance);
+        task_util::TaskFire(
+            boost::bind(&PathResolverTest::FireResolverNexthopHoldTimerCallback,
+                this, table->path_resolver()), "bgp::ResolverNexthop");
+    }
+
+    ShowPathResolver GetPathResolverShowInfo(const string &instance) {
+        BgpTable *table = GetTable(instance);
+        ShowPathResolver spr;
+        table->path_resolver()->FillShowInfo(&spr, true);
+        return spr;
+    }
+
     void DisableResolverPathUpdateProcessing(const string &instance) {
         BgpTable *table = GetTable(instance);
         table->path_resolver()->DisableResolverPathUpdateProcessing();
@@ -2226,6 +2257,85 @@ TYPED_TEST(PathResolverTest, MultiplePrefixChangeXmppPath2) {
     }
 }
 
+//
+// BGP has multiple prefixes, each with the same nexthop.
+// Change XMPP path multiple times within the nexthop hold time.
+// The changes get coalesced into a single update of the resolved paths.
+//
+TYPED_TEST(PathResolverTest, MultiplePrefixChangeXmppPathHoldTime) {
+    PeerMock *bgp_peer1 = this->bgp_peer1_;
+    PeerMock *xmpp_peer1 = this->xmpp_peer1_;
+
+    for (int idx = 1; idx <= DB::PartitionCount() * 2; ++idx) {
+        this->AddBgpPath(bgp_peer1, "blue", this->BuildPrefix(idx),
+            this->BuildHostAddress(bgp_peer1->ToString()));
+    }
+
+    this->AddXmppPath(xmpp_peer1, "blue",
+        this->BuildPrefix(bgp_peer1->ToString(), 32),
+        this->BuildNextHopAddress("172.16.1.1"), 10000);
+    for (int idx = 1; idx <= DB::PartitionCount() * 2; ++idx) {
+        this->VerifyPathAttributes("blue", this->BuildPrefix(idx), bgp_peer1,
+            this->BuildNextHopAddress("172.16.1.1"), 10000);
+    }
+
+    task_util::WaitForIdle();
+    ShowPathResolver spr1 = this->GetPathResolverShowInfo("blue");
+    EXPECT_EQ(0, spr1.get_nexthop_hold_time());
+    EXPECT_LE(1, spr1.get_nexthop_update_count());
+    EXPECT_LE(1, spr1.get_nexthop_processed_count());
+    EXPECT_LE(1, spr1.get_path_update_count());
+    EXPECT_GE(spr1.get_path_update_max_latency_usecs(),
+        spr1.get_path_update_avg_latency_usecs());
+
+    // The hold time is long enough that the timer never fires on its own,
+    // the test fires it explicitly.
+    this->SetResolverNexthopHoldTime("blue", 3600 * 1000);
+    for (int label = 10001; label <= 10004; ++label) {
+        this->AddXmppPath(xmpp_peer1, "blue",
+            this->BuildPrefix(bgp_peer1->ToString(), 32),
+            this->BuildNextHopAddress("172.16.1.1"), label);
+        task_util::WaitForIdle();
+    }
+    EXPECT_EQ(1, this->ResolverNexthopUpdateListSize("blue"));
+    EXPECT_TRUE(this->IsResolverNexthopHoldTimerRunning("blue"));
+    for (int idx = 1; idx <= DB::PartitionCount() * 2; ++idx) {
+        this->VerifyPathAttributes("blue", this->BuildPrefix(idx), bgp_peer1,
+            this->BuildNextHopAddress("172.16.1.1"), 10000);
+    }
+
+    this->FireResolverNexthopHoldTimer("blue");
+    TASK_UTIL_EXPECT_EQ(0, this->ResolverNexthopUpdateListSize("blue"));
+    for (int idx = 1; idx <= DB::PartitionCount() * 2; ++idx) {
+        this->VerifyPathAttributes("blue", this->BuildPrefix(idx), bgp_peer1,
+            this->BuildNextHopAddress("172.16.1.1"), 10004);
+    }
+
+    task_util::WaitForIdle();
+    ShowPathResolver spr2 = this->GetPathResolverShowInfo("blue");
+    EXPECT_EQ(3600 * 1000, spr2.get_nexthop_hold_time());
+    EXPECT_EQ(spr1.get_nexthop_update_count() + 4,
+        spr2.get_nexthop_update_count());
+    EXPECT_EQ(spr1.get_nexthop_processed_count() + 1,
+        spr2.get_nexthop_processed_count());
+    EXPECT_LT(1.0, spr2.get_nexthop_coalesce_ratio());
+    EXPECT_LT(spr1.get_path_update_count(), spr2.get_path_update_count());
+    EXPECT_GE(spr2.get_path_update_max_latency_usecs(),
+        spr2.get_path_update_avg_latency_usecs());
+
+    this->SetResolverNexthopHoldTime("blue", 0);
+    this->DeleteXmppPath(xmpp_peer1, "blue",
+        this->BuildPrefix(bgp_peer1->ToString(), 32));
+    for (int idx = 1; idx <= DB::PartitionCount() * 2; ++idx) {
+        this->VerifyPathNoExists("blue", this->BuildPrefix(idx), bgp_peer1,
+            this->BuildNextHopAddress("172.16.1.1"));
+    }
+
+    for (int idx = 1; idx <= DB::PartitionCount() * 2; ++idx) {
+        this->DeleteBgpPath(bgp_peer1, "blue", this->BuildPrefix(idx));
+    }
+}
+
 //
 // BGP has 2 paths for all prefixes.
 //
@@ -2,13 +2,22 @@
  * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
  */
 
+#include <boost/foreach.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "base/time_util.h"
 #include "base/test/task_test_util.h"
 
 #include "bgp/bgp_log.h"
 #include "bgp/bgp_ribout.h"
 #include "bgp/bgp_server.h"
 #include "bgp/extended-community/mac_mobility.h"
+#include "bgp/extended-community/tag.h"
 #include "bgp/inet/inet_route.h"
+#include "bgp/tunnel_encap/tunnel_encap.h"
 #include "control-node/control_node.h"
 
 class BgpPeerMock : public IPeer {
@@ -60,6 +69,52 @@ protected:
         task_util::WaitForIdle();
     }
 
+    // Add an ECMP path from each of the peers, with a nexthop derived from
+    // the index and with the tunnel encapsulations and tags that are typical
+    // for service chain routes.
+    void AddEcmpPaths(InetRoute *route, std::vector<BgpPeerMock> *peers,
+        int index) {
+        for (size_t idx = 0; idx < peers->size(); ++idx) {
+            BgpAttrLocalPref local_pref(100);
+            BgpAttrNextHop nexthop(0x0a000000 + (index << 4) + idx);
+            ExtCommunitySpec extcomm_spec;
+            extcomm_spec.communities.push_back(
+                TunnelEncap("gre").GetExtCommunityValue());
+            extcomm_spec.communities.push_back(
+                TunnelEncap("udp").GetExtCommunityValue());
+            extcomm_spec.communities.push_back(
+                TunnelEncap("vxlan").GetExtCommunityValue());
+            extcomm_spec.communities.push_back(
+                Tag(0, 100 + idx).GetExtCommunityValue());
+            BgpAttrSpec spec;
+            spec.push_back(&local_pref);
+            spec.push_back(&nexthop);
+            spec.push_back(&extcomm_spec);
+            BgpAttrPtr attr = server_.attr_db()->Locate(spec);
+            route->InsertPath(new BgpPath(&peers->at(idx),
+                BgpPath::BGP_XMPP, attr, 0, 16 + idx));
+        }
+    }
+
+    void DeleteEcmpPaths(InetRoute *route, std::vector<BgpPeerMock> *peers) {
+        for (size_t idx = 0; idx < peers->size(); ++idx) {
+            route->RemovePath(&peers->at(idx));
+        }
+    }
+
+    // Heap memory used by an unshared copy of the nexthop list.
+    static size_t NextHopListMemory(const RibOutAttr::NextHopList &list) {
+        size_t size = list.capacity() * sizeof(RibOutAttr::NextHop);
+        BOOST_FOREACH(const RibOutAttr::NextHop &nexthop, list) {
+            size += nexthop.encap().capacity() * sizeof(std::string);
+            BOOST_FOREACH(const std::string &encap, nexthop.encap()) {
+                size += encap.capacity();
+            }
+            size += nexthop.tag_list().capacity() * sizeof(int);
+        }
+        return size;
+    }
+
     EventManager evm_;
     BgpServer server_;
 };
@@ -316,6 +371,132 @@ TEST_F(RibOutAttributesTest, SequenceNumber2) {
     route.RemovePath(&peer2);
 }
 
+//
+// RibOutAttrs with the same nexthops share the nexthop list, which goes
+// away with the last RibOutAttr that refers to it.
+//
+TEST_F(RibOutAttributesTest, SharedNextHopList) {
+    std::vector<BgpPeerMock> peers(4);
+    InetRoute route1(Ip4Prefix::FromString("10.1.1.0/24"));
+    InetRoute route2(Ip4Prefix::FromString("10.1.2.0/24"));
+    InetRoute route3(Ip4Prefix::FromString("10.1.3.0/24"));
+    AddEcmpPaths(&route1, &peers, 1);
+    AddEcmpPaths(&route2, &peers, 1);
+    AddEcmpPaths(&route3, &peers, 2);
+    size_t count = RibOutAttr::SharedNextHopListCount();
+
+    {
+    RibOutAttr ribout_attr1(&route1, route1.BestPath()->GetAttr(), true);
+    RibOutAttr ribout_attr2(&route2, route2.BestPath()->GetAttr(), true);
+    RibOutAttr ribout_attr3(&route3, route3.BestPath()->GetAttr(), true);
+    EXPECT_EQ(count + 2, RibOutAttr::SharedNextHopListCount());
+
+    EXPECT_EQ(4, ribout_attr1.nexthop_list().size());
+    EXPECT_EQ(3, ribout_attr1.nexthop_list().at(0).encap().size());
+    EXPECT_EQ(1, ribout_attr1.nexthop_list().at(0).tag_list().size());
+    EXPECT_EQ(&ribout_attr1.nexthop_list(), &ribout_attr2.nexthop_list());
+    EXPECT_NE(&ribout_attr1.nexthop_list(), &ribout_attr3.nexthop_list());
+    EXPECT_TRUE(ribout_attr1 == ribout_attr2);
+    EXPECT_TRUE(ribout_attr1 != ribout_attr3);
+
+    RibOutAttr ribout_attr4(ribout_attr3);
+    EXPECT_EQ(&ribout_attr3.nexthop_list(), &ribout_attr4.nexthop_list());
+    EXPECT_TRUE(ribout_attr3 == ribout_attr4);
+    ribout_attr3.clear();
+    EXPECT_TRUE(ribout_attr3.nexthop_list().empty());
+    EXPECT_EQ(count + 2, RibOutAttr::SharedNextHopListCount());
+    ribout_attr4 = ribout_attr1;
+    EXPECT_EQ(count + 1, RibOutAttr::SharedNextHopListCount());
+    }
+
+    EXPECT_EQ(count, RibOutAttr::SharedNextHopListCount());
+    DeleteEcmpPaths(&route1, &peers);
+    DeleteEcmpPaths(&route2, &peers);
+    DeleteEcmpPaths(&route3, &peers);
+}
+
+//
+// Build RibOutAttrs for kRibOutAttrCount routes that have 4 ECMP paths each,
+// and copy them the way the export and update code does. The routes share
+// kNextHopSetCount different sets of nexthops, as is the case for routes
+// that are re-originated by a service chain.
+//
+// Reports the time taken as well as the memory needed for the nexthop lists,
+// both with the shared lists and as it would be with a private copy of the
+// list in each RibOutAttr.
+//
+TEST_F(RibOutAttributesTest, Benchmark) {
+    static const int kNextHopSetCount = 64;
+    static const int kRibOutAttrCount = 1024 * 1024;
+
+    std::vector<BgpPeerMock> peers(4);
+    std::vector<InetRoute *> routes;
+    for (int idx = 0; idx < kNextHopSetCount; ++idx) {
+        InetRoute *route = new InetRoute(
+            Ip4Prefix(Ip4Address(0x0b000000 + (idx << 8)), 24));
+        AddEcmpPaths(route, &peers, idx);
+        routes.push_back(route);
+    }
+    size_t count = RibOutAttr::SharedNextHopListCount();
+
+    std::vector<RibOutAttr> ribout_attrs;
+    ribout_attrs.reserve(kRibOutAttrCount);
+    uint64_t start = ClockMonotonicUsec();
+    for (int idx = 0; idx < kRibOutAttrCount; ++idx) {
+        InetRoute *route = routes[idx % kNextHopSetCount];
+        ribout_attrs.push_back(
+            RibOutAttr(route, route->BestPath()->GetAttr(), true));
+    }
+    uint64_t build_time = ClockMonotonicUsec() - start;
+
+    start = ClockMonotonicUsec();
+    std::vector<RibOutAttr> ribout_attrs_copy(ribout_attrs);
+    uint64_t copy_time = ClockMonotonicUsec() - start;
+
+    start = ClockMonotonicUsec();
+    int equal_count = 0;
+    for (int idx = 0; idx < kRibOutAttrCount; ++idx) {
+        if (ribout_attrs[idx] == ribout_attrs_copy[idx])
+            equal_count++;
+    }
+    uint64_t compare_time = ClockMonotonicUsec() - start;
+    EXPECT_EQ(kRibOutAttrCount, equal_count);
+    EXPECT_EQ(count + kNextHopSetCount,
+        RibOutAttr::SharedNextHopListCount());
+
+    size_t unshared_memory = 0;
+    size_t shared_memory = 0;
+    for (int idx = 0; idx < kNextHopSetCount; ++idx) {
+        size_t list_memory =
+            NextHopListMemory(ribout_attrs[idx].nexthop_list());
+        unshared_memory += list_memory * (kRibOutAttrCount / kNextHopSetCount);
+        shared_memory +=
+            list_memory + sizeof(RibOutAttr::SharedNextHopList);
+    }
+    unshared_memory += kRibOutAttrCount * sizeof(RibOutAttr::NextHopList);
+    shared_memory +=
+        kRibOutAttrCount * sizeof(RibOutAttr::SharedNextHopListPtr);
+
+    std::cout << "RibOutAttrs         : " << kRibOutAttrCount << std::endl;
+    std::cout << "Build time          : " << build_time << " usec"
+        << std::endl;
+    std::cout << "Copy time           : " << copy_time << " usec"
+        << std::endl;
+    std::cout << "Compare time        : " << compare_time << " usec"
+        << std::endl;
+    std::cout << "Nexthop list memory : " << shared_memory / 1024
+        << " KB, unshared " << unshared_memory / 1024 << " KB per copy"
+        << std::endl;
+
+    ribout_attrs.clear();
+    ribout_attrs_copy.clear();
+    EXPECT_EQ(count, RibOutAttr::SharedNextHopListCount());
+    for (int idx = 0; idx < kNextHopSetCount; ++idx) {
+        DeleteEcmpPaths(routes[idx], &peers);
+        delete routes[idx];
+    }
+}
+
 }  // namespace
 
 static void SetUp() {
@@ -7,6 +7,10 @@
 #include <boost/foreach.hpp>
 #include <boost/assign/list_of.hpp>
 
+#include <iostream>
+
+#include "base/string_util.h"
+#include "base/time_util.h"
 #include "bgp/bgp_config_ifmap.h"
 #include "bgp/bgp_config_parser.h"
 #include "bgp/bgp_factory.h"
@@ -194,6 +198,36 @@ protected:
         task_util::WaitForIdle();
     }
 
+    // Add or delete count routes in the instance, starting at the given
+    // prefix, without waiting for each of them.
+    void EnqueueInetRoutes(IPeer *peer, const string &instance_name,
+                           const string &prefix, int count, bool add) {
+        boost::system::error_code error;
+        Ip4Prefix start = Ip4Prefix::FromString(prefix, &error);
+        EXPECT_FALSE(error);
+        BgpAttrSpec attr_spec;
+        boost::scoped_ptr<BgpAttrLocalPref> local_pref(
+                                new BgpAttrLocalPref(100));
+        attr_spec.push_back(local_pref.get());
+        BgpAttrPtr attr = bgp_server_->attr_db()->Locate(attr_spec);
+        BgpTable *table = static_cast<BgpTable *>(
+            bgp_server_->database()->FindTable(instance_name + ".inet.0"));
+        ASSERT_TRUE(table != NULL);
+        for (int idx = 0; idx < count; ++idx) {
+            Ip4Prefix nlri(Ip4Address(start.addr().to_ulong() + idx), 32);
+            DBRequest request;
+            if (add) {
+                request.oper = DBRequest::DB_ENTRY_ADD_CHANGE;
+                request.data.reset(new BgpTable::RequestData(attr, 0, 0));
+            } else {
+                request.oper = DBRequest::DB_ENTRY_DELETE;
+            }
+            request.key.reset(new InetTable::RequestKey(nlri, peer));
+            table->Enqueue(&request);
+        }
+        task_util::WaitForIdle();
+    }
+
     void AddVPNRouteCommon(IPeer *peer, const string &prefix,
                            const BgpAttrSpec &attr_spec) {
         boost::system::error_code error;
@@ -528,6 +562,22 @@ protected:
         TASK_UTIL_EXPECT_EQ(count, (vpn_ts ? vpn_ts->route_count() : 0));
     }
 
+    void DisableReplicatorRouteTargetProcessing() {
+        bgp_server_->replicator(Address::INETVPN)->
+            DisableRouteTargetProcessing();
+    }
+
+    void EnableReplicatorRouteTargetProcessing() {
+        bgp_server_->replicator(Address::INETVPN)->
+            EnableRouteTargetProcessing();
+    }
+
+    uint64_t TableWalkCount(const string &instance_name) {
+        BgpTable *table = static_cast<BgpTable *>(
+            bgp_server_->database()->FindTable(instance_name + ".inet.0"));
+        return table->walk_count();
+    }
+
     void DisableBulkSync() {
         DBTableWalkMgr *walk_mgr = bgp_server_->database()->GetWalkMgr();
         walk_mgr->DisableWalkProcessing();
@@ -2092,6 +2142,135 @@ TEST_F(ReplicationTest, UpdateInstanceImportRouteTargets1) {
     TASK_UTIL_EXPECT_TRUE(InetRouteLookup("red", "10.0.1.1/32") == NULL);
 }
 
+//
+// Adding or removing an import target re-evaluates the routes with the target
+// without walking the table that exports it.
+//
+TEST_F(ReplicationTest, UpdateInstanceImportRouteTargetsNoWalk) {
+    vector<string> instance_names = list_of("blue")("red");
+    multimap<string, string> connections;
+    NetworkConfig(instance_names, connections);
+    task_util::WaitForIdle();
+
+    boost::system::error_code ec;
+    peers_.push_back(
+        new BgpPeerMock(Ip4Address::from_string("192.168.0.1", ec)));
+
+    AddInetRoute(peers_[0], "blue", "10.0.1.1/32", 100, "192.168.0.1:1");
+    task_util::WaitForIdle();
+    VERIFY_EQ(0, RouteCount("red"));
+    uint64_t blue_walk_count = TableWalkCount("blue");
+
+    // Add blue export target to red import target list.
+    AddInstanceImportRouteTarget("red", "target:64496:1");
+    VERIFY_EQ(1, RouteCount("red"));
+    TASK_UTIL_EXPECT_TRUE(InetRouteLookup("red", "10.0.1.1/32") != NULL);
+    TASK_UTIL_EXPECT_EQ(blue_walk_count, TableWalkCount("blue"));
+
+    // Remove blue export target from red import target list.
+    RemoveInstanceRouteTarget("red", "target:64496:1");
+    VERIFY_EQ(0, RouteCount("red"));
+    TASK_UTIL_EXPECT_EQ(blue_walk_count, TableWalkCount("blue"));
+
+    DeleteInetRoute(peers_[0], "blue", "10.0.1.1/32");
+    task_util::WaitForIdle();
+    VERIFY_EQ(0, RouteCount("blue"));
+}
+
+//
+// Route in a VRF with a target in it's attributes that the VRF does not
+// export gets replicated when another VRF starts importing the target.
+//
+TEST_F(ReplicationTest, UpdateInstanceImportRouteTargetsRouteTarget) {
+    vector<string> instance_names = list_of("blue")("red");
+    multimap<string, string> connections;
+    NetworkConfig(instance_names, connections);
+    task_util::WaitForIdle();
+
+    boost::system::error_code ec;
+    peers_.push_back(
+        new BgpPeerMock(Ip4Address::from_string("192.168.0.1", ec)));
+
+    AddInetRoute(peers_[0], "blue", "10.0.1.1/32", 100, "192.168.0.1:1",
+                 list_of("target:64496:100"));
+    task_util::WaitForIdle();
+    VERIFY_EQ(0, RouteCount("red"));
+
+    AddInstanceImportRouteTarget("red", "target:64496:100");
+    VERIFY_EQ(1, RouteCount("red"));
+    TASK_UTIL_EXPECT_TRUE(InetRouteLookup("red", "10.0.1.1/32") != NULL);
+
+    RemoveInstanceRouteTarget("red", "target:64496:100");
+    VERIFY_EQ(0, RouteCount("red"));
+
+    DeleteInetRoute(peers_[0], "blue", "10.0.1.1/32");
+    task_util::WaitForIdle();
+    VERIFY_EQ(0, RouteCount("blue"));
+}
+
+//
+// Time taken to converge after a single import target change, with many VRFs
+// that have routes.  Only the routes of the VRF that exports the target get
+// evaluated.
+//
+TEST_F(ReplicationTest, UpdateInstanceImportRouteTargetsBenchmark) {
+    const int kInstanceCount = 64;
+    const int kRouteCount = 1024;
+
+    vector<string> instance_names;
+    for (int idx = 0; idx < kInstanceCount; ++idx) {
+        instance_names.push_back("vrf" + integerToString(idx));
+    }
+    multimap<string, string> connections;
+    NetworkConfig(instance_names, connections);
+    task_util::WaitForIdle();
+
+    boost::system::error_code ec;
+    peers_.push_back(
+        new BgpPeerMock(Ip4Address::from_string("192.168.0.1", ec)));
+
+    uint64_t start = ClockMonotonicUsec();
+    for (int idx = 0; idx < kInstanceCount; ++idx) {
+        Ip4Address addr(0x0a000000 + (idx << 16));
+        EnqueueInetRoutes(peers_[0], instance_names[idx],
+            addr.to_string() + "/32", kRouteCount, true);
+    }
+    uint64_t add_time = ClockMonotonicUsec() - start;
+    VERIFY_EQ(kRouteCount, RouteCount("vrf0"));
+    string last = instance_names.back();
+    VERIFY_EQ(kRouteCount, RouteCount(last));
+    uint64_t walk_count = TableWalkCount("vrf0");
+
+    // The last VRF starts importing the routes of the first one.
+    start = ClockMonotonicUsec();
+    AddInstanceImportRouteTarget(last, "target:64496:1");
+    TASK_UTIL_EXPECT_EQ(2 * kRouteCount, RouteCount(last));
+    uint64_t import_time = ClockMonotonicUsec() - start;
+
+    start = ClockMonotonicUsec();
+    RemoveInstanceRouteTarget(last, "target:64496:1");
+    TASK_UTIL_EXPECT_EQ(kRouteCount, RouteCount(last));
+    uint64_t remove_time = ClockMonotonicUsec() - start;
+    EXPECT_EQ(walk_count, TableWalkCount("vrf0"));
+
+    std::cout << "VRFs: " << kInstanceCount << ", routes per VRF: "
+        << kRouteCount << std::endl;
+    std::cout << "Add routes            : " << add_time << " usec"
+        << std::endl;
+    std::cout << "Add import target     : " << import_time << " usec"
+        << std::endl;
+    std::cout << "Remove import target  : " << remove_time << " usec"
+        << std::endl;
+
+    for (int idx = 0; idx < kInstanceCount; ++idx) {
+        Ip4Address addr(0x0a000000 + (idx << 16));
+        EnqueueInetRoutes(peers_[0], instance_names[idx],
+            addr.to_string() + "/32", kRouteCount, false);
+    }
+    VERIFY_EQ(0, RouteCount("vrf0"));
+    VERIFY_EQ(0, RouteCount(last));
+}
+
 TEST_F(ReplicationTest, UpdateInstanceImportRouteTargets2) {
     vector<string> instance_names = list_of("blue")("red");
     multimap<string, string> connections;
@@ -2631,6 +2810,7 @@ TEST_F(ReplicationTest, TableStateOnVRFInBulkSyncList) {
     TASK_UTIL_EXPECT_EQ(0, ts_red->route_count());
 
     DisableBulkSync();
+    DisableReplicatorRouteTargetProcessing();
 
     RemoveInstanceRouteTarget("blue", "target:64496:1");
     RemoveInstanceRouteTarget("red", "target:64496:2");
@@ -2666,6 +2846,7 @@ TEST_F(ReplicationTest, TableStateOnVRFInBulkSyncList) {
     TASK_UTIL_EXPECT_TRUE(ts_blue->table()->IsDeleted());
     TASK_UTIL_EXPECT_TRUE(ts_red->table()->IsDeleted());
 
+    EnableReplicatorRouteTargetProcessing();
     EnableBulkSync();
 
     VerifyVRFTableStateExists("blue", false);
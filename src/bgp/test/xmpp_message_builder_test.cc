@@ -2,10 +2,12 @@
  * Copyright (c) 2016 Juniper Networks, Inc. All rights reserved.
  */
 
+#include "base/time_util.h"
 #include "bgp/bgp_factory.h"
 #include "bgp/bgp_ribout.h"
 #include "bgp/bgp_ribout_updates.h"
 #include "bgp/xmpp_message_builder.h"
+#include "bgp/community.h"
 #include "bgp/inet/inet_route.h"
 #include "bgp/test/bgp_server_test_util.h"
 #include "control-node/control_node.h"
@@ -161,6 +163,124 @@ INSTANTIATE_TEST_CASE_P(LongPeerName, XmppMessageBuilderParamTest,
     ::testing::Combine(
         ::testing::Values(true), ::testing::Values(false), ::testing::Bool()));
 
+class XmppMessageBuilderAttrCacheTest : public XmppMessageBuilderTest {
+protected:
+    static const int kAttrCount = 1024;
+    static const int kLabelCount = 32;
+    static const int kEncodeRouteCount = 1024 * 1024;
+
+    virtual void SetUp() {
+        XmppMessageBuilderTest::SetUp();
+        for (int idx = 0; idx < kAttrCount; ++idx) {
+            BgpAttrNextHop nexthop(0x0a0a0a0a + idx % 16);
+            BgpAttrLocalPref local_pref(100 + idx);
+            CommunitySpec community;
+            community.communities.push_back(0xFFFF0000 + idx);
+            community.communities.push_back(0xFFFF0001);
+            BgpAttrSpec spec;
+            spec.push_back(&nexthop);
+            spec.push_back(&local_pref);
+            spec.push_back(&community);
+            BgpAttrPtr attr = bs_x_->attr_db()->Locate(spec);
+            attrs_.push_back(attr);
+            for (int lidx = 0; lidx < kLabelCount; ++lidx) {
+                attr_roattrs_.push_back(
+                    new RibOutAttr(table_, attr.get(), 1000 + lidx, 0, true));
+            }
+        }
+    }
+
+    virtual void TearDown() {
+        xmpp_message()->set_attr_cache_enabled(true);
+        STLDeleteValues(&attr_roattrs_);
+        attrs_.clear();
+        XmppMessageBuilderTest::TearDown();
+    }
+
+    BgpXmppMessage *xmpp_message() {
+        return static_cast<BgpXmppMessage *>(message_);
+    }
+
+    // Build a message with kRouteCount routes, all with the attribute at
+    // attr_idx, and return the encoded message.
+    string Encode(int msg_idx, int attr_idx) {
+        const RibOutAttr *roattr = attr_roattrs_[attr_idx * kLabelCount];
+        message_->Start(ribout_, false, roattr, routes_[0]);
+        for (int ridx = 1; ridx < kRouteCount; ++ridx) {
+            int lidx = (msg_idx + ridx) % kLabelCount;
+            roattr = attr_roattrs_[attr_idx * kLabelCount + lidx];
+            message_->AddRoute(routes_[ridx], roattr);
+        }
+        message_->Finish();
+        XmppTestPeer peer("agent.juniper.net");
+        size_t msgsize;
+        const string *msg_str = NULL;
+        const uint8_t *msg = message_->GetData(&peer, &msgsize, &msg_str);
+        return string(reinterpret_cast<const char *>(msg), msgsize);
+    }
+
+    uint64_t EncodeAll(bool cache) {
+        xmpp_message()->set_attr_cache_enabled(cache);
+        uint64_t start = ClockMonotonicUsec();
+        for (int idx = 0; idx < kEncodeRouteCount / kRouteCount; ++idx) {
+            Encode(idx, idx % kAttrCount);
+        }
+        return ClockMonotonicUsec() - start;
+    }
+
+    vector<BgpAttrPtr> attrs_;
+    vector<RibOutAttr *> attr_roattrs_;
+};
+
+//
+// Messages encoded using the cached attribute fragments must be identical
+// to messages encoded from scratch.
+//
+TEST_F(XmppMessageBuilderAttrCacheTest, Equivalence) {
+    vector<string> expected;
+    xmpp_message()->set_attr_cache_enabled(false);
+    for (int idx = 0; idx < 2 * kAttrCount; ++idx) {
+        expected.push_back(Encode(idx, idx % kAttrCount));
+    }
+
+    xmpp_message()->set_attr_cache_enabled(true);
+    for (int idx = 0; idx < 2 * kAttrCount; ++idx) {
+        EXPECT_EQ(expected[idx], Encode(idx, idx % kAttrCount));
+        EXPECT_EQ(idx < kAttrCount ? 1 : 0,
+            message_->num_attr_cache_misses());
+        EXPECT_EQ(idx < kAttrCount ? kRouteCount - 1 : kRouteCount,
+            message_->num_attr_cache_hits());
+    }
+    EXPECT_EQ(kAttrCount, xmpp_message()->attr_cache_size());
+}
+
+//
+// Deleting the ribout clears cached fragments for the table.
+//
+TEST_F(XmppMessageBuilderAttrCacheTest, ClearOnRibOutDelete) {
+    for (int idx = 0; idx < kAttrCount; ++idx) {
+        Encode(idx, idx);
+    }
+    EXPECT_EQ(kAttrCount, xmpp_message()->attr_cache_size());
+    table_->RibOutDelete(
+        RibExportPolicy(BgpProto::XMPP, RibExportPolicy::XMPP, -1, 0));
+    EXPECT_EQ(0, xmpp_message()->attr_cache_size());
+    ribout_ = table_->RibOutLocate(bs_x_->update_sender(),
+        RibExportPolicy(BgpProto::XMPP, RibExportPolicy::XMPP, -1, 0));
+}
+
+//
+// Encode 1M routes across 1K attribute sets with and without the cache.
+//
+TEST_F(XmppMessageBuilderAttrCacheTest, Benchmark) {
+    uint64_t nocache_time = EncodeAll(false);
+    uint64_t cache_time = EncodeAll(true);
+    cout << "Encoded " << kEncodeRouteCount << " routes with "
+         << kAttrCount << " attributes" << endl;
+    cout << "Without attribute cache : " << nocache_time << " usec" << endl;
+    cout << "With attribute cache    : " << cache_time << " usec" << endl;
+}
+
 class TestEnvironment : public ::testing::Environment {
     virtual ~TestEnvironment() { }
     virtual void SetUp() {
@@ -17,6 +17,7 @@
 #include "bgp/evpn/evpn_route.h"
 #include "bgp/routing-instance/routing_instance.h"
 #include "bgp/security_group/security_group.h"
+#include "base/string_util.h"
 #include "db/db.h"
 #include "net/community_type.h"
 #include "schema/xmpp_multicast_types.h"
@@ -29,6 +30,8 @@ using pugi::xml_node;
 using std::ostringstream;
 using std::copy;
 using std::fill;
+using std::make_pair;
+using std::pair;
 using std::string;
 using std::stringstream;
 using std::vector;
@@ -72,11 +75,13 @@ BgpXmppMessage::BgpXmppMessage()
       cache_routes_(false),
       repr_valid_(false),
       mobility_(0, false),
-      etree_leaf_(false) {
+      etree_leaf_(false),
+      attr_cache_enabled_(true) {
     msg_begin_.reserve(kMaxFromToLength);
 }
 
 BgpXmppMessage::~BgpXmppMessage() {
+    ClearAttrCache();
 }
 
 void BgpXmppMessage::Reset() {
@@ -195,20 +200,37 @@ void BgpXmppMessage::AddIpReach(const BgpRoute *route,
         return;
     }
 
+    assert(!roattr->nexthop_list().empty());
+
+    // Use the pre-rendered item for the attribute if available.
+    vector<string> virtual_network_list;
+    BOOST_FOREACH(const RibOutAttr::NextHop &nexthop, roattr->nexthop_list()) {
+        virtual_network_list.push_back(GetVirtualNetwork(nexthop));
+    }
+    size_t pos = repr_.size();
+    if (attr_cache_enabled_) {
+        const AttrFragment *fragment =
+            LookupAttrFragment(roattr, virtual_network_list);
+        if (fragment && EncodeAttrFragment(route, roattr, fragment)) {
+            num_attr_cache_hit_++;
+            if (cache_routes_)
+                roattr->set_repr(repr_, pos);
+            return;
+        }
+    }
+
     autogen::ItemType item;
     item.entry.nlri.af = route->Afi();
     item.entry.nlri.safi = route->XmppSafi();
     item.entry.nlri.address = route->ToString();
     item.entry.version = 1;
-    item.entry.virtual_network = GetVirtualNetwork(route, roattr);
+    item.entry.virtual_network = virtual_network_list.front();
     item.entry.local_preference = roattr->attr()->local_pref();
     item.entry.med = roattr->attr()->med();
     item.entry.sequence_number = mobility_.sequence_number;
     item.entry.mobility.seqno = mobility_.sequence_number;
     item.entry.mobility.sticky = mobility_.sticky;
 
-    assert(!roattr->nexthop_list().empty());
-
     // Encode all next-hops in the list.
     BOOST_FOREACH(const RibOutAttr::NextHop &nexthop, roattr->nexthop_list()) {
         EncodeNextHop(route, nexthop, &item);
@@ -231,10 +253,8 @@ void BgpXmppMessage::AddIpReach(const BgpRoute *route,
     xml_node node = doc_.append_child("item");
     node.append_attribute("id") = route->ToXmppIdString().c_str();
 
-    // Remember the previous size.
     // Using remove_child instead of reset allows memory pages allocated for
     // the xml_document to be reused during the lifetime of the xml_document.
-    size_t pos = repr_.size();
     item.Encode(&node);
     doc_.print(writer_, "\t", pugi::format_default, pugi::encoding_auto, 3);
     doc_.remove_child(node);
@@ -242,6 +262,164 @@ void BgpXmppMessage::AddIpReach(const BgpRoute *route,
     // Cache the substring starting at the previous size.
     if (cache_routes_)
         roattr->set_repr(repr_, pos);
+
+    // Split the rendered item into fragments for other routes that share
+    // the same attribute.
+    if (attr_cache_enabled_) {
+        num_attr_cache_miss_++;
+        AddAttrFragment(route, roattr, virtual_network_list, repr_.substr(pos));
+    }
+}
+
+//
+// Find the pre-rendered item for the BgpAttr and label-less nexthops in the
+// RibOutAttr.
+//
+// Note that the tunnel encapsulation list is omitted from nexthops with a
+// null label, so the fragment can only be used if the labels of the nexthops
+// in the RibOutAttr are null in exactly the same places.
+//
+const BgpXmppMessage::AttrFragment *BgpXmppMessage::LookupAttrFragment(
+    const RibOutAttr *roattr,
+    const vector<string> &virtual_network_list) const {
+    const RibOutAttr::NextHopList &nexthop_list = roattr->nexthop_list();
+    pair<AttrFragmentMap::const_iterator, AttrFragmentMap::const_iterator>
+        range = attr_cache_.equal_range(make_pair(table_, roattr->attr()));
+    for (AttrFragmentMap::const_iterator it = range.first;
+         it != range.second; ++it) {
+        const AttrFragment *fragment = it->second;
+        if (fragment->nexthop_list.size() != nexthop_list.size())
+            continue;
+        if (fragment->virtual_network_list != virtual_network_list)
+            continue;
+        bool match = true;
+        for (size_t idx = 0; match && idx < nexthop_list.size(); ++idx) {
+            const RibOutAttr::NextHop &nexthop = nexthop_list[idx];
+            const RibOutAttr::NextHop &cached = fragment->nexthop_list[idx];
+            if ((nexthop.label() == 0) != (cached.label() == 0) ||
+                nexthop.CompareToExceptLabel(cached) != 0) {
+                match = false;
+            }
+        }
+        if (match)
+            return fragment;
+    }
+    return NULL;
+}
+
+//
+// Split the rendered item for the route into fragments at the route id, the
+// prefix and the label of each nexthop and add them to the cache.
+//
+// The rendered item is verified to be in the expected format, which protects
+// against changes in the schema generated encoder. The item is not cached if
+// anything unexpected is found.
+//
+void BgpXmppMessage::AddAttrFragment(const BgpRoute *route,
+    const RibOutAttr *roattr, const vector<string> &virtual_network_list,
+    const string &repr) {
+    const RibOutAttr::NextHopList &nexthop_list = roattr->nexthop_list();
+    vector<string> text_list;
+
+    string id_attribute = "id=\"" + route->ToXmppIdString() + "\"";
+    size_t id_pos = repr.find(id_attribute);
+    if (id_pos == string::npos)
+        return;
+    id_pos += 4;
+    text_list.push_back(repr.substr(0, id_pos));
+
+    string prefix_element = "<address>" + route->ToString() + "</address>";
+    size_t nlri_pos = repr.find("<nlri>", id_pos);
+    size_t prefix_pos = repr.find(prefix_element, id_pos);
+    if (nlri_pos == string::npos || prefix_pos == string::npos ||
+        prefix_pos < nlri_pos || prefix_pos > repr.find("</nlri>", nlri_pos)) {
+        return;
+    }
+    prefix_pos += 9;
+    text_list.push_back(
+        repr.substr(id_pos + route->ToXmppIdString().size(),
+                    prefix_pos - id_pos - route->ToXmppIdString().size()));
+
+    size_t start_pos = prefix_pos + route->ToString().size();
+    BOOST_FOREACH(const RibOutAttr::NextHop &nexthop, nexthop_list) {
+        string label = integerToString(nexthop.label());
+        size_t label_pos = repr.find("<label>", start_pos);
+        if (label_pos == string::npos)
+            return;
+        label_pos += 7;
+        if (repr.compare(label_pos, label.size() + 8, label + "</label>") != 0)
+            return;
+        text_list.push_back(repr.substr(start_pos, label_pos - start_pos));
+        start_pos = label_pos + label.size();
+    }
+    if (repr.find("<label>", start_pos) != string::npos)
+        return;
+    text_list.push_back(repr.substr(start_pos));
+
+    if (attr_cache_.size() >= kMaxAttrCacheSize)
+        ClearAttrCache();
+    AttrFragment *fragment = new AttrFragment;
+    fragment->attr = roattr->attr();
+    fragment->nexthop_list = nexthop_list;
+    fragment->virtual_network_list = virtual_network_list;
+    fragment->text_list.swap(text_list);
+    attr_cache_.insert(make_pair(make_pair(table_, roattr->attr()), fragment));
+}
+
+//
+// Encode an ip reach item by splicing the route id, prefix and labels into
+// the pre-rendered fragments.
+//
+// Return false if the id or the prefix would need to be escaped, so that the
+// caller falls back to the regular encoder. This never happens for the route
+// types that use this path.
+//
+bool BgpXmppMessage::EncodeAttrFragment(const BgpRoute *route,
+    const RibOutAttr *roattr, const AttrFragment *fragment) {
+    string id = route->ToXmppIdString();
+    string prefix = route->ToString();
+    if (id.find_first_of("&<>\"'") != string::npos ||
+        prefix.find_first_of("&<>\"'") != string::npos) {
+        return false;
+    }
+
+    const vector<string> &text_list = fragment->text_list;
+    repr_ += text_list[0];
+    repr_ += id;
+    repr_ += text_list[1];
+    repr_ += prefix;
+    const RibOutAttr::NextHopList &nexthop_list = roattr->nexthop_list();
+    for (size_t idx = 0; idx < nexthop_list.size(); ++idx) {
+        repr_ += text_list[idx + 2];
+        repr_ += integerToString(nexthop_list[idx].label());
+    }
+    repr_ += text_list.back();
+    return true;
+}
+
+void BgpXmppMessage::ClearAttrCache() {
+    STLDeleteElements(&attr_cache_);
+}
+
+//
+// Remove all cached fragments for the given table. This is called when a
+// RibOut for the table is deleted so that the cache doesn't hold references
+// to BgpAttrs after the ribout is gone.
+//
+void BgpXmppMessage::ClearCache(const BgpTable *table) {
+    AttrFragmentMap::iterator it =
+        attr_cache_.lower_bound(
+            make_pair(table, static_cast<const BgpAttr *>(NULL)));
+    while (it != attr_cache_.end() && it->first.first == table) {
+        delete it->second;
+        attr_cache_.erase(it++);
+    }
+}
+
+void BgpXmppMessage::set_attr_cache_enabled(bool enabled) {
+    attr_cache_enabled_ = enabled;
+    if (!enabled)
+        ClearAttrCache();
 }
 
 void BgpXmppMessage::AddIpUnreach(const BgpRoute *route) {
@@ -309,7 +487,7 @@ void BgpXmppMessage::AddEnetReach(const BgpRoute *route,
 
     EvpnRoute *evpn_route =
         static_cast<EvpnRoute *>(const_cast<BgpRoute *>(route));
-    const EvpnPrefix &evpn_prefix = evpn_route->GetPrefix();
+    const EvpnPackedPrefix &evpn_prefix = evpn_route->GetPackedPrefix();
     item.entry.nlri.ethernet_tag = evpn_prefix.tag();
     item.entry.nlri.mac = evpn_prefix.mac_addr().ToString();
     item.entry.nlri.address = evpn_prefix.ip_address().to_string() + "/" +
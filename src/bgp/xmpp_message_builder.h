@@ -7,7 +7,9 @@
 
 #include <pugixml/pugixml.hpp>
 
+#include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "bgp/message_builder.h"
@@ -41,11 +43,16 @@ public:
     virtual bool AddRoute(const BgpRoute *route, const RibOutAttr *roattr);
     virtual const uint8_t *GetData(IPeerUpdate *peer, size_t *lenp,
                                    const std::string **msg_str);
+    virtual void ClearCache(const BgpTable *table);
+
+    void set_attr_cache_enabled(bool enabled);
+    size_t attr_cache_size() const { return attr_cache_.size(); }
 
 private:
     static const size_t kMaxFromToLength = 192;
     static const uint32_t kMaxReachCount = 32;
     static const uint32_t kMaxUnreachCount = 256;
+    static const size_t kMaxAttrCacheSize = 4096;
 
     class XmlWriter : public pugi::xml_writer {
     public:
@@ -67,7 +74,36 @@ private:
         bool sticky;
     };
 
+    //
+    // Pre-rendered xml for an ip reach item, keyed by table and BgpAttr.
+    //
+    // Everything in the item other than the route id, the prefix and the
+    // nexthop labels is a function of the BgpAttr and the nexthops sans
+    // their labels. The rendered item is split at those places so that
+    // routes sharing the attribute only need to splice in their id, prefix
+    // and labels.
+    //
+    // The BgpAttrPtr holds a reference to make sure that the BgpAttr can't
+    // be freed and reused for different attributes while it's in the cache.
+    //
+    struct AttrFragment {
+        BgpAttrPtr attr;
+        RibOutAttr::NextHopList nexthop_list;
+        std::vector<std::string> virtual_network_list;
+        std::vector<std::string> text_list;
+    };
+    typedef std::pair<const BgpTable *, const BgpAttr *> AttrFragmentKey;
+    typedef std::multimap<AttrFragmentKey, AttrFragment *> AttrFragmentMap;
+
     virtual void Reset();
+    const AttrFragment *LookupAttrFragment(const RibOutAttr *roattr,
+        const std::vector<std::string> &virtual_network_list) const;
+    void AddAttrFragment(const BgpRoute *route, const RibOutAttr *roattr,
+        const std::vector<std::string> &virtual_network_list,
+        const std::string &repr);
+    bool EncodeAttrFragment(const BgpRoute *route, const RibOutAttr *roattr,
+        const AttrFragment *fragment);
+    void ClearAttrCache();
     void EncodeNextHop(const BgpRoute *route,
                        const RibOutAttr::NextHop &nexthop,
                        autogen::ItemType *item);
@@ -109,6 +145,9 @@ private:
     std::vector<std::string> community_list_;
     LoadBalance::LoadBalanceAttribute load_balance_attribute_;
 
+    bool attr_cache_enabled_;
+    AttrFragmentMap attr_cache_;
+
     DISALLOW_COPY_AND_ASSIGN(BgpXmppMessage);
 };
 
@@ -0,0 +1,510 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef ctrlplane_db_btree_index_h
+#define ctrlplane_db_btree_index_h
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <functional>
+
+#include "base/util.h"
+
+//
+// Ordered index of entry pointers organized as a B+ tree.
+//
+// Compared to an intrusive red-black tree, each node holds many entries in a
+// contiguous array, so a lookup touches a handful of nodes instead of one
+// node per level of a much deeper tree, and an ordered walk touches entries
+// of the same leaf in sequence.
+//
+// Leaves are linked in key order. Each inner node key is a pointer to the
+// smallest entry in the subtree to its right, so the tree does not own or
+// copy keys. The tree does not own the entries either.
+//
+// The index keeps a hint to the position of the entry that was last returned
+// by First() or Next(). This makes Next() for that entry O(1), which is the
+// common case for table walks. The hint is invalidated by any modification.
+// Find(), LowerBound() and UpperBound() are const and leave the hint alone,
+// so lookups done without exclusion (e.g. DBTablePartition::FindNoLock) do
+// not race with each other on it.
+//
+// Not thread safe; the caller is expected to provide exclusion for
+// modifications and for First() and Next().
+//
+template <typename T, typename Compare = std::less<T> >
+class BTreeIndex {
+public:
+    static const int kLeafSlots = 64;
+    static const int kInnerSlots = 64;
+
+    BTreeIndex() : root_(new LeafNode), head_(NULL), size_(0) {
+        head_ = static_cast<LeafNode *>(root_);
+        ClearHint();
+    }
+
+    ~BTreeIndex() {
+        FreeNode(root_);
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    // Insert the entry. Returns false if an entry with the same key is
+    // already present.
+    bool Insert(T *entry) {
+        ClearHint();
+        Node *split_node = NULL;
+        T *split_key = NULL;
+        if (!InsertRecursive(root_, entry, &split_node, &split_key))
+            return false;
+        size_++;
+        if (split_node) {
+            InnerNode *root = new InnerNode;
+            root->count = 2;
+            root->keys[0] = split_key;
+            root->children[0] = root_;
+            root->children[1] = split_node;
+            root_ = root;
+        }
+        return true;
+    }
+
+    // Remove the entry with the same key as the passed entry. Returns false
+    // if there's no such entry.
+    bool Erase(const T &key) {
+        ClearHint();
+        PathElement path[kMaxDepth];
+        int depth = 0;
+        Node *node = root_;
+        while (!node->leaf) {
+            InnerNode *inner = static_cast<InnerNode *>(node);
+            int index = ChildIndex(inner, key);
+            path[depth].node = inner;
+            path[depth].index = index;
+            depth++;
+            node = inner->children[index];
+        }
+
+        LeafNode *leaf = static_cast<LeafNode *>(node);
+        int pos = LowerBound(leaf, key);
+        if (pos == leaf->count || compare_(key, *leaf->entries[pos]))
+            return false;
+        memmove(&leaf->entries[pos], &leaf->entries[pos + 1],
+                (leaf->count - pos - 1) * sizeof(T *));
+        leaf->count--;
+        size_--;
+
+        // Rebalance bottom up and fix up separator keys that may have
+        // referred to the erased entry.
+        for (int level = depth - 1; level >= 0; --level) {
+            InnerNode *parent = path[level].node;
+            int index = path[level].index;
+            if (Underflow(parent->children[index]))
+                index = Rebalance(parent, index);
+            for (int idx = index - 1; idx <= index; ++idx) {
+                if (idx >= 0 && idx < parent->count - 1)
+                    parent->keys[idx] = MinEntry(parent->children[idx + 1]);
+            }
+        }
+
+        // Collapse the root if it's an inner node with a single child.
+        while (!root_->leaf && root_->count == 1) {
+            InnerNode *root = static_cast<InnerNode *>(root_);
+            root_ = root->children[0];
+            delete root;
+        }
+        return true;
+    }
+
+    T *Find(const T &key) const {
+        LeafNode *leaf = FindLeaf(key);
+        int pos = LowerBound(leaf, key);
+        if (pos == leaf->count || compare_(key, *leaf->entries[pos]))
+            return NULL;
+        return leaf->entries[pos];
+    }
+
+    // Returns the first entry that is not less than the key.
+    T *LowerBound(const T &key) const {
+        LeafNode *leaf = FindLeaf(key);
+        int pos = LowerBound(leaf, key);
+        if (!Advance(&leaf, &pos))
+            return NULL;
+        return leaf->entries[pos];
+    }
+
+    // Returns the first entry that is greater than the key.
+    T *UpperBound(const T &key) const {
+        LeafNode *leaf = FindLeaf(key);
+        int pos = UpperBound(leaf, key);
+        if (!Advance(&leaf, &pos))
+            return NULL;
+        return leaf->entries[pos];
+    }
+
+    T *First() {
+        return Position(head_, 0);
+    }
+
+    // Returns the entry following the passed entry. The passed entry need
+    // not be in the index.
+    T *Next(const T *entry) {
+        LeafNode *leaf = hint_leaf_;
+        int pos = hint_pos_;
+        if (leaf && pos < leaf->count && leaf->entries[pos] == entry)
+            return Position(leaf, pos + 1);
+        leaf = FindLeaf(*entry);
+        return Position(leaf, UpperBound(leaf, *entry));
+    }
+
+private:
+    static const int kMinLeafSlots = kLeafSlots / 2;
+    static const int kMinInnerSlots = kInnerSlots / 2;
+    static const int kMaxDepth = 16;
+
+    struct Node {
+        explicit Node(bool leaf) : leaf(leaf), count(0) { }
+        bool leaf;
+        int count;
+    };
+
+    struct LeafNode : public Node {
+        LeafNode() : Node(true), next(NULL), prev(NULL) { }
+        LeafNode *next;
+        LeafNode *prev;
+        T *entries[kLeafSlots];
+    };
+
+    // Count is the number of children, which is one more than the number
+    // of keys.
+    struct InnerNode : public Node {
+        InnerNode() : Node(false) { }
+        T *keys[kInnerSlots - 1];
+        Node *children[kInnerSlots];
+    };
+
+    struct PathElement {
+        InnerNode *node;
+        int index;
+    };
+
+    void FreeNode(Node *node) {
+        if (node->leaf) {
+            delete static_cast<LeafNode *>(node);
+            return;
+        }
+        InnerNode *inner = static_cast<InnerNode *>(node);
+        for (int idx = 0; idx < inner->count; ++idx) {
+            FreeNode(inner->children[idx]);
+        }
+        delete inner;
+    }
+
+    void ClearHint() {
+        hint_leaf_ = NULL;
+        hint_pos_ = 0;
+    }
+
+    T *SetHint(LeafNode *leaf, int pos) {
+        hint_leaf_ = leaf;
+        hint_pos_ = pos;
+        return leaf->entries[pos];
+    }
+
+    // Moves on to the next leaf if the position is past the end of the leaf.
+    // Returns false if there's no entry at or after the position.
+    static bool Advance(LeafNode **leaf, int *pos) {
+        if (*pos == (*leaf)->count) {
+            *leaf = (*leaf)->next;
+            *pos = 0;
+        }
+        return *leaf && (*leaf)->count != 0;
+    }
+
+    // Returns the entry at the given position and remembers it in the hint.
+    T *Position(LeafNode *leaf, int pos) {
+        if (!Advance(&leaf, &pos)) {
+            ClearHint();
+            return NULL;
+        }
+        return SetHint(leaf, pos);
+    }
+
+    bool Underflow(const Node *node) const {
+        if (node->leaf)
+            return node->count < kMinLeafSlots;
+        return node->count < kMinInnerSlots;
+    }
+
+    static T *MinEntry(Node *node) {
+        while (!node->leaf)
+            node = static_cast<InnerNode *>(node)->children[0];
+        LeafNode *leaf = static_cast<LeafNode *>(node);
+        assert(leaf->count > 0);
+        return leaf->entries[0];
+    }
+
+    // Index of the child whose subtree may contain the key.
+    int ChildIndex(const InnerNode *inner, const T &key) const {
+        int low = 0, high = inner->count - 1;
+        while (low < high) {
+            int mid = (low + high) / 2;
+            if (compare_(key, *inner->keys[mid])) {
+                high = mid;
+            } else {
+                low = mid + 1;
+            }
+        }
+        return low;
+    }
+
+    int LowerBound(const LeafNode *leaf, const T &key) const {
+        int low = 0, high = leaf->count;
+        while (low < high) {
+            int mid = (low + high) / 2;
+            if (compare_(*leaf->entries[mid], key)) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+
+    int UpperBound(const LeafNode *leaf, const T &key) const {
+        int low = 0, high = leaf->count;
+        while (low < high) {
+            int mid = (low + high) / 2;
+            if (compare_(key, *leaf->entries[mid])) {
+                high = mid;
+            } else {
+                low = mid + 1;
+            }
+        }
+        return low;
+    }
+
+    LeafNode *FindLeaf(const T &key) const {
+        Node *node = root_;
+        while (!node->leaf) {
+            InnerNode *inner = static_cast<InnerNode *>(node);
+            node = inner->children[ChildIndex(inner, key)];
+        }
+        return static_cast<LeafNode *>(node);
+    }
+
+    // Insert the entry into the subtree rooted at node. If the node had to
+    // be split, the new right sibling and its smallest key are returned via
+    // split_node and split_key.
+    bool InsertRecursive(Node *node, T *entry, Node **split_node,
+                         T **split_key) {
+        if (node->leaf) {
+            LeafNode *leaf = static_cast<LeafNode *>(node);
+            int pos = LowerBound(leaf, *entry);
+            if (pos < leaf->count && !compare_(*entry, *leaf->entries[pos]))
+                return false;
+            if (leaf->count == kLeafSlots) {
+                LeafNode *right = SplitLeaf(leaf);
+                if (pos > leaf->count) {
+                    pos -= leaf->count;
+                    leaf = right;
+                }
+                *split_node = right;
+            }
+            memmove(&leaf->entries[pos + 1], &leaf->entries[pos],
+                    (leaf->count - pos) * sizeof(T *));
+            leaf->entries[pos] = entry;
+            leaf->count++;
+            if (*split_node)
+                *split_key = static_cast<LeafNode *>(*split_node)->entries[0];
+            return true;
+        }
+
+        InnerNode *inner = static_cast<InnerNode *>(node);
+        int index = ChildIndex(inner, *entry);
+        Node *child_split_node = NULL;
+        T *child_split_key = NULL;
+        if (!InsertRecursive(inner->children[index], entry,
+                             &child_split_node, &child_split_key)) {
+            return false;
+        }
+        if (!child_split_node)
+            return true;
+
+        // Insert the new child to the right of the child that was split.
+        if (inner->count == kInnerSlots) {
+            InnerNode *right = SplitInner(inner, split_key);
+            if (index >= inner->count) {
+                index -= inner->count;
+                inner = right;
+            }
+            *split_node = right;
+        }
+        memmove(&inner->keys[index + 1], &inner->keys[index],
+                (inner->count - 1 - index) * sizeof(T *));
+        memmove(&inner->children[index + 2], &inner->children[index + 1],
+                (inner->count - 1 - index) * sizeof(Node *));
+        inner->keys[index] = child_split_key;
+        inner->children[index + 1] = child_split_node;
+        inner->count++;
+        return true;
+    }
+
+    // Move the upper half of the leaf to a new right sibling.
+    LeafNode *SplitLeaf(LeafNode *leaf) {
+        LeafNode *right = new LeafNode;
+        int keep = leaf->count / 2;
+        right->count = leaf->count - keep;
+        memcpy(right->entries, &leaf->entries[keep],
+               right->count * sizeof(T *));
+        leaf->count = keep;
+        right->next = leaf->next;
+        right->prev = leaf;
+        if (leaf->next)
+            leaf->next->prev = right;
+        leaf->next = right;
+        return right;
+    }
+
+    // Move the upper half of the children to a new right sibling. The key
+    // separating the two halves is returned via split_key.
+    InnerNode *SplitInner(InnerNode *inner, T **split_key) {
+        InnerNode *right = new InnerNode;
+        int keep = inner->count / 2;
+        right->count = inner->count - keep;
+        memcpy(right->children, &inner->children[keep],
+               right->count * sizeof(Node *));
+        memcpy(right->keys, &inner->keys[keep],
+               (right->count - 1) * sizeof(T *));
+        *split_key = inner->keys[keep - 1];
+        inner->count = keep;
+        return right;
+    }
+
+    // Fix up the underflowing child at index by borrowing from or merging
+    // with a sibling. Returns the index of the node that now holds the
+    // child's entries.
+    int Rebalance(InnerNode *parent, int index) {
+        if (parent->count == 1)
+            return index;
+
+        Node *child = parent->children[index];
+        Node *left = (index > 0) ? parent->children[index - 1] : NULL;
+        Node *right = (index + 1 < parent->count) ?
+            parent->children[index + 1] : NULL;
+
+        if (left && left->count > MinSlots(left)) {
+            BorrowFromLeft(left, child);
+            return index;
+        }
+        if (right && right->count > MinSlots(right)) {
+            BorrowFromRight(child, right);
+            return index;
+        }
+        if (left) {
+            Merge(parent, index - 1);
+            return index - 1;
+        }
+        Merge(parent, index);
+        return index;
+    }
+
+    static int MinSlots(const Node *node) {
+        return node->leaf ? kMinLeafSlots : kMinInnerSlots;
+    }
+
+    void BorrowFromLeft(Node *left, Node *child) {
+        if (child->leaf) {
+            LeafNode *lleaf = static_cast<LeafNode *>(left);
+            LeafNode *cleaf = static_cast<LeafNode *>(child);
+            memmove(&cleaf->entries[1], &cleaf->entries[0],
+                    cleaf->count * sizeof(T *));
+            cleaf->entries[0] = lleaf->entries[lleaf->count - 1];
+            cleaf->count++;
+            lleaf->count--;
+            return;
+        }
+        InnerNode *linner = static_cast<InnerNode *>(left);
+        InnerNode *cinner = static_cast<InnerNode *>(child);
+        memmove(&cinner->children[1], &cinner->children[0],
+                cinner->count * sizeof(Node *));
+        memmove(&cinner->keys[1], &cinner->keys[0],
+                (cinner->count - 1) * sizeof(T *));
+        cinner->children[0] = linner->children[linner->count - 1];
+        cinner->keys[0] = MinEntry(cinner->children[1]);
+        cinner->count++;
+        linner->count--;
+    }
+
+    void BorrowFromRight(Node *child, Node *right) {
+        if (child->leaf) {
+            LeafNode *cleaf = static_cast<LeafNode *>(child);
+            LeafNode *rleaf = static_cast<LeafNode *>(right);
+            cleaf->entries[cleaf->count] = rleaf->entries[0];
+            cleaf->count++;
+            rleaf->count--;
+            memmove(&rleaf->entries[0], &rleaf->entries[1],
+                    rleaf->count * sizeof(T *));
+            return;
+        }
+        InnerNode *cinner = static_cast<InnerNode *>(child);
+        InnerNode *rinner = static_cast<InnerNode *>(right);
+        cinner->children[cinner->count] = rinner->children[0];
+        cinner->keys[cinner->count - 1] = MinEntry(rinner->children[0]);
+        cinner->count++;
+        rinner->count--;
+        memmove(&rinner->children[0], &rinner->children[1],
+                rinner->count * sizeof(Node *));
+        memmove(&rinner->keys[0], &rinner->keys[1],
+                (rinner->count - 1) * sizeof(T *));
+    }
+
+    // Merge the child at index + 1 into the child at index and remove it
+    // from the parent.
+    void Merge(InnerNode *parent, int index) {
+        Node *left = parent->children[index];
+        Node *right = parent->children[index + 1];
+        if (left->leaf) {
+            LeafNode *lleaf = static_cast<LeafNode *>(left);
+            LeafNode *rleaf = static_cast<LeafNode *>(right);
+            memcpy(&lleaf->entries[lleaf->count], &rleaf->entries[0],
+                   rleaf->count * sizeof(T *));
+            lleaf->count += rleaf->count;
+            lleaf->next = rleaf->next;
+            if (rleaf->next)
+                rleaf->next->prev = lleaf;
+            delete rleaf;
+        } else {
+            InnerNode *linner = static_cast<InnerNode *>(left);
+            InnerNode *rinner = static_cast<InnerNode *>(right);
+            linner->keys[linner->count - 1] = MinEntry(rinner->children[0]);
+            memcpy(&linner->keys[linner->count], &rinner->keys[0],
+                   (rinner->count - 1) * sizeof(T *));
+            memcpy(&linner->children[linner->count], &rinner->children[0],
+                   rinner->count * sizeof(Node *));
+            linner->count += rinner->count;
+            delete rinner;
+        }
+
+        memmove(&parent->keys[index], &parent->keys[index + 1],
+                (parent->count - index - 2) * sizeof(T *));
+        memmove(&parent->children[index + 1], &parent->children[index + 2],
+                (parent->count - index - 2) * sizeof(Node *));
+        parent->count--;
+    }
+
+    Compare compare_;
+    Node *root_;
+    LeafNode *head_;
+    size_t size_;
+    LeafNode *hint_leaf_;
+    int hint_pos_;
+
+    DISALLOW_COPY_AND_ASSIGN(BTreeIndex);
+};
+
+#endif  // ctrlplane_db_btree_index_h
@@ -5,6 +5,7 @@
 #include "db/db_partition.h"
 
 #include <list>
+#include <vector>
 #include <tbb/atomic.h>
 #include <tbb/concurrent_queue.h>
 #include <tbb/mutex.h>
@@ -73,6 +74,22 @@ public:
 
     }
 
+    // Push all the entries before starting the runner, so that the mutex is
+    // taken once for the whole batch.
+    bool EnqueueRequests(const std::vector<RequestQueueEntry *> &entries) {
+        for (std::vector<RequestQueueEntry *>::const_iterator it =
+             entries.begin(); it != entries.end(); ++it) {
+            request_queue_.push(*it);
+        }
+        MaybeStartRunner();
+        long count = entries.size();
+        uint32_t max = request_count_.fetch_and_add(count) + count - 1;
+        if (max > max_request_queue_len_)
+            max_request_queue_len_ = max;
+        total_request_count_ += count;
+        return max < (kThreshold - 1);
+    }
+
     bool DequeueRequest(RequestQueueEntry **req_entry) {
         bool success = request_queue_.try_pop(*req_entry);
         if (success) {
@@ -277,6 +294,17 @@ bool DBPartition::EnqueueRequest(DBTablePartBase *tpart, DBClient *client,
     return work_queue_->EnqueueRequest(entry);
 }
 
+bool DBPartition::EnqueueRequests(DBTablePartBase *tpart, DBClient *client,
+                                  const DBRequestList &req_list) {
+    std::vector<RequestQueueEntry *> entries;
+    entries.reserve(req_list.size());
+    for (DBRequestList::const_iterator it = req_list.begin();
+         it != req_list.end(); ++it) {
+        entries.push_back(new RequestQueueEntry(tpart, client, *it));
+    }
+    return work_queue_->EnqueueRequests(entries);
+}
+
 void DBPartition::EnqueueRemove(DBTablePartBase *tpart, DBEntryBase *db_entry) {
     RemoveQueueEntry *entry = new RemoveQueueEntry(tpart, db_entry);
     db_entry->SetOnRemoveQ();
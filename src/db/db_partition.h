@@ -28,6 +28,9 @@ public:
     // Returns false if the client should stop enqueuing updates.
     bool EnqueueRequest(DBTablePartBase *tpart, DBClient *client,
                         DBRequest *req);
+    // Enqueue a batch of requests for the same table partition.
+    bool EnqueueRequests(DBTablePartBase *tpart, DBClient *client,
+                         const DBRequestList &req_list);
 
     void EnqueueRemove(DBTablePartBase *tpart, DBEntryBase *db_entry);
 
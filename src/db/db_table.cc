@@ -196,6 +196,34 @@ bool DBTableBase::Enqueue(DBRequest *req) {
     return partition->EnqueueRequest(tpart, NULL, req);
 }
 
+bool DBTableBase::Enqueue(const DBRequestList &req_list) {
+    if (req_list.empty())
+        return true;
+
+    int partition_count = DB::PartitionCount();
+    vector<DBTablePartBase *> tpart_list(partition_count);
+    vector<DBRequestList> part_req_list(partition_count);
+    for (DBRequestList::const_iterator it = req_list.begin();
+         it != req_list.end(); ++it) {
+        DBTablePartBase *tpart = GetTablePartition((*it)->key.get());
+        tpart_list[tpart->index()] = tpart;
+        part_req_list[tpart->index()].push_back(*it);
+    }
+
+    bool result = true;
+    for (int index = 0; index < partition_count; ++index) {
+        if (part_req_list[index].empty())
+            continue;
+        DBPartition *partition = db_->GetPartition(index);
+        enqueue_count_ += part_req_list[index].size();
+        if (!partition->EnqueueRequests(tpart_list[index], NULL,
+                                        part_req_list[index])) {
+            result = false;
+        }
+    }
+    return result;
+}
+
 void DBTableBase::EnqueueRemove(DBEntryBase *db_entry) {
     DBTablePartBase *tpart = GetTablePartition(db_entry);
     DBPartition *partition = db_->GetPartition(tpart->index());
@@ -360,7 +388,8 @@ void DBTable::TableWalker::StartWalk() {
 DBTable::DBTable(DB *db, const string &name)
     : DBTableBase(db, name),
       walker_(new TableWalker(this)),
-      walker_task_id_(db->task_id()) {
+      walker_task_id_(db->task_id()),
+      walk_slot_(-1) {
 
     static bool init_ = false;
     static int iter_to_yield_env_ = 0;
@@ -609,12 +638,12 @@ void DBTable::WalkAgain(DBTable::DBTableWalkRef walk) {
 
 bool DBTable::InvokeWalkCb(DBTablePartBase *part, DBEntryBase *entry) {
     DBTableWalkMgr *walk_mgr = database()->GetWalkMgr();
-    return walk_mgr->InvokeWalkCb(part, entry);
+    return walk_mgr->InvokeWalkCb(this, part, entry);
 }
 
 void DBTable::WalkDone() {
     incr_walk_complete_count();
     walker_->ClearWalkWorks();
     DBTableWalkMgr *walk_mgr = database()->GetWalkMgr();
-    return walk_mgr->WalkDone();
+    return walk_mgr->WalkDone(this);
 }
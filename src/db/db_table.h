@@ -53,6 +53,8 @@ private:
     DISALLOW_COPY_AND_ASSIGN(DBRequest);
 };
 
+typedef std::vector<DBRequest *> DBRequestList;
+
 // Database table interface.
 class DBTableBase {
 public:
@@ -66,6 +68,11 @@ public:
 
     // Enqueue a request to the table. Takes ownership of the data.
     bool Enqueue(DBRequest *req);
+    // Enqueue a batch of requests to the table. Requests are grouped by
+    // table partition and each group is handed to its DB partition in one
+    // go. Takes ownership of the data in all the requests. Returns false if
+    // the client should stop enqueuing updates.
+    bool Enqueue(const DBRequestList &req_list);
     void EnqueueRemove(DBEntryBase *db_entry);
 
     // Determine the table partition depending on the record key.
@@ -200,6 +207,12 @@ public:
     // Override if *really* necessary
     virtual DBTablePartition *AllocPartition(int index);
 
+    // Return true to index entries in each partition with a B+ tree instead
+    // of a red-black tree. A B+ tree is more cache friendly for lookups and
+    // walks of large tables, but GetNext needs a search unless it's called
+    // for the entry returned by the previous lookup.
+    virtual bool UseBTreeIndex() const { return false; }
+
     // Input processing implemented by derived class. Default 
     // implementation takes care of Add/Delete/Change.
     // Override if *really* necessary
@@ -338,6 +351,9 @@ private:
     DBTable::DBTableWalkRef walk_ref_;
     int walker_task_id_;
     int max_walk_iteration_to_yield_;
+    // Index in DBTableWalkMgr::walk_slots_ while the table is being walked,
+    // -1 otherwise.
+    int walk_slot_;
 
     DISALLOW_COPY_AND_ASSIGN(DBTable);
 };
@@ -6,9 +6,11 @@
 #define ctrlplane_db_table_partition_h
 
 #include <boost/intrusive/list.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <tbb/spin_rw_mutex.h>
 #include <tbb/mutex.h>
 
+#include "db/db_btree_index.h"
 #include "db/db_entry.h"
 
 class DBTableBase;
@@ -69,7 +71,10 @@ public:
         boost::intrusive::set_member_hook<>,
         &DBEntry::node_> SetMember;
     typedef boost::intrusive::set<DBEntry, SetMember> Tree;
-    
+    typedef BTreeIndex<DBEntry> BTree;
+
+    // Entries are kept in a B+ tree instead of the intrusive set if the
+    // table asks for it via DBTable::UseBTreeIndex().
     DBTablePartition(DBTable *parent, int index);
 
     ///////////////////////////////////////////////////////////////
@@ -110,13 +115,15 @@ public:
     DBEntry *FindNext(const DBRequestKey *key);
 
     DBTable *table();
-    size_t size() const { return tree_.size(); }
+    size_t size() const { return btree_ ? btree_->size() : tree_.size(); }
+    bool btree_index() const { return btree_.get() != NULL; }
 
 private:
     DBEntry *FindInternal(const DBEntry *entry);
 
     tbb::mutex mutex_;
     Tree tree_;
+    boost::scoped_ptr<BTree> btree_;
     DISALLOW_COPY_AND_ASSIGN(DBTablePartition);
 };
 
@@ -4,7 +4,9 @@
 
 #include "db/db_table_walk_mgr.h"
 
-#include <tbb/atomic.h>
+#include <stdlib.h>
+
+#include <set>
 
 #include <boost/bind.hpp>
 #include <boost/foreach.hpp>
@@ -12,10 +14,30 @@
 #include "base/logging.h"
 #include "base/task.h"
 #include "base/task_annotations.h"
+#include "base/time_util.h"
 #include "db/db.h"
 #include "db/db_partition.h"
 #include "db/db_table.h"
 #include "db/db_table_partition.h"
+#include "db/db_types.h"
+
+using std::set;
+using std::vector;
+
+//
+// All walk managers in the process, so that the introspect handler can find
+// them.
+//
+static tbb::mutex walk_mgr_set_mutex;
+static set<DBTableWalkMgr *> walk_mgr_set;
+static uint32_t walk_mgr_next_id;
+
+static int GetConfiguredWalkConcurrency() {
+    char *count_str = getenv("DB_TABLE_WALK_CONCURRENCY");
+    if (!count_str)
+        return 1;
+    return strtoul(count_str, NULL, 0);
+}
 
 DBTableWalkMgr::DBTableWalkMgr()
     : walk_request_trigger_(new TaskTrigger(
@@ -23,49 +45,146 @@ DBTableWalkMgr::DBTableWalkMgr()
         TaskScheduler::GetInstance()->GetTaskId("db::Walker"), 0)),
       walk_done_trigger_(new TaskTrigger(
         boost::bind(&DBTableWalkMgr::ProcessWalkDone, this),
-        TaskScheduler::GetInstance()->GetTaskId("db::Walker"), 0)) {
+        TaskScheduler::GetInstance()->GetTaskId("db::Walker"), 0)),
+      walk_slots_(kMaxConcurrentWalks),
+      max_concurrent_walks_(1),
+      active_walks_(0),
+      walk_requests_(0),
+      walk_requests_clubbed_(0),
+      walks_started_(0),
+      walks_completed_(0),
+      max_queue_depth_(0),
+      total_wait_time_usecs_(0),
+      max_wait_time_usecs_(0),
+      total_walk_time_usecs_(0),
+      max_walk_time_usecs_(0) {
+    int count = GetConfiguredWalkConcurrency();
+    if (count > kMaxConcurrentWalks)
+        count = kMaxConcurrentWalks;
+    if (count > 1)
+        max_concurrent_walks_ = count;
+
+    tbb::mutex::scoped_lock lock(walk_mgr_set_mutex);
+    id_ = walk_mgr_next_id++;
+    walk_mgr_set.insert(this);
+}
+
+DBTableWalkMgr::~DBTableWalkMgr() {
+    tbb::mutex::scoped_lock lock(walk_mgr_set_mutex);
+    walk_mgr_set.erase(this);
+}
+
+void DBTableWalkMgr::SetMaxConcurrentWalks(int count) {
+    if (count < 1)
+        count = 1;
+    if (count > kMaxConcurrentWalks)
+        count = kMaxConcurrentWalks;
+    tbb::mutex::scoped_lock lock(mutex_);
+    max_concurrent_walks_ = count;
+    walk_request_trigger_->Set();
+}
+
+//
+// Remove the first request in the list for a table that is not being walked,
+// provided a slot is available.
+//
+DBTableWalkMgr::WalkRequestInfoPtr DBTableWalkMgr::DequeueWalkRequest() {
+    tbb::mutex::scoped_lock lock(mutex_);
+    if (active_walks_ >= max_concurrent_walks_)
+        return WalkRequestInfoPtr();
+    for (WalkRequestInfoList::iterator it = walk_request_list_.begin();
+         it != walk_request_list_.end(); ++it) {
+        WalkRequestInfoPtr info = *it;
+        if (info->table->walk_slot_ >= 0)
+            continue;
+        walk_request_set_.erase(info.get());
+        walk_request_list_.erase(it);
+        return info;
+    }
+    return WalkRequestInfoPtr();
+}
+
+//
+// Start the walk on the table of the request in a free slot, unless all the
+// walkers that requested it have been stopped in the meantime.
+// The walk is started without holding the mutex_ as DBTable::StartWalk calls
+// WalkDone right away if the table is empty.
+//
+void DBTableWalkMgr::StartTableWalk(WalkRequestInfoPtr info) {
+    bool walk_table = false;
+    BOOST_FOREACH(DBTable::DBTableWalkRef walker, info->pending_requests) {
+        if (walker->stopped()) continue;
+        walker->set_in_progress();
+        walker->reset_walk_again();
+        walk_table = true;
+    }
+    if (!walk_table)
+        return;
+
+    int slot = 0;
+    while (walk_slots_[slot])
+        slot++;
+    assert(slot < kMaxConcurrentWalks);
+    walk_slots_[slot] = info;
+    info->start_time = ClockMonotonicUsec();
+    {
+        tbb::mutex::scoped_lock lock(mutex_);
+        active_walks_++;
+        walks_started_++;
+        uint64_t wait_time = info->start_time - info->request_time;
+        total_wait_time_usecs_ += wait_time;
+        if (wait_time > max_wait_time_usecs_)
+            max_wait_time_usecs_ = wait_time;
+    }
+
+    // start the walk
+    DBTable *table = info->table;
+    table->walk_slot_ = slot;
+    table->StartWalk();
 }
 
 bool DBTableWalkMgr::ProcessWalkRequestList() {
     CHECK_CONCURRENCY("db::Walker");
-    if (!current_table_walk_.empty()) return true;
     while (true) {
-        if (walk_request_list_.empty()) break;
-        WalkRequestInfoPtr info = walk_request_list_.front();
-        walk_request_set_.erase(info.get());
-        walk_request_list_.pop_front();
-        current_table_walk_.swap(info->pending_requests);
-        DBTable *table = info->table;
-        bool walk_table = false;
-        BOOST_FOREACH(DBTable::DBTableWalkRef walker, current_table_walk_) {
-            if (walker->stopped()) continue;
-            walker->set_in_progress();
-            walker->reset_walk_again();
-            walk_table = true;
-        }
-        if (walk_table) {
-            // start the walk
-            table->StartWalk();
-            break;
-        } else {
-            current_table_walk_.clear();
-        }
+        WalkRequestInfoPtr info = DequeueWalkRequest();
+        if (!info) break;
+        StartTableWalk(info);
     }
     return true;
 }
 
 bool DBTableWalkMgr::ProcessWalkDone() {
     CHECK_CONCURRENCY("db::Walker");
-    assert(!current_table_walk_.empty());
-    BOOST_FOREACH(DBTable::DBTableWalkRef walker, current_table_walk_) {
-        if (walker->walk_again())
-            walker->set_walk_requested();
-        else if (!walker->stopped())
-            walker->set_walk_done();
-        if (walker->stopped() || walker->walk_again()) continue;
-        walker->walk_complete()(walker, walker->table());
+    WalkDoneList done_list;
+    {
+        tbb::mutex::scoped_lock lock(mutex_);
+        done_list.swap(walk_done_list_);
+    }
+
+    BOOST_FOREACH(DBTable *table, done_list) {
+        assert(table->walk_slot_ >= 0);
+        WalkRequestInfoPtr info;
+        info.swap(walk_slots_[table->walk_slot_]);
+        table->walk_slot_ = -1;
+        {
+            tbb::mutex::scoped_lock lock(mutex_);
+            active_walks_--;
+            walks_completed_++;
+            uint64_t walk_time = ClockMonotonicUsec() - info->start_time;
+            total_walk_time_usecs_ += walk_time;
+            if (walk_time > max_walk_time_usecs_)
+                max_walk_time_usecs_ = walk_time;
+        }
+
+        BOOST_FOREACH(DBTable::DBTableWalkRef walker, info->pending_requests) {
+            if (walker->walk_again())
+                walker->set_walk_requested();
+            else if (!walker->stopped())
+                walker->set_walk_done();
+            if (walker->stopped() || walker->walk_again()) continue;
+            walker->walk_complete()(walker, walker->table());
+        }
     }
-    current_table_walk_.clear();
     walk_request_trigger_->Set();
     return true;
 }
@@ -98,27 +217,39 @@ void DBTableWalkMgr::WalkTable(DBTable::DBTableWalkRef walk) {
         walk->set_walk_requested();
     }
 
+    walk_requests_++;
+
+    // Club the request with the one already queued for the table, if any.
     WalkRequestInfo tmp_info = WalkRequestInfo(table);
     WalkRequestInfoSet::iterator it = walk_request_set_.find(&tmp_info);
     if (it != walk_request_set_.end()) {
+        walk_requests_clubbed_++;
         (*it)->AppendWalkReq(walk);
         return;
     }
 
     WalkRequestInfo *new_info = new WalkRequestInfo(table);
     new_info->AppendWalkReq(walk);
+    new_info->request_time = ClockMonotonicUsec();
     walk_request_list_.push_back(WalkRequestInfoPtr(new_info));
     walk_request_set_.insert(new_info);
+    if (walk_request_list_.size() > max_queue_depth_)
+        max_queue_depth_ = walk_request_list_.size();
     walk_request_trigger_->Set();
 }
 
-void DBTableWalkMgr::WalkDone() {
+void DBTableWalkMgr::WalkDone(DBTable *table) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    walk_done_list_.push_back(table);
     walk_done_trigger_->Set();
 }
 
-bool DBTableWalkMgr::InvokeWalkCb(DBTablePartBase *part, DBEntryBase *entry) {
+bool DBTableWalkMgr::InvokeWalkCb(DBTable *table, DBTablePartBase *part,
+                                  DBEntryBase *entry) {
+    const WalkReqList &current_table_walk =
+        walk_slots_[table->walk_slot_]->pending_requests;
     uint32_t skip_walk_count = 0;
-    BOOST_FOREACH(DBTable::DBTableWalkRef walker, current_table_walk_) {
+    BOOST_FOREACH(DBTable::DBTableWalkRef walker, current_table_walk) {
         if (walker->done() || walker->stopped() || walker->walk_again()) {
             skip_walk_count++;
             continue;
@@ -129,5 +260,42 @@ bool DBTableWalkMgr::InvokeWalkCb(DBTablePartBase *part, DBEntryBase *entry) {
             if (!walker->stopped()) walker->set_walk_done();
         }
     }
-    return (skip_walk_count < current_table_walk_.size());
+    return (skip_walk_count < current_table_walk.size());
+}
+
+void DBTableWalkMgr::GetStats(DBTableWalkMgrStats *stats) const {
+    tbb::mutex::scoped_lock lock(mutex_);
+    stats->set_walk_mgr_id(id_);
+    stats->set_max_concurrent_walks(max_concurrent_walks_);
+    stats->set_active_walks(active_walks_);
+    stats->set_queue_depth(walk_request_list_.size());
+    stats->set_max_queue_depth(max_queue_depth_);
+    stats->set_walk_requests(walk_requests_);
+    stats->set_walk_requests_clubbed(walk_requests_clubbed_);
+    stats->set_walks_started(walks_started_);
+    stats->set_walks_completed(walks_completed_);
+    stats->set_total_wait_time_usecs(total_wait_time_usecs_);
+    stats->set_max_wait_time_usecs(max_wait_time_usecs_);
+    stats->set_total_walk_time_usecs(total_walk_time_usecs_);
+    stats->set_max_walk_time_usecs(max_walk_time_usecs_);
+}
+
+void DBTableWalkMgr::GetAllStats(vector<DBTableWalkMgrStats> *stats_list) {
+    tbb::mutex::scoped_lock lock(walk_mgr_set_mutex);
+    for (set<DBTableWalkMgr *>::const_iterator it = walk_mgr_set.begin();
+         it != walk_mgr_set.end(); ++it) {
+        DBTableWalkMgrStats stats;
+        (*it)->GetStats(&stats);
+        stats_list->push_back(stats);
+    }
+}
+
+void ShowDBTableWalkMgrReq::HandleRequest() const {
+    ShowDBTableWalkMgrResp *resp = new ShowDBTableWalkMgrResp;
+    vector<DBTableWalkMgrStats> stats_list;
+    DBTableWalkMgr::GetAllStats(&stats_list);
+    resp->set_walk_mgr_stats(stats_list);
+    resp->set_context(context());
+    resp->set_more(false);
+    resp->Response();
 }
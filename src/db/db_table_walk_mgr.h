@@ -7,6 +7,7 @@
 
 #include <list>
 #include <set>
+#include <vector>
 
 #include <boost/assign.hpp>
 #include <boost/function.hpp>
@@ -22,6 +23,8 @@
 
 #include "db/db_table.h"
 
+class DBTableWalkMgrStats;
+
 //
 // DBTableWalkMgr:
 // ==============
@@ -62,48 +65,79 @@
 //    restarted from beginning of DBTable. This API should be called from a task
 //    which is mutually exclusive from db::Walker task.
 //
-// DBTableWalkMgr ensures that not more than one DBTable is walked at any point
-// in time. All other DBTable walk requests are queued and taken up only after
-// current walk completes.
+// DBTableWalkMgr ensures that not more than max_concurrent_walks() DBTables
+// are walked at any point in time, and that a given DBTable is never walked
+// more than once at a time. All other DBTable walk requests are queued and
+// taken up only after one of the current walks completes.
+// The limit defaults to 1 i.e. tables are walked one after the other. It can
+// be raised with SetMaxConcurrentWalks or the DB_TABLE_WALK_CONCURRENCY
+// environment variable, so that walks on many small tables don't have to wait
+// for a walk on a large one.
 // Actual DBTable walk (i.e. iterating the DBTablePartition) is performed in
 // db::DBTable task or task id configured with DBTable::SetWalkTaskId with
 // instance id set as partition index.
-// The advantage of running DBTable walk in serial manner is in clubbing
-// multiple walk requests on a given table and serving such requests in one
-// iteration of DBTable walk
+// The advantage of queueing DBTable walks is in clubbing multiple walk
+// requests on a given table and serving such requests in one iteration of
+// DBTable walk
 //
 // WalkReqList holds list of DBTableWalkRef(i.e. walkers created by multiple
 // application modules) that requested for DBTable walk on a specific table.
-// InvokeWalkCb notifies all such walkers stored in current_table_walk_, while
-// iterating through DBTable entries
+// InvokeWalkCb notifies all such walkers of the walk in progress on the table,
+// while iterating through DBTable entries
 //
 // WalkRequestInfo:
 // ===============
 // WalkRequestInfo is a per table Walk request structure. It also holds
-// DBTableWalkRef which requested for DBTable walk.
+// DBTableWalkRef which requested for DBTable walk. Once the walk is started,
+// the WalkRequestInfo moves to walk_slots_ and the walkers in it are the ones
+// that get notified.
 //
 // WalkRequestInfoList
 // ===================
 // walk_request_list_ holds list of WalkRequestInfo. This list is keyed by
 // DBTable. Additional walk_request_set_ is maintained for easy search of
 // WalkRequestInfo for a given DBTable.
-// Current table on which walk is going on will not be present in the
+// Tables on which walk is going on will not be present in the
 // walk_request_list_. If caller requests for WalkAgain(), it is added back to
-// the walk_request_list_ (in the end of the list).
+// the walk_request_list_ (in the end of the list). Requests are taken up in
+// list order, skipping the tables that are being walked. So tables that get
+// walked again and again don't starve the others.
+//
+// Walk Slots:
+// ==========
+// walk_slots_ holds the WalkRequestInfo of the walks in progress. The index
+// of the slot is stored in the DBTable, so that InvokeWalkCb can find the
+// walkers without a lookup that would need a lock. The vector is allocated
+// with kMaxConcurrentWalks entries upfront and never resized.
 //
 // Task Triggers:
 // walk_request_trigger_ : Task trigger which evaluate walk_request_list_.
-// It removes the WalkRequestInfo on top of this list and starts walk on the
-// table. This task trigger runs in "db::Walker" task context.
+// It removes WalkRequestInfo from this list and starts walk on the tables
+// till all slots are in use. This task trigger runs in "db::Walker" task
+// context.
 //
 // walk_done_trigger_ : Task trigger ensures that WalkCompleteFn is triggered
 // in db::Walker task context for all DBTableWalkRef which requested for
-// current DBTable walk. At the end of ProcessWalkDone, walk_request_trigger_ is
-// triggered to evaluate walk request from top of walk_request_list_.
+// the completed DBTable walks. At the end of ProcessWalkDone,
+// walk_request_trigger_ is triggered to evaluate walk request from top of
+// walk_request_list_.
 //
 class DBTableWalkMgr {
 public:
+    static const int kMaxConcurrentWalks = 64;
+
     DBTableWalkMgr();
+    ~DBTableWalkMgr();
+
+    // Concurrency : should be invoked from a task which is mutually exclusive
+    // "db::Walker" task
+    void SetMaxConcurrentWalks(int count);
+    int max_concurrent_walks() const { return max_concurrent_walks_; }
+
+    void GetStats(DBTableWalkMgrStats *stats) const;
+
+    // Stats for all walk managers in the process, for introspect.
+    static void GetAllStats(std::vector<DBTableWalkMgrStats> *stats_list);
 
     void DisableWalkProcessing() {
         walk_request_trigger_->set_disable();
@@ -126,7 +160,8 @@ private:
     typedef std::set<DBTable::DBTableWalkRef> WalkReqList;
 
     struct WalkRequestInfo {
-        WalkRequestInfo(DBTable *table) : table(table) {
+        WalkRequestInfo(DBTable *table)
+            : table(table), request_time(0), start_time(0) {
         }
 
         void AppendWalkReq(DBTable::DBTableWalkRef ref) {
@@ -142,6 +177,8 @@ private:
         }
         DBTable *table;
         WalkReqList pending_requests;
+        uint64_t request_time;
+        uint64_t start_time;
     };
 
     struct WalkRequestCompare {
@@ -153,6 +190,8 @@ private:
     typedef boost::shared_ptr<WalkRequestInfo> WalkRequestInfoPtr;
     typedef std::list<WalkRequestInfoPtr> WalkRequestInfoList;
     typedef std::set<WalkRequestInfo *, WalkRequestCompare> WalkRequestInfoSet;
+    typedef std::vector<WalkRequestInfoPtr> WalkSlotList;
+    typedef std::vector<DBTable *> WalkDoneList;
 
     // Create a DBTable Walker
     DBTable::DBTableWalkRef AllocWalker(DBTable *table, DBTable::WalkFn walk_fn,
@@ -165,27 +204,45 @@ private:
     void WalkTable(DBTable::DBTableWalkRef walk);
 
     // DBTable finished walking
-    void WalkDone();
+    void WalkDone(DBTable *table);
 
     // Walk the table again
     void WalkAgain(DBTable::DBTableWalkRef walk);
 
     bool ProcessWalkRequestList();
+    WalkRequestInfoPtr DequeueWalkRequest();
+    void StartTableWalk(WalkRequestInfoPtr info);
 
     bool ProcessWalkDone();
 
-    bool InvokeWalkCb(DBTablePartBase *part, DBEntryBase *entry);
+    bool InvokeWalkCb(DBTable *table, DBTablePartBase *part,
+                      DBEntryBase *entry);
 
     boost::scoped_ptr<TaskTrigger> walk_request_trigger_;
     boost::scoped_ptr<TaskTrigger> walk_done_trigger_;
 
     // Mutex to protect walk_request_list_ and walk_request_set_ as
-    // Walk can be requested from task which may run concurrently
-    tbb::mutex mutex_;
+    // Walk can be requested from task which may run concurrently.
+    // Also protects walk_done_list_ and the stats.
+    mutable tbb::mutex mutex_;
     WalkRequestInfoList walk_request_list_;
     WalkRequestInfoSet walk_request_set_;
 
-    WalkReqList current_table_walk_;
+    WalkSlotList walk_slots_;
+    WalkDoneList walk_done_list_;
+    int max_concurrent_walks_;
+    int active_walks_;
+
+    uint32_t id_;
+    uint64_t walk_requests_;
+    uint64_t walk_requests_clubbed_;
+    uint64_t walks_started_;
+    uint64_t walks_completed_;
+    size_t max_queue_depth_;
+    uint64_t total_wait_time_usecs_;
+    uint64_t max_wait_time_usecs_;
+    uint64_t total_walk_time_usecs_;
+    uint64_t max_walk_time_usecs_;
 
     DISALLOW_COPY_AND_ASSIGN(DBTableWalkMgr);
 };
@@ -0,0 +1,331 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "db/db_btree_index.h"
+
+#include <boost/intrusive/set.hpp>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/time_util.h"
+
+#include "testing/gunit.h"
+
+using std::string;
+using std::vector;
+
+//
+// Entry with a string key and a set hook, similar to a route entry.
+//
+class TestEntry {
+public:
+    explicit TestEntry(uint32_t value) : value_(value) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%u.%u.%u.%u/32", value >> 24,
+                 (value >> 16) & 0xff, (value >> 8) & 0xff, value & 0xff);
+        key_ = buf;
+    }
+
+    bool operator<(const TestEntry &rhs) const {
+        if (value_ != rhs.value_)
+            return value_ < rhs.value_;
+        return key_ < rhs.key_;
+    }
+
+    uint32_t value() const { return value_; }
+
+    boost::intrusive::set_member_hook<> node_;
+
+private:
+    uint32_t value_;
+    string key_;
+};
+
+typedef BTreeIndex<TestEntry> Index;
+typedef boost::intrusive::member_hook<TestEntry,
+    boost::intrusive::set_member_hook<>, &TestEntry::node_> SetMember;
+typedef boost::intrusive::set<TestEntry, SetMember> Tree;
+
+class BTreeIndexTest : public ::testing::Test {
+protected:
+    virtual void TearDown() {
+        DeleteEntries();
+    }
+
+    void DeleteEntries() {
+        for (vector<TestEntry *>::iterator it = entries_.begin();
+             it != entries_.end(); ++it) {
+            delete *it;
+        }
+        entries_.clear();
+    }
+
+    void CreateEntries(size_t count, bool shuffle) {
+        entries_.reserve(count);
+        for (size_t idx = 0; idx < count; ++idx) {
+            entries_.push_back(new TestEntry(idx * 2));
+        }
+        if (shuffle)
+            std::random_shuffle(entries_.begin(), entries_.end());
+    }
+
+    // Verify that a walk over the index returns exactly the expected values
+    // in order.
+    void VerifyWalk(Index *index, const std::set<uint32_t> &expected) {
+        EXPECT_EQ(expected.size(), index->size());
+        std::set<uint32_t>::const_iterator it = expected.begin();
+        for (TestEntry *entry = index->First(); entry;
+             entry = index->Next(entry), ++it) {
+            ASSERT_TRUE(it != expected.end());
+            EXPECT_EQ(*it, entry->value());
+        }
+        EXPECT_TRUE(it == expected.end());
+    }
+
+    vector<TestEntry *> entries_;
+};
+
+TEST_F(BTreeIndexTest, Empty) {
+    Index index;
+    TestEntry key(10);
+    EXPECT_TRUE(index.empty());
+    EXPECT_TRUE(index.First() == NULL);
+    EXPECT_TRUE(index.Find(key) == NULL);
+    EXPECT_TRUE(index.LowerBound(key) == NULL);
+    EXPECT_TRUE(index.UpperBound(key) == NULL);
+    EXPECT_TRUE(index.Next(&key) == NULL);
+    EXPECT_FALSE(index.Erase(key));
+}
+
+TEST_F(BTreeIndexTest, InsertDuplicate) {
+    Index index;
+    CreateEntries(1, false);
+    TestEntry duplicate(0);
+    EXPECT_TRUE(index.Insert(entries_[0]));
+    EXPECT_FALSE(index.Insert(&duplicate));
+    EXPECT_EQ(1, index.size());
+    EXPECT_EQ(entries_[0], index.Find(duplicate));
+}
+
+//
+// Lookups of present and absent keys. Entries have even values, so odd
+// values fall between entries.
+//
+TEST_F(BTreeIndexTest, Lookup) {
+    const size_t count = 10000;
+    Index index;
+    CreateEntries(count, true);
+    for (size_t idx = 0; idx < count; ++idx) {
+        EXPECT_TRUE(index.Insert(entries_[idx]));
+    }
+
+    for (uint32_t value = 0; value < count * 2; ++value) {
+        TestEntry key(value);
+        TestEntry *entry = index.Find(key);
+        TestEntry *lower = index.LowerBound(key);
+        TestEntry *upper = index.UpperBound(key);
+        if (value % 2 == 0) {
+            ASSERT_TRUE(entry != NULL);
+            EXPECT_EQ(value, entry->value());
+            EXPECT_EQ(entry, lower);
+        } else {
+            EXPECT_TRUE(entry == NULL);
+        }
+        if (value < count * 2 - 2) {
+            ASSERT_TRUE(upper != NULL);
+            EXPECT_EQ((value + 2) & ~1, upper->value());
+        } else {
+            EXPECT_TRUE(upper == NULL);
+        }
+        if (value % 2 == 1 && value + 1 < count * 2) {
+            ASSERT_TRUE(lower != NULL);
+            EXPECT_EQ(value + 1, lower->value());
+        }
+    }
+
+    // Next for an entry that is not in the index.
+    TestEntry key(101);
+    ASSERT_TRUE(index.Next(&key) != NULL);
+    EXPECT_EQ(102, index.Next(&key)->value());
+}
+
+//
+// Lookups go through a const index and don't disturb a walk in progress.
+//
+TEST_F(BTreeIndexTest, LookupDuringWalk) {
+    const size_t count = 1000;
+    Index index;
+    CreateEntries(count, true);
+    for (size_t idx = 0; idx < count; ++idx) {
+        EXPECT_TRUE(index.Insert(entries_[idx]));
+    }
+
+    const Index &lookup_index = index;
+    uint32_t expected = 0;
+    for (TestEntry *entry = index.First(); entry;
+         entry = index.Next(entry), expected += 2) {
+        EXPECT_EQ(expected, entry->value());
+        TestEntry key((expected * 7) % (count * 2));
+        EXPECT_TRUE(lookup_index.LowerBound(key) != NULL);
+        lookup_index.Find(key);
+        lookup_index.UpperBound(key);
+    }
+    EXPECT_EQ(count * 2, expected);
+}
+
+//
+// Random inserts and erases, verified against std::set.
+//
+TEST_F(BTreeIndexTest, Random) {
+    const size_t count = 20000;
+    Index index;
+    CreateEntries(count, true);
+    std::set<uint32_t> expected;
+
+    srand(1);
+    for (int round = 0; round < 8; ++round) {
+        for (size_t idx = 0; idx < count; ++idx) {
+            TestEntry *entry = entries_[rand() % count];
+            if (rand() % 2) {
+                bool inserted = expected.insert(entry->value()).second;
+                EXPECT_EQ(inserted, index.Insert(entry));
+            } else {
+                bool erased = expected.erase(entry->value()) != 0;
+                EXPECT_EQ(erased, index.Erase(*entry));
+            }
+        }
+        VerifyWalk(&index, expected);
+    }
+
+    // Erase everything in random order.
+    for (size_t idx = 0; idx < count; ++idx) {
+        bool erased = expected.erase(entries_[idx]->value()) != 0;
+        EXPECT_EQ(erased, index.Erase(*entries_[idx]));
+        if (idx % 1000 == 0)
+            VerifyWalk(&index, expected);
+    }
+    EXPECT_TRUE(index.empty());
+    EXPECT_TRUE(index.First() == NULL);
+}
+
+//
+// Erase entries while walking, the way the table walker and deletion of a
+// table's entries interleave.
+//
+TEST_F(BTreeIndexTest, EraseDuringWalk) {
+    const size_t count = 10000;
+    Index index;
+    CreateEntries(count, false);
+    std::set<uint32_t> expected;
+    for (size_t idx = 0; idx < count; ++idx) {
+        index.Insert(entries_[idx]);
+        expected.insert(entries_[idx]->value());
+    }
+
+    size_t visited = 0;
+    TestEntry *next = NULL;
+    for (TestEntry *entry = index.First(); entry; entry = next) {
+        next = index.Next(entry);
+        if (visited++ % 3 == 0) {
+            index.Erase(*entry);
+            expected.erase(entry->value());
+        }
+    }
+    EXPECT_EQ(count, visited);
+    VerifyWalk(&index, expected);
+}
+
+//
+// Compare insert, lookup and walk times against boost::intrusive::set.
+// Sizes can be set via DB_BTREE_INDEX_BENCHMARK_SIZES as a comma separated
+// list.
+//
+TEST_F(BTreeIndexTest, Benchmark) {
+    vector<size_t> sizes;
+    const char *str = getenv("DB_BTREE_INDEX_BENCHMARK_SIZES");
+    if (str) {
+        for (char *cp = const_cast<char *>(str); *cp; ) {
+            sizes.push_back(strtoul(cp, &cp, 0));
+            if (*cp == ',')
+                cp++;
+        }
+    } else {
+        sizes.push_back(100 * 1000);
+        sizes.push_back(1000 * 1000);
+        sizes.push_back(5 * 1000 * 1000);
+    }
+
+    for (vector<size_t>::const_iterator it = sizes.begin();
+         it != sizes.end(); ++it) {
+        size_t count = *it;
+        DeleteEntries();
+        CreateEntries(count, true);
+
+        Tree tree;
+        uint64_t start = ClockMonotonicUsec();
+        for (size_t idx = 0; idx < count; ++idx) {
+            tree.insert(*entries_[idx]);
+        }
+        uint64_t tree_insert = ClockMonotonicUsec() - start;
+
+        Index index;
+        start = ClockMonotonicUsec();
+        for (size_t idx = 0; idx < count; ++idx) {
+            index.Insert(entries_[idx]);
+        }
+        uint64_t index_insert = ClockMonotonicUsec() - start;
+
+        size_t found = 0;
+        start = ClockMonotonicUsec();
+        for (size_t idx = 0; idx < count; ++idx) {
+            if (tree.find(*entries_[idx]) != tree.end())
+                found++;
+        }
+        uint64_t tree_lookup = ClockMonotonicUsec() - start;
+
+        start = ClockMonotonicUsec();
+        for (size_t idx = 0; idx < count; ++idx) {
+            if (index.Find(*entries_[idx]))
+                found++;
+        }
+        uint64_t index_lookup = ClockMonotonicUsec() - start;
+        EXPECT_EQ(count * 2, found);
+
+        size_t walked = 0;
+        start = ClockMonotonicUsec();
+        for (Tree::iterator tit = tree.begin(); tit != tree.end(); ++tit) {
+            walked++;
+        }
+        uint64_t tree_walk = ClockMonotonicUsec() - start;
+
+        start = ClockMonotonicUsec();
+        for (TestEntry *entry = index.First(); entry;
+             entry = index.Next(entry)) {
+            walked++;
+        }
+        uint64_t index_walk = ClockMonotonicUsec() - start;
+        EXPECT_EQ(count * 2, walked);
+
+        tree.clear();
+        std::cout << count << " entries" << std::endl;
+        std::cout << "  Insert : rbtree " << tree_insert << " usec, btree "
+            << index_insert << " usec" << std::endl;
+        std::cout << "  Lookup : rbtree " << tree_lookup << " usec, btree "
+            << index_lookup << " usec" << std::endl;
+        std::cout << "  Walk   : rbtree " << tree_walk << " usec, btree "
+            << index_walk << " usec" << std::endl;
+    }
+}
+
+int main(int argc, char **argv) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
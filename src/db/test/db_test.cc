@@ -275,6 +275,112 @@ TEST_F(DBTest, Find) {
     del_notification = 0;
 }
 
+// Batched enqueue of requests spread over all partitions.
+TEST_F(DBTest, EnqueueBatch) {
+    const int num_entries = 1024;
+
+    tid_ = itbl->Register(boost::bind(&DBTest::DBTestListener, this, _1, _2));
+    adc_notification = 0;
+    del_notification = 0;
+    uint64_t enqueue_count = itbl->enqueue_count();
+
+    DBRequestList req_list;
+    for (int idx = 0; idx < num_entries; ++idx) {
+        DBRequest *req = new DBRequest(DBRequest::DB_ENTRY_ADD_CHANGE);
+        req->key.reset(new VlanTableReqKey(idx));
+        req->data.reset(new VlanTableReqData("DB Test Vlan"));
+        req_list.push_back(req);
+    }
+    itbl->Enqueue(req_list);
+    STLDeleteValues(&req_list);
+    TASK_UTIL_EXPECT_EQ(num_entries, adc_notification);
+    TASK_UTIL_EXPECT_EQ(num_entries, itbl->Size());
+    EXPECT_EQ(enqueue_count + num_entries, itbl->enqueue_count());
+
+    {
+        ConcurrencyScope scope("db::DBTable");
+        for (int idx = 0; idx < num_entries; ++idx) {
+            VlanTableReqKey key(idx);
+            Vlan *vlan = itbl->Find(&key);
+            ASSERT_TRUE(vlan != NULL);
+            EXPECT_EQ("DB Test Vlan", vlan->getDesc());
+        }
+    }
+
+    for (int idx = 0; idx < num_entries; ++idx) {
+        DBRequest *req = new DBRequest(DBRequest::DB_ENTRY_DELETE);
+        req->key.reset(new VlanTableReqKey(idx));
+        req_list.push_back(req);
+    }
+    itbl->Enqueue(req_list);
+    STLDeleteValues(&req_list);
+    TASK_UTIL_EXPECT_EQ(num_entries, del_notification);
+    TASK_UTIL_EXPECT_EQ(0, itbl->Size());
+
+    itbl->Unregister(tid_);
+    adc_notification = 0;
+    del_notification = 0;
+}
+
+//
+// Compare the time taken to enqueue requests one at a time and in batches.
+// The scheduler is stopped so that only the enqueue path gets measured.
+//
+TEST_F(DBTest, EnqueueBatchBenchmark) {
+    const int num_entries = 32 * 1024;
+    const size_t batch_size = 1024;
+
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    int partition_count = DB::PartitionCount();
+    std::vector<uint64_t> start_count(partition_count);
+    for (int index = 0; index < partition_count; ++index) {
+        start_count[index] = db_.GetPartition(index)->total_request_count();
+    }
+
+    scheduler->Stop();
+    uint64_t start = ClockMonotonicUsec();
+    for (int idx = 0; idx < num_entries; ++idx) {
+        DBRequest req(DBRequest::DB_ENTRY_ADD_CHANGE);
+        req.key.reset(new VlanTableReqKey(idx));
+        req.data.reset(new VlanTableReqData("DB Test Vlan"));
+        itbl->Enqueue(&req);
+    }
+    uint64_t single_time = ClockMonotonicUsec() - start;
+    scheduler->Start();
+    TASK_UTIL_EXPECT_EQ(num_entries, itbl->Size());
+
+    DBRequestList req_list;
+    req_list.reserve(batch_size);
+    scheduler->Stop();
+    start = ClockMonotonicUsec();
+    for (int idx = 0; idx < num_entries; ++idx) {
+        DBRequest *req = new DBRequest(DBRequest::DB_ENTRY_DELETE);
+        req->key.reset(new VlanTableReqKey(idx));
+        req_list.push_back(req);
+        if (req_list.size() == batch_size) {
+            itbl->Enqueue(req_list);
+            STLDeleteValues(&req_list);
+        }
+    }
+    itbl->Enqueue(req_list);
+    STLDeleteValues(&req_list);
+    uint64_t batch_time = ClockMonotonicUsec() - start;
+    scheduler->Start();
+    TASK_UTIL_EXPECT_EQ(0, itbl->Size());
+
+    std::cout << "Single enqueue  : " << num_entries << " requests in "
+        << single_time << " usec" << std::endl;
+    std::cout << "Batched enqueue : " << num_entries << " requests in "
+        << batch_time << " usec" << std::endl;
+    for (int index = 0; index < partition_count; ++index) {
+        uint64_t count = db_.GetPartition(index)->total_request_count() -
+            start_count[index];
+        std::cout << "Partition " << index << " : " << count << " requests, "
+            << "max queue length "
+            << db_.GetPartition(index)->max_request_queue_len() << std::endl;
+    }
+}
+
 void RegisterFactory() {
     DB::RegisterFactory("db.test.vlan.0", &VlanTable::CreateTable);
     DB::RegisterFactory("db.test.vlan.1", &VlanTable::CreateTable);
@@ -8,13 +8,14 @@
 
 #include "io/event_manager.h"
 #include "base/logging.h"
+#include "io/io_buffer_pool.h"
 #include "io/io_log.h"
 
 using boost::asio::io_service;
 
 SandeshTraceBufferPtr IOTraceBuf(SandeshTraceBufferCreate(IO_TRACE_BUF, 1000));
 
-EventManager::EventManager() {
+EventManager::EventManager() : buffer_pool_(new IOBufferPool) {
     shutdown_ = false;
 }
 
@@ -9,9 +9,12 @@
 
 #include <tbb/spin_mutex.h>
 #include <boost/asio/io_service.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include "base/util.h"
 
+class IOBufferPool;
+
 //
 // Wrapper around boost::io_service.
 //
@@ -38,8 +41,15 @@ public:
 
     boost::asio::io_service *io_service() { return &io_service_; }
 
+    // Pool of receive buffers for the sessions that run on this
+    // EventManager.
+    const boost::shared_ptr<IOBufferPool> &buffer_pool() const {
+        return buffer_pool_;
+    }
+
 private:
     boost::asio::io_service io_service_;
+    boost::shared_ptr<IOBufferPool> buffer_pool_;
     bool shutdown_;
     tbb::spin_mutex mutex_;
 
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "io/io_buffer_pool.h"
+
+#include <set>
+
+#include "io/io_types.h"
+
+using boost::asio::buffer_cast;
+using boost::asio::buffer_size;
+using boost::asio::mutable_buffer;
+using std::set;
+using std::vector;
+
+//
+// All pools in the process, so that the introspect handler can find them.
+//
+static tbb::mutex pool_set_mutex;
+static set<IOBufferPool *> pool_set;
+static uint32_t pool_next_id;
+
+IOBufferPool::SizeClass::SizeClass()
+    : buffer_size(0), max_free(0),
+      allocs(0), hits(0), releases(0), discards(0), in_use(0) {
+}
+
+IOBufferPool::IOBufferPool() {
+    for (int idx = 0; idx < kSizeClasses; ++idx) {
+        SizeClass &size_class = size_classes_[idx];
+        size_class.buffer_size = kMinBufferSize << idx;
+        size_class.max_free = kMaxFreeBytes / size_class.buffer_size;
+        size_class.free_list.reserve(size_class.max_free);
+    }
+    large_allocs_ = 0;
+    large_in_use_ = 0;
+
+    tbb::mutex::scoped_lock lock(pool_set_mutex);
+    id_ = pool_next_id++;
+    pool_set.insert(this);
+}
+
+IOBufferPool::~IOBufferPool() {
+    {
+        tbb::mutex::scoped_lock lock(pool_set_mutex);
+        pool_set.erase(this);
+    }
+
+    for (int idx = 0; idx < kSizeClasses; ++idx) {
+        SizeClass &size_class = size_classes_[idx];
+        assert(size_class.in_use == 0);
+        for (vector<uint8_t *>::iterator it = size_class.free_list.begin();
+             it != size_class.free_list.end(); ++it) {
+            delete[] *it;
+        }
+    }
+    assert(large_in_use_ == 0);
+}
+
+//
+// Index of the smallest size class with buffers of at least size bytes,
+// or -1 if the size is larger than the largest class.
+//
+int IOBufferPool::SizeClassIndex(size_t size) {
+    size_t buffer_size = kMinBufferSize;
+    for (int idx = 0; idx < kSizeClasses; ++idx, buffer_size <<= 1) {
+        if (size <= buffer_size)
+            return idx;
+    }
+    return -1;
+}
+
+mutable_buffer IOBufferPool::Allocate(size_t size) {
+    int idx = SizeClassIndex(size);
+    if (idx < 0) {
+        large_allocs_++;
+        large_in_use_++;
+        return mutable_buffer(new uint8_t[size], size);
+    }
+
+    SizeClass &size_class = size_classes_[idx];
+    uint8_t *data = NULL;
+    {
+        tbb::mutex::scoped_lock lock(size_class.mutex);
+        size_class.allocs++;
+        size_class.in_use++;
+        if (!size_class.free_list.empty()) {
+            size_class.hits++;
+            data = size_class.free_list.back();
+            size_class.free_list.pop_back();
+        }
+    }
+    if (!data)
+        data = new uint8_t[size_class.buffer_size];
+    return mutable_buffer(data, size_class.buffer_size);
+}
+
+void IOBufferPool::Release(mutable_buffer buffer) {
+    uint8_t *data = buffer_cast<uint8_t *>(buffer);
+    size_t size = buffer_size(buffer);
+    int idx = SizeClassIndex(size);
+    if (idx < 0) {
+        large_in_use_--;
+        delete[] data;
+        return;
+    }
+
+    SizeClass &size_class = size_classes_[idx];
+    assert(size == size_class.buffer_size);
+    {
+        tbb::mutex::scoped_lock lock(size_class.mutex);
+        assert(size_class.in_use > 0);
+        size_class.releases++;
+        size_class.in_use--;
+        if (size_class.free_list.size() < size_class.max_free) {
+            size_class.free_list.push_back(data);
+            return;
+        }
+        size_class.discards++;
+    }
+    delete[] data;
+}
+
+size_t IOBufferPool::in_use() const {
+    size_t count = large_in_use_;
+    for (int idx = 0; idx < kSizeClasses; ++idx) {
+        const SizeClass &size_class = size_classes_[idx];
+        tbb::mutex::scoped_lock lock(size_class.mutex);
+        count += size_class.in_use;
+    }
+    return count;
+}
+
+size_t IOBufferPool::free_count() const {
+    size_t count = 0;
+    for (int idx = 0; idx < kSizeClasses; ++idx) {
+        const SizeClass &size_class = size_classes_[idx];
+        tbb::mutex::scoped_lock lock(size_class.mutex);
+        count += size_class.free_list.size();
+    }
+    return count;
+}
+
+//
+// One entry per size class, plus one with a buffer size of 0 for requests
+// that are larger than the largest class.
+//
+void IOBufferPool::GetStats(vector<IOBufferPoolStats> *stats_list) const {
+    for (int idx = 0; idx < kSizeClasses; ++idx) {
+        const SizeClass &size_class = size_classes_[idx];
+        tbb::mutex::scoped_lock lock(size_class.mutex);
+        IOBufferPoolStats stats;
+        stats.set_pool_id(id_);
+        stats.set_buffer_size(size_class.buffer_size);
+        stats.set_allocs(size_class.allocs);
+        stats.set_hits(size_class.hits);
+        stats.set_releases(size_class.releases);
+        stats.set_discards(size_class.discards);
+        stats.set_in_use(size_class.in_use);
+        stats.set_free(size_class.free_list.size());
+        stats_list->push_back(stats);
+    }
+
+    IOBufferPoolStats stats;
+    stats.set_pool_id(id_);
+    stats.set_buffer_size(0);
+    stats.set_allocs(large_allocs_);
+    stats.set_in_use(large_in_use_);
+    stats_list->push_back(stats);
+}
+
+void IOBufferPool::GetAllStats(vector<IOBufferPoolStats> *stats_list) {
+    tbb::mutex::scoped_lock lock(pool_set_mutex);
+    for (set<IOBufferPool *>::const_iterator it = pool_set.begin();
+         it != pool_set.end(); ++it) {
+        (*it)->GetStats(stats_list);
+    }
+}
+
+void IOBufferPoolReq::HandleRequest() const {
+    IOBufferPoolResp *resp = new IOBufferPoolResp;
+    vector<IOBufferPoolStats> stats_list;
+    IOBufferPool::GetAllStats(&stats_list);
+    resp->set_pool_stats(stats_list);
+    resp->set_context(context());
+    resp->set_more(false);
+    resp->Response();
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef SRC_IO_IO_BUFFER_POOL_H_
+#define SRC_IO_IO_BUFFER_POOL_H_
+
+#include <tbb/atomic.h>
+#include <tbb/mutex.h>
+
+#include <vector>
+
+#include <boost/asio/buffer.hpp>
+
+#include "base/util.h"
+
+class IOBufferPoolStats;
+
+//
+// Pool of receive buffers shared by the TcpSessions of an EventManager.
+//
+// Buffers come in kSizeClasses size classes, starting at kMinBufferSize and
+// doubling from one class to the next. A request is served from the free
+// list of the smallest class that fits, so the buffer may be larger than
+// what was asked for. Released buffers go back to the free list of their
+// class, unless the class already keeps kMaxFreeBytes worth of free buffers,
+// in which case they are deleted. Requests larger than the largest class
+// are served straight from the heap.
+//
+// This avoids a heap allocation and free of a 16KB or larger array for each
+// read on each of the sessions, which otherwise shows up as steady allocator
+// churn and fragmentation with thousands of sessions.
+//
+// Concurrency: Allocate is called from the io thread while Release gets
+// called from the reader tasks, so each size class has its own mutex.
+//
+// The pool is referenced via a shared_ptr by the EventManager as well as
+// the sessions, so that sessions that outlive the EventManager can still
+// release their buffers.
+//
+class IOBufferPool {
+public:
+    static const size_t kMinBufferSize = 16 * 1024;
+    static const int kSizeClasses = 5;
+    static const size_t kMaxFreeBytes = 4 * 1024 * 1024;
+
+    IOBufferPool();
+    ~IOBufferPool();
+
+    // Returns a buffer with at least size bytes.
+    boost::asio::mutable_buffer Allocate(size_t size);
+    // Buffer must be the same as returned by Allocate.
+    void Release(boost::asio::mutable_buffer buffer);
+
+    // Number of buffers handed out and not yet released.
+    size_t in_use() const;
+    // Number of buffers in the free lists.
+    size_t free_count() const;
+
+    void GetStats(std::vector<IOBufferPoolStats> *stats_list) const;
+
+    // Stats for all pools in the process, for introspect.
+    static void GetAllStats(std::vector<IOBufferPoolStats> *stats_list);
+
+private:
+    struct SizeClass {
+        SizeClass();
+
+        mutable tbb::mutex mutex;
+        size_t buffer_size;
+        size_t max_free;
+        std::vector<uint8_t *> free_list;
+        uint64_t allocs;
+        uint64_t hits;
+        uint64_t releases;
+        uint64_t discards;
+        uint64_t in_use;
+    };
+
+    static int SizeClassIndex(size_t size);
+
+    uint32_t id_;
+    SizeClass size_classes_[kSizeClasses];
+    tbb::atomic<uint64_t> large_allocs_;
+    tbb::atomic<uint64_t> large_in_use_;
+
+    DISALLOW_COPY_AND_ASSIGN(IOBufferPool);
+};
+
+#endif  // SRC_IO_IO_BUFFER_POOL_H_
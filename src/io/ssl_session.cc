@@ -179,6 +179,17 @@ size_t SslSession::WriteSome(const uint8_t *data, size_t len,
     }
 }
 
+// The ssl stream writes only the first buffer of the sequence, so the
+// gather write ends up as a partial write, which the caller handles.
+size_t SslSession::WriteSome(const std::vector<Buffer> &buffers,
+                             error_code *error) {
+    if (IsSslHandShakeSuccessLocked()) {
+        return ssl_socket_->write_some(buffers, *error);
+    } else {
+        return (TcpSession::WriteSome(buffers, error));
+    }
+}
+
 void SslSession::AsyncWrite(const u_int8_t *data, size_t size) {
     if (IsSslHandShakeSuccessLocked()) {
         async_write(*ssl_socket_.get(), buffer(data, size),
@@ -69,6 +69,8 @@ private:
                     boost::system::error_code *error);
     std::size_t WriteSome(const uint8_t *data, std::size_t len,
                           boost::system::error_code *error);
+    std::size_t WriteSome(const std::vector<Buffer> &buffers,
+                          boost::system::error_code *error);
     void AsyncWrite(const u_int8_t *data, std::size_t size);
 
     static void TriggerSslHandShakeInternal(SslSessionPtr ptr,
@@ -9,10 +9,9 @@
 #include "io/tcp_session.h"
 #include "io/io_log.h"
 
-using boost::asio::buffer;
-using boost::asio::buffer_cast;
-using boost::asio::mutable_buffer;
+using boost::asio::const_buffer;
 using boost::system::error_code;
+using std::vector;
 using tbb::mutex;
 
 TcpMessageWriter::TcpMessageWriter(TcpSession *session) :
@@ -20,23 +19,23 @@ TcpMessageWriter::TcpMessageWriter(TcpSession *session) :
 }
 
 TcpMessageWriter::~TcpMessageWriter() {
-    for (BufferQueue::iterator iter = buffer_queue_.begin();
-         iter != buffer_queue_.end(); ++iter) {
-        DeleteBuffer(*iter);
-    }
-    buffer_queue_.clear();
+    STLDeleteValues(&buffer_queue_);
+    STLDeleteValues(&free_buffers_);
 }
 
-int TcpMessageWriter::Send(const uint8_t *data, size_t len, error_code *ec) {
-    int wrote = 0;
-
+void TcpMessageWriter::UpdateStats(size_t len) {
     // Update socket write call statistics.
     session_->stats_.write_calls++;
     session_->stats_.write_bytes += len;
 
     session_->server_->stats_.write_calls++;
     session_->server_->stats_.write_bytes += len;
+}
 
+int TcpMessageWriter::Send(const uint8_t *data, size_t len, error_code *ec) {
+    int wrote = 0;
+
+    UpdateStats(len);
     if (buffer_queue_.empty()) {
         wrote = session_->WriteSome(data, len, ec);
         if (TcpSession::IsSocketErrorHard(*ec)) return -1;
@@ -59,38 +58,67 @@ int TcpMessageWriter::Send(const uint8_t *data, size_t len, error_code *ec) {
 
 // Socket is ready for write. Flush any pending data
 void TcpMessageWriter::HandleWriteReady(error_code *error) {
+    vector<const_buffer> buffers;
+    buffers.reserve(kMaxGatherBuffers);
     while (!buffer_queue_.empty()) {
-        boost::asio::mutable_buffer head = buffer_queue_.front();
-        const uint8_t *data = buffer_cast<const uint8_t *>(head) + offset_;
-        int remaining = buffer_size(head) - offset_;
-        int wrote = session_->WriteSome(data, remaining, error);
+        buffers.clear();
+        size_t offset = offset_;
+        size_t remaining = 0;
+        for (BufferQueue::const_iterator iter = buffer_queue_.begin();
+             iter != buffer_queue_.end() &&
+             buffers.size() < static_cast<size_t>(kMaxGatherBuffers);
+             ++iter) {
+            const Buffer *buffer = *iter;
+            buffers.push_back(const_buffer(buffer->data() + offset,
+                                           buffer->size() - offset));
+            remaining += buffer->size() - offset;
+            offset = 0;
+        }
+
+        size_t wrote = session_->WriteSome(buffers, error);
         if (TcpSession::IsSocketErrorHard(*error)) {
             return;
         }
-        assert(wrote >= 0);
+        BufferConsume(wrote);
         if (wrote != remaining) {
-            offset_ += wrote;
             session_->DeferWriter();
             return;
+        }
+    }
+}
+
+// Recycle the buffers at the head of the queue that have been written in
+// full and advance the offset into the first one that hasn't.
+void TcpMessageWriter::BufferConsume(size_t len) {
+    while (len > 0) {
+        assert(!buffer_queue_.empty());
+        Buffer *head = buffer_queue_.front();
+        size_t remaining = head->size() - offset_;
+        if (len < remaining) {
+            offset_ += len;
+            return;
+        }
+        len -= remaining;
+        offset_ = 0;
+        buffer_queue_.pop_front();
+        if (free_buffers_.size() < static_cast<size_t>(kMaxFreeBuffers)) {
+            head->clear();
+            free_buffers_.push_back(head);
         } else {
-            offset_ = 0;
-            DeleteBuffer(head);
-            buffer_queue_.pop_front();
+            delete head;
         }
     }
-    buffer_queue_.clear();
 }
 
 void TcpMessageWriter::BufferAppend(const uint8_t *src, int bytes) {
-    u_int8_t *data = new u_int8_t[bytes];
-    memcpy(data, src, bytes);
-    mutable_buffer buffer = mutable_buffer(data, bytes);
+    if (bytes == 0)
+        return;
+    if (free_buffers_.empty()) {
+        buffer_queue_.push_back(new Buffer(src, src + bytes));
+        return;
+    }
+    Buffer *buffer = free_buffers_.back();
+    free_buffers_.pop_back();
+    buffer->assign(src, src + bytes);
     buffer_queue_.push_back(buffer);
 }
-
-void TcpMessageWriter::DeleteBuffer(mutable_buffer buffer) {
-    const uint8_t *data = buffer_cast<const uint8_t *>(buffer);
-    delete[] data;
-    return;
-}
-
@@ -8,6 +8,7 @@
 #include <tbb/mutex.h>
 
 #include <list>
+#include <vector>
 #include <boost/asio.hpp>
 #include <boost/bind.hpp>
 #include <boost/asio/buffer.hpp>
@@ -17,9 +18,23 @@
 
 class TcpSession;
 
+//
+// Writes messages to the socket of a TcpSession without blocking.
+//
+// Data that can't be written right away is queued and flushed when the
+// socket becomes writable again. The queue is flushed with a gather write
+// of up to kMaxGatherBuffers buffers in a single system call.
+//
+// Buffers are recycled once they have been written, so that queueing data
+// under backpressure doesn't allocate memory for every message.
+//
 class TcpMessageWriter {
 public:
     static const int kDefaultBufferSize = 4 * 1024;
+    static const int kMaxGatherBuffers = 64;
+    static const int kMaxFreeBuffers = kMaxGatherBuffers;
+    typedef std::vector<uint8_t> Buffer;
+
     explicit TcpMessageWriter(TcpSession *session);
     ~TcpMessageWriter();
 
@@ -30,13 +45,16 @@ public:
 private:
     friend class TcpSession;
     typedef boost::intrusive_ptr<TcpSession> TcpSessionPtr;
-    typedef std::list<boost::asio::mutable_buffer> BufferQueue;
+    typedef std::list<Buffer *> BufferQueue;
+    typedef std::vector<Buffer *> BufferList;
+    void UpdateStats(size_t len);
     void BufferAppend(const uint8_t *data, int len);
-    void DeleteBuffer(boost::asio::mutable_buffer buffer);
+    void BufferConsume(size_t len);
     void HandleWriteReady(boost::system::error_code *ec);
 
     BufferQueue buffer_queue_;
-    int offset_;
+    BufferList free_buffers_;
+    size_t offset_;
     TcpSession *session_;
 };
 
@@ -15,6 +15,7 @@
 
 #include "base/logging.h"
 #include "io/event_manager.h"
+#include "io/io_buffer_pool.h"
 #include "io/io_log.h"
 #include "io/io_utils.h"
 #include "io/tcp_message_write.h"
@@ -36,6 +37,7 @@ using boost::system::error_code;
 using std::min;
 using std::ostringstream;
 using std::string;
+using std::vector;
 
 using boost::asio::error::eof;
 using boost::asio::error::try_again;
@@ -97,6 +99,7 @@ TcpSession::TcpSession(
     }
     if (server_) {
         io_strand_.reset(new Strand(*server->event_manager()->io_service()));
+        buffer_pool_ = server->event_manager()->buffer_pool();
     }
     defer_reader_ = false;
 }
@@ -110,14 +113,26 @@ TcpSession::~TcpSession() {
     buffer_queue_.clear();
 }
 
+//
+// Receive buffers come from the pool of the EventManager, if any. A buffer
+// from the pool may be larger than the requested size.
+//
 mutable_buffer TcpSession::AllocateBuffer(size_t buffer_size) {
-    u_int8_t *data = new u_int8_t[buffer_size];
-    mutable_buffer buffer = mutable_buffer(data, buffer_size);
+    mutable_buffer buffer;
+    if (buffer_pool_) {
+        buffer = buffer_pool_->Allocate(buffer_size);
+    } else {
+        buffer = mutable_buffer(new u_int8_t[buffer_size], buffer_size);
+    }
     buffer_queue_.push_back(buffer);
     return buffer;
 }
 
 void TcpSession::DeleteBuffer(mutable_buffer buffer) {
+    if (buffer_pool_) {
+        buffer_pool_->Release(buffer);
+        return;
+    }
     uint8_t *data = buffer_cast<uint8_t *>(buffer);
     delete[] data;
 }
@@ -204,6 +219,11 @@ size_t TcpSession::WriteSome(const uint8_t *data, size_t len,
     return socket()->write_some(buffer(data, len), *error);
 }
 
+size_t TcpSession::WriteSome(const vector<Buffer> &buffers,
+                             error_code *error) {
+    return socket()->write_some(buffers, *error);
+}
+
 void TcpSession::AsyncWrite(const u_int8_t *data, size_t size) {
     async_write(*socket(), buffer(data, size),
         bind(&TcpSession::AsyncWriteHandler, TcpSessionPtr(this),
@@ -437,6 +457,12 @@ bool TcpSession::Send(const u_int8_t *data, size_t size, size_t *sent) {
     return ret;
 }
 
+bool TcpSession::SendBuffer(vector<u_int8_t> *data, size_t *sent) {
+    bool ret = Send(data->data(), data->size(), sent);
+    data->clear();
+    return ret;
+}
+
 Task* TcpSession::CreateReaderTask(mutable_buffer buffer,
                                   size_t bytes_transferred) {
     Buffer rdbuf(buffer_cast<const uint8_t *>(buffer), bytes_transferred);
@@ -11,6 +11,7 @@
 #include <deque>
 #include <list>
 #include <string>
+#include <vector>
 
 #include <boost/asio/buffer.hpp>
 #include <boost/asio/io_service.hpp>
@@ -19,6 +20,7 @@
 #include <boost/intrusive_ptr.hpp>
 #include <boost/function.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 
 #ifndef _LIBCPP_VERSION
 #include <tbb/compat/condition_variable>
@@ -28,6 +30,7 @@
 #include "io/tcp_server.h"
 
 class EventManager;
+class IOBufferPool;
 class TcpServer;
 class TcpSession;
 class TcpMessageWriter;
@@ -63,6 +66,11 @@ public:
     // Performs a non-blocking send operation.
     virtual bool Send(const u_int8_t *data, size_t size, size_t *sent);
 
+    // Performs a non-blocking send operation of the data in the vector
+    // using Send, and clears the vector so that the caller can build the
+    // next message in the same storage.
+    bool SendBuffer(std::vector<u_int8_t> *data, size_t *sent);
+
     // Called by TcpServer to trigger async read.
     virtual bool Connected(Endpoint remote);
 
@@ -192,6 +200,9 @@ protected:
                             boost::system::error_code *error);
     virtual std::size_t WriteSome(const uint8_t *data, std::size_t len,
                                   boost::system::error_code *error);
+    // Gather write of the buffers in a single system call.
+    virtual std::size_t WriteSome(const std::vector<Buffer> &buffers,
+                                  boost::system::error_code *error);
     virtual void AsyncWrite(const u_int8_t *data, std::size_t size);
 
     virtual int reader_task_id() const {
@@ -245,6 +256,7 @@ private:
     TcpServerPtr server_;
     boost::scoped_ptr<Socket> socket_;
     boost::scoped_ptr<Strand> io_strand_;
+    boost::shared_ptr<IOBufferPool> buffer_pool_;
     bool read_on_connect_;
 
     /**************** protected by mutex_ ****************/
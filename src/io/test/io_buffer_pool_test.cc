@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <tbb/mutex.h>
+
+#include <memory>
+#include <vector>
+
+#include <boost/bind.hpp>
+
+#include "testing/gunit.h"
+
+#include "base/logging.h"
+#include "base/task.h"
+#include "base/test/task_test_util.h"
+
+#include "io/event_manager.h"
+#include "io/io_buffer_pool.h"
+#include "io/io_types.h"
+#include "io/tcp_server.h"
+#include "io/tcp_session.h"
+#include "io/test/event_manager_test.h"
+#include "io/io_log.h"
+
+using boost::asio::buffer_cast;
+using boost::asio::buffer_size;
+using boost::asio::mutable_buffer;
+using std::auto_ptr;
+using std::vector;
+
+namespace {
+
+class IOBufferPoolTest : public ::testing::Test {
+protected:
+    IOBufferPoolStats GetStats(size_t buffer_size) {
+        vector<IOBufferPoolStats> stats_list;
+        pool_.GetStats(&stats_list);
+        for (vector<IOBufferPoolStats>::const_iterator it = stats_list.begin();
+             it != stats_list.end(); ++it) {
+            if (it->get_buffer_size() == buffer_size)
+                return *it;
+        }
+        return IOBufferPoolStats();
+    }
+
+    IOBufferPool pool_;
+};
+
+TEST_F(IOBufferPoolTest, SizeClasses) {
+    const size_t kMin = IOBufferPool::kMinBufferSize;
+    const size_t kMax = kMin << (IOBufferPool::kSizeClasses - 1);
+
+    vector<mutable_buffer> buffers;
+    buffers.push_back(pool_.Allocate(1));
+    EXPECT_EQ(kMin, buffer_size(buffers.back()));
+    buffers.push_back(pool_.Allocate(kMin));
+    EXPECT_EQ(kMin, buffer_size(buffers.back()));
+    buffers.push_back(pool_.Allocate(kMin + 1));
+    EXPECT_EQ(2 * kMin, buffer_size(buffers.back()));
+    buffers.push_back(pool_.Allocate(kMax));
+    EXPECT_EQ(kMax, buffer_size(buffers.back()));
+    buffers.push_back(pool_.Allocate(kMax + 1));
+    EXPECT_EQ(kMax + 1, buffer_size(buffers.back()));
+    EXPECT_EQ(5, pool_.in_use());
+    EXPECT_EQ(1, GetStats(0).get_in_use());
+
+    for (vector<mutable_buffer>::iterator it = buffers.begin();
+         it != buffers.end(); ++it) {
+        pool_.Release(*it);
+    }
+    EXPECT_EQ(0, pool_.in_use());
+    EXPECT_EQ(4, pool_.free_count());
+}
+
+TEST_F(IOBufferPoolTest, Reuse) {
+    mutable_buffer buffer1 = pool_.Allocate(100);
+    pool_.Release(buffer1);
+    mutable_buffer buffer2 = pool_.Allocate(200);
+    EXPECT_EQ(buffer_cast<uint8_t *>(buffer1), buffer_cast<uint8_t *>(buffer2));
+    pool_.Release(buffer2);
+
+    IOBufferPoolStats stats = GetStats(IOBufferPool::kMinBufferSize);
+    EXPECT_EQ(2, stats.get_allocs());
+    EXPECT_EQ(1, stats.get_hits());
+    EXPECT_EQ(2, stats.get_releases());
+    EXPECT_EQ(0, stats.get_in_use());
+    EXPECT_EQ(1, stats.get_free());
+}
+
+//
+// Releases beyond kMaxFreeBytes worth of free buffers in a size class are
+// freed rather than kept around.
+//
+TEST_F(IOBufferPoolTest, FreeListLimit) {
+    const size_t kMaxFree =
+        IOBufferPool::kMaxFreeBytes / IOBufferPool::kMinBufferSize;
+    const size_t kExtra = 10;
+
+    vector<mutable_buffer> buffers;
+    for (size_t idx = 0; idx < kMaxFree + kExtra; ++idx) {
+        buffers.push_back(pool_.Allocate(IOBufferPool::kMinBufferSize));
+    }
+    for (vector<mutable_buffer>::iterator it = buffers.begin();
+         it != buffers.end(); ++it) {
+        pool_.Release(*it);
+    }
+
+    IOBufferPoolStats stats = GetStats(IOBufferPool::kMinBufferSize);
+    EXPECT_EQ(kMaxFree, stats.get_free());
+    EXPECT_EQ(kExtra, stats.get_discards());
+    EXPECT_EQ(kMaxFree, pool_.free_count());
+}
+
+class PoolTestSession : public TcpSession {
+public:
+    PoolTestSession(TcpServer *server, Socket *socket)
+        : TcpSession(server, socket) {
+    }
+
+protected:
+    virtual void OnRead(Buffer buffer) {
+        ReleaseBuffer(buffer);
+    }
+};
+
+class PoolTestServer : public TcpServer {
+public:
+    explicit PoolTestServer(EventManager *evm) : TcpServer(evm) {
+    }
+
+    virtual TcpSession *AllocSession(Socket *socket) {
+        TcpSession *session = new PoolTestSession(this, socket);
+        tbb::mutex::scoped_lock lock(mutex_);
+        sessions_.push_back(session);
+        return session;
+    }
+
+    size_t session_count() {
+        tbb::mutex::scoped_lock lock(mutex_);
+        return sessions_.size();
+    }
+
+    void CloseSessions() {
+        tbb::mutex::scoped_lock lock(mutex_);
+        for (vector<TcpSession *>::iterator it = sessions_.begin();
+             it != sessions_.end(); ++it) {
+            (*it)->Close();
+        }
+    }
+
+    void DeleteSessions() {
+        tbb::mutex::scoped_lock lock(mutex_);
+        for (vector<TcpSession *>::iterator it = sessions_.begin();
+             it != sessions_.end(); ++it) {
+            DeleteSession(*it);
+        }
+        sessions_.clear();
+    }
+
+private:
+    tbb::mutex mutex_;
+    vector<TcpSession *> sessions_;
+};
+
+class IOBufferPoolSessionTest : public ::testing::Test {
+protected:
+    static const int kSessionCount = 16;
+
+    virtual void SetUp() {
+        evm_.reset(new EventManager());
+        server_ = new PoolTestServer(evm_.get());
+        client_ = new PoolTestServer(evm_.get());
+        thread_.reset(new ServerThread(evm_.get()));
+        server_->Initialize(0);
+        task_util::WaitForIdle();
+        thread_->Start();
+    }
+
+    virtual void TearDown() {
+        server_->Shutdown();
+        client_->Shutdown();
+        task_util::WaitForIdle();
+        TcpServerManager::DeleteServer(server_);
+        TcpServerManager::DeleteServer(client_);
+        evm_->Shutdown();
+        thread_->Join();
+        task_util::WaitForIdle();
+    }
+
+    void Connect(int count) {
+        boost::asio::ip::tcp::endpoint endpoint;
+        boost::system::error_code ec;
+        endpoint.address(
+            boost::asio::ip::address::from_string("127.0.0.1", ec));
+        endpoint.port(server_->GetPort());
+        for (int idx = 0; idx < count; ++idx) {
+            clients_.push_back(client_->CreateSession());
+            client_->Connect(clients_.back(), endpoint);
+        }
+        TASK_UTIL_EXPECT_EQ(count, server_->session_count());
+        for (vector<TcpSession *>::iterator it = clients_.begin();
+             it != clients_.end(); ++it) {
+            TASK_UTIL_EXPECT_TRUE((*it)->IsEstablished());
+        }
+    }
+
+    void DeleteClients() {
+        client_->DeleteSessions();
+        clients_.clear();
+    }
+
+    auto_ptr<ServerThread> thread_;
+    auto_ptr<EventManager> evm_;
+    PoolTestServer *server_;
+    PoolTestServer *client_;
+    vector<TcpSession *> clients_;
+};
+
+//
+// Buffers that were read but not yet handed to the reader task when the
+// sessions get closed go back to the pool when the sessions are deleted.
+//
+TEST_F(IOBufferPoolSessionTest, CloseMidRead) {
+    Connect(kSessionCount);
+    IOBufferPool *pool = evm_->buffer_pool().get();
+    EXPECT_EQ(0, pool->in_use());
+
+    // Stop the scheduler so that the reader tasks don't run.
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    scheduler->Stop();
+
+    uint8_t msg[1024];
+    memset(msg, 0xab, sizeof(msg));
+    for (vector<TcpSession *>::iterator it = clients_.begin();
+         it != clients_.end(); ++it) {
+        (*it)->Send(msg, sizeof(msg), NULL);
+    }
+    TASK_UTIL_EXPECT_EQ(kSessionCount, pool->in_use());
+
+    server_->CloseSessions();
+    for (vector<TcpSession *>::iterator it = clients_.begin();
+         it != clients_.end(); ++it) {
+        (*it)->Close();
+    }
+    scheduler->Start();
+    task_util::WaitForIdle();
+
+    server_->DeleteSessions();
+    DeleteClients();
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(0, pool->in_use());
+    EXPECT_LE(kSessionCount, pool->free_count());
+}
+
+//
+// Buffers get reused across reads, so the free list stays small while the
+// sessions exchange data.
+//
+TEST_F(IOBufferPoolSessionTest, Reuse) {
+    Connect(kSessionCount);
+    IOBufferPool *pool = evm_->buffer_pool().get();
+
+    uint8_t msg[1024];
+    memset(msg, 0xab, sizeof(msg));
+    for (int round = 0; round < 16; ++round) {
+        for (vector<TcpSession *>::iterator it = clients_.begin();
+             it != clients_.end(); ++it) {
+            (*it)->Send(msg, sizeof(msg), NULL);
+        }
+        task_util::WaitForIdle();
+    }
+    TASK_UTIL_EXPECT_EQ(0, pool->in_use());
+    EXPECT_GE(static_cast<size_t>(kSessionCount), pool->free_count());
+
+    server_->CloseSessions();
+    server_->DeleteSessions();
+    DeleteClients();
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(0, pool->in_use());
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <tbb/atomic.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <boost/bind.hpp>
+
+#include "testing/gunit.h"
+
+#include "base/logging.h"
+#include "base/task.h"
+#include "base/time_util.h"
+#include "base/test/task_test_util.h"
+
+#include "io/event_manager.h"
+#include "io/tcp_message_write.h"
+#include "io/tcp_server.h"
+#include "io/tcp_session.h"
+#include "io/test/event_manager_test.h"
+#include "io/io_log.h"
+
+using std::auto_ptr;
+using std::vector;
+
+namespace {
+
+//
+// The sender writes a byte stream in which the byte at offset n has the
+// value n % kPatternModulo. The receiver verifies that it gets the stream
+// in order, with nothing lost or duplicated.
+//
+static const int kPatternModulo = 251;
+
+class WriteTestServer;
+
+class WriteTestSession : public TcpSession {
+public:
+    WriteTestSession(WriteTestServer *server, Socket *socket);
+
+    uint64_t total() const { return total_; }
+    uint64_t errors() const { return errors_; }
+    uint64_t send_calls() const { return send_calls_; }
+    bool write_ready() const { return write_ready_; }
+    void set_write_ready(bool write_ready) { write_ready_ = write_ready; }
+
+    // Fill the buffer with the next size bytes of the stream.
+    void FillBuffer(vector<uint8_t> *buffer, size_t size) {
+        buffer->resize(size);
+        for (size_t idx = 0; idx < size; ++idx) {
+            (*buffer)[idx] = (send_offset_ + idx) % kPatternModulo;
+        }
+        send_offset_ += size;
+    }
+
+    virtual bool Send(const u_int8_t *data, size_t size, size_t *sent) {
+        send_calls_++;
+        return TcpSession::Send(data, size, sent);
+    }
+
+    virtual void WriteReady(const boost::system::error_code &error) {
+        write_ready_ = true;
+    }
+
+protected:
+    virtual ~WriteTestSession() {
+    }
+
+    virtual void OnRead(Buffer buffer) {
+        const uint8_t *data = BufferData(buffer);
+        size_t len = BufferSize(buffer);
+        for (size_t idx = 0; idx < len; ++idx) {
+            if (data[idx] != (total_ + idx) % kPatternModulo)
+                errors_++;
+        }
+        total_ += len;
+        ReleaseBuffer(buffer);
+    }
+
+private:
+    uint64_t send_offset_;
+    uint64_t send_calls_;
+    tbb::atomic<uint64_t> total_;
+    tbb::atomic<uint64_t> errors_;
+    tbb::atomic<bool> write_ready_;
+};
+
+class WriteTestServer : public TcpServer {
+public:
+    explicit WriteTestServer(EventManager *evm)
+        : TcpServer(evm), session_(NULL) {
+    }
+
+    virtual TcpSession *AllocSession(Socket *socket) {
+        session_ = new WriteTestSession(this, socket);
+        return session_;
+    }
+
+    void SessionReset() {
+        if (session_)
+            DeleteSession(session_);
+        session_ = NULL;
+    }
+
+    void Connect(int port) {
+        boost::system::error_code ec;
+        boost::asio::ip::tcp::endpoint endpoint;
+        endpoint.address(
+            boost::asio::ip::address::from_string("127.0.0.1", ec));
+        endpoint.port(port);
+        TcpServer::Connect(session_, endpoint);
+    }
+
+    WriteTestSession *session() const { return session_; }
+
+private:
+    WriteTestSession *session_;
+};
+
+WriteTestSession::WriteTestSession(WriteTestServer *server, Socket *socket)
+    : TcpSession(server, socket), send_offset_(0), send_calls_(0) {
+    total_ = 0;
+    errors_ = 0;
+    write_ready_ = false;
+}
+
+class TcpWriteTest : public ::testing::Test {
+protected:
+    static const int kMessageSize = 4096;
+    static const int kMessageCount = 64 * 1024;
+
+    virtual void SetUp() {
+        evm_.reset(new EventManager());
+        server_ = new WriteTestServer(evm_.get());
+        client_ = new WriteTestServer(evm_.get());
+        thread_.reset(new ServerThread(evm_.get()));
+        server_->Initialize(0);
+        task_util::WaitForIdle();
+        thread_->Start();
+
+        client_->CreateSession();
+        client_->Connect(server_->GetPort());
+        TASK_UTIL_ASSERT_TRUE(client_->session()->IsEstablished());
+        TASK_UTIL_ASSERT_TRUE(server_->session() != NULL);
+        TASK_UTIL_ASSERT_TRUE(server_->session()->IsEstablished());
+    }
+
+    virtual void TearDown() {
+        client_->session()->Close();
+        server_->session()->Close();
+        task_util::WaitForIdle();
+
+        server_->Shutdown();
+        server_->SessionReset();
+        client_->Shutdown();
+        client_->SessionReset();
+        task_util::WaitForIdle();
+
+        TcpServerManager::DeleteServer(server_);
+        server_ = NULL;
+        TcpServerManager::DeleteServer(client_);
+        client_ = NULL;
+
+        evm_->Shutdown();
+        thread_->Join();
+        task_util::WaitForIdle();
+    }
+
+    // Send count messages, waiting for WriteReady whenever the session
+    // applies backpressure. Each message is built either in a new buffer
+    // or in the same buffer, which SendBuffer clears for reuse. Returns the
+    // elapsed time until the receiver got all the data.
+    uint64_t SendMessages(bool reuse, int count) {
+        WriteTestSession *session = client_->session();
+        uint64_t start_total = server_->session()->total();
+        vector<uint8_t> buffer;
+        buffer.reserve(kMessageSize);
+
+        uint64_t start = ClockMonotonicUsec();
+        for (int idx = 0; idx < count; ++idx) {
+            session->set_write_ready(false);
+            bool ready;
+            if (reuse) {
+                session->FillBuffer(&buffer, kMessageSize);
+                ready = session->SendBuffer(&buffer, NULL);
+                EXPECT_TRUE(buffer.empty());
+                EXPECT_GE(buffer.capacity(),
+                          static_cast<size_t>(kMessageSize));
+            } else {
+                vector<uint8_t> message;
+                message.reserve(kMessageSize);
+                session->FillBuffer(&message, kMessageSize);
+                ready = session->Send(message.data(), message.size(), NULL);
+            }
+            while (!ready && !session->write_ready()) {
+                usleep(10);
+            }
+        }
+        uint64_t total = start_total +
+            static_cast<uint64_t>(count) * kMessageSize;
+        TASK_UTIL_EXPECT_EQ(total, server_->session()->total());
+        return ClockMonotonicUsec() - start;
+    }
+
+    auto_ptr<ServerThread> thread_;
+    auto_ptr<EventManager> evm_;
+    WriteTestServer *server_;
+    WriteTestServer *client_;
+};
+
+//
+// Fill up the socket with the reader deferred, so that the data gets
+// queued, some of it after a partial write. All the data gets to the
+// receiver in order once the reader resumes, and WriteReady gets called.
+// SendBuffer goes through Send, and the buffer keeps its capacity after a
+// partial write.
+//
+TEST_F(TcpWriteTest, SendBufferBackpressure) {
+    WriteTestSession *session = client_->session();
+    server_->session()->SetDeferReader(true);
+
+    vector<uint8_t> buffer;
+    size_t sent = 0;
+    bool ready = true;
+    uint64_t total = 0;
+    uint64_t send_calls = 0;
+    while (ready) {
+        session->FillBuffer(&buffer, kMessageSize);
+        ready = session->SendBuffer(&buffer, &sent);
+        EXPECT_TRUE(buffer.empty());
+        EXPECT_GE(buffer.capacity(), static_cast<size_t>(kMessageSize));
+        EXPECT_EQ(++send_calls, session->send_calls());
+        total += kMessageSize;
+    }
+
+    // The socket is blocked, so more data just gets queued.
+    for (int idx = 0; idx < 2 * TcpMessageWriter::kMaxGatherBuffers; ++idx) {
+        session->FillBuffer(&buffer, idx % 2 ? kMessageSize : 1);
+        ready = session->SendBuffer(&buffer, &sent);
+        EXPECT_FALSE(ready);
+        EXPECT_EQ(0, sent);
+        EXPECT_TRUE(buffer.empty());
+        EXPECT_EQ(++send_calls, session->send_calls());
+        total += idx % 2 ? kMessageSize : 1;
+    }
+
+    server_->session()->SetDeferReader(false);
+    TASK_UTIL_EXPECT_TRUE(session->write_ready());
+    TASK_UTIL_EXPECT_EQ(total, server_->session()->total());
+    EXPECT_EQ(0, server_->session()->errors());
+
+    // Send and SendBuffer can be mixed.
+    SendMessages(false, 16);
+    SendMessages(true, 16);
+    EXPECT_EQ(0, server_->session()->errors());
+}
+
+//
+// Throughput of messages that are built in a new buffer each time and of
+// messages that are built in the same buffer and sent with SendBuffer.
+//
+TEST_F(TcpWriteTest, Benchmark) {
+    uint64_t new_time = SendMessages(false, kMessageCount);
+    uint64_t reuse_time = SendMessages(true, kMessageCount);
+    EXPECT_EQ(0, server_->session()->errors());
+
+    uint64_t bytes = static_cast<uint64_t>(kMessageCount) * kMessageSize;
+    std::cout << "Sent " << kMessageCount << " messages of "
+        << kMessageSize << " bytes" << std::endl;
+    std::cout << "New buffers    : " << new_time << " usec, "
+        << bytes / (new_time ? new_time : 1) << " MB/sec" << std::endl;
+    std::cout << "Reused buffer  : " << reuse_time << " usec, "
+        << bytes / (reuse_time ? reuse_time : 1) << " MB/sec" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -32,15 +32,15 @@
 ///////////////////////////////////////////////////////////////////////////////
 bool KSyncNetlinkEntry::Add() {
     Sync();
+    KSyncSock   *sock = KSyncSock::Get(0);
     int len = MsgLen();
-    char *msg = (char *)malloc(len);
+    char *msg = sock->AllocMsgBuffer(len);
     int  msg_len = AddMsg(msg, len);
     assert(msg_len <= len);
     if (msg_len == 0) {
-        free(msg);
+        sock->FreeMsgBuffer(msg);
         return true;
     }
-    KSyncSock   *sock = KSyncSock::Get(0);
     sock->SendAsync(this, msg_len, msg, KSyncEntry::ADD_ACK);
     return false;
 }
@@ -50,29 +50,29 @@ bool KSyncNetlinkEntry::Change() {
         return true;
     }
 
+    KSyncSock   *sock = KSyncSock::Get(0);
     int len = MsgLen();
-    char *msg = (char *)malloc(len);
+    char *msg = sock->AllocMsgBuffer(len);
     int  msg_len = ChangeMsg(msg, len);
     assert(msg_len <= len);
     if (msg_len == 0) {
-        free(msg);
+        sock->FreeMsgBuffer(msg);
         return true;
     }
-    KSyncSock   *sock = KSyncSock::Get(0);
     sock->SendAsync(this, msg_len, msg, KSyncEntry::CHANGE_ACK);
     return false;
 }
 
 bool KSyncNetlinkEntry::Delete() {
+    KSyncSock   *sock = KSyncSock::Get(0);
     int len = MsgLen();
-    char *msg = (char *)malloc(len);
+    char *msg = sock->AllocMsgBuffer(len);
     int  msg_len = DeleteMsg(msg, len);
     assert(msg_len <= len);
     if (msg_len == 0) {
-        free(msg);
+        sock->FreeMsgBuffer(msg);
         return true;
     }
-    KSyncSock   *sock = KSyncSock::Get(0);
     sock->SendAsync(this, msg_len, msg, KSyncEntry::DEL_ACK);
     return false;
 }
@@ -81,43 +81,43 @@ bool KSyncNetlinkEntry::Delete() {
 // KSyncNetlinkDBEntry routines
 ///////////////////////////////////////////////////////////////////////////////
 bool KSyncNetlinkDBEntry::Add() {
+    KSyncSock   *sock = KSyncSock::Get(0);
     int len = MsgLen();
-    char *msg = (char *)malloc(len);
+    char *msg = sock->AllocMsgBuffer(len);
     int  msg_len = AddMsg(msg, len); 
     assert(msg_len <= len);
     if (msg_len == 0) {
-        free(msg);
+        sock->FreeMsgBuffer(msg);
         return true;
     }
-    KSyncSock   *sock = KSyncSock::Get(0);
     sock->SendAsync(this, msg_len, msg, KSyncEntry::ADD_ACK);
     return false;
 }
 
 bool KSyncNetlinkDBEntry::Change() {
+    KSyncSock   *sock = KSyncSock::Get(0);
     int len = MsgLen();
-    char *msg = (char *)malloc(len);
+    char *msg = sock->AllocMsgBuffer(len);
     int  msg_len = ChangeMsg(msg, len);
     assert(msg_len <= len);
     if (msg_len == 0) {
-        free(msg);
+        sock->FreeMsgBuffer(msg);
         return true;
     }
-    KSyncSock   *sock = KSyncSock::Get(0);
     sock->SendAsync(this, msg_len, msg, KSyncEntry::CHANGE_ACK);
     return false;
 }
 
 bool KSyncNetlinkDBEntry::Delete() {
+    KSyncSock   *sock = KSyncSock::Get(0);
     int len = MsgLen();
-    char *msg = (char *)malloc(len);
+    char *msg = sock->AllocMsgBuffer(len);
     int  msg_len = DeleteMsg(msg, len);
     assert(msg_len <= len);
     if (msg_len == 0) {
-        free(msg);
+        sock->FreeMsgBuffer(msg);
         return true;
     }
-    KSyncSock   *sock = KSyncSock::Get(0);
     sock->SendAsync(this, msg_len, msg, KSyncEntry::DEL_ACK);
     return false;
 }
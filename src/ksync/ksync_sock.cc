@@ -194,6 +194,7 @@ KSyncSock::KSyncSock() :
     bulk_seq_no_(kInvalidBulkSeqNo), bulk_buf_size_(0), bulk_msg_count_(0),
     rx_buff_(NULL), read_inline_(true), bulk_msg_context_(NULL),
     ksync_bulk_sandesh_context_(), uve_bulk_sandesh_context_(),
+    tx_buffer_pool_(), msg_buffer_pool_(),
     tx_count_(0), ack_count_(0), err_count_(0) {
     TaskScheduler *scheduler = TaskScheduler::GetInstance();
 
@@ -213,6 +214,7 @@ KSyncSock::KSyncSock() :
     rx_buff_ = NULL;
     seqno_ = 0;
     uve_seqno_ = 0;
+    bulk_tx_mode_ = false;
 }
 
 KSyncSock::~KSyncSock() {
@@ -231,6 +233,14 @@ KSyncSock::~KSyncSock() {
         delete uve_rx_queue[i];
     }
 
+    char *buff;
+    while (tx_buffer_pool_.try_pop(buff)) {
+        delete[] buff;
+    }
+    while (msg_buffer_pool_.try_pop(buff)) {
+        free(buff);
+    }
+
     if (nl_client_->cl_buf) {
         free(nl_client_->cl_buf);
     }
@@ -408,6 +418,7 @@ bool KSyncSock::ProcessKernelData(KSyncBulkSandeshContext *bulk_sandesh_context,
     BulkDecoder(data.buff_, bulk_sandesh_context);
     // Remove the IoContext only on last netlink message
     if (IsMoreData(data.buff_) == false) {
+        FreeTxBuffer(bulk_message_context->ReleaseTxBuffer());
         if (data.bulk_msg_context_ != NULL) {
             delete data.bulk_msg_context_;
         } else {
@@ -537,6 +548,7 @@ KSyncBulkMsgContext *KSyncSock::LocateBulkContext
             bulk_msg_count_ = 0;
             bulk_msg_context_ = new KSyncBulkMsgContext(io_context_type,
                                                         work_queue_index);
+            InitBulkContext(bulk_msg_context_);
         }
         return bulk_msg_context_;
     }
@@ -546,9 +558,10 @@ KSyncBulkMsgContext *KSyncSock::LocateBulkContext
         bulk_seq_no_ = seqno;
         bulk_buf_size_ = 0;
         bulk_msg_count_ = 0;
-        wait_tree_.insert(WaitTreePair(seqno,
-                                       KSyncBulkMsgContext(io_context_type,
-                                                           work_queue_index)));
+        std::pair<WaitTree::iterator, bool> ret =
+            wait_tree_.insert(WaitTreePair(seqno,
+                KSyncBulkMsgContext(io_context_type, work_queue_index)));
+        InitBulkContext(&ret.first->second);
     }
 
     WaitTree::iterator it = wait_tree_.find(bulk_seq_no_);
@@ -556,6 +569,72 @@ KSyncBulkMsgContext *KSyncSock::LocateBulkContext
     return &it->second;
 }
 
+// The limits and the transmit buffer are picked when a bulk context is
+// created, so that bulk transmit mode can be changed while messages are
+// being sent
+void KSyncSock::InitBulkContext(KSyncBulkMsgContext *bulk_message_context) {
+    if (bulk_tx_mode_) {
+        bulk_message_context->set_tx_buffer(AllocTxBuffer(), kBulkTxBufSize);
+        max_bulk_msg_count_ = kBulkTxMsgCount;
+        max_bulk_buf_size_ = kBulkTxBufSize;
+    } else {
+        max_bulk_msg_count_ = kMaxBulkMsgCount;
+        max_bulk_buf_size_ = kMaxBulkMsgSize;
+    }
+}
+
+void KSyncSock::SetBulkTxMode(bool enable) {
+    bulk_tx_mode_ = enable;
+}
+
+char *KSyncSock::AllocTxBuffer() {
+    char *buff;
+    if (tx_buffer_pool_.try_pop(buff))
+        return buff;
+    return new char[kBulkTxBufSize];
+}
+
+void KSyncSock::FreeTxBuffer(char *buff) {
+    if (buff == NULL)
+        return;
+    // unsafe_size is only a hint, the pool may go a little above the limit
+    if (tx_buffer_pool_.unsafe_size() >= (int)kMaxTxBufferPoolSize) {
+        delete[] buff;
+        return;
+    }
+    tx_buffer_pool_.push(buff);
+}
+
+// The size of a message buffer is kept in the header before it, so that
+// FreeMsgBuffer knows whether the buffer goes back to the pool
+char *KSyncSock::AllocMsgBuffer(int len) {
+    char *buff;
+    uint32_t size = kMsgBufferSize;
+    if ((uint32_t)len > kMsgBufferSize) {
+        size = len;
+        buff = (char *)malloc(kMsgBufferHeaderSize + size);
+    } else if (msg_buffer_pool_.try_pop(buff) == false) {
+        buff = (char *)malloc(kMsgBufferHeaderSize + size);
+    }
+    memcpy(buff, &size, sizeof(size));
+    return buff + kMsgBufferHeaderSize;
+}
+
+void KSyncSock::FreeMsgBuffer(char *msg) {
+    if (msg == NULL)
+        return;
+    char *buff = msg - kMsgBufferHeaderSize;
+    uint32_t size;
+    memcpy(&size, buff, sizeof(size));
+    // unsafe_size is only a hint, the pool may go a little above the limit
+    if (size != kMsgBufferSize ||
+        msg_buffer_pool_.unsafe_size() >= (int)kMaxMsgBufferPoolSize) {
+        free(buff);
+        return;
+    }
+    msg_buffer_pool_.push(buff);
+}
+
 // Try adding an io-context to bulk context. Returns
 //  - true  : if message can be added to bulk context
 //  - false : if message cannot be added to bulk context
@@ -989,6 +1068,20 @@ int KSyncSockTcpSessionReader::MsgLength(Buffer buffer, int offset) {
     return nlh->nlmsg_len;
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// IoContext routines
+/////////////////////////////////////////////////////////////////////////////
+void IoContext::FreeMsg() {
+    if (msg_ == NULL)
+        return;
+    if (msg_sock_ != NULL) {
+        msg_sock_->FreeMsgBuffer(msg_);
+    } else {
+        free(msg_);
+    }
+    msg_ = NULL;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // KSyncIoContext routines
 /////////////////////////////////////////////////////////////////////////////
@@ -1000,6 +1093,7 @@ KSyncIoContext::KSyncIoContext(KSyncSock *sock, KSyncEntry *sync_entry,
               IoContext::IOC_KSYNC, sync_entry->GetTableIndex()),
     entry_(sync_entry), event_(event) {
     SetSeqno(sock->AllocSeqNo(type(), index()));
+    set_msg_sock(sock);
 }
 
 void KSyncIoContext::Handler() {
@@ -1176,15 +1270,18 @@ void KSyncBulkSandeshContext::VrouterOpsMsgHandler(vrouter_ops *req) {
 KSyncBulkMsgContext::KSyncBulkMsgContext(IoContext::Type type,
                                          uint32_t index) :
     io_context_list_(), io_context_type_(type), work_queue_index_(index),
-    rx_buffer_index_(0), vr_response_count_(0), io_context_list_it_() {
+    rx_buffer_index_(0), tx_buffer_(NULL), tx_buffer_size_(0),
+    tx_buffer_len_(0), vr_response_count_(0), io_context_list_it_() {
 }
 
 KSyncBulkMsgContext::KSyncBulkMsgContext(const KSyncBulkMsgContext &rhs) :
     io_context_list_(), io_context_type_(rhs.io_context_type_),
     work_queue_index_(rhs.work_queue_index_),
-    rx_buffer_index_(0), vr_response_count_(0), io_context_list_it_() {
+    rx_buffer_index_(0), tx_buffer_(NULL), tx_buffer_size_(0),
+    tx_buffer_len_(0), vr_response_count_(0), io_context_list_it_() {
     assert(rhs.vr_response_count_ == 0);
     assert(rhs.rx_buffer_index_ == 0);
+    assert(rhs.tx_buffer_ == NULL);
     assert(rhs.io_context_list_.size() == 0);
 }
 
@@ -1198,6 +1295,9 @@ KSyncBulkMsgContext::~KSyncBulkMsgContext() {
     for (uint32_t i = 0; i < rx_buffer_index_; i++) {
         delete[] rx_buffers_[i];
     }
+    if (tx_buffer_ != NULL) {
+        delete[] tx_buffer_;
+    }
 }
 
 char *KSyncBulkMsgContext::GetReceiveBuffer() {
@@ -1208,16 +1308,51 @@ char *KSyncBulkMsgContext::GetReceiveBuffer() {
 }
 
 void KSyncBulkMsgContext::AddReceiveBuffer(char *buff) {
-    assert(rx_buffer_index_ < kMaxRxBufferCount);
+    // A bulk context in bulk transmit mode can get more pre-allocated buffers
+    // than it can hold. Free the extra buffers, GetReceiveBuffer allocates
+    // buffers if needed
+    if (rx_buffer_index_ >= kMaxRxBufferCount) {
+        delete[] buff;
+        return;
+    }
     rx_buffers_[rx_buffer_index_++] = buff;
 }
 
+void KSyncBulkMsgContext::set_tx_buffer(char *buff, uint32_t size) {
+    assert(tx_buffer_ == NULL);
+    assert(io_context_list_.size() == 0);
+    tx_buffer_ = buff;
+    tx_buffer_size_ = size;
+    tx_buffer_len_ = 0;
+}
+
+char *KSyncBulkMsgContext::ReleaseTxBuffer() {
+    char *buff = tx_buffer_;
+    tx_buffer_ = NULL;
+    tx_buffer_size_ = 0;
+    tx_buffer_len_ = 0;
+    return buff;
+}
+
 void KSyncBulkMsgContext::Insert(IoContext *ioc) {
     io_context_list_.push_back(*ioc);
+    if (tx_buffer_ == NULL)
+        return;
+
+    // Copy message to the transmit buffer and free the IoContext buffer
+    assert((tx_buffer_len_ + ioc->msg_len_) <= tx_buffer_size_);
+    memcpy(tx_buffer_ + tx_buffer_len_, ioc->msg_, ioc->msg_len_);
+    tx_buffer_len_ += ioc->msg_len_;
+    ioc->FreeMsg();
     return;
 }
 
 void KSyncBulkMsgContext::Data(KSyncBufferList *iovec) {
+    if (tx_buffer_ != NULL) {
+        iovec->push_back(buffer(tx_buffer_, tx_buffer_len_));
+        return;
+    }
+
     IoContextList::iterator it = io_context_list_.begin();
     while (it != io_context_list_.end()) {
         iovec->push_back(buffer(it->GetMsg(), it->GetMsgLen()));
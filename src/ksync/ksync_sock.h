@@ -11,6 +11,7 @@
 #include <boost/asio/netlink_protocol.hpp>
 #include <boost/asio/netlink_endpoint.hpp>
 #include <tbb/atomic.h>
+#include <tbb/concurrent_queue.h>
 #include <tbb/mutex.h>
 #include <base/queue_task.h>
 #include <sandesh/common/vns_constants.h>
@@ -25,6 +26,7 @@
 #define KSYNC_SOCK_RECV_BUFF_SIZE (256 * 1024)
 
 class KSyncEntry;
+class KSyncSock;
 class KSyncIoContext;
 class KSyncSockTcpSession;
 struct nl_client;
@@ -87,21 +89,23 @@ public:
 
     IoContext() :
         sandesh_context_(NULL), msg_(NULL), msg_len_(0), seqno_(0),
-        type_(IOC_KSYNC), index_(0), rx_buffer1_(NULL), rx_buffer2_(NULL) {
+        type_(IOC_KSYNC), index_(0), rx_buffer1_(NULL), rx_buffer2_(NULL),
+        msg_sock_(NULL) {
     }
     IoContext(char *msg, uint32_t len, uint32_t seq, AgentSandeshContext *ctx, 
               Type type) :
         sandesh_context_(ctx), msg_(msg), msg_len_(len), seqno_(seq),
-        type_(type), index_(0), rx_buffer1_(NULL), rx_buffer2_(NULL) {
+        type_(type), index_(0), rx_buffer1_(NULL), rx_buffer2_(NULL),
+        msg_sock_(NULL) {
     }
     IoContext(char *msg, uint32_t len, uint32_t seq, AgentSandeshContext *ctx, 
               Type type, uint32_t index) :
         sandesh_context_(ctx), msg_(msg), msg_len_(len), seqno_(seq),
-        type_(type), index_(index), rx_buffer1_(NULL), rx_buffer2_(NULL) {
+        type_(type), index_(index), rx_buffer1_(NULL), rx_buffer2_(NULL),
+        msg_sock_(NULL) {
     }
     virtual ~IoContext() { 
-        if (msg_ != NULL)
-            free(msg_);
+        FreeMsg();
         assert(rx_buffer1_ == NULL);
         assert(rx_buffer2_ == NULL);
     }
@@ -125,6 +129,9 @@ public:
     char *rx_buffer2() { return rx_buffer2_; }
     void reset_rx_buffer2() { rx_buffer2_ = NULL; }
     uint32_t index() const { return index_; }
+    // Message buffer is allocated with sock->AllocMsgBuffer
+    void set_msg_sock(KSyncSock *sock) { msg_sock_ = sock; }
+    void FreeMsg();
 
     boost::intrusive::list_member_hook<> node_;
 
@@ -142,13 +149,17 @@ private:
     // computation in KSync Tx Queue context.
     char *rx_buffer1_;
     char *rx_buffer2_;
+    // KSyncSock to release msg_ to. msg_ is allocated with malloc if NULL
+    KSyncSock *msg_sock_;
 
     friend class KSyncSock;
+    friend class KSyncBulkMsgContext;
 };
 
 /* IoContext tied to KSyncEntry */
 class  KSyncIoContext : public IoContext {
 public:
+    // The msg must be allocated with KSyncSock::AllocMsgBuffer
     KSyncIoContext(KSyncSock *sock, KSyncEntry *sync_entry, int msg_len,
                    char *msg, KSyncEntry::KSyncEvent event);
     virtual ~KSyncIoContext() {
@@ -203,6 +214,26 @@ private:
  *
  *     class KSyncBulkSandeshContext is used to decode the Sandesh Responses
  *     and move the IoContext on getting VrResponse
+ *
+ * Bulk transmit mode
+ *   By default, the messages in a KSyncBulkMsgContext are sent as an io-vector
+ *   of the buffers in each IoContext. boost::asio passes at most 64 buffers
+ *   to the socket, so an io-vector cannot carry much more than the default
+ *   kMaxBulkMsgCount messages. In bulk transmit mode
+ *   (KSyncSock::SetBulkTxMode), each KSyncBulkMsgContext gets a buffer from
+ *   a pool in KSyncSock. Messages are copied into it when added to the
+ *   context and the IoContext buffer goes back to the message buffer pool
+ *   right away. The bulk context is then sent as a single contiguous
+ *   buffer, and upto kBulkTxMsgCount messages are bunched together. The
+ *   buffer goes back to the pool once all responses for the context are
+ *   processed.
+ *
+ * Message buffers
+ *   KSync entries encode their messages into buffers from
+ *   KSyncSock::AllocMsgBuffer, which keeps a pool of kMsgBufferSize buffers.
+ *   Messages are encoded in DB task context and the buffers are released in
+ *   KSyncTxQueue or KSync receive work-queue context, so the pool saves a
+ *   malloc and a cross-thread free for every message.
  */
 typedef boost::intrusive::member_hook<IoContext,
         boost::intrusive::list_member_hook<>,
@@ -218,6 +249,9 @@ public:
 
     void Insert(IoContext *ioc);
     void Data(KSyncBufferList *iovec);
+    // Transmit buffer used in bulk transmit mode
+    void set_tx_buffer(char *buff, uint32_t size);
+    char *ReleaseTxBuffer();
     IoContext::Type io_context_type() const {
         return io_context_type_;
     }
@@ -239,6 +273,10 @@ private:
     char *rx_buffers_[kMaxRxBufferCount];
     // Index of next buffer to process
     uint32_t rx_buffer_index_;
+    // Buffer holding the messages in bulk transmit mode. NULL otherwise
+    char *tx_buffer_;
+    uint32_t tx_buffer_size_;
+    uint32_t tx_buffer_len_;
 
     ///////////////////////////////////////////////////////////////////////
     // Following fields are used for decode processing
@@ -298,6 +336,21 @@ public:
     const static unsigned kMaxBulkMsgSize = (4*1024);
     // Sequence number to denote invalid builk-context
     const static unsigned kInvalidBulkSeqNo = 0xFFFFFFFF;
+    // Number of messages that can be bunched together in bulk transmit mode
+    const static unsigned kBulkTxMsgCount = 128;
+    // Size of buffer in bulk transmit mode. Netlink attribute length is 16
+    // bits, so it must be less than 64K
+    const static unsigned kBulkTxBufSize = (32*1024);
+    // Max number of free buffers kept in the bulk transmit buffer pool
+    const static unsigned kMaxTxBufferPoolSize = 64;
+    // Size of the pooled message buffers. Messages that need a larger buffer
+    // use a buffer that is not pooled
+    const static unsigned kMsgBufferSize = KSyncEntry::kDefaultMsgSize;
+    // Space before each message buffer to keep its size. Keeps the malloc
+    // alignment
+    const static unsigned kMsgBufferHeaderSize = 16;
+    // Max number of free buffers kept in the message buffer pool
+    const static unsigned kMaxMsgBufferPoolSize = (4*1024);
 
     typedef std::map<uint32_t, KSyncBulkMsgContext> WaitTree;
     typedef std::pair<uint32_t, KSyncBulkMsgContext> WaitTreePair;
@@ -380,6 +433,14 @@ public:
     uint32_t WaitTreeSize() const;
     void SetSeqno(uint32_t seq);
     void SetMeasureQueueDelay(bool val);
+    // Enable or disable bulk transmit mode. Applies to bulk contexts created
+    // after the call
+    void SetBulkTxMode(bool enable);
+    bool bulk_tx_mode() const { return bulk_tx_mode_; }
+    // Buffer to encode a message of upto len bytes into. Must be released
+    // with FreeMsgBuffer
+    char *AllocMsgBuffer(int len);
+    void FreeMsgBuffer(char *msg);
 protected:
     static void Init(bool use_work_queue, const std::string &cpu_pin_policy);
     static void SetSockTableEntry(KSyncSock *sock);
@@ -434,6 +495,9 @@ private:
         tbb::mutex::scoped_lock lock(mutex_);
         return (wait_tree_.size() <= KSYNC_ACK_WAIT_THRESHOLD);
     }
+    void InitBulkContext(KSyncBulkMsgContext *bulk_message_context);
+    char *AllocTxBuffer();
+    void FreeTxBuffer(char *buff);
 
 private:
     char *rx_buff_;
@@ -445,6 +509,13 @@ private:
     KSyncBulkMsgContext *bulk_msg_context_;
     KSyncBulkSandeshContext ksync_bulk_sandesh_context_[kRxWorkQueueCount];
     KSyncBulkSandeshContext uve_bulk_sandesh_context_[kRxWorkQueueCount];
+    // Set from agent init, read in KSyncTxQueue context
+    tbb::atomic<bool> bulk_tx_mode_;
+    // Free buffers for bulk transmit mode. Buffers are allocated in
+    // KSyncTxQueue context and freed in KSync receive work-queue context
+    tbb::concurrent_queue<char *> tx_buffer_pool_;
+    // Free message buffers. Buffers are allocated in DB task context
+    tbb::concurrent_queue<char *> msg_buffer_pool_;
 
     // Debug stats
     int tx_count_;
@@ -553,12 +553,23 @@ bool KSyncSockTypeMap::Validate(char *data) {
     }
     return true;
 }
+
+static uint32_t IoVectorLength(KSyncBufferList *iovec) {
+    KSyncBufferList::iterator it = iovec->begin();
+    uint32_t len = 0;
+    while (it != iovec->end()) {
+        len += boost::asio::buffer_size(*it);
+        it++;
+    }
+    return len;
+}
+
 static int IoVectorToData(char *data, uint32_t len, KSyncBufferList *iovec) {
     KSyncBufferList::iterator it = iovec->begin();
     int offset = 0;
     while (it != iovec->end()) {
         unsigned char *buf = boost::asio::buffer_cast<unsigned char *>(*it);
-        assert((offset + boost::asio::buffer_size(*it)) < len);
+        assert((offset + boost::asio::buffer_size(*it)) <= len);
         memcpy(data + offset, buf, boost::asio::buffer_size(*it));
         offset +=  boost::asio::buffer_size(*it);
         it++;
@@ -569,21 +580,22 @@ static int IoVectorToData(char *data, uint32_t len, KSyncBufferList *iovec) {
 //send or store in map
 void KSyncSockTypeMap::AsyncSendTo(KSyncBufferList *iovec, uint32_t seq_no,
                                    HandlerCb cb) {
-    char data[4096];
-    int data_len = IoVectorToData(data, 4096, iovec);
+    // Bulk transmit mode can send more than 4K in one message
+    std::vector<char> data(IoVectorLength(iovec));
+    int data_len = IoVectorToData(&data[0], data.size(), iovec);
 
     KSyncUserSockContext ctx(seq_no);
     //parse and store info in map [done in Process() callbacks]
-    ProcessSandesh((const uint8_t *)(data), data_len, &ctx);
+    ProcessSandesh((const uint8_t *)(&data[0]), data_len, &ctx);
 }
 
 //send or store in map
 std::size_t KSyncSockTypeMap::SendTo(KSyncBufferList *iovec, uint32_t seq_no) {
-    char data[4096];
-    int data_len = IoVectorToData(data, 4096, iovec);
+    std::vector<char> data(IoVectorLength(iovec));
+    int data_len = IoVectorToData(&data[0], data.size(), iovec);
     KSyncUserSockContext ctx(seq_no);
     //parse and store info in map [done in Process() callbacks]
-    ProcessSandesh((const uint8_t *)(data), data_len, &ctx);
+    ProcessSandesh((const uint8_t *)(&data[0]), data_len, &ctx);
     return 0;
 }
 
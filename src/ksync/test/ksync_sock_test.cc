@@ -0,0 +1,315 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <sys/socket.h>
+#include <iostream>
+
+#include <boost/array.hpp>
+#include <tbb/atomic.h>
+
+#include "base/logging.h"
+#include "base/time_util.h"
+#include "testing/gunit.h"
+#include "base/test/task_test_util.h"
+#include "net/address.h"
+
+#include "ksync/ksync_entry.h"
+#include "ksync/ksync_sock.h"
+
+using namespace std;
+
+// Every message starts with a running counter and the length of the
+// encoded vr_route_req following it
+struct TestMsgHeader {
+    uint32_t msg;
+    uint32_t len;
+};
+
+// Sandesh context for the test objects. Only vr_response is expected
+class TestSandeshContext : public AgentSandeshContext {
+public:
+    TestSandeshContext() : AgentSandeshContext() { }
+    virtual ~TestSandeshContext() { }
+
+    virtual void IfMsgHandler(vr_interface_req *req) { assert(0); }
+    virtual void NHMsgHandler(vr_nexthop_req *req) { assert(0); }
+    virtual void RouteMsgHandler(vr_route_req *req) { assert(0); }
+    virtual void MplsMsgHandler(vr_mpls_req *req) { assert(0); }
+    virtual int VrResponseMsgHandler(vr_response *resp) { return 0; }
+    virtual void MirrorMsgHandler(vr_mirror_req *req) { assert(0); }
+    virtual void FlowMsgHandler(vr_flow_req *req) { assert(0); }
+    virtual void VrfAssignMsgHandler(vr_vrf_assign_req *req) { assert(0); }
+    virtual void VrfStatsMsgHandler(vr_vrf_stats_req *req) { assert(0); }
+    virtual void DropStatsMsgHandler(vr_drop_stats_req *req) { assert(0); }
+    virtual void VxLanMsgHandler(vr_vxlan_req *req) { assert(0); }
+    virtual void VrouterOpsMsgHandler(vrouter_ops *req) { assert(0); }
+    virtual void QosConfigMsgHandler(vr_qos_map_req *req) { assert(0); }
+    virtual void ForwardingClassMsgHandler(vr_fc_map_req *req) { assert(0); }
+};
+
+// IoContext for a test object. Counts the objects whose response is processed
+class TestIoContext : public IoContext {
+public:
+    TestIoContext(char *msg, uint32_t len, uint32_t seqno,
+                  AgentSandeshContext *ctx) :
+        IoContext(msg, len, seqno, ctx, IoContext::IOC_KSYNC) {
+    }
+    virtual ~TestIoContext() { }
+
+    virtual void Handler() { done_count_++; }
+
+    static tbb::atomic<uint32_t> done_count_;
+};
+tbb::atomic<uint32_t> TestIoContext::done_count_;
+
+// KSyncSock looping back a response for every bulk message sent. Every
+// message starts with a running counter, used to verify that messages are
+// sent in order.
+class TestKSyncSock : public KSyncSock {
+public:
+    // Response for a bulk message
+    struct Response {
+        uint32_t seqno;
+        uint32_t msg_count;
+    };
+
+    TestKSyncSock() : KSyncSock() { Reset(); }
+    virtual ~TestKSyncSock() { }
+
+    static void Init() {
+        SetSockTableEntry(new TestKSyncSock());
+        // Use the KSyncTxQueue thread like the netlink socket does
+        KSyncSock::Init(false, "disabled");
+    }
+
+    void Reset() {
+        send_count_ = 0;
+        msg_count_ = 0;
+        next_msg_ = 0;
+        max_msgs_per_send_ = 0;
+        max_iovec_size_ = 0;
+        last_seqno_ = 0;
+        last_msg_count_ = 0;
+    }
+
+    virtual bool BulkDecoder(char *data, KSyncBulkSandeshContext *ctxt) {
+        Response *resp = reinterpret_cast<Response *>(data);
+        vr_response vr_resp;
+        for (uint32_t i = 0; i < resp->msg_count; i++) {
+            ctxt->VrResponseMsgHandler(&vr_resp);
+        }
+        // Completes the last IoContext in the bulk message
+        return ctxt->Decoder(data, 0, 1, false);
+    }
+
+    virtual bool Decoder(char *data, AgentSandeshContext *ctxt) {
+        assert(0);
+        return true;
+    }
+
+    uint32_t send_count() const { return send_count_; }
+    uint32_t msg_count() const { return msg_count_; }
+    uint32_t max_msgs_per_send() const { return max_msgs_per_send_; }
+    size_t max_iovec_size() const { return max_iovec_size_; }
+
+private:
+    virtual void AsyncReceive(boost::asio::mutable_buffers_1, HandlerCb) {
+        assert(0);
+    }
+
+    virtual void AsyncSendTo(KSyncBufferList *iovec, uint32_t seq_no,
+                             HandlerCb cb) {
+        assert(0);
+    }
+
+    // Gathers the io-vector like the kernel does and walks the messages
+    virtual std::size_t SendTo(KSyncBufferList *iovec, uint32_t seq_no) {
+        std::vector<char> data;
+        for (KSyncBufferList::iterator it = iovec->begin();
+             it != iovec->end(); ++it) {
+            const char *buf = boost::asio::buffer_cast<const char *>(*it);
+            data.insert(data.end(), buf, buf + boost::asio::buffer_size(*it));
+        }
+
+        uint32_t count = 0;
+        std::size_t offset = 0;
+        while (offset < data.size()) {
+            TestMsgHeader hdr;
+            memcpy(&hdr, &data[offset], sizeof(hdr));
+            EXPECT_EQ(next_msg_, hdr.msg);
+            next_msg_++;
+            count++;
+            offset += sizeof(hdr) + hdr.len;
+        }
+        EXPECT_EQ(data.size(), offset);
+        std::size_t len = data.size();
+
+        send_count_++;
+        msg_count_ += count;
+        if (count > max_msgs_per_send_)
+            max_msgs_per_send_ = count;
+        if (iovec->size() > max_iovec_size_)
+            max_iovec_size_ = iovec->size();
+        last_seqno_ = seq_no;
+        last_msg_count_ = count;
+        return len;
+    }
+
+    virtual void Receive(boost::asio::mutable_buffers_1 buf) {
+        Response *resp = boost::asio::buffer_cast<Response *>(buf);
+        resp->seqno = last_seqno_;
+        resp->msg_count = last_msg_count_;
+    }
+
+    virtual uint32_t GetSeqno(char *data) {
+        return reinterpret_cast<Response *>(data)->seqno;
+    }
+
+    virtual bool IsMoreData(char *data) { return false; }
+    virtual bool Validate(char *data) { return true; }
+
+    uint32_t send_count_;
+    uint32_t msg_count_;
+    uint32_t next_msg_;
+    uint32_t max_msgs_per_send_;
+    size_t max_iovec_size_;
+    uint32_t last_seqno_;
+    uint32_t last_msg_count_;
+    DISALLOW_COPY_AND_ASSIGN(TestKSyncSock);
+};
+
+class KSyncSockTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+        sock_ = static_cast<TestKSyncSock *>(KSyncSock::Get(0));
+        sock_->Reset();
+        TestIoContext::done_count_ = 0;
+    }
+
+    virtual void TearDown() {
+        sock_->SetBulkTxMode(false);
+    }
+
+    // Encode a route add for object i into buf, like RouteKSyncEntry does
+    int Encode(uint32_t i, char *buf, int buf_len) {
+        vr_route_req encoder;
+        encoder.set_h_op(sandesh_op::ADD);
+        encoder.set_rtr_rid(0);
+        encoder.set_rtr_vrf_id(1);
+        encoder.set_rtr_family(AF_INET);
+        boost::array<unsigned char, 4> bytes =
+            Ip4Address(0x0a000000 + i).to_bytes();
+        std::vector<int8_t> rtr_prefix(bytes.begin(), bytes.end());
+        encoder.set_rtr_prefix(rtr_prefix);
+        encoder.set_rtr_prefix_len(32);
+        encoder.set_rtr_nh_id(i % 1024);
+        encoder.set_rtr_label_flags(0);
+
+        TestMsgHeader hdr;
+        int error = 0;
+        int encode_len = encoder.WriteBinary((uint8_t *)buf + sizeof(hdr),
+                                             buf_len - sizeof(hdr), &error);
+        EXPECT_EQ(0, error);
+        hdr.msg = i;
+        hdr.len = encode_len;
+        memcpy(buf, &hdr, sizeof(hdr));
+        return sizeof(hdr) + encode_len;
+    }
+
+    // Program count objects and return the time taken in usec. Messages are
+    // encoded into buffers from the KSyncSock message buffer pool, like
+    // KSyncNetlinkEntry does, or into malloc-ed buffers
+    uint64_t Program(uint32_t count, bool pool_msg_buffers = true) {
+        int buf_len = KSyncEntry::kDefaultMsgSize;
+        uint64_t start = ClockMonotonicUsec();
+        for (uint32_t i = 0; i < count; i++) {
+            char *msg;
+            if (pool_msg_buffers) {
+                msg = sock_->AllocMsgBuffer(buf_len);
+            } else {
+                msg = (char *)malloc(buf_len);
+            }
+            int msg_len = Encode(i, msg, buf_len);
+            uint32_t seqno = sock_->AllocSeqNo(IoContext::IOC_KSYNC);
+            TestIoContext *ioc = new TestIoContext(msg, msg_len, seqno,
+                                                   &sandesh_context_);
+            if (pool_msg_buffers)
+                ioc->set_msg_sock(sock_);
+            sock_->GenericSend(ioc);
+        }
+        TASK_UTIL_EXPECT_EQ(count, TestIoContext::done_count_);
+        uint64_t time = ClockMonotonicUsec() - start;
+
+        EXPECT_EQ(count, sock_->msg_count());
+        cout << "Programmed " << count << " objects in " << time
+            << " usec, " << (count * 1000000ULL) / (time ? time : 1)
+            << " objects/sec, " << sock_->send_count() << " sends, "
+            << "max " << sock_->max_msgs_per_send()
+            << " messages per send" << endl;
+        return time;
+    }
+
+    TestKSyncSock *sock_;
+    TestSandeshContext sandesh_context_;
+};
+
+TEST_F(KSyncSockTest, Default) {
+    EXPECT_FALSE(sock_->bulk_tx_mode());
+    Program(100000);
+    uint32_t max_msg_count = KSyncSock::kMaxBulkMsgCount;
+    EXPECT_LE(sock_->max_msgs_per_send(), max_msg_count);
+}
+
+// Messages encoded into malloc-ed buffers, as done before the message buffer
+// pool was added
+TEST_F(KSyncSockTest, MallocMsgBuffer) {
+    Program(100000, false);
+}
+
+// Every bulk message is sent as one buffer
+TEST_F(KSyncSockTest, BulkTxMode) {
+    sock_->SetBulkTxMode(true);
+    EXPECT_TRUE(sock_->bulk_tx_mode());
+    Program(100000);
+    uint32_t max_msg_count = KSyncSock::kBulkTxMsgCount;
+    EXPECT_LE(sock_->max_msgs_per_send(), max_msg_count);
+    EXPECT_EQ(1U, sock_->max_iovec_size());
+}
+
+// Default limits are restored when bulk transmit mode is disabled
+TEST_F(KSyncSockTest, BulkTxModeDisable) {
+    sock_->SetBulkTxMode(true);
+    Program(10000);
+
+    sock_->SetBulkTxMode(false);
+    sock_->Reset();
+    TestIoContext::done_count_ = 0;
+    Program(10000);
+    uint32_t max_msg_count = KSyncSock::kMaxBulkMsgCount;
+    EXPECT_LE(sock_->max_msgs_per_send(), max_msg_count);
+}
+
+// Freed message buffers are reused. Buffers larger than the pooled ones can
+// be allocated too
+TEST_F(KSyncSockTest, MsgBufferPool) {
+    char *msg = sock_->AllocMsgBuffer(KSyncEntry::kDefaultMsgSize);
+    sock_->FreeMsgBuffer(msg);
+    char *msg1 = sock_->AllocMsgBuffer(KSyncEntry::kDefaultMsgSize / 2);
+    EXPECT_TRUE(msg == msg1);
+    sock_->FreeMsgBuffer(msg1);
+
+    char *large_msg = sock_->AllocMsgBuffer(KSyncSock::kBufLen);
+    memset(large_msg, 0, KSyncSock::kBufLen);
+    sock_->FreeMsgBuffer(large_msg);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    LoggingInit();
+
+    TestKSyncSock::Init();
+    int ret = RUN_ALL_TESTS();
+    KSyncSock::Shutdown();
+    return ret;
+}
@@ -28,6 +28,30 @@ void Route::insert(const Path *ipath) {
     path_.push_back(*path);
 }
 
+//
+// Insert a path in front of the first path that it's better than, which is
+// where a stable sort of the list puts it. This avoids sorting all the paths
+// whenever a single path gets added.
+//
+void Route::insert(const Path *ipath, Compare compare) {
+    Path *path = const_cast<Path *> (ipath);
+    const Path *prev_front = front();
+
+    path->set_time_stamp_usecs(UTCTimestampUsec());
+    PathList::iterator it = path_.begin();
+    while (it != path_.end() && !compare(*path, *it))
+        ++it;
+    path_.insert(it, *path);
+#ifndef NDEBUG
+    assert(IsSorted(compare));
+#endif
+
+    // If the best path changes, update route's time stamp.
+    if (prev_front != front()) {
+        set_last_change_at_to_now();
+    }
+}
+
 // Remove a path
 void Route::remove(const Path *ipath) {
     Path *path = const_cast<Path *> (ipath);
@@ -45,3 +69,14 @@ void Route::Sort(Compare compare, const Path *prev_front) {
         set_last_change_at_to_now();
     }
 }
+
+bool Route::IsSorted(Compare compare) const {
+    PathList::const_iterator it = path_.begin();
+    if (it == path_.end())
+        return true;
+    for (PathList::const_iterator next = it; ++next != path_.end(); ++it) {
+        if (compare(*next, *it))
+            return false;
+    }
+    return true;
+}
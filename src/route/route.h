@@ -37,12 +37,25 @@ public:
     // Insert a path
     void insert(const Path *path);
 
+    // Insert a path at its position as per the compare function.
+    //
+    // The path list must already be sorted as per the same function. This
+    // holds as long as paths are only added with this method and removed,
+    // since removing a path doesn't change the order of the others. Code
+    // that changes paths in place in a way that can affect their order must
+    // call Sort afterwards.
+    void insert(const Path *path, Compare compare);
+
     // Remove a path
     void remove(const Path *path);
 
     // Sort paths based on compare function.
     void Sort(Compare compare, const Path *prev_front);
 
+    // Return true if no path is better than the one in front of it as per
+    // the compare function.
+    bool IsSorted(Compare compare) const;
+
     const PathList &GetPathList() const {
         return path_;
     }
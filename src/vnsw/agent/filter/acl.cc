@@ -116,6 +116,7 @@ DBEntry *AclTable::OperDBAdd(const DBRequest *req) {
          ++it) {
         acl->AddAclEntry(*it, acl->acl_entries_);
     }
+    acl->BuildClassifier();
 
     AclSandeshData sandesh_data;
     acl->SetAclSandeshData(sandesh_data);
@@ -163,6 +164,9 @@ bool AclTable::OperDBOnChange(DBEntry *entry, const DBRequest *req) {
             }
         }
     }
+    if (data->ace_add && changed) {
+        acl->BuildClassifier();
+    }
 
     // Replace the existing aces, ace_add is to add to the existing
     // entries
@@ -646,6 +650,17 @@ void AclDBEntry::SetAclEntries(AclEntries &entries)
         entries.erase(tmp);
         acl_entries_.insert(acl_entries_.end(), *ae);
     }
+    BuildClassifier();
+}
+
+void AclDBEntry::BuildClassifier() {
+    std::vector<const AclEntry *> rules;
+    rules.reserve(acl_entries_.size());
+    for (AclEntries::const_iterator it = acl_entries_.begin();
+         it != acl_entries_.end(); ++it) {
+        rules.push_back(it.operator->());
+    }
+    classifier_.Build(rules);
 }
 
 bool AclDBEntry::IsQosConfigResolved() {
@@ -726,6 +741,12 @@ bool AclDBEntry::DeleteAclEntry(const uint32_t acl_entry_id)
         if (ace_id == iter->id()) {
             AclEntry *ae = iter.operator->();
             acl_entries_.erase(acl_entries_.iterator_to(*iter));
+            // Clear the rule in the classifier rather than rebuilding it,
+            // unless most of the rules it holds have been removed
+            if (!classifier_.Remove(ae) ||
+                classifier_.removed_count() > classifier_.size()) {
+                BuildClassifier();
+            }
             ACL_TRACE(Info, "acl entry " + integerToString(acl_entry_id) + " deleted");
             delete ae;
             return true;
@@ -737,6 +758,7 @@ bool AclDBEntry::DeleteAclEntry(const uint32_t acl_entry_id)
 
 void AclDBEntry::DeleteAllAclEntries()
 {
+    classifier_.Clear();
     AclEntries::iterator iter;
     iter = acl_entries_.begin();
     while (iter != acl_entries_.end()) {
@@ -750,7 +772,6 @@ void AclDBEntry::DeleteAllAclEntries()
 bool AclDBEntry::PacketMatch(const PacketHeader &packet_header, 
 			                 MatchAclParams &m_acl, FlowPolicyInfo *info) const
 {
-    AclEntries::const_iterator iter;
     bool ret_val = false;
     m_acl.terminal_rule = false;
 	m_acl.action_info.action = 0;
@@ -759,10 +780,16 @@ bool AclDBEntry::PacketMatch(const PacketHeader &packet_header,
         info->acl_name = GetName();
     }
 
-    for (iter = acl_entries_.begin();
-         iter != acl_entries_.end();
-         ++iter) {
-        const AclEntry::ActionList &al = iter->PacketMatch(packet_header, info);
+    // Only the rules picked by the classifier can match, evaluate them in
+    // order
+    AclClassifier::RuleSet candidates;
+    classifier_.Lookup(packet_header, info != NULL, &candidates);
+    for (size_t idx = candidates.find_first();
+         idx != AclClassifier::RuleSet::npos;
+         idx = candidates.find_next(idx)) {
+        const AclEntry *entry = classifier_.rule(idx);
+        const AclEntry::ActionList &al =
+            entry->PacketMatch(packet_header, info);
 	AclEntry::ActionList::const_iterator al_it;
 	for (al_it = al.begin(); al_it != al.end(); ++al_it) {
 	     TrafficAction *ta = static_cast<TrafficAction *>(*al_it.operator->());
@@ -802,21 +829,21 @@ bool AclDBEntry::PacketMatch(const PacketHeader &packet_header,
                  info->drop = true;
                  info->terminal = false;
                  info->other = false;
-                 info->uuid = iter->uuid();
+                 info->uuid = entry->uuid();
              }
          }
 	}
         if (!(al.empty())) {
             ret_val = true;
-            m_acl.ace_id_list.push_back(iter->id());
-            if (iter->IsTerminal()) {
+            m_acl.ace_id_list.push_back(entry->id());
+            if (entry->IsTerminal()) {
                 m_acl.terminal_rule = true;
                 /* Set uuid only if it is NOT already set as
                  * drop/terminal uuid */
                 if (info && !info->drop && !info->terminal) {
                     info->terminal = true;
                     info->other = false;
-                    info->uuid = iter->uuid();
+                    info->uuid = entry->uuid();
                 }
                 return ret_val;
             }
@@ -824,7 +851,7 @@ bool AclDBEntry::PacketMatch(const PacketHeader &packet_header,
              * then set the uuid with the first matching uuid */
             if (info && !info->drop && !info->terminal && !info->other) {
                 info->other = true;
-                info->uuid = iter->uuid();
+                info->uuid = entry->uuid();
             }
         }
     }
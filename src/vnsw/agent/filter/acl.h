@@ -15,6 +15,7 @@
 #include <filter/acl_entry_match.h>
 #include <filter/acl_entry_spec.h>
 #include <filter/acl_entry.h>
+#include <filter/acl_classifier.h>
 
 struct FlowKey;
 
@@ -136,12 +137,18 @@ public:
     bool IsQosConfigResolved();
     bool Isresolved();
     const AclEntry* GetAclEntryAtIndex(uint32_t) const;
+    const AclClassifier &classifier() const { return classifier_; }
 private:
     friend class AclTable;
+    // Compile acl_entries_ into classifier_, called when they are added or
+    // replaced. DeleteAclEntry only removes the rule from classifier_.
+    void BuildClassifier();
+
     uuid uuid_;
     bool dynamic_acl_;
     std::string name_;
     AclEntries acl_entries_;
+    AclClassifier classifier_;
     DISALLOW_COPY_AND_ASSIGN(AclDBEntry);
 };
 
@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <netinet/in.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <filter/acl_classifier.h>
+#include <filter/acl_entry.h>
+#include <filter/acl_entry_match.h>
+#include <filter/packet_header.h>
+
+AclClassifier::AclClassifier() : removed_count_(0) {
+    Clear();
+}
+
+AclClassifier::~AclClassifier() {
+}
+
+void AclClassifier::Clear() {
+    Build(std::vector<const AclEntry *>());
+}
+
+namespace {
+
+// A range of a rule starts or stops covering values at point
+struct RangeEdge {
+    RangeEdge(uint32_t edge_point, size_t edge_list, bool edge_start) :
+        point(edge_point), list(edge_list), start(edge_start) { }
+    bool operator<(const RangeEdge &rhs) const { return point < rhs.point; }
+    uint32_t point;
+    size_t list;
+    bool start;
+};
+
+}  // namespace
+
+// Sweeps the range edges in order of value. Each range list of a rule
+// counts the ranges that cover the current value, and each rule counts its
+// range lists that cover it. A rule's bit is toggled when that count reaches
+// or leaves the number of range lists of the rule, so every edge costs
+// constant time and the bitmap is copied once per interval.
+void AclClassifier::Field::Build(const std::vector<FieldRule> &field_rules) {
+    RuleSet rule_set(field_rules.size());
+    std::vector<size_t> list_rule;
+    std::vector<RangeEdge> edges;
+    for (size_t idx = 0; idx < field_rules.size(); ++idx) {
+        const FieldRule &rule = field_rules[idx];
+        // A rule without constraints accepts every value
+        if (rule.empty())
+            rule_set.set(idx);
+        for (FieldRule::const_iterator it = rule.begin(); it != rule.end();
+             ++it) {
+            for (RangeList::const_iterator range = it->begin();
+                 range != it->end(); ++range) {
+                if (range->min > range->max)
+                    continue;
+                edges.push_back(RangeEdge(range->min, list_rule.size(),
+                                          true));
+                edges.push_back(RangeEdge(range->max + 1, list_rule.size(),
+                                          false));
+            }
+            list_rule.push_back(idx);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    std::vector<uint32_t> list_cover(list_rule.size(), 0);
+    std::vector<size_t> rule_cover(field_rules.size(), 0);
+    start.clear();
+    rules.clear();
+
+    // Intervals with the same rules as the previous one are merged into it
+    std::vector<RangeEdge>::const_iterator edge = edges.begin();
+    uint32_t point = 0;
+    while (true) {
+        for (; edge != edges.end() && edge->point == point; ++edge) {
+            size_t idx = list_rule[edge->list];
+            size_t list_count = field_rules[idx].size();
+            if (edge->start) {
+                if (list_cover[edge->list]++ == 0 &&
+                    ++rule_cover[idx] == list_count) {
+                    rule_set.set(idx);
+                }
+            } else {
+                if (--list_cover[edge->list] == 0 &&
+                    rule_cover[idx]-- == list_count) {
+                    rule_set.reset(idx);
+                }
+            }
+        }
+        if (rules.empty() || rules.back() != rule_set) {
+            start.push_back(point);
+            rules.push_back(rule_set);
+        }
+        if (edge == edges.end())
+            break;
+        point = edge->point;
+    }
+}
+
+void AclClassifier::Field::Remove(size_t index) {
+    for (std::vector<RuleSet>::iterator it = rules.begin(); it != rules.end();
+         ++it) {
+        it->reset(index);
+    }
+}
+
+const AclClassifier::RuleSet &AclClassifier::Field::Find(
+    uint32_t value) const {
+    std::vector<uint32_t>::const_iterator it =
+        std::upper_bound(start.begin(), start.end(), value);
+    return rules[it - start.begin() - 1];
+}
+
+void AclClassifier::AddRanges(const RangeSList &ranges, RangeList *list) {
+    for (RangeSList::const_iterator it = ranges.begin(); it != ranges.end();
+         ++it) {
+        list->push_back(ValueRange(it->min, it->max));
+    }
+}
+
+void AclClassifier::AddRule(size_t index, const AclEntry *entry,
+                            std::vector<FieldRule> *field_rules) {
+    const std::vector<AclEntryMatch *> &matches = entry->matches();
+    for (std::vector<AclEntryMatch *>::const_iterator it = matches.begin();
+         it != matches.end(); ++it) {
+        const AclEntryMatch *match = *it;
+        FieldType field = FIELD_COUNT;
+        RangeList list;
+
+        switch (match->type()) {
+        case AclEntryMatch::PROTOCOL_MATCH:
+            field = PROTOCOL;
+            AddRanges(static_cast<const ProtocolMatch *>(match)->
+                      protocol_ranges(), &list);
+            break;
+        case AclEntryMatch::SOURCE_PORT_MATCH:
+            field = SRC_PORT;
+            AddRanges(static_cast<const PortMatch *>(match)->port_ranges(),
+                      &list);
+            break;
+        case AclEntryMatch::DESTINATION_PORT_MATCH:
+            field = DST_PORT;
+            AddRanges(static_cast<const PortMatch *>(match)->port_ranges(),
+                      &list);
+            break;
+        case AclEntryMatch::SERVICE_GROUP_MATCH: {
+            field = PROTOCOL;
+            const ServiceGroupMatch::ServicePortList &service_port_list =
+                static_cast<const ServiceGroupMatch *>(match)->
+                service_port_list();
+            for (ServiceGroupMatch::ServicePortList::const_iterator port =
+                 service_port_list.begin(); port != service_port_list.end();
+                 ++port) {
+                list.push_back(ValueRange(port->protocol.min,
+                                          port->protocol.max));
+            }
+            break;
+        }
+        case AclEntryMatch::ADDRESS_MATCH:
+            if (static_cast<const AddressMatch *>(match)->addr_type() ==
+                AddressMatch::NETWORK_ID) {
+                policy_info_rules_.set(index);
+            }
+            break;
+        default:
+            break;
+        }
+
+        if (field != FIELD_COUNT)
+            field_rules[field][index].push_back(list);
+    }
+}
+
+void AclClassifier::Build(const std::vector<const AclEntry *> &rules) {
+    rules_ = rules;
+    removed_count_ = 0;
+    policy_info_rules_.clear();
+    policy_info_rules_.resize(rules_.size());
+
+    std::vector<FieldRule> field_rules[FIELD_COUNT];
+    for (int field = 0; field < FIELD_COUNT; ++field) {
+        field_rules[field].resize(rules_.size());
+    }
+    for (size_t idx = 0; idx < rules_.size(); ++idx) {
+        AddRule(idx, rules_[idx], field_rules);
+    }
+    for (int field = 0; field < FIELD_COUNT; ++field) {
+        fields_[field].Build(field_rules[field]);
+    }
+}
+
+bool AclClassifier::Remove(const AclEntry *entry) {
+    std::vector<const AclEntry *>::iterator it =
+        std::find(rules_.begin(), rules_.end(), entry);
+    if (it == rules_.end())
+        return false;
+
+    size_t index = it - rules_.begin();
+    *it = NULL;
+    removed_count_++;
+    for (int field = 0; field < FIELD_COUNT; ++field) {
+        fields_[field].Remove(index);
+    }
+    policy_info_rules_.reset(index);
+    return true;
+}
+
+void AclClassifier::Lookup(const PacketHeader &packet_header,
+                           bool policy_info, RuleSet *candidates) const {
+    *candidates = fields_[PROTOCOL].Find(packet_header.protocol);
+    if (packet_header.protocol == IPPROTO_TCP ||
+        packet_header.protocol == IPPROTO_UDP) {
+        *candidates &= fields_[SRC_PORT].Find(packet_header.src_port);
+        *candidates &= fields_[DST_PORT].Find(packet_header.dst_port);
+    }
+    if (policy_info)
+        *candidates |= policy_info_rules_;
+}
+
+size_t AclClassifier::interval_count() const {
+    size_t count = 0;
+    for (int field = 0; field < FIELD_COUNT; ++field) {
+        count += fields_[field].start.size();
+    }
+    return count;
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef __AGENT_ACL_CLASSIFIER_H__
+#define __AGENT_ACL_CLASSIFIER_H__
+
+#include <vector>
+#include <boost/dynamic_bitset.hpp>
+
+#include <base/util.h>
+#include <filter/acl_entry_match.h>
+
+class AclEntry;
+struct PacketHeader;
+
+/////////////////////////////////////////////////////////////////////////////
+// Compiled form of the rules of an AclDBEntry. It is used to skip the rules
+// that cannot match a packet without evaluating their matches one by one.
+//
+// Every rule gets a bit. The protocol, source port and destination port
+// spaces are each split into intervals. Within an interval the set of rules
+// that accept the value does not change, and the interval keeps a bitmap of
+// those rules. Lookup finds the interval of each field with a binary search
+// and ANDs the bitmaps. The remaining rules are then evaluated in order with
+// AclEntry::PacketMatch, so the result is the same as evaluating every rule.
+//
+// Like SrcPortMatch and DstPortMatch, the port fields apply only to TCP and
+// UDP packets. ServiceGroupMatch only contributes its protocols.
+//
+// An AddressMatch on a network id updates the FlowPolicyInfo even when a
+// later match of the rule fails. Rules with such a match are always
+// candidates when the caller passes a FlowPolicyInfo, so that the
+// FlowPolicyInfo ends up the same as with a full evaluation.
+//
+// The classifier is rebuilt by AclDBEntry when rules are added or replaced.
+// Deleting a single rule only clears its bit in every interval, the rule
+// keeps its index until the next rebuild.
+/////////////////////////////////////////////////////////////////////////////
+class AclClassifier {
+public:
+    typedef boost::dynamic_bitset<> RuleSet;
+
+    AclClassifier();
+    ~AclClassifier();
+
+    // Rules in evaluation order
+    void Build(const std::vector<const AclEntry *> &rules);
+    void Clear();
+    // Clears the bit of the rule so that lookups never pick it. Returns
+    // false if the rule is not in the classifier.
+    bool Remove(const AclEntry *entry);
+
+    // Sets candidates to the rules that can match the packet
+    void Lookup(const PacketHeader &packet_header, bool policy_info,
+                RuleSet *candidates) const;
+
+    const AclEntry *rule(size_t index) const { return rules_[index]; }
+    // Number of rules, not counting the removed ones
+    size_t size() const { return rules_.size() - removed_count_; }
+    size_t removed_count() const { return removed_count_; }
+    // Number of intervals across all fields, for introspection and tests
+    size_t interval_count() const;
+
+private:
+    enum FieldType {
+        PROTOCOL,
+        SRC_PORT,
+        DST_PORT,
+        FIELD_COUNT
+    };
+
+    struct ValueRange {
+        ValueRange(uint32_t min_value, uint32_t max_value) :
+            min(min_value), max(max_value) { }
+        uint32_t min;
+        uint32_t max;
+    };
+    typedef std::vector<ValueRange> RangeList;
+
+    // Constraints of a rule on a field. The rule accepts a value if each of
+    // the range lists contains it.
+    typedef std::vector<RangeList> FieldRule;
+
+    struct Field {
+        void Build(const std::vector<FieldRule> &field_rules);
+        const RuleSet &Find(uint32_t value) const;
+        void Remove(size_t index);
+
+        // Start of each interval, the first one starts at 0
+        std::vector<uint32_t> start;
+        std::vector<RuleSet> rules;
+    };
+
+    static void AddRanges(const RangeSList &ranges, RangeList *list);
+    void AddRule(size_t index, const AclEntry *entry,
+                 std::vector<FieldRule> *field_rules);
+
+    std::vector<const AclEntry *> rules_;
+    size_t removed_count_;
+    Field fields_[FIELD_COUNT];
+    // Rules with matches that update the FlowPolicyInfo
+    RuleSet policy_info_rules_;
+
+    DISALLOW_COPY_AND_ASSIGN(AclClassifier);
+};
+
+#endif
@@ -128,6 +128,7 @@ public:
     const AclEntryMatch* Get(uint32_t index) const {
         return matches_[index];
     }
+    const std::vector<AclEntryMatch *> &matches() const { return matches_; }
 
 private:
     AclEntryID id_;
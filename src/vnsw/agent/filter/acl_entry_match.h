@@ -54,6 +54,7 @@ public:
         }
         return Compare(rhs);
     }
+    Type type() const { return type_; }
 private:
     Type type_;
 };
@@ -95,6 +96,7 @@ public:
     virtual bool Match(const PacketHeader *packet_header,
                        FlowPolicyInfo *info) const = 0;
     virtual bool Compare(const AclEntryMatch &rhs) const;
+    const RangeSList &port_ranges() const { return port_ranges_; }
 protected:
     RangeSList port_ranges_;
 };
@@ -123,6 +125,7 @@ public:
                FlowPolicyInfo *info) const;
     void SetAclEntryMatchSandeshData(AclEntrySandeshData &data);
     virtual bool Compare(const AclEntryMatch &rhs) const;
+    const RangeSList &protocol_ranges() const { return protocol_ranges_; }
 
 private:
     RangeSList protocol_ranges_;
@@ -164,6 +167,10 @@ public:
         return service_port_list_.size();
     }
 
+    const ServicePortList &service_port_list() const {
+        return service_port_list_;
+    }
+
 private:
     ServicePortList service_port_list_;
 };
@@ -240,6 +247,7 @@ public:
     size_t ip_list_size() const {
         return ip_list_.size();
     }
+    AddressType addr_type() const { return addr_type_; }
 private:
     AddressType addr_type_;
     bool src_;
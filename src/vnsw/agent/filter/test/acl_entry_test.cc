@@ -2,7 +2,14 @@
  * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
  */
 
+#include <netinet/in.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
 #include "base/logging.h"
+#include "base/time_util.h"
 #include "testing/gunit.h"
 
 #include "filter/acl_entry.h"
@@ -600,6 +607,219 @@ TEST_F(AclEntryTest, BasicIntrospecSgAclEntry) {
 }
 
 
+// Rule with the given protocol, destination port range and optional source
+// network, with a pass action
+static AclEntrySpec BuildAclEntrySpec(int id, int protocol, int port_min,
+                                      int port_max, const char *src_vn,
+                                      bool terminal) {
+    AclEntrySpec spec;
+    spec.id = id;
+    if (src_vn) {
+        spec.src_addr_type = AddressMatch::NETWORK_ID;
+        spec.src_policy_id_str = src_vn;
+    } else {
+        spec.BuildAddressInfo("10.0.0.0", 8, &spec.src_ip_list);
+        spec.src_addr_type = AddressMatch::IP_ADDR;
+    }
+    if (protocol >= 0) {
+        RangeSpec proto;
+        proto.min = protocol;
+        proto.max = protocol;
+        spec.protocol.push_back(proto);
+    }
+    if (port_min >= 0) {
+        RangeSpec port;
+        port.min = port_min;
+        port.max = port_max;
+        spec.dst_port.push_back(port);
+    }
+    spec.terminal = terminal;
+    ActionSpec action;
+    action.ta_type = TrafficAction::SIMPLE_ACTION;
+    action.simple_action = TrafficAction::PASS;
+    spec.action_l.push_back(action);
+    return spec;
+}
+
+static void SetAclEntries(AclDBEntry *acl,
+                          const std::vector<AclEntrySpec> &spec_list) {
+    AclDBEntry::AclEntries entries;
+    for (size_t i = 0; i < spec_list.size(); i++) {
+        acl->AddAclEntry(spec_list[i], entries);
+    }
+    acl->SetAclEntries(entries);
+}
+
+static std::vector<const AclEntry *> GetAclEntries(const AclDBEntry &acl) {
+    std::vector<const AclEntry *> rules;
+    for (uint32_t i = 0; i < acl.Size(); i++) {
+        rules.push_back(acl.GetAclEntryAtIndex(i));
+    }
+    return rules;
+}
+
+// Evaluates every rule in order, like AclDBEntry::PacketMatch did before it
+// used the classifier
+static void LinearMatch(const std::vector<const AclEntry *> &rules,
+                        const PacketHeader &hdr, FlowPolicyInfo *info,
+                        AclEntryIDList *id_list) {
+    for (size_t i = 0; i < rules.size(); i++) {
+        if (rules[i]->PacketMatch(hdr, info).empty())
+            continue;
+        id_list->push_back(rules[i]->id());
+        if (rules[i]->IsTerminal())
+            break;
+    }
+}
+
+// Checks that the classifier picks the same rules as evaluating all of them,
+// and leaves the same matched VN in the FlowPolicyInfo
+static void VerifyClassifier(const AclDBEntry &acl, const int *protocols) {
+    std::vector<const AclEntry *> rules = GetAclEntries(acl);
+    VnListType vn_list;
+    vn_list.insert("vn1");
+    for (int i = 0; i < 10000; i++) {
+        PacketHeader hdr;
+        hdr.src_ip = Ip4Address(0x0a000001);
+        hdr.dst_ip = Ip4Address(0x14000001);
+        hdr.src_policy_id = &vn_list;
+        hdr.src_sg_id_l = NULL;
+        hdr.dst_sg_id_l = NULL;
+        hdr.protocol = protocols[1 + rand() % 3];
+        hdr.src_port = rand() % 2100;
+        hdr.dst_port = rand() % 2100;
+
+        FlowPolicyInfo info("");
+        MatchAclParams m_acl;
+        acl.PacketMatch(hdr, m_acl, &info);
+        FlowPolicyInfo linear_info("");
+        AclEntryIDList id_list;
+        LinearMatch(rules, hdr, &linear_info, &id_list);
+        EXPECT_TRUE(m_acl.ace_id_list == id_list);
+        EXPECT_EQ(linear_info.src_match_vn, info.src_match_vn);
+
+        MatchAclParams m_acl_no_info;
+        acl.PacketMatch(hdr, m_acl_no_info, NULL);
+        EXPECT_TRUE(m_acl_no_info.ace_id_list == id_list);
+    }
+}
+
+TEST_F(AclEntryTest, Classifier) {
+    const int protocols[] = { -1, IPPROTO_ICMP, IPPROTO_TCP, IPPROTO_UDP };
+    const char *vns[] = { NULL, "vn1", "vn2" };
+    srand(1);
+
+    std::vector<AclEntrySpec> spec_list;
+    for (int id = 1; id <= 300; id++) {
+        int port_min = -1;
+        int port_max = -1;
+        if (rand() % 4) {
+            port_min = rand() % 2000;
+            port_max = port_min + rand() % 100;
+        }
+        spec_list.push_back(BuildAclEntrySpec(id, protocols[rand() % 4],
+                                              port_min, port_max,
+                                              vns[rand() % 3],
+                                              (rand() % 8) == 0));
+    }
+    AclDBEntry acl(boost::uuids::nil_uuid());
+    SetAclEntries(&acl, spec_list);
+    EXPECT_EQ(spec_list.size(), acl.classifier().size());
+    VerifyClassifier(acl, protocols);
+
+    // Removing a rule clears it in the classifier without a rebuild
+    acl.DeleteAclEntry(1);
+    acl.DeleteAclEntry(150);
+    EXPECT_EQ(spec_list.size() - 2, acl.classifier().size());
+    EXPECT_EQ(2U, acl.classifier().removed_count());
+    VerifyClassifier(acl, protocols);
+
+    // The classifier is rebuilt once most of its rules are removed
+    for (int id = 2; id <= 200; id++) {
+        acl.DeleteAclEntry(id);
+    }
+    EXPECT_EQ(100U, acl.classifier().size());
+    EXPECT_GT(acl.classifier().size(), acl.classifier().removed_count());
+    VerifyClassifier(acl, protocols);
+
+    acl.DeleteAllAclEntries();
+    EXPECT_EQ(0U, acl.classifier().size());
+}
+
+// Flows per second evaluated against ACLs of increasing size, with and
+// without the classifier. Rules are TCP with a destination port each, and
+// half of the flows match one of them. Also reports the time to build the
+// classifier for the rules and to delete a single rule.
+TEST_F(AclEntryTest, ClassifierBenchmark) {
+    const int kRuleCount[] = { 10, 100, 1000, 4000 };
+    const int kFlowCount = 20000;
+    srand(1);
+
+    for (size_t idx = 0; idx < sizeof(kRuleCount) / sizeof(int); idx++) {
+        int rule_count = kRuleCount[idx];
+        std::vector<AclEntrySpec> spec_list;
+        for (int id = 1; id <= rule_count; id++) {
+            spec_list.push_back(BuildAclEntrySpec(id, IPPROTO_TCP,
+                                                  1000 + id, 1000 + id,
+                                                  NULL, true));
+        }
+        AclDBEntry acl(boost::uuids::nil_uuid());
+        SetAclEntries(&acl, spec_list);
+        std::vector<const AclEntry *> rules = GetAclEntries(acl);
+
+        std::vector<PacketHeader> flows(kFlowCount);
+        for (int i = 0; i < kFlowCount; i++) {
+            flows[i].src_ip = Ip4Address(0x0a000001);
+            flows[i].src_sg_id_l = NULL;
+            flows[i].dst_sg_id_l = NULL;
+            flows[i].protocol = IPPROTO_TCP;
+            flows[i].src_port = 5000;
+            flows[i].dst_port = 1000 + rand() % (2 * rule_count);
+        }
+
+        uint64_t start = ClockMonotonicUsec();
+        size_t linear_matches = 0;
+        for (int i = 0; i < kFlowCount; i++) {
+            AclEntryIDList id_list;
+            LinearMatch(rules, flows[i], NULL, &id_list);
+            linear_matches += id_list.size();
+        }
+        uint64_t linear_time = ClockMonotonicUsec() - start + 1;
+
+        start = ClockMonotonicUsec();
+        size_t matches = 0;
+        for (int i = 0; i < kFlowCount; i++) {
+            MatchAclParams m_acl;
+            acl.PacketMatch(flows[i], m_acl, NULL);
+            matches += m_acl.ace_id_list.size();
+        }
+        uint64_t classifier_time = ClockMonotonicUsec() - start + 1;
+        EXPECT_EQ(linear_matches, matches);
+
+        AclClassifier classifier;
+        start = ClockMonotonicUsec();
+        classifier.Build(rules);
+        uint64_t build_time = ClockMonotonicUsec() - start;
+        EXPECT_EQ(acl.classifier().interval_count(),
+                  classifier.interval_count());
+
+        start = ClockMonotonicUsec();
+        acl.DeleteAclEntry(rule_count / 2);
+        uint64_t delete_time = ClockMonotonicUsec() - start;
+        EXPECT_EQ(1U, acl.classifier().removed_count());
+
+        std::cout << "Rules " << rule_count
+            << " intervals " << acl.classifier().interval_count()
+            << " linear " << kFlowCount * 1000000ULL / linear_time
+            << " flows/sec classifier "
+            << kFlowCount * 1000000ULL / classifier_time << " flows/sec"
+            << " build " << build_time << " usec"
+            << " delete " << delete_time << " usec"
+            << std::endl;
+        acl.DeleteAllAclEntries();
+    }
+}
+
 } // namespace
 
 int main (int argc, char **argv) {
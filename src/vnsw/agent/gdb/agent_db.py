@@ -66,13 +66,15 @@ def print_flow_entry(entry):
     print(str(entry))
 
 def print_flow_entry_map(flow_table):
+    """ Dumps flows in the open addressing FlowEntryMap, skipping empty slots """
     table_ptr = gdb.parse_and_eval('(FlowTable *)' + str(flow_table))
-    flow_map = StdMapPrinter('flow_entry_map_', table_ptr['flow_entry_map_'])
-    it = flow_map.children()
+    slots = StdVectorPrinter('slots_', table_ptr['flow_entry_map_']['slots_'])
+    it = slots.children()
     try:
-        while (it):
-            entry = next(it)[1]
-            print_flow_entry(entry)
+        while 1:
+            slot = next(it)[1]
+            if slot['flow'] != 0:
+                print_flow_entry(slot['flow'])
     except StopIteration:
         pass
 
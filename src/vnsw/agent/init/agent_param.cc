@@ -495,6 +495,8 @@ void AgentParam::ParseDefaultSectionArguments
                           "DEFAULT.pkt0_tx_buffers");
     GetOptValue<bool>(var_map, measure_queue_delay_,
                       "DEFAULT.measure_queue_delay");
+    GetOptValue<bool>(var_map, ksync_bulk_tx_mode_,
+                      "DEFAULT.ksync_bulk_tx_mode");
     GetOptValue<string>(var_map, tunnel_type_,
                         "DEFAULT.tunnel_type");
 }
@@ -1206,7 +1208,7 @@ AgentParam::AgentParam(bool enable_flow_options,
         enable_service_options_(enable_service_options),
         agent_mode_(agent_mode), gateway_mode_(NONE), vhost_(),
         pkt0_tx_buffer_count_(Agent::kPkt0TxBufferCount),
-        measure_queue_delay_(false),
+        measure_queue_delay_(false), ksync_bulk_tx_mode_(false),
         agent_name_(), eth_port_(),
         eth_port_no_arp_(false), eth_port_encap_type_(),
         dns_client_port_(0), dns_timeout_(3000),
@@ -1397,6 +1399,8 @@ AgentParam::AgentParam(bool enable_flow_options,
          "Simulate Evpn Tor")
         ("DEFAULT.measure_queue_delay", opt::bool_switch(&measure_queue_delay_),
           "Measure flow queue delay")
+        ("DEFAULT.ksync_bulk_tx_mode", opt::bool_switch(&ksync_bulk_tx_mode_),
+          "Send upto 128 KSync messages in one netlink message")
         ("NEXTHOP-SERVER.endpoint", opt::value<string>(),
          "Nexthop Server Endpoint")
         ("NEXTHOP-SERVER.add_pid", opt::bool_switch(&nexthop_server_add_pid_),
@@ -416,6 +416,7 @@ public:
     void set_pkt0_tx_buffer_count(uint32_t val) { pkt0_tx_buffer_count_ = val; }
     bool measure_queue_delay() const { return measure_queue_delay_; }
     void set_measure_queue_delay(bool val) { measure_queue_delay_ = val; }
+    bool ksync_bulk_tx_mode() const { return ksync_bulk_tx_mode_; }
     const std::set<uint16_t>& nic_queue_list() const {
         return nic_queue_list_;
     }
@@ -576,6 +577,7 @@ private:
     // Number of tx-buffers on pkt0 device
     uint32_t pkt0_tx_buffer_count_;
     bool measure_queue_delay_;
+    bool ksync_bulk_tx_mode_;
 
     std::string agent_name_;
     std::string eth_port_;
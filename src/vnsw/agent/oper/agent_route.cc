@@ -341,10 +341,15 @@ void AgentRouteTable::RemoveUnresolvedNH(const NextHop *nh) {
 // Re-evaluate all unresolved routes. Flush and enqueue RESYNC for all routes
 // in the unresolved route tree
 void AgentRouteTable::EvaluateUnresolvedRoutes(void) {
+    DBRequestList req_list;
     for (UnresolvedRouteTree::iterator it = unresolved_rt_tree_.begin();
          it !=  unresolved_rt_tree_.end(); ++it) {
-       (*it)->EnqueueRouteResync();
+        DBRequest *req = new DBRequest(DBRequest::DB_ENTRY_ADD_CHANGE);
+        (*it)->FillRouteResyncRequest(req);
+        req_list.push_back(req);
     }
+    agent_->fabric_inet4_unicast_table()->Enqueue(req_list);
+    STLDeleteValues(&req_list);
 
     unresolved_rt_tree_.clear();
 }
@@ -711,11 +716,16 @@ void AgentRoute::ResyncTunnelNextHop(void) {
     }
 }
 
+// Fill request to RESYNC a route
+void AgentRoute::FillRouteResyncRequest(DBRequest *req) const {
+    req->key = GetDBRequestKey();
+    (static_cast<AgentKey *>(req->key.get()))->sub_op_ = AgentKey::RESYNC;
+}
+
 // Enqueue request to RESYNC a route
 void AgentRoute::EnqueueRouteResync(void) const {
     DBRequest  req(DBRequest::DB_ENTRY_ADD_CHANGE);
-    req.key = GetDBRequestKey();
-    (static_cast<AgentKey *>(req.key.get()))->sub_op_ = AgentKey::RESYNC;
+    FillRouteResyncRequest(&req);
     Agent *agent = (static_cast<AgentRouteTable *>(get_table()))->agent();
     agent->fabric_inet4_unicast_table()->Enqueue(&req);
 }
@@ -725,11 +735,20 @@ void AgentRoute::EnqueueRouteResync(void) const {
 //changed we need to update the same in datapath for indirect
 //routes
 void AgentRoute::UpdateDependantRoutes(void) {
+    if (dependant_routes_.empty())
+        return;
+
+    DBRequestList req_list;
     for (AgentRoute::RouteDependencyList::iterator iter =
          dependant_routes_.begin(); iter != dependant_routes_.end(); iter++) {
         AgentRoute *rt = iter.operator->();
-        rt->EnqueueRouteResync();
+        DBRequest *req = new DBRequest(DBRequest::DB_ENTRY_ADD_CHANGE);
+        rt->FillRouteResyncRequest(req);
+        req_list.push_back(req);
     }
+    Agent *agent = (static_cast<AgentRouteTable *>(get_table()))->agent();
+    agent->fabric_inet4_unicast_table()->Enqueue(req_list);
+    STLDeleteValues(&req_list);
 }
 
 bool AgentRoute::HasUnresolvedPath(void) {
@@ -279,6 +279,7 @@ public:
     bool IsRPFInvalid() const;
 
     void EnqueueRouteResync() const;
+    void FillRouteResyncRequest(DBRequest *req) const;
     void ResyncTunnelNextHop();
     bool HasUnresolvedPath();
     bool Sync(void);
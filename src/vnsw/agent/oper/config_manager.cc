@@ -129,17 +129,18 @@ public:
 
     uint32_t Process(uint32_t weight) {
         uint32_t count = 0;
+        DBRequestList req_list;
         NodeListIterator it = list_.begin();
         while (weight && (it != list_.end())) {
             NodeListIterator prev = it++;
             IFMapNodeState *state = prev->state_.get();
             IFMapNode *node = state->node();
 
-            DBRequest req;
             boost::uuids::uuid id = state->uuid();
             if (table_) {
-                if (table_->ProcessConfig(node, req, id)) {
-                    table_->Enqueue(&req);
+                std::auto_ptr<DBRequest> req(new DBRequest());
+                if (table_->ProcessConfig(node, *req, id)) {
+                    req_list.push_back(req.release());
                 }
             }
 
@@ -153,6 +154,10 @@ public:
             process_count_++;
         }
 
+        if (!req_list.empty()) {
+            table_->Enqueue(req_list);
+            STLDeleteValues(&req_list);
+        }
         return count;
     }
 
@@ -2,10 +2,12 @@
  * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
  */
 
+#include <algorithm>
 #include <vector>
 #include <bitset>
 
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/functional/hash.hpp>
 #include <boost/assign/list_of.hpp>
 #include <boost/unordered_map.hpp>
 #include <sandesh/sandesh_trace.h>
@@ -125,14 +127,12 @@ void FlowTable::GetMutexSeq(tbb::mutex &mutex1, tbb::mutex &mutex2,
 
 FlowEntry *FlowTable::Find(const FlowKey &key) {
     assert(ConcurrencyCheck(flow_task_id_) == true);
-    FlowEntryMap::iterator it;
+    return flow_entry_map_.Find(key);
+}
 
-    it = flow_entry_map_.find(key);
-    if (it != flow_entry_map_.end()) {
-        return it->second;
-    } else {
-        return NULL;
-    }
+void FlowTable::GetNextFlows(const FlowKey &key, size_t count,
+                             std::vector<FlowEntry *> *list) {
+    flow_entry_map_.GetNext(key, count, list);
 }
 
 void FlowTable::Copy(FlowEntry *lhs, FlowEntry *rhs, bool update) {
@@ -145,15 +145,12 @@ void FlowTable::Copy(FlowEntry *lhs, FlowEntry *rhs, bool update) {
 
 FlowEntry *FlowTable::Locate(FlowEntry *flow, uint64_t time) {
     assert(ConcurrencyCheck(flow_task_id_) == true);
-    std::pair<FlowEntryMap::iterator, bool> ret;
-    ret = flow_entry_map_.insert(FlowEntryMapPair(flow->key(), flow));
-    if (ret.second == true) {
+    FlowEntry *ret = flow_entry_map_.Insert(flow);
+    if (ret == flow) {
         agent_->stats()->incr_flow_created();
-        ret.first->second->set_on_tree();
-        return flow;
+        flow->set_on_tree();
     }
-
-    return ret.first->second;
+    return ret;
 }
 
 void FlowTable::Add(FlowEntry *flow, FlowEntry *rflow) {
@@ -402,18 +399,21 @@ bool FlowTable::Delete(const FlowKey &key, bool del_reverse_flow) {
     return DeleteUnLocked(del_reverse_flow, flow, rflow);
 }
 
+// Deleting a flow can remove it from the map. Walk a snapshot of the flows
+// and hold references till done.
 void FlowTable::DeleteAll() {
-    FlowEntryMap::iterator it;
-
-    it = flow_entry_map_.begin();
-    while (it != flow_entry_map_.end()) {
-        FlowEntry *entry = it->second;
-        FlowEntry *reverse_entry = NULL;
-        ++it;
-        if (it != flow_entry_map_.end() &&
-            it->second == entry->reverse_flow_entry()) {
-            reverse_entry = it->second;
-            ++it;
+    std::vector<FlowEntry *> list;
+    flow_entry_map_.GetAll(&list);
+    std::vector<FlowEntryPtr> flow_list(list.begin(), list.end());
+
+    for (std::vector<FlowEntryPtr>::iterator it = flow_list.begin();
+         it != flow_list.end(); ++it) {
+        FlowEntry *entry = it->get();
+        FlowEntry *reverse_entry = entry->reverse_flow_entry();
+        if (reverse_entry == entry ||
+            (reverse_entry &&
+             flow_entry_map_.Find(reverse_entry->key()) != reverse_entry)) {
+            reverse_entry = NULL;
         }
         FLOW_LOCK(entry, reverse_entry, FlowEvent::DELETE_FLOW);
         DeleteUnLocked(true, entry, reverse_entry);
@@ -827,6 +827,174 @@ bool FlowTable::ProcessFlowEvent(const FlowEvent *req, FlowEntry *flow,
     return true;
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// FlowEntryMap implementation
+/////////////////////////////////////////////////////////////////////////////
+const size_t FlowEntryMap::kInitSize;
+const size_t FlowEntryMap::kMaxLoadPercent;
+
+static bool FlowKeyLess(const FlowKey &lhs, const FlowKey &rhs) {
+    return lhs.IsLess(rhs);
+}
+
+FlowEntryMap::FlowEntryMap() : slots_(kInitSize) {
+    size_ = 0;
+}
+
+FlowEntryMap::~FlowEntryMap() {
+}
+
+static void HashAddress(size_t *seed, const IpAddress &addr) {
+    if (addr.is_v4()) {
+        boost::hash_combine(*seed, addr.to_v4().to_ulong());
+    } else {
+        const Ip6Address::bytes_type bytes = addr.to_v6().to_bytes();
+        boost::hash_range(*seed, bytes.begin(), bytes.end());
+    }
+}
+
+size_t FlowEntryMap::Hash(const FlowKey &key) {
+    size_t seed = 0;
+    boost::hash_combine(seed, static_cast<int>(key.family));
+    boost::hash_combine(seed, key.nh);
+    HashAddress(&seed, key.src_addr);
+    HashAddress(&seed, key.dst_addr);
+    boost::hash_combine(seed, key.protocol);
+    boost::hash_combine(seed, key.src_port);
+    boost::hash_combine(seed, key.dst_port);
+
+    // boost hashes integers to themselves. Mix the bits so that the low
+    // order bits used to pick the slot depend on all the fields.
+    uint64_t hash = seed;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return static_cast<size_t>(hash);
+}
+
+// Returns the slot with the key, or the empty slot that ends its probe
+// sequence.
+size_t FlowEntryMap::FindSlot(const FlowKey &key, size_t hash) const {
+    size_t mask = slots_.size() - 1;
+    size_t idx = hash & mask;
+    while (slots_[idx].flow != NULL) {
+        if (slots_[idx].hash == hash && slots_[idx].flow->key().IsEqual(key))
+            break;
+        idx = (idx + 1) & mask;
+    }
+    return idx;
+}
+
+size_t FlowEntryMap::FindFreeSlot(const SlotList &slots, size_t hash) const {
+    size_t mask = slots.size() - 1;
+    size_t idx = hash & mask;
+    while (slots[idx].flow != NULL) {
+        idx = (idx + 1) & mask;
+    }
+    return idx;
+}
+
+void FlowEntryMap::Resize(size_t capacity) {
+    SlotList slots(capacity);
+    for (SlotList::const_iterator it = slots_.begin(); it != slots_.end();
+         ++it) {
+        if (it->flow != NULL)
+            slots[FindFreeSlot(slots, it->hash)] = *it;
+    }
+    slots_.swap(slots);
+}
+
+FlowEntry *FlowEntryMap::Find(const FlowKey &key) const {
+    return slots_[FindSlot(key, Hash(key))].flow;
+}
+
+FlowEntry *FlowEntryMap::Insert(FlowEntry *flow) {
+    size_t hash = Hash(flow->key());
+    size_t idx = FindSlot(flow->key(), hash);
+    if (slots_[idx].flow != NULL)
+        return slots_[idx].flow;
+
+    if ((size_ + 1) * 100 > slots_.size() * kMaxLoadPercent) {
+        Resize(slots_.size() * 2);
+        idx = FindFreeSlot(slots_, hash);
+    }
+    slots_[idx].flow = flow;
+    slots_[idx].hash = hash;
+    size_++;
+    return flow;
+}
+
+bool FlowEntryMap::Erase(const FlowKey &key) {
+    size_t mask = slots_.size() - 1;
+    size_t hole = FindSlot(key, Hash(key));
+    if (slots_[hole].flow == NULL)
+        return false;
+
+    // Move back the entries following the hole in the probe sequence,
+    // unless their home slot lies between the hole and their current slot.
+    for (size_t idx = (hole + 1) & mask; slots_[idx].flow != NULL;
+         idx = (idx + 1) & mask) {
+        size_t home = slots_[idx].hash & mask;
+        if (((idx - home) & mask) >= ((idx - hole) & mask)) {
+            slots_[hole] = slots_[idx];
+            hole = idx;
+        }
+    }
+    slots_[hole] = Slot();
+    size_--;
+    return true;
+}
+
+// Takes a sorted snapshot of the keys when the key is before all keys in the
+// current snapshot, i.e. when a walk starts from the beginning, or when there
+// is none. The snapshot is shared by all walks. Any sorted snapshot gives the
+// right next flows, it only decides which of the flows added during a walk
+// get returned.
+void FlowEntryMap::GetNext(const FlowKey &key, size_t count,
+                           std::vector<FlowEntry *> *list) {
+    if (count == 0)
+        return;
+
+    std::vector<FlowKey>::const_iterator it =
+        std::upper_bound(walk_key_list_.begin(), walk_key_list_.end(), key,
+                         FlowKeyLess);
+    if (it == walk_key_list_.begin()) {
+        walk_key_list_.clear();
+        walk_key_list_.reserve(size_);
+        for (SlotList::const_iterator slot = slots_.begin();
+             slot != slots_.end(); ++slot) {
+            if (slot->flow != NULL)
+                walk_key_list_.push_back(slot->flow->key());
+        }
+        std::sort(walk_key_list_.begin(), walk_key_list_.end(), FlowKeyLess);
+        it = std::upper_bound(walk_key_list_.begin(), walk_key_list_.end(),
+                              key, FlowKeyLess);
+    }
+
+    size_t added = 0;
+    for (; it != walk_key_list_.end() && added < count; ++it) {
+        FlowEntry *flow = Find(*it);
+        if (flow == NULL)
+            continue;
+        list->push_back(flow);
+        added++;
+    }
+
+    if (it == walk_key_list_.end())
+        std::vector<FlowKey>().swap(walk_key_list_);
+}
+
+void FlowEntryMap::GetAll(std::vector<FlowEntry *> *list) const {
+    list->reserve(list->size() + size_);
+    for (SlotList::const_iterator it = slots_.begin(); it != slots_.end();
+         ++it) {
+        if (it->flow != NULL)
+            list->push_back(it->flow);
+    }
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // FlowEntryFreeList implementation
 /////////////////////////////////////////////////////////////////////////////
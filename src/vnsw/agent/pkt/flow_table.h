@@ -6,6 +6,7 @@
 #define __AGENT_FLOW_TABLE_H__
 
 #include <map>
+#include <vector>
 #if defined(__GNUC__)
 #include "base/compiler.h"
 #if __GNUC_PREREQ(4, 5)
@@ -119,13 +120,83 @@ private:
     DISALLOW_COPY_AND_ASSIGN(FlowEntryFreeList);
 };
 
+/////////////////////////////////////////////////////////////////////////////
+// Hash index of the flows in a FlowTable, keyed on the FlowKey.
+//
+// Open addressing with linear probing over a power of two sized array of
+// slots. A slot keeps the hash of the key next to the FlowEntry pointer, so
+// a probe dereferences the flow only on a hash match and a lookup usually
+// touches a single cache line besides the matching flow. Erase shifts the
+// rest of the probe sequence back instead of leaving tombstones, so lookups
+// don't get slower as flows churn. The array doubles when it gets more than
+// kMaxLoadPercent full and is not shrunk.
+//
+// Flows are not kept in key order, which keeps the flow setup path free of
+// tree rebalancing and node allocation. Introspect, which pages through the
+// flows in key order, uses GetNext to get the batch of flows following a
+// key. GetNext pages from a sorted snapshot of the keys, taken when a walk
+// starts from the beginning. Each page is a binary search in the snapshot
+// plus a lookup per flow, instead of a pass over all slots. Flows deleted
+// since the snapshot are skipped, and flows added since are not returned
+// till the next walk. The snapshot is dropped when a walk reaches its end.
+//
+// The map is modified only from the FlowEvent task of the FlowTable. Other
+// readers must be mutually exclusive with it through the task policy, like
+// with the std::map it replaces. Only size() can be read from any task.
+/////////////////////////////////////////////////////////////////////////////
+class FlowEntryMap {
+public:
+    static const size_t kInitSize = 1024;
+    static const size_t kMaxLoadPercent = 70;
+
+    FlowEntryMap();
+    ~FlowEntryMap();
+
+    FlowEntry *Find(const FlowKey &key) const;
+    // Adds the flow unless there is a flow with the same key already.
+    // Returns the flow in the map.
+    FlowEntry *Insert(FlowEntry *flow);
+    bool Erase(const FlowKey &key);
+
+    // Appends up to count flows with key greater than the given key to the
+    // list, in key order.
+    void GetNext(const FlowKey &key, size_t count,
+                 std::vector<FlowEntry *> *list);
+    // Appends all flows to the list, in no particular order.
+    void GetAll(std::vector<FlowEntry *> *list) const;
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return slots_.size(); }
+    size_t walk_key_count() const { return walk_key_list_.size(); }
+
+    static size_t Hash(const FlowKey &key);
+
+private:
+    struct Slot {
+        Slot() : flow(NULL), hash(0) { }
+        FlowEntry *flow;
+        size_t hash;
+    };
+    typedef std::vector<Slot> SlotList;
+
+    size_t FindSlot(const FlowKey &key, size_t hash) const;
+    size_t FindFreeSlot(const SlotList &slots, size_t hash) const;
+    void Resize(size_t capacity);
+
+    SlotList slots_;
+    tbb::atomic<size_t> size_;
+    // Sorted snapshot of the keys for GetNext
+    std::vector<FlowKey> walk_key_list_;
+    DISALLOW_COPY_AND_ASSIGN(FlowEntryMap);
+};
+
 /////////////////////////////////////////////////////////////////////////////
 // Flow addition is a two step process.
 // - FlowHandler :
 //   Flow is created in this context (file pkt_flow_info.cc).
 //   There can potentially be multiple FlowHandler task running in parallel
 // - FlowTable :
-//   This module will maintain a tree of all flows created. It is also
+//   This module will maintain a hash map of all flows created. It is also
 //   responsible to generate KSync events. It is run in a single task context
 //
 //   Functionality of FlowTable:
@@ -140,20 +211,11 @@ struct FlowTaskMsg : public InterTaskMsg {
     FlowEntryPtr fe_ptr;
 };
 
-struct Inet4FlowKeyCmp {
-    bool operator()(const FlowKey &lhs, const FlowKey &rhs) const {
-        const FlowKey &lhs_base = static_cast<const FlowKey &>(lhs);
-        return lhs_base.IsLess(rhs);
-    }
-};
-
 class FlowTable {
 public:
     static const uint32_t kPortNatFlowTableInstance = 0;
     static const uint32_t kInvalidFlowTableInstance = 0xFF;
 
-    typedef std::map<FlowKey, FlowEntry *, Inet4FlowKeyCmp> FlowEntryMap;
-    typedef std::pair<FlowKey, FlowEntry *> FlowEntryMapPair;
     typedef boost::function<bool(FlowEntry *flow)> FlowEntryCb;
     typedef std::vector<FlowEntryPtr> FlowIndexTree;
 
@@ -195,12 +257,10 @@ public:
     Agent *agent() const { return agent_; }
     uint16_t table_index() const { return table_index_; }
     size_t Size() { return flow_entry_map_.size(); }
-    FlowTable::FlowEntryMap::iterator begin() {
-        return flow_entry_map_.begin();
-    }
-    FlowTable::FlowEntryMap::iterator end() {
-        return flow_entry_map_.end(); 
-    }
+    // Flows following the key, in key order. Used by introspect to page
+    // through the flows
+    void GetNextFlows(const FlowKey &key, size_t count,
+                      std::vector<FlowEntry *> *list);
 
     const LinkLocalFlowInfoMap &linklocal_flow_info_map() {
         return linklocal_flow_info_map_;
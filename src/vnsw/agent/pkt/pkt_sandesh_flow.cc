@@ -309,7 +309,6 @@ bool PktSandeshFlow::SetFlowKey(string key) {
 }
 
 bool PktSandeshFlow::Run() {
-    FlowTable::FlowEntryMap::iterator it;
     std::vector<SandeshFlowData>& list =
         const_cast<std::vector<SandeshFlowData>&>(resp_obj_->get_flow_list());
     int count = 0;
@@ -332,54 +331,46 @@ bool PktSandeshFlow::Run() {
         return true;
     }
 
-    if (key_valid_)  {
-        it = flow_obj->flow_entry_map_.upper_bound(flow_iteration_key_);
-    } else {
+    if (!key_valid_)  {
          FlowErrorResp *resp = new FlowErrorResp();
          SendResponse(resp);
          return true;
     }
 
-    while (it == flow_obj->flow_entry_map_.end() &&
-          ++partition_id_ < agent_->flow_thread_count()) {
-         flow_obj = agent_->pkt()->flow_table(partition_id_);
-         it =  flow_obj->flow_entry_map_.begin();
-    }
-
-    while (it != flow_obj->flow_entry_map_.end()) {
-        FlowEntry *fe = it->second;
-        FlowStatsCollector *fec = fe->fsc();
-        const FlowExportInfo *info = NULL;
-        if (fec) {
-            info = fec->FindFlowExportInfo(fe);
+    // Ask each partition for one flow more than what fits in the response,
+    // to know whether the partition has more flows for the next page
+    std::vector<FlowEntry *> flow_list;
+    FlowKey key = flow_iteration_key_;
+    while (true) {
+        flow_list.clear();
+        flow_obj->GetNextFlows(key, kMaxFlowResponse - count + 1, &flow_list);
+        std::vector<FlowEntry *>::const_iterator it = flow_list.begin();
+        for (; it != flow_list.end() && count < kMaxFlowResponse; ++it) {
+            FlowEntry *fe = *it;
+            FlowStatsCollector *fec = fe->fsc();
+            const FlowExportInfo *info = NULL;
+            if (fec) {
+                info = fec->FindFlowExportInfo(fe);
+            }
+            SetSandeshFlowData(list, fe, info);
+            count++;
         }
-        SetSandeshFlowData(list, fe, info);
-        ++it;
-        count++;
+
         if (count == kMaxFlowResponse) {
-            if (it != flow_obj->flow_entry_map_.end()) {
+            if (it != flow_list.end()) {
+                FlowEntry *fe = *(it - 1);
                 resp_obj_->set_flow_key(GetFlowKey(fe->key(), partition_id_));
-                flow_key_set = true;
-
             } else {
-                FlowKey key;
-                resp_obj_->set_flow_key(GetFlowKey(key, ++partition_id_));
-                flow_key_set = true;
+                resp_obj_->set_flow_key(GetFlowKey(FlowKey(), ++partition_id_));
             }
+            flow_key_set = true;
             break;
         }
 
-        while (it == flow_obj->flow_entry_map_.end()) {
-            if (++partition_id_ < agent_->flow_thread_count()) {
-                flow_obj = agent_->pkt()->flow_table(partition_id_);
-                it = flow_obj->flow_entry_map_.begin();
-                if (it != flow_obj->flow_entry_map_.end()) {
-                    break;
-                }
-            } else {
-              break;
-           }
-        }
+        if (++partition_id_ >= agent_->flow_thread_count())
+            break;
+        flow_obj = agent_->pkt()->flow_table(partition_id_);
+        key = FlowKey();
     }
 
     if (!flow_key_set) {
@@ -439,18 +430,17 @@ void FetchFlowRecord::HandleRequest() const {
     key.dst_port = (unsigned)get_dst_port();
     key.protocol = get_protocol();
 
-    FlowTable::FlowEntryMap::iterator it;
+    FlowEntry *fe = NULL;
     for (int i = 0; i < agent->flow_thread_count(); i++) {
         flow_obj = agent->pkt()->flow_table(i);
-        it = flow_obj->flow_entry_map_.find(key);
-        if (it != flow_obj->flow_entry_map_.end())
+        fe = flow_obj->flow_entry_map_.Find(key);
+        if (fe != NULL)
             break;
     }
 
     SandeshResponse *resp;
-    if (flow_obj && it != flow_obj->flow_entry_map_.end()) {
+    if (fe != NULL) {
        FlowRecordResp *flow_resp = new FlowRecordResp();
-       FlowEntry *fe = it->second;
        FlowStatsCollector *fec = fe->fsc();
        const FlowExportInfo *info = NULL;
        if (fec) {
@@ -545,60 +535,47 @@ bool PktSandeshFlowStats::Run() {
         return true;
     }
 
-    FlowTable::FlowEntryMap::iterator it;
-    if (key_valid_)  {
-        it = flow_obj->flow_entry_map_.upper_bound(flow_iteration_key_);
-    } else {
+    if (!key_valid_)  {
          FlowErrorResp *resp = new FlowErrorResp();
          SendResponse(resp);
          return true;
     }
 
-    while (it == flow_obj->flow_entry_map_.end() &&
-          ++partition_id_ < agent_->flow_thread_count()) {
-         flow_obj = agent_->pkt()->flow_table(partition_id_);
-         it =  flow_obj->flow_entry_map_.begin();
-    }
-
-    while (it != flow_obj->flow_entry_map_.end()) {
-        FlowEntry *fe = it->second;
-        const FlowExportInfo *info = NULL;
-        if (fe->fsc()) {
-            info = fe->fsc()->FindFlowExportInfo(fe);
+    std::vector<FlowEntry *> flow_list;
+    FlowKey key = flow_iteration_key_;
+    while (true) {
+        flow_list.clear();
+        flow_obj->GetNextFlows(key, kMaxFlowResponse - count + 1, &flow_list);
+        std::vector<FlowEntry *>::const_iterator it = flow_list.begin();
+        for (; it != flow_list.end() && count < kMaxFlowResponse; ++it) {
+            FlowEntry *fe = *it;
+            const FlowExportInfo *info = NULL;
+            if (fe->fsc()) {
+                info = fe->fsc()->FindFlowExportInfo(fe);
+            }
+            SetSandeshFlowData(list, fe, info);
+            count++;
         }
-        SetSandeshFlowData(list, fe, info);
-        ++it;
-        count++;
+
         if (count == kMaxFlowResponse) {
-            if (it != flow_obj->flow_entry_map_.end()) {
-                ostringstream ostr;
+            ostringstream ostr;
+            if (it != flow_list.end()) {
+                FlowEntry *fe = *(it - 1);
                 ostr << proto_ << ":" << port_ << ":"
                     << GetFlowKey(fe->key(), partition_id_);
-                resp_->set_flow_key(ostr.str());
-                flow_key_set = true;
             } else {
-                ostringstream ostr;
-                FlowKey key;
                 ostr << proto_ << ":" << port_ << ":"
-                    << GetFlowKey(key, ++partition_id_);
-                resp_->set_flow_key(ostr.str());
-                flow_key_set = true;
+                    << GetFlowKey(FlowKey(), ++partition_id_);
             }
+            resp_->set_flow_key(ostr.str());
+            flow_key_set = true;
             break;
         }
 
-        while (it == flow_obj->flow_entry_map_.end()) {
-            if (++partition_id_ < agent_->flow_thread_count()) {
-                flow_obj = agent_->pkt()->flow_table(partition_id_);
-                it = flow_obj->flow_entry_map_.begin();
-                if (it != flow_obj->flow_entry_map_.end()) {
-                    break;
-                }
-            } else {
-              break;
-           }
-         }
-
+        if (++partition_id_ >= agent_->flow_thread_count())
+            break;
+        flow_obj = agent_->pkt()->flow_table(partition_id_);
+        key = FlowKey();
     }
 
     if (!flow_key_set) {
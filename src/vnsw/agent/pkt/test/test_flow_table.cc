@@ -3,7 +3,10 @@
  */
 
 #include "base/os.h"
+#include <map>
+#include <vector>
 #include <base/task.h>
+#include <base/time_util.h>
 #include <base/test/task_test_util.h>
 #include "test/test_cmn_util.h"
 #include "test_flow_util.h"
@@ -23,6 +26,16 @@ struct PortInfo input[] = {
     {"vif0", 1, vm1_ip, "00:00:00:01:01:01", 1, 1},
     {"vif1", 2, vm2_ip, "00:00:00:01:01:02", 1, 2},
 };
+struct FlowKeyCmp {
+    bool operator()(const FlowKey &lhs, const FlowKey &rhs) const {
+        return lhs.IsLess(rhs);
+    }
+};
+
+static bool FlowEntryKeyLess(const FlowEntry *lhs, const FlowEntry *rhs) {
+    return lhs->key().IsLess(rhs->key());
+}
+
 IpamInfo ipam_info[] = {
     {"1.1.1.0", 24, "1.1.1.10"},
 };
@@ -347,6 +360,192 @@ TEST_F(TestFlowTable, ResetFlowStats) {
                                200, 1, 30, vif0->flow_key_nh()->id(), 10));
 }
 
+class FlowEntryMapTest : public ::testing::Test {
+protected:
+    FlowEntryMapTest() : table_(Agent::GetInstance()->pkt()->flow_table(0)) {
+    }
+
+    virtual void TearDown() {
+        flow_list_.clear();
+        client->WaitForIdle();
+    }
+
+    // Adds count forward and reverse flow pairs to flow_list_
+    void CreateFlows(int count) {
+        for (int i = 0; i < count; i++) {
+            FlowKey key(1, Ip4Address(0x01010101 + i / 1024),
+                        Ip4Address(0x02020202), 6, 1000 + i % 1024, 80);
+            flow_list_.push_back(FlowEntry::Allocate(key, table_));
+            FlowKey rkey(2, key.dst_addr, key.src_addr, 6, 80, key.src_port);
+            flow_list_.push_back(FlowEntry::Allocate(rkey, table_));
+        }
+    }
+
+    FlowTable *table_;
+    std::vector<FlowEntryPtr> flow_list_;
+};
+
+TEST_F(FlowEntryMapTest, InsertFindErase) {
+    FlowEntryMap map;
+    CreateFlows(4096);
+    for (size_t i = 0; i < flow_list_.size(); i++) {
+        EXPECT_TRUE(map.Insert(flow_list_[i].get()) == flow_list_[i].get());
+    }
+    EXPECT_EQ(flow_list_.size(), map.size());
+    EXPECT_GE(map.capacity() * FlowEntryMap::kMaxLoadPercent,
+              map.size() * 100);
+
+    // A flow with the key of one in the map isn't added
+    FlowEntryPtr dup(FlowEntry::Allocate(flow_list_[0]->key(), table_));
+    EXPECT_TRUE(map.Insert(dup.get()) == flow_list_[0].get());
+    EXPECT_EQ(flow_list_.size(), map.size());
+
+    // Erase every other flow, the rest must still be found
+    for (size_t i = 0; i < flow_list_.size(); i += 2) {
+        EXPECT_TRUE(map.Erase(flow_list_[i]->key()));
+    }
+    for (size_t i = 0; i < flow_list_.size(); i++) {
+        FlowEntry *flow = (i % 2) ? flow_list_[i].get() : NULL;
+        EXPECT_TRUE(map.Find(flow_list_[i]->key()) == flow);
+    }
+    EXPECT_FALSE(map.Erase(flow_list_[0]->key()));
+
+    for (size_t i = 1; i < flow_list_.size(); i += 2) {
+        EXPECT_TRUE(map.Erase(flow_list_[i]->key()));
+    }
+    EXPECT_EQ(0U, map.size());
+}
+
+// Paging through the map with GetNext returns all flows in key order
+TEST_F(FlowEntryMapTest, GetNext) {
+    FlowEntryMap map;
+    CreateFlows(1000);
+    for (size_t i = 0; i < flow_list_.size(); i++) {
+        map.Insert(flow_list_[i].get());
+    }
+
+    std::vector<FlowEntry *> sorted;
+    map.GetAll(&sorted);
+    EXPECT_EQ(flow_list_.size(), sorted.size());
+    std::sort(sorted.begin(), sorted.end(), FlowEntryKeyLess);
+
+    std::vector<FlowEntry *> walk;
+    FlowKey key;
+    while (true) {
+        size_t count = walk.size();
+        map.GetNext(key, 100, &walk);
+        if (walk.size() == count)
+            break;
+        EXPECT_GE(100U, walk.size() - count);
+        key = walk.back()->key();
+    }
+    EXPECT_TRUE(walk == sorted);
+    // Snapshot of the keys is dropped at the end of the walk
+    EXPECT_EQ(0U, map.walk_key_count());
+
+    for (size_t i = 0; i < flow_list_.size(); i++) {
+        map.Erase(flow_list_[i]->key());
+    }
+}
+
+// Flows erased during a walk are skipped, flows added during a walk are
+// returned by the next walk
+TEST_F(FlowEntryMapTest, GetNextChurn) {
+    FlowEntryMap map;
+    CreateFlows(1000);
+    size_t half = flow_list_.size() / 2;
+    for (size_t i = 0; i < half; i++) {
+        map.Insert(flow_list_[i].get());
+    }
+
+    std::vector<FlowEntry *> walk;
+    map.GetNext(FlowKey(), 100, &walk);
+    EXPECT_EQ(100U, walk.size());
+    EXPECT_EQ(half, map.walk_key_count());
+
+    // Erase all flows not returned yet and add the other half
+    for (size_t i = 0; i < half; i++) {
+        if (std::find(walk.begin(), walk.end(), flow_list_[i].get()) ==
+            walk.end()) {
+            map.Erase(flow_list_[i]->key());
+        }
+    }
+    for (size_t i = half; i < flow_list_.size(); i++) {
+        map.Insert(flow_list_[i].get());
+    }
+
+    // Rest of the walk returns nothing, the flows left in the snapshot are
+    // erased and the added flows are not in it
+    map.GetNext(walk.back()->key(), 100, &walk);
+    EXPECT_EQ(100U, walk.size());
+    EXPECT_EQ(0U, map.walk_key_count());
+
+    // Next walk returns all flows in the map
+    walk.clear();
+    map.GetNext(FlowKey(), flow_list_.size(), &walk);
+    EXPECT_EQ(100U + flow_list_.size() - half, walk.size());
+    EXPECT_EQ(map.size(), walk.size());
+
+    for (size_t i = 0; i < flow_list_.size(); i++) {
+        map.Erase(flow_list_[i]->key());
+    }
+}
+
+// Compares the cost of setting up flows in the FlowEntryMap and in the
+// std::map it replaced. Setting up a flow looks up the forward flow and
+// adds the forward and reverse flows.
+TEST_F(FlowEntryMapTest, SetupRateBenchmark) {
+    typedef std::map<FlowKey, FlowEntry *, FlowKeyCmp> FlowTreeMap;
+    const int kFlowCount = 32 * 1024;
+    CreateFlows(kFlowCount);
+
+    FlowTreeMap tree;
+    uint64_t start = ClockMonotonicUsec();
+    for (size_t i = 0; i < flow_list_.size(); i += 2) {
+        FlowEntry *flow = flow_list_[i].get();
+        FlowEntry *rflow = flow_list_[i + 1].get();
+        if (tree.find(flow->key()) == tree.end()) {
+            tree.insert(std::make_pair(flow->key(), flow));
+            tree.insert(std::make_pair(rflow->key(), rflow));
+        }
+    }
+    uint64_t tree_setup = ClockMonotonicUsec() - start;
+    start = ClockMonotonicUsec();
+    for (size_t i = 0; i < flow_list_.size(); i++) {
+        tree.erase(flow_list_[i]->key());
+    }
+    uint64_t tree_delete = ClockMonotonicUsec() - start;
+
+    FlowEntryMap map;
+    start = ClockMonotonicUsec();
+    for (size_t i = 0; i < flow_list_.size(); i += 2) {
+        FlowEntry *flow = flow_list_[i].get();
+        FlowEntry *rflow = flow_list_[i + 1].get();
+        if (map.Find(flow->key()) == NULL) {
+            map.Insert(flow);
+            map.Insert(rflow);
+        }
+    }
+    uint64_t map_setup = ClockMonotonicUsec() - start;
+    EXPECT_EQ(flow_list_.size(), map.size());
+    start = ClockMonotonicUsec();
+    for (size_t i = 0; i < flow_list_.size(); i++) {
+        map.Erase(flow_list_[i]->key());
+    }
+    uint64_t map_delete = ClockMonotonicUsec() - start;
+    EXPECT_EQ(0U, map.size());
+
+    std::cout << "Flows " << kFlowCount
+        << " std::map setup " << tree_setup << " usec delete "
+        << tree_delete << " usec, FlowEntryMap setup " << map_setup
+        << " usec delete " << map_delete << " usec" << std::endl;
+    if (map_setup) {
+        std::cout << "FlowEntryMap setup rate "
+            << (kFlowCount * 1000000ULL) / map_setup << " flows/sec"
+            << std::endl;
+    }
+}
+
 int main(int argc, char *argv[]) {
     int ret = 0;
     GETUSERARGS();
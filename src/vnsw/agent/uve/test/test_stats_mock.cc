@@ -3,6 +3,7 @@
  */
 
 #include "base/os.h"
+#include "base/time_util.h"
 #include "cmn/agent_cmn.h"
 #include "pkt/pkt_init.h"
 #include "pkt/flow_table.h"
@@ -1132,6 +1133,62 @@ TEST_F(StatsTestMock, FlowReuse_1) {
     f->ClearCount();
 }
 
+// Measure the number of flows exported per second on one core. Task scheduler
+// is stopped so that the collector is not running while flows are exported
+// from the test thread. The rate includes the cost of DispatchFlowMsg of
+// FlowStatsCollectorTest
+TEST_F(StatsTestMock, FlowExportBenchmark) {
+    TestFlow flow[] = {
+        {
+            TestFlowPkt(Address::INET, "1.1.1.1", "1.1.1.2", 1, 0, 0, "vrf5",
+                        flow0->id()),
+            {
+                new VerifyVn("vn5", "vn5"),
+            }
+        }
+    };
+
+    CreateFlow(flow, 1);
+    client->WaitForIdle();
+    EXPECT_EQ(2U, flow_proto_->FlowCount());
+
+    FlowEntry *fe = flow[0].pkt_.FlowFetch();
+    EXPECT_TRUE(fe != NULL);
+    FlowStatsCollector *fsc = fe->fsc();
+    EXPECT_TRUE(fsc != NULL);
+    FlowExportInfo *info = fsc->FindFlowExportInfo(fe);
+    EXPECT_TRUE(info != NULL);
+    FlowStatsCollectorTest *f = static_cast<FlowStatsCollectorTest *>(fsc);
+
+    const uint32_t kExportCount = 20000;
+    // Export flows above sampling threshold so that none of them are dropped
+    uint64_t bytes = fsc->threshold();
+    TaskScheduler::GetInstance()->Stop();
+    f->ClearCount();
+    f->ClearList();
+    uint64_t start = ClockMonotonicUsec();
+    for (uint32_t i = 0; i < kExportCount; i++) {
+        fsc->ExportFlow(info, bytes, 1, NULL, true);
+    }
+    uint64_t elapsed = ClockMonotonicUsec() - start + 1;
+    uint64_t dispatch_count = f->dispatch_count();
+    f->ClearList();
+    TaskScheduler::GetInstance()->Start();
+
+    // Messages of the last few flows may be pending dispatch
+    uint32_t max_pending = FlowStatsCollector::kMaxFlowMsgsPerSend;
+    EXPECT_LE(kExportCount - max_pending, dispatch_count);
+    cout << "Exported " << kExportCount << " flows, " << dispatch_count
+        << " flow log messages in " << elapsed << " usec, "
+        << (kExportCount * 1000000ULL / elapsed) << " flows/sec" << endl;
+
+    DeleteFlow(flow, 1);
+    client->WaitForIdle();
+    EXPECT_EQ(0U, flow_proto_->FlowCount());
+    f->ResetLastSentLog();
+    f->ClearCount();
+}
+
 #if 0
 TEST_F(StatsTestMock, FlowTcpClosedFlow) {
     VrfEntry *vrf = Agent::GetInstance()->vrf_table()->FindVrfFromName("vrf5");
@@ -1,3 +1,4 @@
+#include <boost/uuid/uuid_io.hpp>
 #include <vrouter/flow_stats/flow_stats_collector.h>
 #include <pkt/flow_table.h>
 
@@ -48,7 +49,10 @@ bool FlowExportInfo::IsActionLog() const {
 void FlowExportInfo::CopyFlowInfo(FlowEntry *fe) {
     gen_id_ = fe->gen_id();
     flow_handle_ = fe->flow_handle();
-    uuid_ = fe->uuid();
+    if (uuid_str_.empty() || uuid_ != fe->uuid()) {
+        uuid_ = fe->uuid();
+        uuid_str_ = to_string(uuid_);
+    }
     flags_ = fe->flags();
     FlowEntry *rflow = reverse_flow();
     if (rflow) {
@@ -69,3 +73,106 @@ void FlowExportInfo::SetActionLog() {
     fe->data().match_p.action_info.action =
         fe->data().match_p.action_info.action | (1 << TrafficAction::LOG);
 }
+
+/////////////////////////////////////////////////////////////////////////////
+// FlowExportInfoIndex methods
+/////////////////////////////////////////////////////////////////////////////
+FlowExportInfoIndex::Page::Page() : count(0) {
+    for (uint32_t i = 0; i < kPageSize; i++) {
+        slots[i] = NULL;
+    }
+}
+
+FlowExportInfoIndex::FlowExportInfoIndex() : page_count_(0), count_(0) {
+}
+
+FlowExportInfoIndex::~FlowExportInfoIndex() {
+    overflow_list_.clear();
+    STLDeleteValues(&pages_);
+}
+
+bool FlowExportInfoIndex::AddSlot(FlowExportInfo *info) {
+    uint32_t flow_handle = info->flow_handle();
+    if (flow_handle == FlowEntry::kInvalidFlowHandle)
+        return false;
+
+    uint32_t page = flow_handle / kPageSize;
+    if (page >= pages_.size())
+        pages_.resize(page + 1, NULL);
+    if (pages_[page] == NULL) {
+        pages_[page] = new Page();
+        page_count_++;
+    }
+
+    FlowExportInfo **slot = &pages_[page]->slots[flow_handle % kPageSize];
+    if (*slot != NULL)
+        return false;
+
+    *slot = info;
+    pages_[page]->count++;
+    count_++;
+    return true;
+}
+
+void FlowExportInfoIndex::Add(FlowExportInfo *info) {
+    if (IsPresent(info))
+        return;
+
+    if (AddSlot(info) == false)
+        overflow_list_.push_back(*info);
+}
+
+void FlowExportInfoIndex::Remove(FlowExportInfo *info) {
+    if (info->is_linked()) {
+        overflow_list_.erase(overflow_list_.iterator_to(*info));
+        return;
+    }
+
+    uint32_t flow_handle = info->flow_handle();
+    if (At(flow_handle) != info)
+        return;
+
+    uint32_t page = flow_handle / kPageSize;
+    pages_[page]->slots[flow_handle % kPageSize] = NULL;
+    count_--;
+    if (--pages_[page]->count == 0) {
+        delete pages_[page];
+        pages_[page] = NULL;
+        page_count_--;
+    }
+}
+
+bool FlowExportInfoIndex::IsPresent(const FlowExportInfo *info) const {
+    return info->is_linked() || At(info->flow_handle()) == info;
+}
+
+void FlowExportInfoIndex::Relocate(FlowExportInfo *info) {
+    if (info->is_linked() == false)
+        return;
+
+    FlowExportInfoList::iterator it = overflow_list_.iterator_to(*info);
+    if (AddSlot(info))
+        overflow_list_.erase(it);
+}
+
+uint32_t FlowExportInfoIndex::SkipEmptyPages(uint32_t flow_handle) const {
+    uint32_t page = flow_handle / kPageSize;
+    if (page < pages_.size() && pages_[page] != NULL)
+        return flow_handle;
+
+    for (page++; page < pages_.size(); page++) {
+        if (pages_[page] != NULL)
+            return page * kPageSize;
+    }
+    return slot_count();
+}
+
+FlowExportInfo *FlowExportInfoIndex::RotateOverflow() {
+    if (overflow_list_.empty())
+        return NULL;
+
+    FlowExportInfo *info = &overflow_list_.front();
+    overflow_list_.pop_front();
+    overflow_list_.push_back(*info);
+    return info;
+}
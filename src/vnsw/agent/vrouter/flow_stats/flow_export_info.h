@@ -4,6 +4,7 @@
 #ifndef __AGENT_FLOW_EXPORT_INFO_H__
 #define __AGENT_FLOW_EXPORT_INFO_H__
 
+#include <vector>
 #include <pkt/flow_entry.h>
 #include <filter/acl.h>
 
@@ -58,6 +59,8 @@ public:
     uint32_t flow_handle() const { return flow_handle_; }
     void set_flow_handle(uint32_t value) { flow_handle_ = value; }
     const boost::uuids::uuid &uuid() const { return uuid_; }
+    // uuid formatted for flow export
+    const std::string &uuid_str() const { return uuid_str_; }
     const boost::uuids::uuid &rev_flow_egress_uuid() const {
         return rev_flow_egress_uuid_;
     }
@@ -101,6 +104,7 @@ private:
     uint8_t gen_id_;
     uint32_t flow_handle_;
     boost::uuids::uuid uuid_;
+    std::string uuid_str_;
     boost::uuids::uuid rev_flow_egress_uuid_;
     uint32_t flags_;
     std::string last_exported_source_vn_;
@@ -108,4 +112,69 @@ private:
 };
 
 typedef boost::intrusive::list<FlowExportInfo> FlowExportInfoList;
+
+// Index of FlowExportInfo entries on the vrouter flow handle. Slot N holds the
+// entry with flow handle N, so walking the slots in order reads the
+// vr_flow_entry table in shared memory sequentially.
+//
+// Flows are assigned to collector instances by flow table and aging config,
+// not by flow handle, so the flows of an instance can have any flow handle.
+// Slots are allocated in pages of kPageSize flow handles, and a page is freed
+// when its last entry is removed. An index only holds the pages that its
+// flows are in, plus a page table with a pointer per kPageSize flow handles,
+// and the ageing sweep skips the pages that are not allocated.
+//
+// Entries that do not have a flow handle yet, or whose flow handle is held by
+// another entry (vrouter can reuse the handle of a flow still being deleted),
+// are kept in an overflow list. Relocate moves them to their slot once the
+// flow handle is known and the slot is free.
+//
+// The flow handle of an entry must not change while it is in the index.
+class FlowExportInfoIndex {
+public:
+    static const uint32_t kPageSize = 256;
+
+    FlowExportInfoIndex();
+    ~FlowExportInfoIndex();
+
+    void Add(FlowExportInfo *info);
+    void Remove(FlowExportInfo *info);
+    bool IsPresent(const FlowExportInfo *info) const;
+    // Move an overflow entry to its slot if the slot is free
+    void Relocate(FlowExportInfo *info);
+    // Move the first overflow entry to the end of the list and return it
+    FlowExportInfo *RotateOverflow();
+
+    FlowExportInfo *At(uint32_t flow_handle) const {
+        uint32_t page = flow_handle / kPageSize;
+        if (page >= pages_.size() || pages_[page] == NULL)
+            return NULL;
+        return pages_[page]->slots[flow_handle % kPageSize];
+    }
+    // First flow handle at or after flow_handle that is in an allocated page,
+    // or slot_count() if there is none
+    uint32_t SkipEmptyPages(uint32_t flow_handle) const;
+    uint32_t slot_count() const { return pages_.size() * kPageSize; }
+    size_t page_count() const { return page_count_; }
+    size_t overflow_size() const { return overflow_list_.size(); }
+    size_t size() const { return count_ + overflow_list_.size(); }
+
+private:
+    struct Page {
+        Page();
+        FlowExportInfo *slots[kPageSize];
+        // Number of entries in slots
+        uint32_t count;
+    };
+
+    bool AddSlot(FlowExportInfo *info);
+
+    std::vector<Page *> pages_;
+    // Number of allocated pages
+    size_t page_count_;
+    // Number of entries in pages_
+    size_t count_;
+    FlowExportInfoList overflow_list_;
+    DISALLOW_COPY_AND_ASSIGN(FlowExportInfoIndex);
+};
 #endif //  __AGENT_FLOW_EXPORT_INFO_H__
@@ -50,7 +50,8 @@ FlowStatsCollector::FlowStatsCollector(boost::asio::io_service &io, int intvl,
         task_id_(uve->agent()->task_scheduler()->GetTaskId
                  (kTaskFlowStatsCollector)),
         rand_gen_(boost::uuids::random_generator()),
-        flow_iteration_key_(NULL),
+        flow_iteration_key_(0),
+        overflow_entries_to_visit_(0),
         entries_to_visit_(0),
         flow_tcp_syn_age_time_(FlowTcpSynAgeTime),
         retry_delete_(true),
@@ -59,10 +60,12 @@ FlowStatsCollector::FlowStatsCollector(boost::asio::io_service &io, int intvl,
                        instance_id,
                        boost::bind(&FlowStatsCollector::RequestHandler, 
                                    this, _1)),
-        msg_list_(kMaxFlowMsgsPerSend, FlowLogData()), msg_index_(0),
+        msg_list_(),
         flow_aging_key_(*key), instance_id_(instance_id),
         flow_stats_manager_(aging_module), parent_(obj), ageing_task_(NULL),
-        current_time_(GetCurrentTime()), ageing_task_starts_(0) {
+        current_time_(GetCurrentTime()), ageing_task_starts_(0),
+        ageing_pass_start_time_(0), ageing_passes_(0),
+        last_ageing_pass_time_(0) {
         if (flow_cache_timeout) {
             // Convert to usec
             flow_age_time_intvl_ = 1000000L * (uint64_t)flow_cache_timeout;
@@ -70,6 +73,8 @@ FlowStatsCollector::FlowStatsCollector(boost::asio::io_service &io, int intvl,
             flow_age_time_intvl_ = FlowAgeTime;
         }
         deleted_ = false;
+        // A local flow adds two messages before they are enqueued
+        msg_list_.reserve(kMaxFlowMsgsPerSend + 1);
         request_queue_.set_name("Flow stats collector");
         request_queue_.set_measure_busy_time
             (agent_uve_->agent()->MeasureQueueDelay());
@@ -130,7 +135,7 @@ uint32_t FlowStatsCollector::TimersPerScan() {
 // A lower-bound and an upper-bound are enforced on entries_to_visit_
 void FlowStatsCollector::UpdateEntriesToVisit() {
     // Compute number of flows to visit per scan-time
-    uint32_t count = flow_export_info_list_.size();
+    uint32_t count = flow_index_.size();
     uint32_t entries = count / timers_per_scan_;
 
     // Update number of entries to visit in flow.
@@ -634,8 +639,7 @@ bool FlowStatsCollector::AgeFlow(KSyncFlowMemory *ksync_obj,
 }
 
 // Check if a flow is to be aged or evicted. Returns number of flows visited
-uint32_t FlowStatsCollector::ProcessFlow(FlowExportInfoList::iterator &it,
-                                         KSyncFlowMemory *ksync_obj,
+uint32_t FlowStatsCollector::ProcessFlow(KSyncFlowMemory *ksync_obj,
                                          FlowExportInfo *info,
                                          uint64_t curr_time) {
     uint32_t count = 1;
@@ -666,6 +670,11 @@ uint32_t FlowStatsCollector::ProcessFlow(FlowExportInfoList::iterator &it,
             info->CopyFlowInfo(fe);
         }
     }
+    // Move the flow from the overflow list to its slot in the index once its
+    // flow handle is known and the slot is free. A flow whose flow handle was
+    // reused by vrouter stays in the overflow list until the old flow leaves
+    // the slot.
+    flow_index_.Relocate(info);
     const vr_flow_entry *k_flow = NULL;
     vr_flow_stats k_stats;
     KFlowData kinfo;
@@ -681,15 +690,13 @@ uint32_t FlowStatsCollector::ProcessFlow(FlowExportInfoList::iterator &it,
         // Flow evicted?
         if (EvictFlow(ksync_obj, k_flow, kinfo.flags, flow_handle, gen_id,
                       info, curr_time) == true) {
-            // If retry_delete_ enabled, dont change flow_export_info_list_
+            // If retry_delete_ enabled, dont change flow_index_
             if (retry_delete_ == true)
                 return count;
 
             // We dont want to retry delete-events, remove flow from ageing list
-            assert(info->is_linked());
-            FlowExportInfoList::iterator flow_it =
-                flow_export_info_list_.iterator_to(*info);
-            flow_export_info_list_.erase(flow_it);
+            assert(flow_index_.IsPresent(info));
+            flow_index_.Remove(info);
 
             return count;
         }
@@ -700,75 +707,91 @@ uint32_t FlowStatsCollector::ProcessFlow(FlowExportInfoList::iterator &it,
     if (AgeFlow(ksync_obj, k_flow, k_stats, kinfo, info, curr_time) == false)
         return count;
 
-    // If retry_delete_ enabled, dont change flow_export_info_list_
+    // If retry_delete_ enabled, dont change flow_index_
     if (retry_delete_ == false)
         return count;
 
     // Flow aged, remove both forward and reverse flow
-    assert(info->is_linked());
-    FlowExportInfoList::iterator flow_it =
-        flow_export_info_list_.iterator_to(*info);
-    flow_export_info_list_.erase(flow_it);
+    assert(flow_index_.IsPresent(info));
+    flow_index_.Remove(info);
 
     FlowEntry *rfe = info->reverse_flow();
     FlowExportInfo *rev_info = FindFlowExportInfo(rfe);
     if (rev_info) {
-        if (rev_info->is_linked()) {
-            FlowExportInfoList::iterator rev_flow_it =
-                flow_export_info_list_.iterator_to(*rev_info);
-            if (rev_flow_it == it) {
-                it++;
-            }
-            flow_export_info_list_.erase(rev_flow_it);
-        }
+        flow_index_.Remove(rev_info);
         count++;
     }
     return count;
 }
 
+// Visit upto max_count flows, continuing the ageing pass in progress. The
+// pass sweeps the flow handles in flow_index_ in order, skipping the pages
+// that hold no flows, and then visits the flows in its overflow list.
 uint32_t FlowStatsCollector::RunAgeing(uint32_t max_count) {
-    FlowExportInfoList::iterator it;
-    if (flow_iteration_key_ == NULL) {
-        it = flow_export_info_list_.begin();
-    } else {
-        FlowEntryTree::iterator tree_it = flow_tree_.find(flow_iteration_key_);
-        // Flow to iterate next is not found. Force stop this iteration.
-        // We will continue from begining on next timer
-        if (tree_it == flow_tree_.end()) {
-            flow_iteration_key_ = NULL;
-            return entries_to_visit_;
-        }
-        it = flow_export_info_list_.iterator_to(tree_it->second);
+    if (ageing_pass_start_time_ == 0) {
+        ageing_pass_start_time_ = ClockMonotonicUsec();
+        flow_iteration_key_ = 0;
+        overflow_entries_to_visit_ = flow_index_.overflow_size();
     }
 
     KSyncFlowMemory *ksync_obj = agent_uve_->agent()->ksync()->
         ksync_flow_memory();
     uint64_t curr_time = GetCurrentTime();
     uint32_t count = 0;
-    while (count < max_count) {
-        if (it == flow_export_info_list_.end()) {
+    uint32_t handles = 0;
+    while (count < max_count && handles < kFlowHandlesPerTask &&
+           flow_iteration_key_ != FlowEntry::kInvalidFlowHandle) {
+        flow_iteration_key_ = flow_index_.SkipEmptyPages(flow_iteration_key_);
+        if (flow_iteration_key_ >= flow_index_.slot_count()) {
+            // Sweep is done. Flows relocated from the overflow list below
+            // can add slots past the end, they are visited in next pass.
+            flow_iteration_key_ = FlowEntry::kInvalidFlowHandle;
             break;
         }
 
-        FlowExportInfo *info = &(*it);
-        it++;
+        FlowExportInfo *info = flow_index_.At(flow_iteration_key_);
+        flow_iteration_key_++;
+        handles++;
+        if (info == NULL)
+            continue;
+
         flows_visited_++;
-        count += ProcessFlow(it, ksync_obj, info, curr_time);
+        count += ProcessFlow(ksync_obj, info, curr_time);
     }
 
-    //Send any pending flow export messages
-    DispatchPendingFlowMsg();
+    if (flow_iteration_key_ == FlowEntry::kInvalidFlowHandle) {
+        while (count < max_count && overflow_entries_to_visit_ > 0) {
+            // Flows may have left the overflow list since start of the pass,
+            // including the ones relocated by ProcessFlow
+            if (overflow_entries_to_visit_ > flow_index_.overflow_size()) {
+                overflow_entries_to_visit_ = flow_index_.overflow_size();
+                if (overflow_entries_to_visit_ == 0)
+                    break;
+            }
 
-    // Update iterator for next pass
-    if (it == flow_export_info_list_.end()) {
-        flow_iteration_key_ = NULL;
-    } else {
-        flow_iteration_key_ = it->flow();
+            FlowExportInfo *info = flow_index_.RotateOverflow();
+            overflow_entries_to_visit_--;
+            flows_visited_++;
+            count += ProcessFlow(ksync_obj, info, curr_time);
+        }
+
+        if (overflow_entries_to_visit_ == 0) {
+            AgeingPassDone();
+        }
     }
 
+    //Send any pending flow export messages
+    DispatchPendingFlowMsg();
+
     return count;
 }
 
+void FlowStatsCollector::AgeingPassDone() {
+    last_ageing_pass_time_ = ClockMonotonicUsec() - ageing_pass_start_time_;
+    ageing_pass_start_time_ = 0;
+    ageing_passes_++;
+}
+
 // Timer fired for ageing. Update the number of entries to visit and start the
 // task if its already not ruuning
 bool FlowStatsCollector::Run() {
@@ -789,7 +812,8 @@ bool FlowStatsCollector::Run() {
                 << " AgeingTasks Num " << ageing_task_starts_
                 << " Request count " << request_queue_.Length()
                 << " Tree size " << flow_tree_.size()
-                << " List size " << flow_export_info_list_.size()
+                << " Index size " << flow_index_.size()
+                << " Last pass time " << last_ageing_pass_time_
                 << " flows visited " << flows_visited_
                 << " flows aged " << flows_aged_
                 << " flows evicted " << flows_evicted_);
@@ -811,8 +835,8 @@ bool FlowStatsCollector::RunAgeingTask() {
         entries_to_visit_ -= count;
     else
         entries_to_visit_ = 0;
-    // Done with task if we reach end of tree or count is exceeded
-    if (flow_iteration_key_ == NULL || entries_to_visit_ == 0) {
+    // Done with task if ageing pass is complete or count is exceeded
+    if (ageing_pass_start_time_ == 0 || entries_to_visit_ == 0) {
         entries_to_visit_ = 0;
         ageing_task_ = NULL;
         return true;
@@ -855,7 +879,8 @@ void FlowStatsCollector::UpdateStatsEvent(const FlowEntryPtr &flow,
 
 void FlowStatsCollector::SetUnderlayInfo(FlowExportInfo *info,
                                          FlowLogData &s_flow) {
-    string rid = agent_uve_->agent()->router_id().to_string();
+    const string &rid =
+        flow_log_strings_.RouterIdString(agent_uve_->agent()->router_id());
     FlowEntry *flow = info->flow();
     uint16_t underlay_src_port = 0;
     if (flow->is_flags_set(FlowEntry::LocalFlow)) {
@@ -910,10 +935,11 @@ void FlowStatsCollector::SetImplicitFlowDetails(FlowExportInfo *info,
             const VmInterface *vmi =
                 dynamic_cast<const VmInterface *>(rflow->intf_entry());
             if (vmi) {
-                s_flow.set_vmi_uuid(UuidToString(vmi->vmi_cfg_uuid()));
+                s_flow.set_vmi_uuid(flow_log_strings_.UuidString
+                                    (vmi->vmi_cfg_uuid()));
             } else {
-                s_flow.set_vmi_uuid(UuidToString(rflow->intf_entry()->
-                                                 GetUuid()));
+                s_flow.set_vmi_uuid(flow_log_strings_.UuidString
+                                    (rflow->intf_entry()->GetUuid()));
             }
         }
         s_flow.set_reverse_uuid(to_string(rflow->uuid()));
@@ -926,38 +952,28 @@ void FlowStatsCollector::SetImplicitFlowDetails(FlowExportInfo *info,
     }
 }
 
-void FlowStatsCollector::GetFlowSandeshActionParams
-    (const FlowAction &action_info, std::string &action_str) {
-    std::bitset<32> bs(action_info.action);
-    for (unsigned int i = 0; i <= bs.size(); i++) {
-        if (bs[i]) {
-            if (!action_str.empty()) {
-                action_str += "|";
-            }
-            action_str += TrafficAction::ActionToString(
-                static_cast<TrafficAction::Action>(i));
-        }
-    }
+// Add a message to msg_list_. The message is dispatched on EnqueueFlowMsg
+// or DispatchPendingFlowMsg
+FlowLogData &FlowStatsCollector::AddFlowMsg() {
+    assert(msg_list_.size() < msg_list_.capacity());
+    msg_list_.push_back(FlowLogData());
+    return msg_list_.back();
 }
 
 void FlowStatsCollector::EnqueueFlowMsg() {
-    msg_index_++;
-    if (msg_index_ == kMaxFlowMsgsPerSend) {
+    if (msg_list_.size() >= kMaxFlowMsgsPerSend) {
         DispatchFlowMsg(msg_list_);
-        msg_index_ = 0;
+        msg_list_.clear();
     }
 }
 
 void FlowStatsCollector::DispatchPendingFlowMsg() {
-    if (msg_index_ == 0) {
+    if (msg_list_.empty()) {
         return;
     }
 
-    vector<FlowLogData>::const_iterator first = msg_list_.begin();
-    vector<FlowLogData>::const_iterator last = msg_list_.begin() + msg_index_;
-    vector<FlowLogData> new_list(first, last);
-    DispatchFlowMsg(new_list);
-    msg_index_ = 0;
+    DispatchFlowMsg(msg_list_);
+    msg_list_.clear();
 }
 
 void FlowStatsCollector::DispatchFlowMsg(const std::vector<FlowLogData> &lst) {
@@ -966,10 +982,61 @@ void FlowStatsCollector::DispatchFlowMsg(const std::vector<FlowLogData> &lst) {
     FLOW_LOG_DATA_OBJECT_LOG("", SandeshLevel::SYS_INFO, lst);
 }
 
-uint8_t FlowStatsCollector::GetFlowMsgIdx() {
-    FlowLogData &obj = msg_list_[msg_index_];
-    obj = FlowLogData();
-    return msg_index_;
+/////////////////////////////////////////////////////////////////////////////
+// FlowLogStrings methods
+/////////////////////////////////////////////////////////////////////////////
+FlowLogStrings::FlowLogStrings() {
+}
+
+FlowLogStrings::~FlowLogStrings() {
+}
+
+const std::string &FlowLogStrings::ActionString(uint32_t action) {
+    ActionStringMap::iterator it = action_map_.find(action);
+    if (it != action_map_.end())
+        return it->second;
+
+    std::string action_str;
+    std::bitset<32> bs(action);
+    for (unsigned int i = 0; i < bs.size(); i++) {
+        if (bs[i]) {
+            if (!action_str.empty()) {
+                action_str += "|";
+            }
+            action_str += TrafficAction::ActionToString(
+                static_cast<TrafficAction::Action>(i));
+        }
+    }
+    return action_map_.insert(make_pair(action, action_str)).first->second;
+}
+
+const std::string &FlowLogStrings::DropReasonString(uint16_t reason) {
+    DropReasonStringMap::iterator it = drop_reason_map_.find(reason);
+    if (it != drop_reason_map_.end())
+        return it->second;
+
+    return drop_reason_map_.insert
+        (make_pair(reason, FlowEntry::DropReasonStr(reason))).first->second;
+}
+
+const std::string &FlowLogStrings::UuidString(const boost::uuids::uuid &u) {
+    UuidStringMap::iterator it = uuid_map_.find(u);
+    if (it != uuid_map_.end())
+        return it->second;
+
+    // Strings of deleted interfaces are not tracked, start afresh instead
+    if (uuid_map_.size() >= kMaxUuidStrings)
+        uuid_map_.clear();
+    return uuid_map_.insert(make_pair(u, UuidToString(u))).first->second;
+}
+
+const std::string &FlowLogStrings::RouterIdString
+    (const Ip4Address &router_id) {
+    if (router_id_str_.empty() || router_id_ != router_id) {
+        router_id_ = router_id;
+        router_id_str_ = router_id.to_string();
+    }
+    return router_id_str_;
 }
 
 void FlowStatsCollector::ExportFlowLocked(FlowExportInfo *info,
@@ -1078,9 +1145,9 @@ void FlowStatsCollector::ExportFlow(FlowExportInfo *info,
         info->set_exported_atleast_once(true);
     }
 
-    FlowLogData &s_flow = msg_list_[GetFlowMsgIdx()];
+    FlowLogData &s_flow = AddFlowMsg();
 
-    s_flow.set_flowuuid(to_string(info->uuid()));
+    s_flow.set_flowuuid(info->uuid_str());
     s_flow.set_bytes(info->bytes());
     s_flow.set_packets(info->packets());
     s_flow.set_diff_bytes(diff_bytes);
@@ -1116,8 +1183,8 @@ void FlowStatsCollector::ExportFlow(FlowExportInfo *info,
             s_flow.set_forward_flow(true);
         }
 
-        string drop_reason = FlowEntry::DropReasonStr(flow->data().drop_reason);
-        s_flow.set_drop_reason(drop_reason);
+        s_flow.set_drop_reason(flow_log_strings_.DropReasonString
+                               (flow->data().drop_reason));
 
         s_flow.set_sg_rule_uuid(flow->sg_rule_uuid());
         s_flow.set_nw_ace_uuid(flow->nw_ace_uuid());
@@ -1125,10 +1192,11 @@ void FlowStatsCollector::ExportFlow(FlowExportInfo *info,
             const VmInterface *vmi =
                 dynamic_cast<const VmInterface *>(flow->intf_entry());
             if (vmi) {
-                s_flow.set_vmi_uuid(UuidToString(vmi->vmi_cfg_uuid()));
+                s_flow.set_vmi_uuid(flow_log_strings_.UuidString
+                                    (vmi->vmi_cfg_uuid()));
             } else {
-                s_flow.set_vmi_uuid(UuidToString(flow->intf_entry()->
-                                                 GetUuid()));
+                s_flow.set_vmi_uuid(flow_log_strings_.UuidString
+                                    (flow->intf_entry()->GetUuid()));
             }
         }
 
@@ -1139,9 +1207,8 @@ void FlowStatsCollector::ExportFlow(FlowExportInfo *info,
         }
 
         // Set flow action
-        std::string action_str;
-        GetFlowSandeshActionParams(flow->data().match_p.action_info, action_str);
-        s_flow.set_action(action_str);
+        s_flow.set_action(flow_log_strings_.ActionString
+                          (flow->data().match_p.action_info.action));
         SetUnderlayInfo(info, s_flow);
     }
 
@@ -1158,9 +1225,10 @@ void FlowStatsCollector::ExportFlow(FlowExportInfo *info,
             s_flow.set_reverse_uuid(to_string(flow->egress_uuid()));
         }
         SourceIpOverride(info, s_flow, params);
-        EnqueueFlowMsg();
 
-        FlowLogData &s_flow2 = msg_list_[GetFlowMsgIdx()];
+        // Both messages are added before they are enqueued, so that s_flow
+        // is not dispatched before it is copied
+        FlowLogData &s_flow2 = AddFlowMsg();
         s_flow2 = s_flow;
         s_flow2.set_direction_ing(0);
         //Update the interface and VM name in this flow
@@ -1430,6 +1498,8 @@ void FlowStatsCollector::AddFlow(FlowExportInfo info) {
              */
             prev.ResetStats();
         }
+        // Flow handle may change, index the flow again after the update
+        flow_index_.Remove(&prev);
         prev.CopyFlowInfo(fe);
         prev.set_changed(true);
         prev.set_delete_enqueue_time(0);
@@ -1438,59 +1508,14 @@ void FlowStatsCollector::AddFlow(FlowExportInfo info) {
     } else {
         NewFlow(info.flow());
     }
-    if (ret.first->second.is_linked() == false) {
-        flow_export_info_list_.push_back(ret.first->second);
-    }
-}
-
-// The flow being deleted may be the first flow to visit in next ageing
-// iteration. Update the flow to visit next in such case
-void FlowStatsCollector::UpdateFlowIterationKey
-(const FlowEntry *del_flow, FlowEntryTree::iterator &tree_it) {
-    // Flow not found in tree is not a valid scenario. Lets be safe and
-    // restart walk here
-    if (tree_it == flow_tree_.end()) {
-        flow_iteration_key_ = NULL;
-    }
-
-    if (flow_iteration_key_ == NULL) {
-        return;
-    }
-
-    // The flow to visit next for ageing is being deleted. Update next flow to
-    // visit
-    FlowExportInfoList::iterator it =
-        flow_export_info_list_.iterator_to(tree_it->second);
-    ++it;
-
-    // If this is end of list, start from begining again
-    if (it == flow_export_info_list_.end())
-        it = flow_export_info_list_.begin();
-
-    if (it == flow_export_info_list_.end()) {
-        flow_iteration_key_ = NULL;
-    } else {
-        flow_iteration_key_ = it->flow();
-    }
+    flow_index_.Add(&ret.first->second);
 }
 
 void FlowStatsCollector::DeleteFlow(FlowEntryTree::iterator &it) {
-    // Update flow_iteration_key_ if flow being deleted is flow to visit in
-    // next ageing cycle
-    // Nothing to do if flow being deleted is not the next-iteration key
-    if (it->first == flow_iteration_key_) {
-        UpdateFlowIterationKey(it->first, it);
-    }
-
     if (it == flow_tree_.end())
         return;
 
-    if (it->second.is_linked()) {
-        FlowExportInfoList::iterator it1 =
-            flow_export_info_list_.iterator_to(it->second);
-        flow_export_info_list_.erase(it1);
-    }
-
+    flow_index_.Remove(&it->second);
     flow_tree_.erase(it);
 }
 
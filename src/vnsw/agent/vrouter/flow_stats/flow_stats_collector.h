@@ -32,6 +32,35 @@ public:
     uint16_t flags;
 };
 
+// Strings in FlowLogData that are shared by many flows. They are formatted
+// once per collector and copied into the FlowLogData on export, instead of
+// being formatted for every flow exported.
+class FlowLogStrings {
+public:
+    // Limit on number of interface UUID strings kept
+    static const size_t kMaxUuidStrings = 4096;
+
+    FlowLogStrings();
+    ~FlowLogStrings();
+
+    const std::string &ActionString(uint32_t action);
+    const std::string &DropReasonString(uint16_t reason);
+    const std::string &UuidString(const boost::uuids::uuid &u);
+    const std::string &RouterIdString(const Ip4Address &router_id);
+
+private:
+    typedef std::map<uint32_t, std::string> ActionStringMap;
+    typedef std::map<uint16_t, std::string> DropReasonStringMap;
+    typedef std::map<boost::uuids::uuid, std::string> UuidStringMap;
+
+    ActionStringMap action_map_;
+    DropReasonStringMap drop_reason_map_;
+    UuidStringMap uuid_map_;
+    Ip4Address router_id_;
+    std::string router_id_str_;
+    DISALLOW_COPY_AND_ASSIGN(FlowLogStrings);
+};
+
 //Defines the functionality to periodically read flow stats from
 //shared memory (between agent and Kernel) and export this stats info to
 //collector. Also responsible for aging of flow entries. Runs in the context
@@ -54,10 +83,14 @@ public:
 // On every visit of flow, check if flow is idle for configured ageing time and
 // delete the idle flows
 //
-// The flow_tree_ maintains flows sorted on flow pointer. This tree cannot be
-// used to scan flows for ageing since entries can be added/deleted between
-// ageing tasks. Alternatively, another list is maintained in the sequence
-// flows are added to flow ageing module.
+// The flow_tree_ maintains flows sorted on flow pointer and is used to find
+// the FlowExportInfo for a flow. The ageing scan walks flow_index_ instead,
+// which keeps flows indexed on vrouter flow handle. The scan sweeps the
+// flow handles in order, so that vr_flow_entry is read sequentially from
+// shared memory, followed by the flows that are not indexed on flow handle
+// yet. The position of the scan is a flow handle, which stays valid when
+// flows are added or deleted between ageing tasks. Every collector instance
+// sweeps only the pages of flow handles that hold its own flows.
 class FlowStatsCollector : public StatsCollector {
 public:
     // Default ageing time
@@ -74,6 +107,8 @@ public:
     static const uint32_t kMinFlowsPerTimer = 3000;
     // Number of flows to visit per task
     static const uint32_t kFlowsPerTask = 256;
+    // Number of flow handles to sweep per task
+    static const uint32_t kFlowHandlesPerTask = (16 * kFlowsPerTask);
 
     // Retry flow-delete after 5 second
     static const uint64_t kFlowDeleteRetryTime = (5 * 1000 * 1000);
@@ -121,8 +156,7 @@ public:
     boost::uuids::uuid rand_gen();
     bool Run();
     bool RunAgeingTask();
-    uint32_t ProcessFlow(FlowExportInfoList::iterator &it,
-                         KSyncFlowMemory *ksync_obj,
+    uint32_t ProcessFlow(KSyncFlowMemory *ksync_obj,
                          FlowExportInfo *info, uint64_t curr_time);
     bool AgeFlow(KSyncFlowMemory *ksync_obj, const vr_flow_entry *k_flow,
                  const vr_flow_stats &k_stats, const KFlowData &kinfo,
@@ -160,7 +194,12 @@ public:
                           uint32_t packets, uint32_t oflow_bytes,
                           const boost::uuids::uuid &u);
     size_t Size() const { return flow_tree_.size(); }
-    size_t AgeTreeSize() const { return flow_export_info_list_.size(); }
+    size_t AgeTreeSize() const { return flow_index_.size(); }
+    uint64_t ageing_passes() const { return ageing_passes_; }
+    // Duration of the last complete ageing pass in usec
+    uint64_t last_ageing_pass_time() const { return last_ageing_pass_time_; }
+    // Number of flows the ageing task is behind on
+    uint32_t ageing_backlog() const { return entries_to_visit_; }
     void NewFlow(FlowEntry *flow);
     void set_deleted(bool val) {
         deleted_ = val;
@@ -224,10 +263,9 @@ private:
     void FlowDeleteEnqueue(FlowExportInfo *info, uint64_t t);
     void FlowEvictEnqueue(FlowExportInfo *info, uint64_t t,
                           uint32_t flow_handle, uint16_t gen_id);
+    FlowLogData &AddFlowMsg();
     void EnqueueFlowMsg();
     void DispatchPendingFlowMsg();
-    void GetFlowSandeshActionParams(const FlowAction &action_info,
-                                    std::string &action_str);
     void SetUnderlayInfo(FlowExportInfo *info, FlowLogData &s_flow);
     void UpdateThreshold(uint32_t new_value);
 
@@ -251,26 +289,28 @@ private:
     void RequestHandlerExit(bool done);
     void AddFlow(FlowExportInfo info);
     void DeleteFlow(FlowEntryTree::iterator &it);
-    void UpdateFlowIterationKey(const FlowEntry *del_flow,
-                                FlowEntryTree::iterator &tree_it);
+    void AgeingPassDone();
     void HandleFlowStatsUpdate(const FlowKey &key, uint32_t bytes,
                                uint32_t packets, uint32_t oflow_bytes);
 
     void UpdateFlowStats(FlowExportInfo *flow, uint64_t &diff_bytes,
                          uint64_t &diff_pkts);
-    uint8_t GetFlowMsgIdx();
 
     AgentUveBase *agent_uve_;
     int task_id_;
     boost::uuids::random_generator rand_gen_;
-    const FlowEntry* flow_iteration_key_;
+    // Next flow handle to visit in ageing pass, kInvalidFlowHandle once the
+    // sweep of the pass is done
+    uint32_t flow_iteration_key_;
+    // Flows in overflow list of flow_index_ to visit in ageing pass
+    size_t overflow_entries_to_visit_;
     uint64_t flow_age_time_intvl_;
     // Number of entries pending to be visited
     uint32_t entries_to_visit_;
     uint64_t flow_tcp_syn_age_time_;
 
     FlowEntryTree flow_tree_;
-    FlowExportInfoList flow_export_info_list_;
+    FlowExportInfoIndex flow_index_;
     // Flag to specify if flow-delete request event must be retried
     // If enabled
     //    Dont remove FlowExportInfo from list after generating delete event
@@ -282,8 +322,10 @@ private:
     //    are covered before disabling the fag
     bool retry_delete_;
     Queue request_queue_;
+    // Flow log messages pending dispatch. The vector is reserved upfront and
+    // handed to DispatchFlowMsg as is, so it is never reallocated or copied
     std::vector<FlowLogData> msg_list_;
-    uint8_t msg_index_;
+    FlowLogStrings flow_log_strings_;
     tbb::atomic<bool> deleted_;
     FlowAgingTableKey flow_aging_key_;
     uint32_t instance_id_;
@@ -298,6 +340,10 @@ private:
     // and used for all requests in current run
     uint64_t current_time_;
     uint64_t ageing_task_starts_;
+    // Start time of ageing pass in progress, 0 if there is none
+    uint64_t ageing_pass_start_time_;
+    uint64_t ageing_passes_;
+    uint64_t last_ageing_pass_time_;
 
     // Per ageing-timer stats for debugging
     uint32_t flows_visited_;
@@ -391,6 +391,18 @@ void ShowAgingConfig::HandleRequest() const {
         cfg.set_port(it->first.port);
         cfg.set_cache_timeout(it->second->GetAgeTimeInSeconds());
         cfg.set_stats_interval(0);
+        std::vector<FlowAgeingScanStats> scan_stats_list;
+        for (int i = 0; i < FlowStatsCollectorObject::kMaxCollectors; i++) {
+            const FlowStatsCollector *col = it->second->GetCollector(i);
+            FlowAgeingScanStats scan_stats;
+            scan_stats.set_instance_id(col->instance_id());
+            scan_stats.set_flow_count(col->Size());
+            scan_stats.set_ageing_passes(col->ageing_passes());
+            scan_stats.set_last_ageing_pass_time(col->last_ageing_pass_time());
+            scan_stats.set_ageing_backlog(col->ageing_backlog());
+            scan_stats_list.push_back(scan_stats);
+        }
+        cfg.set_ageing_scan_stats(scan_stats_list);
         std::vector<AgingConfig> &list =
             const_cast<std::vector<AgingConfig>&>(
                     ((AgingConfigResponse *)resp)->get_aging_config_list());
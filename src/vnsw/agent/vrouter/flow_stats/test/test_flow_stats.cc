@@ -256,6 +256,7 @@ TEST_F(FlowStatsTest, FlowAddVerify) {
     util_.EnqueueFlowStatsCollectorTask();
 
     WAIT_FOR(5000, 1000, (col->AgeTreeSize() == (col->Size() - 2)));
+    WAIT_FOR(1000, 1000, (col->ageing_passes() > 0));
 
     //Send requests to create flow again
     CreateFlow(flow, 1);
@@ -274,6 +275,98 @@ TEST_F(FlowStatsTest, FlowAddVerify) {
     FlowTeardown();
 }
 
+//Verify that FlowExportInfoIndex keeps flows in the slot of their flow handle
+//and moves flows without a usable flow handle to overflow list
+TEST_F(FlowStatsTest, FlowExportInfoIndex) {
+    FlowExportInfoIndex index;
+    FlowExportInfo info[4];
+    info[0].set_flow_handle(10);
+    info[1].set_flow_handle(2);
+    // Flow handle of info[2] is not known yet
+    // info[3] has same flow handle as info[0]
+    info[3].set_flow_handle(10);
+
+    for (int i = 0; i < 4; i++) {
+        index.Add(&info[i]);
+    }
+    index.Add(&info[0]);
+    EXPECT_EQ(4U, index.size());
+    EXPECT_EQ(static_cast<uint32_t>(FlowExportInfoIndex::kPageSize),
+              index.slot_count());
+    EXPECT_EQ(1U, index.page_count());
+    EXPECT_EQ(2U, index.overflow_size());
+    EXPECT_TRUE(index.At(10) == &info[0]);
+    EXPECT_TRUE(index.At(2) == &info[1]);
+    EXPECT_TRUE(index.At(3) == NULL);
+    EXPECT_TRUE(index.At(100) == NULL);
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(index.IsPresent(&info[i]));
+    }
+
+    // Overflow list is visited in rotation
+    EXPECT_TRUE(index.RotateOverflow() == &info[2]);
+    EXPECT_TRUE(index.RotateOverflow() == &info[3]);
+    EXPECT_TRUE(index.RotateOverflow() == &info[2]);
+
+    // Slot is taken, info[3] stays in overflow list
+    index.Relocate(&info[3]);
+    EXPECT_EQ(2U, index.overflow_size());
+
+    index.Remove(&info[0]);
+    EXPECT_FALSE(index.IsPresent(&info[0]));
+    EXPECT_TRUE(index.At(10) == NULL);
+    index.Relocate(&info[3]);
+    EXPECT_TRUE(index.At(10) == &info[3]);
+
+    info[2].set_flow_handle(20);
+    index.Relocate(&info[2]);
+    EXPECT_TRUE(index.At(20) == &info[2]);
+    EXPECT_EQ(0U, index.overflow_size());
+    EXPECT_EQ(3U, index.size());
+    EXPECT_TRUE(index.RotateOverflow() == NULL);
+
+    index.Remove(&info[1]);
+    index.Remove(&info[2]);
+    index.Remove(&info[3]);
+    index.Remove(&info[3]);
+    EXPECT_EQ(0U, index.size());
+    EXPECT_EQ(0U, index.page_count());
+}
+
+//Verify that FlowExportInfoIndex allocates slots only for the pages of flow
+//handles in use, and that the sweep skips the other pages
+TEST_F(FlowStatsTest, FlowExportInfoIndexPages) {
+    const uint32_t page_size = FlowExportInfoIndex::kPageSize;
+    FlowExportInfoIndex index;
+    FlowExportInfo info[3];
+    info[0].set_flow_handle(1);
+    info[1].set_flow_handle(10 * page_size + 5);
+    info[2].set_flow_handle(10 * page_size + 6);
+    for (int i = 0; i < 3; i++) {
+        index.Add(&info[i]);
+    }
+    EXPECT_EQ(2U, index.page_count());
+    EXPECT_EQ(11 * page_size, index.slot_count());
+
+    EXPECT_EQ(0U, index.SkipEmptyPages(0));
+    EXPECT_EQ(page_size - 1, index.SkipEmptyPages(page_size - 1));
+    EXPECT_EQ(10 * page_size, index.SkipEmptyPages(page_size));
+    EXPECT_EQ(10 * page_size + 7, index.SkipEmptyPages(10 * page_size + 7));
+    EXPECT_EQ(index.slot_count(), index.SkipEmptyPages(11 * page_size));
+
+    // Page is freed with its last entry
+    index.Remove(&info[0]);
+    EXPECT_EQ(1U, index.page_count());
+    EXPECT_EQ(10 * page_size, index.SkipEmptyPages(0));
+    index.Remove(&info[1]);
+    EXPECT_EQ(1U, index.page_count());
+    EXPECT_TRUE(index.At(10 * page_size + 6) == &info[2]);
+    index.Remove(&info[2]);
+    EXPECT_EQ(0U, index.page_count());
+    EXPECT_EQ(index.slot_count(), index.SkipEmptyPages(0));
+    EXPECT_TRUE(index.At(10 * page_size + 6) == NULL);
+}
+
 int main(int argc, char *argv[]) {
     int ret;
     GETUSERARGS();
@@ -120,6 +120,7 @@ void KSync::InitDone() {
     profile->RegisterKSyncStatsCb(boost::bind(&KSync::SetProfileData,
                                               this, _1));
     KSyncSock::Get(0)->SetMeasureQueueDelay(agent_->MeasureQueueDelay());
+    KSyncSock::Get(0)->SetBulkTxMode(agent_->params()->ksync_bulk_tx_mode());
 }
 
 void KSync::InitFlowMem() {
@@ -0,0 +1,284 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "xmpp/xmpp_stanza_scanner.h"
+
+#include <boost/regex.hpp>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/time_util.h"
+#include "xmpp/xmpp_str.h"
+
+#include "testing/gunit.h"
+
+using std::string;
+using std::vector;
+
+//
+// Frame stanzas the way XmppSession does in the ESTABLISHED state when the
+// scanner is not used: copy each buffer into a string and regex search for
+// the start tag followed by the matching end tag.
+//
+class XmppRegexFramer {
+public:
+    XmppRegexFramer() : start_patt_(rXMPP_MESSAGE), tag_known_(false) {
+    }
+
+    void Read(const uint8_t *data, size_t size, vector<string> *stanzas) {
+        buf_ += string(data, data + size);
+        size_t offset = 0;
+        while (!buf_.empty()) {
+            if (!tag_known_) {
+                size_t pos = buf_.find_first_not_of(sXMPP_VALIDWS);
+                if (pos != 0) {
+                    if (pos == string::npos)
+                        pos = buf_.size();
+                    stanzas->push_back(buf_.substr(0, pos));
+                    buf_.erase(0, pos);
+                    continue;
+                }
+            }
+            boost::smatch res;
+            const boost::regex &patt = tag_known_ ? end_patt_ : start_patt_;
+            string::const_iterator start = buf_.begin() + offset;
+            string::const_iterator last = buf_.end();
+            if (!regex_search(start, last, res, patt) ||
+                !res[0].matched) {
+                break;
+            }
+            if (!tag_known_) {
+                string tag(res[0].first + 1, res[0].second);
+                end_patt_ = boost::regex("</" + tag + "[\\s\\t\\r\\n]*>");
+                tag_known_ = true;
+                offset = res[0].second - buf_.begin();
+                continue;
+            }
+            size_t end = res[0].second - buf_.begin();
+            stanzas->push_back(buf_.substr(0, end));
+            buf_.erase(0, end);
+            offset = 0;
+            tag_known_ = false;
+        }
+    }
+
+private:
+    boost::regex start_patt_;
+    boost::regex end_patt_;
+    bool tag_known_;
+    string buf_;
+};
+
+class XmppStanzaScannerTest : public ::testing::Test {
+protected:
+    static const size_t kBufferSize = 16 * 1024;
+
+    void Read(const string &data, size_t chunk, vector<string> *stanzas) {
+        const uint8_t *cp = reinterpret_cast<const uint8_t *>(data.data());
+        for (size_t offset = 0; offset < data.size(); offset += chunk) {
+            size_t size = std::min(chunk, data.size() - offset);
+            Scan(cp + offset, size, stanzas);
+        }
+    }
+
+    // Same logic as XmppSession::ScanStanzas.
+    void Scan(const uint8_t *data, size_t size, vector<string> *stanzas) {
+        while (size > 0) {
+            bool complete = false;
+            size_t consumed = scanner_.Scan(data, size, &complete);
+            pending_.append(reinterpret_cast<const char *>(data), consumed);
+            if (!complete)
+                break;
+            stanzas->push_back(pending_);
+            pending_.clear();
+            data += consumed;
+            size -= consumed;
+        }
+    }
+
+    void RegexRead(const string &data, size_t chunk, vector<string> *stanzas) {
+        XmppRegexFramer framer;
+        const uint8_t *cp = reinterpret_cast<const uint8_t *>(data.data());
+        for (size_t offset = 0; offset < data.size(); offset += chunk) {
+            size_t size = std::min(chunk, data.size() - offset);
+            framer.Read(cp + offset, size, stanzas);
+        }
+    }
+
+    // Build a stream of route publish messages that looks like what a
+    // vrouter agent sends to the control node.
+    static string BuildAgentTraffic(int count) {
+        std::ostringstream oss;
+        for (int idx = 0; idx < count; ++idx) {
+            oss << "<iq type=\"set\" from=\"agent-" << idx % 16
+                << "@vnsw.contrailsystems.com\""
+                << " to=\"network-control@contrailsystems.com/bgp-peer\""
+                << " id=\"pubsub" << idx << "\">"
+                << "<pubsub xmlns=\"http://jabber.org/protocol/pubsub\">"
+                << "<publish node=\"1/1/default-domain:admin:vn1:vn1/10.1."
+                << (idx >> 8) % 256 << "." << idx % 256 << "/32\">"
+                << "<item><entry xmlns=\"http://www.contrailsystems.com/"
+                << "bgp-l3vpn-unicast.xsd\"><nlri><af>1</af><safi>1</safi>"
+                << "<address>10.1." << (idx >> 8) % 256 << "." << idx % 256
+                << "/32</address></nlri><next-hops><next-hop><af>1</af>"
+                << "<address>192.168.1.1</address><label>" << 16 + idx
+                << "</label><tunnel-encapsulation-list>"
+                << "<tunnel-encapsulation>gre</tunnel-encapsulation>"
+                << "<tunnel-encapsulation>udp</tunnel-encapsulation>"
+                << "</tunnel-encapsulation-list></next-hop></next-hops>"
+                << "<version>1</version><virtual-network>"
+                << "default-domain:admin:vn1</virtual-network>"
+                << "<sequence-number>0</sequence-number>"
+                << "<security-group-list><security-group>8000001"
+                << "</security-group></security-group-list>"
+                << "<local-preference>100</local-preference>"
+                << "</entry></item></publish></pubsub></iq>";
+            oss << "<iq type=\"set\" from=\"agent-" << idx % 16
+                << "@vnsw.contrailsystems.com\""
+                << " to=\"network-control@contrailsystems.com/bgp-peer\">"
+                << "<pubsub xmlns=\"http://jabber.org/protocol/pubsub\">"
+                << "<collection node=\"default-domain:admin:vn1:vn1\">"
+                << "<associate node=\"1/1/default-domain:admin:vn1:vn1/10.1."
+                << (idx >> 8) % 256 << "." << idx % 256 << "/32\" />"
+                << "</collection></pubsub></iq>";
+            if (idx % 64 == 0)
+                oss << " ";
+        }
+        return oss.str();
+    }
+
+    static string TestData() {
+        const char *path = getenv("XMPP_STANZA_SCANNER_TEST_DATA_FILE");
+        if (!path)
+            return BuildAgentTraffic(20000);
+        std::ifstream file(path);
+        std::stringstream content;
+        content << file.rdbuf();
+        return content.str();
+    }
+
+    XmppStanzaScanner scanner_;
+    string pending_;
+};
+
+TEST_F(XmppStanzaScannerTest, Basic) {
+    vector<string> stanzas;
+    Read("<iq type='set'><pubsub/></iq><message to='x'>hi</message>",
+         kBufferSize, &stanzas);
+    ASSERT_EQ(2, stanzas.size());
+    EXPECT_EQ("<iq type='set'><pubsub/></iq>", stanzas[0]);
+    EXPECT_EQ("<message to='x'>hi</message>", stanzas[1]);
+    EXPECT_FALSE(scanner_.InStanza());
+}
+
+TEST_F(XmppStanzaScannerTest, EmptyElement) {
+    vector<string> stanzas;
+    Read("<iq type='result'/><iq type='get' />", kBufferSize, &stanzas);
+    ASSERT_EQ(2, stanzas.size());
+    EXPECT_EQ("<iq type='result'/>", stanzas[0]);
+    EXPECT_EQ("<iq type='get' />", stanzas[1]);
+}
+
+TEST_F(XmppStanzaScannerTest, QuotedAttributes) {
+    vector<string> stanzas;
+    Read("<iq a='</iq>' b=\"/>\"><x c='>'/></iq>", kBufferSize, &stanzas);
+    ASSERT_EQ(1, stanzas.size());
+    EXPECT_EQ("<iq a='</iq>' b=\"/>\"><x c='>'/></iq>", stanzas[0]);
+}
+
+TEST_F(XmppStanzaScannerTest, NestedSameTag) {
+    vector<string> stanzas;
+    Read("<message><message>x</message></message  >", kBufferSize, &stanzas);
+    ASSERT_EQ(1, stanzas.size());
+    EXPECT_EQ("<message><message>x</message></message  >", stanzas[0]);
+}
+
+TEST_F(XmppStanzaScannerTest, Whitespace) {
+    vector<string> stanzas;
+    Read(" \n<iq/>" sXMPP_WHITESPACE "<iq/>\t", kBufferSize, &stanzas);
+    ASSERT_EQ(5, stanzas.size());
+    EXPECT_EQ(" \n", stanzas[0]);
+    EXPECT_EQ("<iq/>", stanzas[1]);
+    EXPECT_EQ(sXMPP_WHITESPACE, stanzas[2]);
+    EXPECT_EQ("<iq/>", stanzas[3]);
+    EXPECT_EQ("\t", stanzas[4]);
+}
+
+TEST_F(XmppStanzaScannerTest, Prelude) {
+    vector<string> stanzas;
+    Read("</stream:stream><?pi?><iq>a</iq>", kBufferSize, &stanzas);
+    ASSERT_EQ(1, stanzas.size());
+    EXPECT_EQ("</stream:stream><?pi?><iq>a</iq>", stanzas[0]);
+}
+
+TEST_F(XmppStanzaScannerTest, Partial) {
+    vector<string> stanzas;
+    Read("<iq><pubsub><item>", kBufferSize, &stanzas);
+    EXPECT_EQ(0, stanzas.size());
+    EXPECT_TRUE(scanner_.InStanza());
+    EXPECT_EQ(3, scanner_.depth());
+    Read("</item></pubsub></i", kBufferSize, &stanzas);
+    EXPECT_EQ(0, stanzas.size());
+    Read("q><iq", kBufferSize, &stanzas);
+    ASSERT_EQ(1, stanzas.size());
+    EXPECT_EQ("<iq><pubsub><item></item></pubsub></iq>", stanzas[0]);
+    EXPECT_TRUE(scanner_.InStanza());
+    Read("/>", kBufferSize, &stanzas);
+    ASSERT_EQ(2, stanzas.size());
+    EXPECT_EQ("<iq/>", stanzas[1]);
+    EXPECT_FALSE(scanner_.InStanza());
+}
+
+//
+// Split the stream at every possible read size and verify that framing is
+// independent of read boundaries.
+//
+TEST_F(XmppStanzaScannerTest, ReadBoundaries) {
+    string data = BuildAgentTraffic(4);
+    vector<string> expected;
+    Read(data, kBufferSize, &expected);
+    EXPECT_EQ(9, expected.size());
+
+    for (size_t chunk = 1; chunk < data.size(); ++chunk) {
+        vector<string> stanzas;
+        Read(data, chunk, &stanzas);
+        EXPECT_EQ(expected, stanzas) << "Read size " << chunk;
+        EXPECT_FALSE(scanner_.InStanza());
+    }
+}
+
+//
+// Verify that the scanner frames the stream exactly like the regex based
+// framing, and compare the time taken by each.
+//
+TEST_F(XmppStanzaScannerTest, CompareWithRegex) {
+    string data = TestData();
+    vector<string> regex_stanzas;
+    vector<string> stanzas;
+    regex_stanzas.reserve(64 * 1024);
+    stanzas.reserve(64 * 1024);
+
+    uint64_t start = ClockMonotonicUsec();
+    RegexRead(data, kBufferSize, &regex_stanzas);
+    uint64_t regex_time = ClockMonotonicUsec() - start;
+
+    start = ClockMonotonicUsec();
+    Read(data, kBufferSize, &stanzas);
+    uint64_t scanner_time = ClockMonotonicUsec() - start;
+
+    EXPECT_EQ(regex_stanzas, stanzas);
+    std::cout << "Framed " << stanzas.size() << " stanzas from "
+        << data.size() << " bytes" << std::endl;
+    std::cout << "Regex framing   : " << regex_time << " usec" << std::endl;
+    std::cout << "Scanner framing : " << scanner_time << " usec" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
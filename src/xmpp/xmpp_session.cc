@@ -36,6 +36,7 @@ XmppSession::XmppSession(XmppConnectionManager *manager, SslSocket *socket,
       stats_(XmppStanza::RESERVED_STANZA, XmppSession::StatsPair(0, 0)),
       keepalive_probes_(kSessionKeepaliveProbes) {
     buf_.reserve(kMaxMessageSize);
+    pending_.reserve(kMaxMessageSize);
     offset_ = buf_.begin();
     stream_open_matched_ = false;
 }
@@ -266,9 +267,46 @@ bool XmppSession::Match(Buffer buffer, int *result, bool NewBuf) {
     return true;
 }
 
+//
+// Frame stanzas in the ESTABLISHED state using the streaming scanner.
+//
+// Complete stanzas are handed to the connection straight out of the read
+// buffer. Only the part of a stanza that straddles a read boundary is
+// accumulated in pending_, and the scanner resumes from where it stopped
+// when the next buffer is read.
+//
+void XmppSession::ScanStanzas(Buffer buffer) {
+    const uint8_t *data = BufferData(buffer);
+    size_t size = BufferSize(buffer);
+
+    while (size > 0 && connection_) {
+        bool complete = false;
+        size_t consumed = scanner_.Scan(data, size, &complete);
+        if (!complete) {
+            pending_.append(reinterpret_cast<const char *>(data), consumed);
+            break;
+        }
+
+        if (pending_.empty()) {
+            connection_->ReceiveMsg(this,
+                string(reinterpret_cast<const char *>(data), consumed));
+        } else {
+            pending_.append(reinterpret_cast<const char *>(data), consumed);
+            connection_->ReceiveMsg(this, pending_);
+            pending_.clear();
+        }
+        data += consumed;
+        size -= consumed;
+    }
+}
+
 // Read the socket stream and send messages to the connection object.
-// The buffer is copied to local string for regex match. 
-// TODO Code need to change st Match() is done on buffer itself.
+//
+// Stanzas in the ESTABLISHED state are framed by the streaming scanner
+// directly on the buffer. Stream negotiation in earlier states is state
+// dependent and infrequent, so the buffer is copied to a local string for
+// regex match. Any partial match left over by the regex framing is drained
+// before switching to the scanner.
 void XmppSession::OnRead(Buffer buffer) {
     if (this->Connection() == NULL || !connection_) {
         // Connection is deleted. Session is being deleted as well
@@ -285,6 +323,13 @@ void XmppSession::OnRead(Buffer buffer) {
         return;
     }
 
+    if (connection_->GetStateMcState() == xmsm::ESTABLISHED &&
+        !tag_known_ && buf_.empty()) {
+        ScanStanzas(buffer);
+        ReleaseBuffer(buffer);
+        return;
+    }
+
     int result = 0;
     bool more = Match(buffer, &result, true);
     do {
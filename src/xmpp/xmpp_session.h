@@ -9,6 +9,7 @@
 #include <boost/regex.hpp>
 #include "io/ssl_server.h"
 #include "io/ssl_session.h"
+#include "xmpp/xmpp_stanza_scanner.h"
 
 class XmppServer;
 class XmppConnection;
@@ -58,6 +59,7 @@ private:
     void SetBuf(const std::string &);
     void ReplaceBuf(const std::string &);
     bool LeftOver() const;
+    void ScanStanzas(Buffer buffer);
 
     XmppConnectionManager *manager_;
     XmppConnection *connection_;
@@ -68,6 +70,8 @@ private:
     int tag_known_;
     int task_instance_;
     boost::match_results<std::string::const_iterator> res_;
+    XmppStanzaScanner scanner_;
+    std::string pending_;
     std::vector<StatsPair> stats_; // packet count
     int keepalive_idle_time_;
     int keepalive_interval_;
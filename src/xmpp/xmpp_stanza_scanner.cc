@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "xmpp/xmpp_stanza_scanner.h"
+
+XmppStanzaScanner::XmppStanzaScanner()
+    : state_(IDLE), depth_(0), quote_(0) {
+}
+
+void XmppStanzaScanner::Reset() {
+    state_ = IDLE;
+    depth_ = 0;
+    quote_ = 0;
+}
+
+//
+// Same set of characters as sXMPP_VALIDWS. The last two are the utf-8
+// encoding of U+0200, which is used as a whitespace keepalive.
+//
+bool XmppStanzaScanner::IsWhitespace(uint8_t ch) {
+    return (ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t' ||
+            ch == 0xC8 || ch == 0x80);
+}
+
+size_t XmppStanzaScanner::Scan(const uint8_t *data, size_t len,
+    bool *complete) {
+    *complete = false;
+    size_t idx = 0;
+    while (idx < len) {
+        uint8_t ch = data[idx];
+        switch (state_) {
+        case IDLE:
+            if (IsWhitespace(ch)) {
+                state_ = WHITESPACE;
+            } else if (ch == '<') {
+                state_ = TAG_OPEN;
+            } else {
+                state_ = PRELUDE;
+            }
+            break;
+
+        case WHITESPACE:
+            // Report whitespace upto the start of the next stanza.
+            if (!IsWhitespace(ch)) {
+                state_ = IDLE;
+                *complete = true;
+                return idx;
+            }
+            break;
+
+        case PRELUDE:
+            if (ch == '<')
+                state_ = TAG_OPEN;
+            break;
+
+        case TEXT:
+            if (ch == '<')
+                state_ = TAG_OPEN;
+            break;
+
+        case TAG_OPEN:
+            if (ch == '/') {
+                state_ = END_TAG;
+            } else if (ch == '?' || ch == '!') {
+                state_ = MARKUP;
+            } else {
+                state_ = START_TAG;
+            }
+            break;
+
+        case START_TAG:
+            if (ch == '"' || ch == '\'') {
+                quote_ = ch;
+                state_ = ATTR_VALUE;
+            } else if (ch == '/') {
+                state_ = EMPTY_TAG_END;
+            } else if (ch == '>') {
+                depth_++;
+                state_ = TEXT;
+            }
+            break;
+
+        case ATTR_VALUE:
+            if (ch == quote_)
+                state_ = START_TAG;
+            break;
+
+        case EMPTY_TAG_END:
+            if (ch != '>') {
+                // Not an empty element tag after all; rescan this byte.
+                state_ = START_TAG;
+                continue;
+            }
+            if (depth_ == 0) {
+                Reset();
+                *complete = true;
+                return idx + 1;
+            }
+            state_ = TEXT;
+            break;
+
+        case END_TAG:
+            if (ch != '>')
+                break;
+            if (depth_ == 0) {
+                // Unbalanced end tag before the first element.
+                state_ = PRELUDE;
+                break;
+            }
+            if (--depth_ == 0) {
+                Reset();
+                *complete = true;
+                return idx + 1;
+            }
+            state_ = TEXT;
+            break;
+
+        case MARKUP:
+            if (ch == '>')
+                state_ = depth_ ? TEXT : PRELUDE;
+            break;
+        }
+        idx++;
+    }
+
+    // Whitespace is delivered as soon as it's read, like the regex framing.
+    if (state_ == WHITESPACE) {
+        state_ = IDLE;
+        *complete = true;
+    }
+    return len;
+}
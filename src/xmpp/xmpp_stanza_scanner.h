@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef SRC_XMPP_XMPP_STANZA_SCANNER_H_
+#define SRC_XMPP_XMPP_STANZA_SCANNER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "base/util.h"
+
+//
+// Incremental scanner that finds top level stanza boundaries in an xmpp
+// stream without copying or regex matching.
+//
+// The scanner is a small state machine that tracks element depth over the
+// raw bytes of the read buffer.  State is kept across calls to Scan, so a
+// stanza that straddles multiple reads is found without rescanning bytes
+// that have already been examined.
+//
+// Whitespace between stanzas is reported as a stanza of its own since it
+// is used as a keepalive. Any other bytes before the first element (e.g.
+// a stray end tag or processing instruction) become part of the following
+// stanza, which matches the behavior of the regex based framing.
+//
+// Comments and CDATA sections are not interpreted; their contents must not
+// contain a '>'. Neither is generated by any xmpp peer we talk to.
+//
+class XmppStanzaScanner {
+public:
+    XmppStanzaScanner();
+
+    void Reset();
+
+    // Scan upto len bytes starting at data. Returns the number of bytes
+    // consumed. If a stanza boundary was found, complete is set to true and
+    // the consumed bytes end at the boundary. Otherwise, all len bytes are
+    // consumed and the scanner expects more data.
+    size_t Scan(const uint8_t *data, size_t len, bool *complete);
+
+    // Returns true if the scanner is in the middle of a stanza.
+    bool InStanza() const { return state_ != IDLE; }
+    int depth() const { return depth_; }
+
+private:
+    enum State {
+        IDLE,           // Between stanzas
+        WHITESPACE,     // In whitespace between stanzas
+        PRELUDE,        // In bytes before the first element of a stanza
+        TEXT,           // In character data inside an element
+        TAG_OPEN,       // Seen '<'
+        START_TAG,      // In a start tag name or attributes
+        ATTR_VALUE,     // In a quoted attribute value
+        EMPTY_TAG_END,  // Seen '/' in a start tag
+        END_TAG,        // In an end tag
+        MARKUP,         // In a processing instruction, comment or declaration
+    };
+
+    static bool IsWhitespace(uint8_t ch);
+
+    State state_;
+    int depth_;
+    uint8_t quote_;
+
+    DISALLOW_COPY_AND_ASSIGN(XmppStanzaScanner);
+};
+
+#endif  // SRC_XMPP_XMPP_STANZA_SCANNER_H_